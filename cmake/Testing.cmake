@@ -36,21 +36,34 @@ endfunction()
 
 auto_test(core core "${${PROJECT_NAME}_RESOURCES}")
 auto_test(core contactid "")
+auto_test(core coreloopmetrics "")
+auto_test(core fileprogressaggregator "")
+auto_test(core filetransferio "")
 auto_test(core toxid "")
 auto_test(core toxstring "")
+auto_test(core videoencodepacer "")
 auto_test(chatlog textformatter "")
 auto_test(net bsu "${${PROJECT_NAME}_RESOURCES}") # needs nodes list
+auto_test(persistence logwriter "")
 auto_test(persistence paths "")
 auto_test(persistence dbschema "")
 auto_test(persistence offlinemsgengine "")
+auto_test(persistence peerblacklist "")
+auto_test(persistence settingsserializer "")
 auto_test(persistence smileypack "${${PROJECT_NAME}_RESOURCES}") # needs emojione
+auto_test(persistence thumbnailcache "")
 auto_test(model friendmessagedispatcher "")
 auto_test(model groupmessagedispatcher "")
+auto_test(model group "")
 auto_test(model messageprocessor "")
 auto_test(model sessionchatlog "")
+auto_test(model chatlogsearch "")
 auto_test(model exiftransform "")
+auto_test(model friendlistmodel "")
 auto_test(model notificationgenerator "")
+auto_test(video framedamagetracker "")
 
 if (UNIX)
+  auto_test(. ipc "")
   auto_test(platform posixsignalnotifier "")
 endif()
@@ -25,9 +25,9 @@
 #include "src/widget/gui.h"
 #include "src/widget/style.h"
 #include "src/widget/widget.h"
-#include "src/model/exiftransform.h"
+#include "src/persistence/thumbnailcache.h"
 
-#include <QBuffer>
+#include <QCursor>
 #include <QDebug>
 #include <QDesktopServices>
 #include <QDesktopWidget>
@@ -36,6 +36,7 @@
 #include <QMessageBox>
 #include <QMouseEvent>
 #include <QPainter>
+#include <QToolTip>
 #include <QVariantAnimation>
 
 #include <cassert>
@@ -89,6 +90,7 @@ FileTransferWidget::FileTransferWidget(QWidget* parent, CoreFile& _coreFile, Tox
     connect(ui->rightButton, &QPushButton::clicked, this, &FileTransferWidget::onRightButtonClicked);
     connect(ui->previewButton, &QPushButton::clicked, this,
             &FileTransferWidget::onPreviewButtonClicked);
+    ui->previewButton->installEventFilter(this);
 
     connect(&GUI::getInstance(), &GUI::themeReload, this, &FileTransferWidget::reloadTheme);
 
@@ -500,48 +502,54 @@ void FileTransferWidget::handleButton(QPushButton* btn)
 
 void FileTransferWidget::showPreview(const QString& filename)
 {
-    static const QStringList previewExtensions = {"png", "jpeg", "jpg", "gif", "svg",
-                                                  "PNG", "JPEG", "JPG", "GIF", "SVG"};
+    if (!ThumbnailCache::canPreview(filename)) {
+        return;
+    }
 
-    if (previewExtensions.contains(QFileInfo(filename).suffix())) {
-        // Subtract to make border visible
-        const int size = qMax(ui->previewButton->width(), ui->previewButton->height()) - 4;
+    // Subtract to make border visible
+    const int size = qMax(ui->previewButton->width(), ui->previewButton->height()) - 4;
 
-        QFile imageFile(filename);
-        if (!imageFile.open(QIODevice::ReadOnly)) {
-            return;
-        }
+    ThumbnailCache::getInstance().requestIcon(filename, size, this, [this](const QImage& icon) {
+        onPreviewIconReady(icon);
+    });
+}
 
-        const QByteArray imageFileData = imageFile.readAll();
-        QImage image = QImage::fromData(imageFileData);
-        auto orientation = ExifTransform::getOrientation(imageFileData);
-        image = ExifTransform::applyTransformation(image, orientation);
+void FileTransferWidget::onPreviewIconReady(const QImage& icon)
+{
+    const QPixmap iconPixmap = QPixmap::fromImage(icon);
+    ui->previewButton->setIcon(QIcon(iconPixmap));
+    ui->previewButton->setIconSize(iconPixmap.size());
+    ui->previewButton->show();
+}
 
-        const QPixmap iconPixmap = scaleCropIntoSquare(QPixmap::fromImage(image), size);
+/**
+ * @brief Loads the mouseover preview when it's shown for the first time.
+ */
+bool FileTransferWidget::eventFilter(QObject* watched, QEvent* event)
+{
+    if (watched != ui->previewButton || event->type() != QEvent::ToolTip
+        || !ui->previewButton->toolTip().isEmpty()) {
+        return QWidget::eventFilter(watched, event);
+    }
 
-        ui->previewButton->setIcon(QIcon(iconPixmap));
-        ui->previewButton->setIconSize(iconPixmap.size());
-        ui->previewButton->show();
-        // Show mouseover preview, but make sure it's not larger than 50% of the screen
-        // width/height
+    if (!previewTooltipRequested) {
+        previewTooltipRequested = true;
+        // make sure it's not larger than 50% of the screen width/height
         const QRect desktopSize = QApplication::desktop()->geometry();
-        const int maxPreviewWidth{desktopSize.width() / 2};
-        const int maxPreviewHeight{desktopSize.height() / 2};
-        const QImage previewImage = [&image, maxPreviewWidth, maxPreviewHeight]() {
-            if (image.width() > maxPreviewWidth || image.height() > maxPreviewHeight) {
-                return image.scaled(maxPreviewWidth, maxPreviewHeight, Qt::KeepAspectRatio,
-                                    Qt::SmoothTransformation);
-            } else {
-                return image;
-            }
-        }();
-
-        QByteArray imageData;
-        QBuffer buffer(&imageData);
-        buffer.open(QIODevice::WriteOnly);
-        previewImage.save(&buffer, "PNG");
-        buffer.close();
-        ui->previewButton->setToolTip("<img src=data:image/png;base64," + imageData.toBase64() + "/>");
+        const auto onReady = [this](const QByteArray& png) { onPreviewTooltipReady(png); };
+        ThumbnailCache::getInstance().requestPreview(fileInfo.filePath, desktopSize.size() / 2,
+                                                     this, onReady);
+    }
+
+    return true;
+}
+
+void FileTransferWidget::onPreviewTooltipReady(const QByteArray& png)
+{
+    const QString toolTip = "<img src=data:image/png;base64," + png.toBase64() + "/>";
+    ui->previewButton->setToolTip(toolTip);
+    if (ui->previewButton->underMouse()) {
+        QToolTip::showText(QCursor::pos(), toolTip, ui->previewButton);
     }
 }
 
@@ -560,31 +568,6 @@ void FileTransferWidget::onPreviewButtonClicked()
     handleButton(ui->previewButton);
 }
 
-QPixmap FileTransferWidget::scaleCropIntoSquare(const QPixmap& source, const int targetSize)
-{
-    QPixmap result;
-
-    // Make sure smaller-than-icon images (at least one dimension is smaller) will not be
-    // upscaled
-    if (source.width() < targetSize || source.height() < targetSize) {
-        result = source;
-    } else {
-        result = source.scaled(targetSize, targetSize, Qt::KeepAspectRatioByExpanding,
-                               Qt::SmoothTransformation);
-    }
-
-    // Then, image has to be cropped (if needed) so it will not overflow rectangle
-    // Only one dimension will be bigger after Qt::KeepAspectRatioByExpanding
-    if (result.width() > targetSize) {
-        return result.copy((result.width() - targetSize) / 2, 0, targetSize, targetSize);
-    } else if (result.height() > targetSize) {
-        return result.copy(0, (result.height() - targetSize) / 2, targetSize, targetSize);
-    }
-
-    // Picture was rectangle in the first place, no cropping
-    return result;
-}
-
 void FileTransferWidget::updateWidget(ToxFile const& file)
 {
     assert(file == fileInfo);
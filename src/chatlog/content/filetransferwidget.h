@@ -63,6 +63,7 @@ protected:
     bool drawButtonAreaNeeded() const;
 
     void paintEvent(QPaintEvent*) final;
+    bool eventFilter(QObject* watched, QEvent* event) final;
 
 public slots:
     void reloadTheme();
@@ -71,9 +72,10 @@ private slots:
     void onLeftButtonClicked();
     void onRightButtonClicked();
     void onPreviewButtonClicked();
+    void onPreviewIconReady(const QImage& icon);
+    void onPreviewTooltipReady(const QByteArray& png);
 
 private:
-    static QPixmap scaleCropIntoSquare(const QPixmap& source, int targetSize);
     static int getExifOrientation(const char* data, const int size);
     static void applyTransformation(const int oritentation, QImage& image);
     static bool tryRemoveFile(const QString &filepath);
@@ -94,5 +96,6 @@ private:
 
     bool active;
     ToxFile::FileStatus lastStatus = ToxFile::INITIALIZING;
+    bool previewTooltipRequested = false;
 
 };
@@ -642,7 +642,7 @@ ToxCorePtr Core::makeToxCore(const QByteArray& savedata, const ICoreSettings* co
         return {};
     }
 
-    core->ext = CoreExt::makeCoreExt(core->tox.get());
+    core->ext = CoreExt::makeCoreExt(core->tox.get(), core->coreLoopLock);
     connect(core.get(), &Core::friendStatusChanged, core->ext.get(), &CoreExt::onFriendStatusChanged);
 
     registerCallbacks(core->tox.get());
@@ -730,6 +730,14 @@ CoreExt* Core::getExt()
     return ext.get();
 }
 
+/**
+ * @brief Iteration rate, core loop lock hold time and toxcore callback cost.
+ */
+CoreLoopMetrics& Core::getLoopMetrics()
+{
+    return loopMetrics;
+}
+
 /* Using the now commented out statements in checkConnection(), I watched how
  * many ticks disconnects-after-initial-connect lasted. Out of roughly 15 trials,
  * 5 disconnected; 4 were DCd for less than 20 ticks, while the 5th was ~50 ticks.
@@ -739,18 +747,26 @@ CoreExt* Core::getExt()
  */
 #define CORE_DISCONNECT_TOLERANCE 30
 
+/* The lock is held for a few hundred microseconds when the loop is healthy, an iteration holding
+ * it longer than this stalls the GUI thread waiting on it, so the loop metrics get logged.
+ */
+#define CORE_SLOW_LOCK_HOLD_US 100000
+
 /**
  * @brief Processes toxcore events and ensure we stay connected, called by its own timer
  */
 void Core::process()
 {
     QMutexLocker ml{&coreLoopLock};
+    QElapsedTimer lockHold;
+    lockHold.start();
 
     ASSERT_CORE_THREAD;
 
     static int tolerance = CORE_DISCONNECT_TOLERANCE;
     tox_iterate(tox.get(), this);
     ext->process();
+    file->process();
 
 #ifdef DEBUG
     // we want to see the debug messages immediately
@@ -768,6 +784,20 @@ void Core::process()
     unsigned sleeptime =
         qMin(tox_iteration_interval(tox.get()), getCoreFile()->corefileIterationInterval());
     toxTimer->start(sleeptime);
+
+    if (!loopClock.isValid()) {
+        loopClock.start();
+    }
+    if (loopMetrics.addIteration(loopClock.elapsed(), lockHold.nsecsElapsed())) {
+        const CoreLoopMetrics::Snapshot metrics = loopMetrics.getSnapshot();
+        if (metrics.maxLockHoldUs >= CORE_SLOW_LOCK_HOLD_US) {
+            qWarning().nospace() << "Slow core loop: " << metrics.iterationsPerSecond
+                                 << " iterations/s, lock held " << metrics.averageLockHoldUs
+                                 << "us on average and " << metrics.maxLockHoldUs << "us at most, "
+                                 << metrics.callbacks << " callbacks taking "
+                                 << metrics.averageCallbackNs << "ns on average";
+        }
+    }
 }
 
 bool Core::checkConnection()
@@ -860,6 +890,7 @@ void Core::bootstrapDht()
 void Core::onFriendRequest(Tox*, const uint8_t* cFriendPk, const uint8_t* cMessage,
                            size_t cMessageSize, void* core)
 {
+    const CoreLoopMetrics::CallbackScope callbackScope{static_cast<Core*>(core)->loopMetrics};
     ToxPk friendPk(cFriendPk);
     QString requestMessage = ToxString(cMessage, cMessageSize).getQString();
     emit static_cast<Core*>(core)->friendRequestReceived(friendPk, requestMessage);
@@ -868,6 +899,7 @@ void Core::onFriendRequest(Tox*, const uint8_t* cFriendPk, const uint8_t* cMessa
 void Core::onFriendMessage(Tox*, uint32_t friendId, Tox_Message_Type type, const uint8_t* cMessage,
                            size_t cMessageSize, void* core)
 {
+    const CoreLoopMetrics::CallbackScope callbackScope{static_cast<Core*>(core)->loopMetrics};
     bool isAction = (type == TOX_MESSAGE_TYPE_ACTION);
     QString msg = ToxString(cMessage, cMessageSize).getQString();
     emit static_cast<Core*>(core)->friendMessageReceived(friendId, msg, isAction);
@@ -875,6 +907,7 @@ void Core::onFriendMessage(Tox*, uint32_t friendId, Tox_Message_Type type, const
 
 void Core::onFriendNameChange(Tox*, uint32_t friendId, const uint8_t* cName, size_t cNameSize, void* core)
 {
+    const CoreLoopMetrics::CallbackScope callbackScope{static_cast<Core*>(core)->loopMetrics};
     QString newName = ToxString(cName, cNameSize).getQString();
     // no saveRequest, this callback is called on every connection, not just on name change
     emit static_cast<Core*>(core)->friendUsernameChanged(friendId, newName);
@@ -882,12 +915,14 @@ void Core::onFriendNameChange(Tox*, uint32_t friendId, const uint8_t* cName, siz
 
 void Core::onFriendTypingChange(Tox*, uint32_t friendId, bool isTyping, void* core)
 {
+    const CoreLoopMetrics::CallbackScope callbackScope{static_cast<Core*>(core)->loopMetrics};
     emit static_cast<Core*>(core)->friendTypingChanged(friendId, isTyping);
 }
 
 void Core::onStatusMessageChanged(Tox*, uint32_t friendId, const uint8_t* cMessage,
                                   size_t cMessageSize, void* core)
 {
+    const CoreLoopMetrics::CallbackScope callbackScope{static_cast<Core*>(core)->loopMetrics};
     QString message = ToxString(cMessage, cMessageSize).getQString();
     // no saveRequest, this callback is called on every connection, not just on name change
     emit static_cast<Core*>(core)->friendStatusMessageChanged(friendId, message);
@@ -895,6 +930,7 @@ void Core::onStatusMessageChanged(Tox*, uint32_t friendId, const uint8_t* cMessa
 
 void Core::onUserStatusChanged(Tox*, uint32_t friendId, Tox_User_Status userstatus, void* core)
 {
+    const CoreLoopMetrics::CallbackScope callbackScope{static_cast<Core*>(core)->loopMetrics};
     Status::Status status;
     switch (userstatus) {
     case TOX_USER_STATUS_AWAY:
@@ -916,6 +952,7 @@ void Core::onUserStatusChanged(Tox*, uint32_t friendId, Tox_User_Status userstat
 
 void Core::onConnectionStatusChanged(Tox*, uint32_t friendId, Tox_Connection status, void* vCore)
 {
+    const CoreLoopMetrics::CallbackScope callbackScope{static_cast<Core*>(vCore)->loopMetrics};
     Core* core = static_cast<Core*>(vCore);
     Status::Status friendStatus;
     switch (status)
@@ -946,6 +983,7 @@ void Core::onConnectionStatusChanged(Tox*, uint32_t friendId, Tox_Connection sta
 void Core::onGroupInvite(Tox* tox, uint32_t friendId, Tox_Conference_Type type,
                          const uint8_t* cookie, size_t length, void* vCore)
 {
+    const CoreLoopMetrics::CallbackScope callbackScope{static_cast<Core*>(vCore)->loopMetrics};
     Core* core = static_cast<Core*>(vCore);
     const QByteArray data(reinterpret_cast<const char*>(cookie), length);
     const GroupInvite inviteInfo(friendId, type, data);
@@ -968,6 +1006,7 @@ void Core::onGroupInvite(Tox* tox, uint32_t friendId, Tox_Conference_Type type,
 void Core::onGroupMessage(Tox*, uint32_t groupId, uint32_t peerId, Tox_Message_Type type,
                           const uint8_t* cMessage, size_t length, void* vCore)
 {
+    const CoreLoopMetrics::CallbackScope callbackScope{static_cast<Core*>(vCore)->loopMetrics};
     Core* core = static_cast<Core*>(vCore);
     bool isAction = type == TOX_MESSAGE_TYPE_ACTION;
     QString message = ToxString(cMessage, length).getQString();
@@ -976,6 +1015,7 @@ void Core::onGroupMessage(Tox*, uint32_t groupId, uint32_t peerId, Tox_Message_T
 
 void Core::onGroupPeerListChange(Tox*, uint32_t groupId, void* vCore)
 {
+    const CoreLoopMetrics::CallbackScope callbackScope{static_cast<Core*>(vCore)->loopMetrics};
     const auto core = static_cast<Core*>(vCore);
     qDebug() << QString("Group %1 peerlist changed").arg(groupId);
     // no saveRequest, this callback is called on every connection to group peer, not just on brand new peers
@@ -985,6 +1025,7 @@ void Core::onGroupPeerListChange(Tox*, uint32_t groupId, void* vCore)
 void Core::onGroupPeerNameChange(Tox*, uint32_t groupId, uint32_t peerId, const uint8_t* name,
                                  size_t length, void* vCore)
 {
+    const CoreLoopMetrics::CallbackScope callbackScope{static_cast<Core*>(vCore)->loopMetrics};
     const auto newName = ToxString(name, length).getQString();
     qDebug() << QString("Group %1, peer %2, name changed to %3").arg(groupId).arg(peerId).arg(newName);
     auto* core = static_cast<Core*>(vCore);
@@ -995,6 +1036,7 @@ void Core::onGroupPeerNameChange(Tox*, uint32_t groupId, uint32_t peerId, const
 void Core::onGroupTitleChange(Tox*, uint32_t groupId, uint32_t peerId, const uint8_t* cTitle,
                               size_t length, void* vCore)
 {
+    const CoreLoopMetrics::CallbackScope callbackScope{static_cast<Core*>(vCore)->loopMetrics};
     Core* core = static_cast<Core*>(vCore);
     QString author;
     // from tox.h: "If peer_number == UINT32_MAX, then author is unknown (e.g. initial joining the conference)."
@@ -1011,12 +1053,14 @@ void Core::onGroupTitleChange(Tox*, uint32_t groupId, uint32_t peerId, const uin
 void Core::onLosslessPacket(Tox*, uint32_t friendId,
                             const uint8_t* data, size_t length, void* vCore)
 {
+    const CoreLoopMetrics::CallbackScope callbackScope{static_cast<Core*>(vCore)->loopMetrics};
     Core* core = static_cast<Core*>(vCore);
     core->ext->onLosslessPacket(friendId, data, length);
 }
 
 void Core::onReadReceiptCallback(Tox*, uint32_t friendId, uint32_t receipt, void* core)
 {
+    const CoreLoopMetrics::CallbackScope callbackScope{static_cast<Core*>(core)->loopMetrics};
     emit static_cast<Core*>(core)->receiptRecieved(friendId, ReceiptNum{receipt});
 }
 
@@ -1090,35 +1134,39 @@ void Core::requestFriendship(const ToxId& friendId, const QString& message)
     }
 }
 
-bool Core::sendMessageWithType(uint32_t friendId, const QString& message, Tox_Message_Type type,
-                               ReceiptNum& receipt)
+FriendSendResult Core::sendMessageWithType(uint32_t friendId, const QString& message,
+                                           Tox_Message_Type type, ReceiptNum& receipt)
 {
-    int size = message.toUtf8().size();
-    auto maxSize = static_cast<int>(getMaxMessageSize());
+    // encode once, the size limit is in UTF-8 bytes
+    ToxString cMessage(message);
+    auto size = cMessage.size();
+    auto maxSize = getMaxMessageSize();
     if (size > maxSize) {
         assert(false);
         qCritical() << "Core::sendMessageWithType called with message of size:" << size
                     << "when max is:" << maxSize << ". Ignoring.";
-        return false;
+        return FriendSendResult::Failed;
     }
 
-    ToxString cMessage(message);
     Tox_Err_Friend_Send_Message error;
     receipt = ReceiptNum{tox_friend_send_message(tox.get(), friendId, type, cMessage.data(),
                                                  cMessage.size(), &error)};
     if (PARSE_ERR(error)) {
-        return true;
+        return FriendSendResult::Sent;
     }
-    return false;
+
+    // Only a full send queue goes away by waiting for toxcore
+    return error == TOX_ERR_FRIEND_SEND_MESSAGE_SENDQ ? FriendSendResult::QueueFull
+                                                      : FriendSendResult::Failed;
 }
 
-bool Core::sendMessage(uint32_t friendId, const QString& message, ReceiptNum& receipt)
+FriendSendResult Core::sendMessage(uint32_t friendId, const QString& message, ReceiptNum& receipt)
 {
     QMutexLocker ml(&coreLoopLock);
     return sendMessageWithType(friendId, message, TOX_MESSAGE_TYPE_NORMAL, receipt);
 }
 
-bool Core::sendAction(uint32_t friendId, const QString& action, ReceiptNum& receipt)
+FriendSendResult Core::sendAction(uint32_t friendId, const QString& action, ReceiptNum& receipt)
 {
     QMutexLocker ml(&coreLoopLock);
     return sendMessageWithType(friendId, action, TOX_MESSAGE_TYPE_ACTION, receipt);
@@ -1139,15 +1187,15 @@ void Core::sendGroupMessageWithType(int groupId, const QString& message, Tox_Mes
 {
     QMutexLocker ml{&coreLoopLock};
 
-    int size = message.toUtf8().size();
-    auto maxSize = static_cast<int>(getMaxMessageSize());
+    ToxString cMsg(message);
+    auto size = cMsg.size();
+    auto maxSize = getMaxMessageSize();
     if (size > maxSize) {
         qCritical() << "Core::sendMessageWithType called with message of size:" << size
                     << "when max is:" << maxSize << ". Ignoring.";
         return;
     }
 
-    ToxString cMsg(message);
     Tox_Err_Conference_Send_Message error;
     tox_conference_send_message(tox.get(), groupId, type, cMsg.data(), cMsg.size(), &error);
     if (!PARSE_ERR(error)) {
@@ -1405,24 +1453,47 @@ void Core::loadFriends()
     std::vector<uint32_t> ids(friendCount);
     tox_self_get_friend_list(tox.get(), ids.data());
     uint8_t friendPk[TOX_PUBLIC_KEY_SIZE] = {0x00};
+    std::vector<uint8_t> buffer;
+
+    // Collect everything in one pass and hand it over in one signal, instead of queueing
+    // several signals per friend
+    QVector<FriendSnapshot> friends;
+    friends.reserve(static_cast<int>(friendCount));
     for (size_t i = 0; i < friendCount; ++i) {
         Tox_Err_Friend_Get_Public_Key keyError;
         tox_friend_get_public_key(tox.get(), ids[i], friendPk, &keyError);
         if (!PARSE_ERR(keyError)) {
             continue;
         }
-        emit friendAdded(ids[i], ToxPk(friendPk));
-        emit friendUsernameChanged(ids[i], getFriendUsername(ids[i]));
+
+        FriendSnapshot snapshot;
+        snapshot.friendId = ids[i];
+        snapshot.publicKey = ToxPk(friendPk);
+
         Tox_Err_Friend_Query queryError;
-        size_t statusMessageSize = tox_friend_get_status_message_size(tox.get(), ids[i], &queryError);
+        const size_t nameSize = tox_friend_get_name_size(tox.get(), ids[i], &queryError);
+        if (PARSE_ERR(queryError) && nameSize) {
+            buffer.resize(nameSize);
+            tox_friend_get_name(tox.get(), ids[i], buffer.data(), &queryError);
+            if (PARSE_ERR(queryError)) {
+                snapshot.username = ToxString(buffer.data(), nameSize).getQString();
+            }
+        }
+
+        const size_t statusMessageSize =
+            tox_friend_get_status_message_size(tox.get(), ids[i], &queryError);
         if (PARSE_ERR(queryError) && statusMessageSize) {
-            std::vector<uint8_t> messageData(statusMessageSize);
-            tox_friend_get_status_message(tox.get(), ids[i], messageData.data(), &queryError);
-            QString friendStatusMessage = ToxString(messageData.data(), statusMessageSize).getQString();
-            emit friendStatusMessageChanged(ids[i], friendStatusMessage);
+            buffer.resize(statusMessageSize);
+            tox_friend_get_status_message(tox.get(), ids[i], buffer.data(), &queryError);
+            if (PARSE_ERR(queryError)) {
+                snapshot.statusMessage = ToxString(buffer.data(), statusMessageSize).getQString();
+            }
         }
-        checkLastOnline(ids[i]);
+
+        friends.append(snapshot);
     }
+
+    emit friendsLoaded(friends);
 }
 
 void Core::loadGroups()
@@ -1597,6 +1668,49 @@ QStringList Core::getGroupPeerNames(int groupId) const
     return names;
 }
 
+/**
+ * @brief Get the public keys and names of all peers of a group
+ *
+ * Reads all peers while holding the core loop lock once, so the result is consistent.
+ */
+QVector<GroupPeer> Core::getGroupPeers(int groupId) const
+{
+    QMutexLocker ml{&coreLoopLock};
+
+    assert(tox != nullptr);
+
+    Tox_Err_Conference_Peer_Query error;
+    const uint32_t nPeers = tox_conference_peer_count(tox.get(), groupId, &error);
+    if (!PARSE_ERR(error)) {
+        qWarning() << "getGroupPeers: Unable to get number of peers";
+        return {};
+    }
+
+    QVector<GroupPeer> peers;
+    peers.reserve(static_cast<int>(nPeers));
+    std::vector<uint8_t> nameBuf;
+    for (uint32_t i = 0; i < nPeers; ++i) {
+        uint8_t peerPk[TOX_PUBLIC_KEY_SIZE] = {0x00};
+        tox_conference_peer_get_public_key(tox.get(), groupId, i, peerPk, &error);
+        if (!PARSE_ERR(error)) {
+            continue;
+        }
+
+        GroupPeer peer{ToxPk(peerPk), QString{}};
+        const size_t length = tox_conference_peer_get_name_size(tox.get(), groupId, i, &error);
+        if (PARSE_ERR(error) && length) {
+            nameBuf.resize(length);
+            tox_conference_peer_get_name(tox.get(), groupId, i, nameBuf.data(), &error);
+            if (PARSE_ERR(error)) {
+                peer.name = ToxString(nameBuf.data(), length).getQString();
+            }
+        }
+        peers.append(peer);
+    }
+
+    return peers;
+}
+
 /**
  * @brief Check, that group has audio or video stream
  * @param groupId Id of group to check
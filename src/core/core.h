@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include "coreloopmetrics.h"
+#include "friendsnapshot.h"
 #include "groupid.h"
 #include "icorefriendmessagesender.h"
 #include "icoregroupmessagesender.h"
@@ -34,6 +36,7 @@
 #include "src/model/status.h"
 #include <tox/tox.h>
 
+#include <QElapsedTimer>
 #include <QMutex>
 #include <QObject>
 #include <QThread>
@@ -82,6 +85,7 @@ public:
 
     const CoreExt* getExt() const;
     CoreExt* getExt();
+    CoreLoopMetrics& getLoopMetrics();
     ~Core();
 
     static const QString TOX_EXT;
@@ -93,6 +97,7 @@ public:
     QString getGroupPeerName(int groupId, int peerId) const override;
     ToxPk getGroupPeerPk(int groupId, int peerId) const override;
     QStringList getGroupPeerNames(int groupId) const override;
+    QVector<GroupPeer> getGroupPeers(int groupId) const override;
     bool getGroupAvEnabled(int groupId) const override;
     ToxPk getFriendPublicKey(uint32_t friendNumber) const;
     QString getFriendUsername(uint32_t friendNumber) const;
@@ -128,11 +133,13 @@ public slots:
     void setUsername(const QString& username);
     void setStatusMessage(const QString& message);
 
-    bool sendMessage(uint32_t friendId, const QString& message, ReceiptNum& receipt) override;
+    FriendSendResult sendMessage(uint32_t friendId, const QString& message,
+                                 ReceiptNum& receipt) override;
     void sendGroupMessage(int groupId, const QString& message) override;
     void sendGroupAction(int groupId, const QString& message) override;
     void changeGroupTitle(int groupId, const QString& title);
-    bool sendAction(uint32_t friendId, const QString& action, ReceiptNum& receipt) override;
+    FriendSendResult sendAction(uint32_t friendId, const QString& action,
+                                ReceiptNum& receipt) override;
     void sendTyping(uint32_t friendId, bool typing);
 
     void setNospam(uint32_t nospam);
@@ -168,6 +175,7 @@ signals:
 
     void friendMessageReceived(uint32_t friendId, const QString& message, bool isAction);
     void friendAdded(uint32_t friendId, const ToxPk& friendPk);
+    void friendsLoaded(const QVector<FriendSnapshot>& friends);
 
     void friendStatusChanged(uint32_t friendId, Status::Status status);
     void friendStatusMessageChanged(uint32_t friendId, const QString& message);
@@ -224,7 +232,8 @@ private:
     static void onReadReceiptCallback(Tox* tox, uint32_t friendId, uint32_t receipt, void* core);
 
     void sendGroupMessageWithType(int groupId, const QString& message, Tox_Message_Type type);
-    bool sendMessageWithType(uint32_t friendId, const QString& message, Tox_Message_Type type, ReceiptNum& receipt);
+    FriendSendResult sendMessageWithType(uint32_t friendId, const QString& message,
+                                         Tox_Message_Type type, ReceiptNum& receipt);
     bool checkConnection();
 
     void makeTox(QByteArray savedata, ICoreSettings* s);
@@ -259,6 +268,8 @@ private:
     QTimer* toxTimer = nullptr;
     // recursive, since we might call our own functions
     mutable QMutex coreLoopLock{QMutex::Recursive};
+    CoreLoopMetrics loopMetrics;
+    QElapsedTimer loopClock;
 
     std::unique_ptr<QThread> coreThread;
     IBootstrapListGenerator& bootstrapNodes;
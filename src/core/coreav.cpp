@@ -78,6 +78,7 @@ CoreAV::CoreAV(std::unique_ptr<ToxAV, ToxAVDeleter> toxav, QMutex& toxCoreLock,
     , coreLock{toxCoreLock}
     , audioSettings{_audioSettings}
     , groupSettings{_groupSettings}
+    , blockedPeers{_groupSettings.getPeerBlackList()}
 {
     assert(coreavThread);
     assert(iterateTimer);
@@ -92,6 +93,8 @@ CoreAV::CoreAV(std::unique_ptr<ToxAV, ToxAVDeleter> toxav, QMutex& toxCoreLock,
     connect(iterateTimer, &QTimer::timeout, this, &CoreAV::process);
     connect(coreavThread.get(), &QThread::finished, iterateTimer, &QTimer::stop);
     connect(coreavThread.get(), &QThread::started, this, &CoreAV::process);
+
+    pacingClock.start();
 }
 
 void CoreAV::connectCallbacks(ToxAV& toxav)
@@ -306,7 +309,11 @@ bool CoreAV::cancelCall(uint32_t friendNum)
         return false;
     }
 
-    calls.erase(friendNum);
+    auto it = calls.find(friendNum);
+    if (it != calls.end()) {
+        logVideoSendStats(friendNum, *it->second);
+        calls.erase(it);
+    }
     locker.unlock();
 
     emit avEnd(friendNum);
@@ -372,7 +379,8 @@ bool CoreAV::sendCallAudio(uint32_t callId, const int16_t* pcm, size_t samples,
 
 void CoreAV::sendCallVideo(uint32_t callId, std::shared_ptr<VideoFrame> vframe)
 {
-    QWriteLocker locker{&callsLock};
+    // Only reads the call, its pacer and bitrate flag can be used concurrently
+    QReadLocker locker{&callsLock};
 
     // We might be running in the FFmpeg thread and holding the CameraSource lock
     // So be careful not to deadlock with anything while toxav locks in toxav_video_send_frame
@@ -388,16 +396,32 @@ void CoreAV::sendCallVideo(uint32_t callId, std::shared_ptr<VideoFrame> vframe)
         return;
     }
 
-    if (call.getNullVideoBitrate()) {
+    VideoEncodePacer& pacer = call.getVideoPacer();
+    const bool restart = call.getNullVideoBitrate();
+    if (restart) {
         qDebug() << "Restarting video stream to friend" << callId;
-        QMutexLocker coreLocker{&coreLock};
-        toxav_video_set_bit_rate(toxav.get(), callId, VIDEO_DEFAULT_BITRATE, nullptr);
         call.setNullVideoBitrate(false);
+        pacer.setBitrate(VIDEO_DEFAULT_BITRATE);
     }
 
-    ToxYUVFrame frame = vframe->toToxYUVFrame();
+    // The bitrate toxav recommended last, or the default one when restarting
+    uint32_t bitrate = VIDEO_DEFAULT_BITRATE;
+    if (pacer.takeBitrateChange(bitrate) || restart) {
+        QMutexLocker coreLocker{&coreLock};
+        toxav_video_set_bit_rate(toxav.get(), callId, bitrate, nullptr);
+    }
+
+    // Drop frames the bitrate has no room for, before spending time on converting them
+    if (!pacer.beginFrame(pacingClock.elapsed())) {
+        return;
+    }
+
+    QElapsedTimer encodeTimer;
+    encodeTimer.start();
+    ToxYUVFrame frame = vframe->toToxYUVFrame(pacer.getFrameSize(vframe->getSourceDimensions().size()));
 
     if (!frame) {
+        pacer.endFrame(false, 0);
         return;
     }
 
@@ -419,6 +443,39 @@ void CoreAV::sendCallVideo(uint32_t callId, std::shared_ptr<VideoFrame> vframe)
     if (err == TOXAV_ERR_SEND_FRAME_SYNC) {
         qDebug() << "toxav_video_send_frame error: Lock busy, dropping frame";
     }
+
+    pacer.endFrame(err == TOXAV_ERR_SEND_FRAME_OK, encodeTimer.nsecsElapsed());
+}
+
+/**
+ * @brief Returns the frame rate, dropped frames and encode time of the video sent in a call.
+ */
+VideoEncodePacer::Stats CoreAV::getVideoSendStats(uint32_t friendNum) const
+{
+    QReadLocker locker{&callsLock};
+
+    auto it = calls.find(friendNum);
+    if (it == calls.end()) {
+        return {};
+    }
+
+    return it->second->getVideoPacer().getStats();
+}
+
+/**
+ * @brief Logs the stats of getVideoSendStats when a call with video ends.
+ * @note Callers hold callsLock for writing, which can't be locked for reading again.
+ */
+void CoreAV::logVideoSendStats(uint32_t friendNum, const ToxFriendCall& call)
+{
+    const VideoEncodePacer::Stats stats = call.getVideoPacer().getStats();
+    if (stats.framesPerSecond == 0.0 && stats.droppedFrames == 0) {
+        return;
+    }
+
+    qDebug() << "Video sent to friend" << friendNum << "at" << stats.framesPerSecond << "fps,"
+             << stats.droppedFrames << "frames dropped," << stats.averageEncodeUs
+             << "us to encode a frame on average";
 }
 
 /**
@@ -482,7 +539,7 @@ void CoreAV::groupCallCallback(void* tox, uint32_t group, uint32_t peer, const i
 
     const ToxPk peerPk = c->getGroupPeerPk(group, peer);
     // don't play the audio if it comes from a muted peer
-    if (cav->groupSettings.getBlackList().contains(peerPk.toString())) {
+    if (cav->blockedPeers.contains(peerPk)) {
         return;
     }
 
@@ -766,11 +823,13 @@ void CoreAV::stateCallback(ToxAV* toxav, uint32_t friendNum, uint32_t state, voi
 
     if (state & TOXAV_FRIEND_CALL_STATE_ERROR) {
         qWarning() << "Call with friend" << friendNum << "died of unnatural causes!";
+        logVideoSendStats(friendNum, call);
         self->calls.erase(friendNum);
         locker.unlock();
         emit self->avEnd(friendNum, true);
     } else if (state & TOXAV_FRIEND_CALL_STATE_FINISHED) {
         qDebug() << "Call with friend" << friendNum << "finished quietly";
+        logVideoSendStats(friendNum, call);
         self->calls.erase(friendNum);
         locker.unlock();
         emit self->avEnd(friendNum);
@@ -828,14 +887,19 @@ void CoreAV::audioBitrateCallback(ToxAV* toxav, uint32_t friendNum, uint32_t rat
     qDebug() << "Recommended audio bitrate with" << friendNum << " is now " << rate << ", ignoring it";
 }
 
-// This is only a dummy implementation for now
 void CoreAV::videoBitrateCallback(ToxAV* toxav, uint32_t friendNum, uint32_t rate, void* vSelf)
 {
     CoreAV* self = static_cast<CoreAV*>(vSelf);
-    Q_UNUSED(self)
     Q_UNUSED(toxav)
 
-    qDebug() << "Recommended video bitrate with" << friendNum << " is now " << rate << ", ignoring it";
+    qDebug() << "Recommended video bitrate with" << friendNum << " is now " << rate;
+
+    // Applied with the next frame sent, toxav functions can't be called from its callbacks
+    QReadLocker locker{&self->callsLock};
+    auto it = self->calls.find(friendNum);
+    if (it != self->calls.end() && rate > 0) {
+        it->second->getVideoPacer().setBitrate(rate);
+    }
 }
 
 void CoreAV::audioFrameCallback(ToxAV*, uint32_t friendNum, const int16_t* pcm, size_t sampleCount,
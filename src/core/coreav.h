@@ -21,7 +21,9 @@
 #pragma once
 
 #include "src/core/toxcall.h"
+#include "src/persistence/peerblacklist.h"
 
+#include <QElapsedTimer>
 #include <QObject>
 #include <QMutex>
 #include <QReadWriteLock>
@@ -49,6 +51,9 @@ class CoreAV : public QObject
 
 public:
     using CoreAVPtr = std::unique_ptr<CoreAV>;
+
+    static constexpr uint32_t VIDEO_DEFAULT_BITRATE = 2500;
+
     static CoreAVPtr makeCoreAV(Tox* core, QMutex& toxCoreLock,
                                 IAudioSettings& audioSettings, IGroupSettings& groupSettings);
 
@@ -65,6 +70,7 @@ public:
     bool sendCallAudio(uint32_t friendNum, const int16_t* pcm, size_t samples, uint8_t chans,
                        uint32_t rate) const;
     void sendCallVideo(uint32_t friendNum, std::shared_ptr<VideoFrame> frame);
+    VideoEncodePacer::Stats getVideoSendStats(uint32_t friendNum) const;
     bool sendGroupCallAudio(int groupNum, const int16_t* pcm, size_t samples, uint8_t chans,
                             uint32_t rate) const;
 
@@ -119,6 +125,7 @@ private:
     CoreAV(std::unique_ptr<ToxAV, ToxAVDeleter> tox, QMutex &toxCoreLock,
            IAudioSettings& _audioSettings, IGroupSettings& _groupSettings);
     void connectCallbacks(ToxAV& toxav);
+    static void logVideoSendStats(uint32_t friendNum, const ToxFriendCall& call);
 
     void process();
     static void audioFrameCallback(ToxAV* toxAV, uint32_t friendNum, const int16_t* pcm,
@@ -128,9 +135,6 @@ private:
                                    const uint8_t* y, const uint8_t* u, const uint8_t* v,
                                    int32_t ystride, int32_t ustride, int32_t vstride, void* self);
 
-private:
-    static constexpr uint32_t VIDEO_DEFAULT_BITRATE = 2500;
-
 private:
     // atomic because potentially accessed by different threads
     std::atomic<IAudioControl*> audio;
@@ -164,4 +168,8 @@ private:
 
     IAudioSettings& audioSettings;
     IGroupSettings& groupSettings;
+    // only used from the Core thread
+    PeerBlackList::Reader blockedPeers;
+    // monotonic time the video pacing of all calls is based on
+    QElapsedTimer pacingClock;
 };
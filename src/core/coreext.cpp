@@ -32,18 +32,19 @@ extern "C" {
 #include <tox_extension_messages.h>
 }
 
-std::unique_ptr<CoreExt> CoreExt::makeCoreExt(Tox* core) {
+std::unique_ptr<CoreExt> CoreExt::makeCoreExt(Tox* core, QMutex& coreLoopLock) {
     auto toxExtPtr = toxext_init(core);
     if (!toxExtPtr) {
         return nullptr;
     }
 
     auto toxExt = ExtensionPtr<ToxExt>(toxExtPtr, toxext_free);
-    return std::unique_ptr<CoreExt>(new CoreExt(std::move(toxExt)));
+    return std::unique_ptr<CoreExt>(new CoreExt(std::move(toxExt), coreLoopLock));
 }
 
-CoreExt::CoreExt(ExtensionPtr<ToxExt> toxExt_)
-    : toxExt(std::move(toxExt_))
+CoreExt::CoreExt(ExtensionPtr<ToxExt> toxExt_, QMutex& coreLoopLock)
+    : coreLoopLock(&coreLoopLock)
+    , toxExt(std::move(toxExt_))
     , toxExtMessages(nullptr, nullptr)
 {
     toxExtMessages = ExtensionPtr<ToxExtensionMessages>(
@@ -71,19 +72,24 @@ void CoreExt::onLosslessPacket(uint32_t friendId, const uint8_t* data, size_t le
 
 CoreExt::Packet::Packet(
     ToxExtPacketList* packetList,
-    ToxExtensionMessages* toxExtMessages,
+    CoreExt& coreExt,
     uint32_t friendId,
     PacketPassKey)
-    : toxExtMessages(toxExtMessages)
+    : coreExt(coreExt)
     , packetList(packetList)
     , friendId(friendId)
 {}
 
+/**
+ * Several messages can be added to the same packet, toxext fills each lossless packet up
+ * to its max size before it starts the next one, so batching messages saves packets.
+ */
 std::unique_ptr<ICoreExtPacket> CoreExt::getPacket(uint32_t friendId)
 {
+    QMutexLocker locker{coreLoopLock};
     return std::unique_ptr<Packet>(new Packet(
         toxext_packet_list_create(toxExt.get(), friendId),
-        toxExtMessages.get(),
+        *this,
         friendId,
         PacketPassKey{}));
 }
@@ -98,12 +104,10 @@ uint64_t CoreExt::Packet::addExtendedMessage(QString message)
         return UINT64_MAX;
     }
 
-    int size = message.toUtf8().size();
-    enum Tox_Extension_Messages_Error err;
-    auto maxSize = static_cast<int>(tox_extension_messages_get_max_sending_size(
-        toxExtMessages,
-        friendId,
-        &err));
+    ToxString toxString(message);
+    auto size = toxString.size();
+    QMutexLocker locker{coreExt.coreLoopLock};
+    auto maxSize = coreExt.getMaxSendingSize(friendId);
 
     if (size > maxSize) {
         assert(false);
@@ -112,9 +116,9 @@ uint64_t CoreExt::Packet::addExtendedMessage(QString message)
         return false;
     }
 
-    ToxString toxString(message);
+    enum Tox_Extension_Messages_Error err;
     const auto receipt = tox_extension_messages_append(
-        toxExtMessages,
+        coreExt.toxExtMessages.get(),
         packetList,
         toxString.data(),
         toxString.size(),
@@ -130,6 +134,7 @@ uint64_t CoreExt::Packet::addExtendedMessage(QString message)
 
 bool CoreExt::Packet::send()
 {
+    QMutexLocker locker{coreExt.coreLoopLock};
     auto ret = toxext_send(packetList);
     if (ret != TOXEXT_SUCCESS) {
         qWarning() << "Failed to send packet";
@@ -145,6 +150,20 @@ uint64_t CoreExt::getMaxExtendedMessageSize()
     return TOX_EXTENSION_MESSAGES_DEFAULT_MAX_RECEIVING_MESSAGE_SIZE;
 }
 
+/**
+ * @brief Max size of a message to friendId, only called with the core loop lock held.
+ */
+uint64_t CoreExt::getMaxSendingSize(uint32_t friendId)
+{
+    const auto it = maxSendingSizes.find(friendId);
+    if (it != maxSendingSizes.end()) {
+        return it->second;
+    }
+
+    enum Tox_Extension_Messages_Error err;
+    return tox_extension_messages_get_max_sending_size(toxExtMessages.get(), friendId, &err);
+}
+
 void CoreExt::onFriendStatusChanged(uint32_t friendId, Status::Status status)
 {
     const auto prevStatusIt = currentStatuses.find(friendId);
@@ -157,15 +176,21 @@ void CoreExt::onFriendStatusChanged(uint32_t friendId, Status::Status status)
     // constructed. In this case we should still ensure the rest of the system
     // knows there is no extension support
     if (status == Status::Status::Offline) {
+        {
+            QMutexLocker locker{coreLoopLock};
+            maxSendingSizes.erase(friendId);
+        }
         emit extendedMessageSupport(friendId, false);
     } else if (prevStatus == Status::Status::Offline) {
+        QMutexLocker locker{coreLoopLock};
         tox_extension_messages_negotiate(toxExtMessages.get(), friendId);
     }
 }
 
 void CoreExt::onExtendedMessageReceived(uint32_t friendId, const uint8_t* data, size_t size, void* userData)
 {
-    QString msg = ToxString(data, size).getQString();
+    // decode straight from the toxext buffer instead of copying it first
+    QString msg = QString::fromUtf8(reinterpret_cast<const char*>(data), static_cast<int>(size));
     emit static_cast<CoreExt*>(userData)->extendedMessageReceived(friendId, msg);
 }
 
@@ -186,6 +211,12 @@ void CoreExt::onExtendedMessageNegotiation(uint32_t friendId, bool compatible, u
     if (maxMessageSize < coreExt->getMaxExtendedMessageSize())
         compatible = false;
 
+    if (compatible) {
+        coreExt->maxSendingSizes[friendId] = maxMessageSize;
+    } else {
+        coreExt->maxSendingSizes.erase(friendId);
+    }
+
     emit coreExt->extendedMessageSupport(friendId, compatible);
 }
 
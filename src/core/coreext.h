@@ -24,6 +24,7 @@
 
 #include <QObject>
 #include <QMap>
+#include <QMutex>
 
 #include <bitset>
 #include <memory>
@@ -50,9 +51,10 @@ public:
      *  registrations with extensions significantly easier to manage
      *
      * @param[in] pointer to core tox instance
+     * @param[in] coreLoopLock lock that has to be held to call into toxext
      * @return CoreExt on success, nullptr on failure
      */
-    static std::unique_ptr<CoreExt> makeCoreExt(Tox* core);
+    static std::unique_ptr<CoreExt> makeCoreExt(Tox* core, QMutex& coreLoopLock);
 
     // We do registration with our own pointer, need to ensure we're in a stable location
     CoreExt(CoreExt const& other) = delete;
@@ -84,7 +86,7 @@ public:
          */
         Packet(
             ToxExtPacketList* packetList,
-            ToxExtensionMessages* toxExtMessages,
+            CoreExt& coreExt,
             uint32_t friendId,
             PacketPassKey);
 
@@ -92,12 +94,11 @@ public:
         Packet(Packet const& other) = delete;
 
         Packet(Packet&& other)
+            : coreExt{other.coreExt}
         {
-            toxExtMessages = other.toxExtMessages;
             packetList = other.packetList;
             friendId = other.friendId;
             hasBeenSent = other.hasBeenSent;
-            other.toxExtMessages = nullptr;
             other.packetList = nullptr;
             other.friendId = 0;
             other.hasBeenSent = false;
@@ -108,8 +109,7 @@ public:
         bool send() override;
     private:
         bool hasBeenSent = false;
-        // Note: non-owning pointer
-        ToxExtensionMessages* toxExtMessages;
+        CoreExt& coreExt;
         // Note: packetList is freed on send() call
         ToxExtPacketList* packetList;
         uint32_t friendId;
@@ -139,9 +139,14 @@ private:
     template <class T>
     using ExtensionPtr = std::unique_ptr<T, void(*)(T*)>;
 
-    CoreExt(ExtensionPtr<ToxExt> toxExt);
+    CoreExt(ExtensionPtr<ToxExt> toxExt, QMutex& coreLoopLock);
 
+    uint64_t getMaxSendingSize(uint32_t friendId);
+
+    QMutex* coreLoopLock = nullptr;
     std::unordered_map<uint32_t, Status::Status> currentStatuses;
+    // max message size each friend negotiated, saves asking toxext for every message
+    std::unordered_map<uint32_t, uint64_t> maxSendingSizes;
     ExtensionPtr<ToxExt> toxExt;
     ExtensionPtr<ToxExtensionMessages> toxExtMessages;
 };
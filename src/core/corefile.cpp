@@ -53,6 +53,16 @@ CoreFile::CoreFile(Tox *core, QMutex &coreLoopLock)
     : tox{core}
     , coreLoopLock{&coreLoopLock}
 {
+    progressClock.start();
+    fileIo.start();
+    connect(this, &CoreFile::fileWritesDrained, this, &CoreFile::onFileWritesDrained,
+            Qt::QueuedConnection);
+}
+
+CoreFile::~CoreFile()
+{
+    // finish pending writes while the signals of completed downloads can still be emitted
+    fileIo.stop();
 }
 
 /**
@@ -68,15 +78,52 @@ unsigned CoreFile::corefileIterationInterval()
        There is no real difference between 10ms sleep and 50ms sleep when it
        comes to CPU usage – just keep the CPU usage low when there are no file
        transfers, and speed things up when there is an ongoing file transfer.
+       As long as toxcore keeps requesting or delivering chunks its queues have
+       room, so iterate again soon instead of capping transfers at one round of
+       chunks per 10ms, but still yield the thread and the core loop lock.
     */
-    constexpr unsigned fileInterval = 10, idleInterval = 1000;
+    constexpr unsigned busyInterval = 1, fileInterval = 10, idleInterval = 1000;
+
+    if (activeTransfers == 0) {
+        return idleInterval;
+    }
+    return lastIterationChunks > 0 ? busyInterval : fileInterval;
+}
 
-    for (ToxFile& file : fileMap) {
-        if (file.status == ToxFile::TRANSMITTING) {
-            return fileInterval;
+/**
+ * @brief Sends chunks that have been read from disk since toxcore requested them and emits
+ * the progress of running transfers, at most once per aggregation interval.
+ *
+ * Called once per Core iteration.
+ */
+void CoreFile::process()
+{
+    QMutexLocker locker{coreLoopLock};
+
+    for (uint64_t key : deferredChunks.keys()) {
+        auto it = deferredChunks.find(key);
+        while (it != deferredChunks.end() && !it->isEmpty()) {
+            const ChunkRequest request = it->first();
+            if (!sendDataChunk(fileMap[key], request.pos, request.length)) {
+                break;
+            }
+            // sending may have failed and removed the transfer
+            it = deferredChunks.find(key);
+            if (it != deferredChunks.end()) {
+                it->removeFirst();
+            }
+        }
+        if (it != deferredChunks.end() && it->isEmpty()) {
+            deferredChunks.erase(it);
         }
     }
-    return idleInterval;
+
+    for (const ToxFileProgressInfo& info : progressAggregator.takeDue(progressClock.elapsed())) {
+        emit fileTransferInfo(info);
+    }
+
+    lastIterationChunks = iterationChunks;
+    iterationChunks = 0;
 }
 
 void CoreFile::connectCallbacks(Tox &tox)
@@ -90,7 +137,7 @@ void CoreFile::connectCallbacks(Tox &tox)
 
 void CoreFile::sendAvatarFile(uint32_t friendId, const QByteArray& data)
 {
-    QMutexLocker{coreLoopLock};
+    QMutexLocker locker{coreLoopLock};
 
     uint64_t filesize = 0;
     uint8_t *file_id = nullptr;
@@ -144,7 +191,7 @@ void CoreFile::sendAvatarFile(uint32_t friendId, const QByteArray& data)
 void CoreFile::sendFile(uint32_t friendId, QString filename, QString filePath,
                         long long filesize)
 {
-    QMutexLocker{coreLoopLock};
+    QMutexLocker locker{coreLoopLock};
 
     ToxString fileName(filename);
     Tox_Err_File_Send sendErr;
@@ -162,7 +209,9 @@ void CoreFile::sendFile(uint32_t friendId, QString filename, QString filePath,
     file.resumeFileId.resize(TOX_FILE_ID_LENGTH);
     tox_file_get_file_id(tox, friendId, fileNum, reinterpret_cast<uint8_t*>(file.resumeFileId.data()),
                          nullptr);
-    if (!file.open(false)) {
+    if (file.open(false)) {
+        fileIo.startSend(getFriendKey(friendId, fileNum), file.file, file.hashGenerator, filesize);
+    } else {
         qWarning() << QString("sendFile: Can't open file, error: %1").arg(file.file->errorString());
     }
 
@@ -173,7 +222,7 @@ void CoreFile::sendFile(uint32_t friendId, QString filename, QString filePath,
 
 void CoreFile::pauseResumeFile(uint32_t friendId, uint32_t fileId)
 {
-    QMutexLocker{coreLoopLock};
+    QMutexLocker locker{coreLoopLock};
 
     ToxFile* file = findFile(friendId, fileId);
     if (!file) {
@@ -189,13 +238,18 @@ void CoreFile::pauseResumeFile(uint32_t friendId, uint32_t fileId)
     file->pauseStatus.localPauseToggle();
 
     if (file->pauseStatus.paused()) {
-        file->status = ToxFile::PAUSED;
+        setStatus(*file, ToxFile::PAUSED);
         emit fileTransferPaused(*file);
     } else {
-        file->status = ToxFile::TRANSMITTING;
+        setStatus(*file, ToxFile::TRANSMITTING);
         emit fileTransferAccepted(*file);
     }
 
+    // a receive waiting for the disk stays paused in toxcore until its data is written
+    if (writePausedFiles.contains(getFriendKey(friendId, fileId))) {
+        return;
+    }
+
     if (file->pauseStatus.localPaused()) {
         tox_file_control(tox, file->friendId, file->fileNum, TOX_FILE_CONTROL_PAUSE,
                          nullptr);
@@ -207,7 +261,7 @@ void CoreFile::pauseResumeFile(uint32_t friendId, uint32_t fileId)
 
 void CoreFile::cancelFileSend(uint32_t friendId, uint32_t fileId)
 {
-    QMutexLocker{coreLoopLock};
+    QMutexLocker locker{coreLoopLock};
 
     ToxFile* file = findFile(friendId, fileId);
     if (!file) {
@@ -215,7 +269,7 @@ void CoreFile::cancelFileSend(uint32_t friendId, uint32_t fileId)
         return;
     }
 
-    file->status = ToxFile::CANCELED;
+    setStatus(*file, ToxFile::CANCELED);
     emit fileTransferCancelled(*file);
     tox_file_control(tox, file->friendId, file->fileNum, TOX_FILE_CONTROL_CANCEL, nullptr);
     removeFile(friendId, fileId);
@@ -223,14 +277,14 @@ void CoreFile::cancelFileSend(uint32_t friendId, uint32_t fileId)
 
 void CoreFile::cancelFileRecv(uint32_t friendId, uint32_t fileId)
 {
-    QMutexLocker{coreLoopLock};
+    QMutexLocker locker{coreLoopLock};
 
     ToxFile* file = findFile(friendId, fileId);
     if (!file) {
         qWarning("cancelFileRecv: No such file in queue");
         return;
     }
-    file->status = ToxFile::CANCELED;
+    setStatus(*file, ToxFile::CANCELED);
     emit fileTransferCancelled(*file);
     tox_file_control(tox, file->friendId, file->fileNum, TOX_FILE_CONTROL_CANCEL, nullptr);
     removeFile(friendId, fileId);
@@ -238,14 +292,14 @@ void CoreFile::cancelFileRecv(uint32_t friendId, uint32_t fileId)
 
 void CoreFile::rejectFileRecvRequest(uint32_t friendId, uint32_t fileId)
 {
-    QMutexLocker{coreLoopLock};
+    QMutexLocker locker{coreLoopLock};
 
     ToxFile* file = findFile(friendId, fileId);
     if (!file) {
         qWarning("rejectFileRecvRequest: No such file in queue");
         return;
     }
-    file->status = ToxFile::CANCELED;
+    setStatus(*file, ToxFile::CANCELED);
     emit fileTransferCancelled(*file);
     tox_file_control(tox, file->friendId, file->fileNum, TOX_FILE_CONTROL_CANCEL, nullptr);
     removeFile(friendId, fileId);
@@ -253,7 +307,7 @@ void CoreFile::rejectFileRecvRequest(uint32_t friendId, uint32_t fileId)
 
 void CoreFile::acceptFileRecvRequest(uint32_t friendId, uint32_t fileId, QString path)
 {
-    QMutexLocker{coreLoopLock};
+    QMutexLocker locker{coreLoopLock};
 
     ToxFile* file = findFile(friendId, fileId);
     if (!file) {
@@ -265,14 +319,16 @@ void CoreFile::acceptFileRecvRequest(uint32_t friendId, uint32_t fileId, QString
         qWarning() << "acceptFileRecvRequest: Unable to open file";
         return;
     }
-    file->status = ToxFile::TRANSMITTING;
+    fileIo.startReceive(getFriendKey(friendId, fileId), file->file, file->hashGenerator,
+                        [this, friendId, fileId]() { emit fileWritesDrained(friendId, fileId); });
+    setStatus(*file, ToxFile::TRANSMITTING);
     emit fileTransferAccepted(*file);
     tox_file_control(tox, file->friendId, file->fileNum, TOX_FILE_CONTROL_RESUME, nullptr);
 }
 
 ToxFile* CoreFile::findFile(uint32_t friendId, uint32_t fileId)
 {
-    QMutexLocker{coreLoopLock};
+    QMutexLocker locker{coreLoopLock};
 
     uint64_t key = getFriendKey(friendId, fileId);
     if (fileMap.contains(key)) {
@@ -290,8 +346,14 @@ void CoreFile::addFile(uint32_t friendId, uint32_t fileId, const ToxFile& file)
     if (fileMap.contains(key)) {
         qWarning() << "addFile: Overwriting existing file transfer with same ID" << friendId << ':'
                    << fileId;
+        if (fileMap[key].status == ToxFile::TRANSMITTING) {
+            --activeTransfers;
+        }
     }
 
+    if (file.status == ToxFile::TRANSMITTING) {
+        ++activeTransfers;
+    }
     fileMap.insert(key, file);
 }
 
@@ -302,10 +364,103 @@ void CoreFile::removeFile(uint32_t friendId, uint32_t fileId)
         qWarning() << "removeFile: No such file in queue";
         return;
     }
-    fileMap[key].file->close();
+    if (fileMap[key].status == ToxFile::TRANSMITTING) {
+        --activeTransfers;
+    }
+    progressAggregator.removeFile(friendId, fileId);
+    deferredChunks.remove(key);
+    writePausedFiles.remove(key);
+    fileIo.close(key);
     fileMap.remove(key);
 }
 
+/**
+ * @brief Changes the status of a transfer, keeping track of how many are transmitting.
+ */
+void CoreFile::setStatus(ToxFile& file, ToxFile::FileStatus status)
+{
+    if (file.status == ToxFile::TRANSMITTING) {
+        --activeTransfers;
+    }
+    if (status == ToxFile::TRANSMITTING) {
+        ++activeTransfers;
+    }
+    file.status = status;
+}
+
+/**
+ * @brief Sends a chunk of a data file from the read-ahead buffer.
+ *
+ * Cancels the transfer if the file can't be read.
+ * @return False if the data hasn't been read from disk yet and the chunk must be sent later.
+ */
+bool CoreFile::sendDataChunk(ToxFile& file, uint64_t pos, size_t length)
+{
+    QByteArray chunk;
+    switch (fileIo.read(getFriendKey(file.friendId, file.fileNum), pos, length, chunk)) {
+    case FileTransferIo::ReadResult::Pending:
+        return false;
+    case FileTransferIo::ReadResult::Error:
+        qWarning("sendDataChunk: Failed to read from file");
+        setStatus(file, ToxFile::CANCELED);
+        emit fileTransferCancelled(file);
+        tox_file_send_chunk(tox, file.friendId, file.fileNum, pos, nullptr, 0, nullptr);
+        removeFile(file.friendId, file.fileNum);
+        return true;
+    case FileTransferIo::ReadResult::Ok:
+        break;
+    }
+
+    file.bytesSent += length;
+    if (!tox_file_send_chunk(tox, file.friendId, file.fileNum, pos,
+                             reinterpret_cast<const uint8_t*>(chunk.constData()), chunk.size(),
+                             nullptr)) {
+        qWarning("sendDataChunk: Failed to send data chunk");
+        return true;
+    }
+
+    ++iterationChunks;
+    progressAggregator.addChunk(file);
+    return true;
+}
+
+/**
+ * @brief Pauses a receive in toxcore until the I/O thread has written its backlog.
+ *
+ * The disk can't keep up, so let the sender wait instead of buffering without bound.
+ */
+void CoreFile::pauseWrites(ToxFile& file)
+{
+    const uint64_t key = getFriendKey(file.friendId, file.fileNum);
+    if (writePausedFiles.contains(key)) {
+        return;
+    }
+
+    writePausedFiles.insert(key);
+    // a transfer the user paused is already paused in toxcore
+    if (!file.pauseStatus.localPaused()) {
+        tox_file_control(tox, file.friendId, file.fileNum, TOX_FILE_CONTROL_PAUSE, nullptr);
+    }
+}
+
+/**
+ * @brief Resumes a receive paused by pauseWrites, unless the user paused it meanwhile.
+ */
+void CoreFile::onFileWritesDrained(uint32_t friendId, uint32_t fileId)
+{
+    QMutexLocker locker{coreLoopLock};
+
+    const uint64_t key = getFriendKey(friendId, fileId);
+    if (!writePausedFiles.remove(key)) {
+        return;
+    }
+
+    const ToxFile* file = findFile(friendId, fileId);
+    if (file && !file->pauseStatus.localPaused()) {
+        tox_file_control(tox, friendId, fileId, TOX_FILE_CONTROL_RESUME, nullptr);
+    }
+}
+
 QString CoreFile::getCleanFileName(QString filename)
 {
     QRegularExpression regex{QStringLiteral(R"([<>:"/\\|?])")};
@@ -318,6 +473,7 @@ void CoreFile::onFileReceiveCallback(Tox* tox, uint32_t friendId, uint32_t fileI
                                      uint64_t filesize, const uint8_t* fname, size_t fnameLen,
                                      void* vCore)
 {
+    const CoreLoopMetrics::CallbackScope callbackScope{static_cast<Core*>(vCore)->getLoopMetrics()};
     Core* core = static_cast<Core*>(vCore);
     CoreFile* coreFile = core->getCoreFile();
     auto filename = ToxString(fname, fnameLen);
@@ -401,6 +557,7 @@ void CoreFile::handleAvatarOffer(uint32_t friendId, uint32_t fileId, bool accept
 void CoreFile::onFileControlCallback(Tox*, uint32_t friendId, uint32_t fileId,
                                      Tox_File_Control control, void* vCore)
 {
+    const CoreLoopMetrics::CallbackScope callbackScope{static_cast<Core*>(vCore)->getLoopMetrics()};
     Core* core = static_cast<Core*>(vCore);
     CoreFile* coreFile = core->getCoreFile();
     ToxFile* file = coreFile->findFile(friendId, fileId);
@@ -412,13 +569,13 @@ void CoreFile::onFileControlCallback(Tox*, uint32_t friendId, uint32_t fileId,
     if (control == TOX_FILE_CONTROL_CANCEL) {
         if (file->fileKind != TOX_FILE_KIND_AVATAR)
             qDebug() << "File transfer" << friendId << ":" << fileId << "cancelled by friend";
-        file->status = ToxFile::CANCELED;
+        coreFile->setStatus(*file, ToxFile::CANCELED);
         emit coreFile->fileTransferCancelled(*file);
         coreFile->removeFile(friendId, fileId);
     } else if (control == TOX_FILE_CONTROL_PAUSE) {
         qDebug() << "onFileControlCallback: Received pause for file " << friendId << ":" << fileId;
         file->pauseStatus.remotePause();
-        file->status = ToxFile::PAUSED;
+        coreFile->setStatus(*file, ToxFile::PAUSED);
         emit coreFile->fileTransferRemotePausedUnpaused(*file, true);
     } else if (control == TOX_FILE_CONTROL_RESUME) {
         if (file->direction == ToxFile::SENDING && file->fileKind == TOX_FILE_KIND_AVATAR)
@@ -426,7 +583,8 @@ void CoreFile::onFileControlCallback(Tox*, uint32_t friendId, uint32_t fileId,
         else
             qDebug() << "onFileControlCallback: Received resume for file " << friendId << ":" << fileId;
         file->pauseStatus.remoteResume();
-        file->status = file->pauseStatus.paused() ? ToxFile::PAUSED : ToxFile::TRANSMITTING;
+        coreFile->setStatus(*file, file->pauseStatus.paused() ? ToxFile::PAUSED
+                                                              : ToxFile::TRANSMITTING);
         emit coreFile->fileTransferRemotePausedUnpaused(*file, false);
     } else {
         qWarning() << "Unhandled file control " << control << " for file " << friendId << ':' << fileId;
@@ -436,7 +594,7 @@ void CoreFile::onFileControlCallback(Tox*, uint32_t friendId, uint32_t fileId,
 void CoreFile::onFileDataCallback(Tox* tox, uint32_t friendId, uint32_t fileId, uint64_t pos,
                                   size_t length, void* vCore)
 {
-
+    const CoreLoopMetrics::CallbackScope callbackScope{static_cast<Core*>(vCore)->getLoopMetrics()};
     Core* core = static_cast<Core*>(vCore);
     CoreFile* coreFile = core->getCoreFile();
     ToxFile* file = coreFile->findFile(friendId, fileId);
@@ -447,7 +605,7 @@ void CoreFile::onFileDataCallback(Tox* tox, uint32_t friendId, uint32_t fileId,
 
     // If we reached EOF, ack and cleanup the transfer
     if (!length) {
-        file->status = ToxFile::FINISHED;
+        coreFile->setStatus(*file, ToxFile::FINISHED);
         if (file->fileKind != TOX_FILE_KIND_AVATAR) {
             emit coreFile->fileTransferFinished(*file);
             emit coreFile->fileUploadFinished(file->filePath);
@@ -456,40 +614,27 @@ void CoreFile::onFileDataCallback(Tox* tox, uint32_t friendId, uint32_t fileId,
         return;
     }
 
-    std::unique_ptr<uint8_t[]> data(new uint8_t[length]);
-    int64_t nread;
-
     if (file->fileKind == TOX_FILE_KIND_AVATAR) {
         QByteArray chunk = file->avatarData.mid(pos, length);
-        nread = chunk.size();
-        memcpy(data.get(), chunk.data(), nread);
-    } else {
-        file->file->seek(pos);
-        nread = file->file->read(reinterpret_cast<char*>(data.get()), length);
-        if (nread <= 0) {
-            qWarning("onFileDataCallback: Failed to read from file");
-            file->status = ToxFile::CANCELED;
-            emit coreFile->fileTransferCancelled(*file);
-            tox_file_send_chunk(tox, friendId, fileId, pos, nullptr, 0, nullptr);
-            coreFile->removeFile(friendId, fileId);
-            return;
+        if (!tox_file_send_chunk(tox, friendId, fileId, pos,
+                                 reinterpret_cast<const uint8_t*>(chunk.constData()), chunk.size(),
+                                 nullptr)) {
+            qWarning("onFileDataCallback: Failed to send data chunk");
         }
-        file->bytesSent += length;
-        file->hashGenerator->addData(reinterpret_cast<const char*>(data.get()), length);
-    }
-
-    if (!tox_file_send_chunk(tox, friendId, fileId, pos, data.get(), nread, nullptr)) {
-        qWarning("onFileDataCallback: Failed to send data chunk");
         return;
     }
-    if (file->fileKind != TOX_FILE_KIND_AVATAR) {
-        emit coreFile->fileTransferInfo(*file);
+
+    // chunks have to be sent in order, queue behind the ones still being read from disk
+    const uint64_t key = getFriendKey(friendId, fileId);
+    if (coreFile->deferredChunks.contains(key) || !coreFile->sendDataChunk(*file, pos, length)) {
+        coreFile->deferredChunks[key].append({pos, length});
     }
 }
 
 void CoreFile::onFileRecvChunkCallback(Tox* tox, uint32_t friendId, uint32_t fileId, uint64_t position,
                                        const uint8_t* data, size_t length, void* vCore)
 {
+    const CoreLoopMetrics::CallbackScope callbackScope{static_cast<Core*>(vCore)->getLoopMetrics()};
     Core* core = static_cast<Core*>(vCore);
     CoreFile* coreFile = core->getCoreFile();
     ToxFile* file = coreFile->findFile(friendId, fileId);
@@ -502,7 +647,7 @@ void CoreFile::onFileRecvChunkCallback(Tox* tox, uint32_t friendId, uint32_t fil
     if (file->bytesSent != position) {
         qWarning("onFileRecvChunkCallback: Received a chunk out-of-order, aborting transfer");
         if (file->fileKind != TOX_FILE_KIND_AVATAR) {
-            file->status = ToxFile::CANCELED;
+            coreFile->setStatus(*file, ToxFile::CANCELED);
             emit coreFile->fileTransferCancelled(*file);
         }
         tox_file_control(tox, friendId, fileId, TOX_FILE_CONTROL_CANCEL, nullptr);
@@ -511,7 +656,7 @@ void CoreFile::onFileRecvChunkCallback(Tox* tox, uint32_t friendId, uint32_t fil
     }
 
     if (!length) {
-        file->status = ToxFile::FINISHED;
+        coreFile->setStatus(*file, ToxFile::FINISHED);
         if (file->fileKind == TOX_FILE_KIND_AVATAR) {
             QPixmap pic;
             pic.loadFromData(file->avatarData);
@@ -520,8 +665,12 @@ void CoreFile::onFileRecvChunkCallback(Tox* tox, uint32_t friendId, uint32_t fil
                 emit core->friendAvatarChanged(core->getFriendPublicKey(friendId), file->avatarData);
             }
         } else {
-            emit coreFile->fileTransferFinished(*file);
-            emit coreFile->fileDownloadFinished(file->filePath);
+            // only report the download once all data is on disk and hashed
+            const ToxFile finished = *file;
+            coreFile->fileIo.close(getFriendKey(friendId, fileId), [coreFile, finished]() {
+                emit coreFile->fileTransferFinished(finished);
+                emit coreFile->fileDownloadFinished(finished.filePath);
+            });
         }
         coreFile->removeFile(friendId, fileId);
         return;
@@ -529,14 +678,28 @@ void CoreFile::onFileRecvChunkCallback(Tox* tox, uint32_t friendId, uint32_t fil
 
     if (file->fileKind == TOX_FILE_KIND_AVATAR) {
         file->avatarData.append(reinterpret_cast<const char*>(data), length);
+        file->hashGenerator->addData(reinterpret_cast<const char*>(data), length);
     } else {
-        file->file->write(reinterpret_cast<const char*>(data), length);
+        switch (coreFile->fileIo.write(getFriendKey(friendId, fileId), data, length)) {
+        case FileTransferIo::WriteResult::Error:
+            qWarning("onFileRecvChunkCallback: Failed to write to file");
+            coreFile->setStatus(*file, ToxFile::CANCELED);
+            emit coreFile->fileTransferCancelled(*file);
+            tox_file_control(tox, friendId, fileId, TOX_FILE_CONTROL_CANCEL, nullptr);
+            coreFile->removeFile(friendId, fileId);
+            return;
+        case FileTransferIo::WriteResult::Full:
+            coreFile->pauseWrites(*file);
+            break;
+        case FileTransferIo::WriteResult::Ok:
+            break;
+        }
     }
+    ++coreFile->iterationChunks;
     file->bytesSent += length;
-    file->hashGenerator->addData(reinterpret_cast<const char*>(data), length);
 
     if (file->fileKind != TOX_FILE_KIND_AVATAR) {
-        emit coreFile->fileTransferInfo(*file);
+        coreFile->progressAggregator.addChunk(*file);
     }
 }
 
@@ -554,7 +717,7 @@ void CoreFile::onConnectionStatusChanged(uint32_t friendId, Status::Status state
     for (uint64_t key : fileMap.keys()) {
         if (key >> 32 != friendId)
             continue;
-        fileMap[key].status = status;
+        setStatus(fileMap[key], status);
         emit fileTransferBrokenUnbroken(fileMap[key], isOffline);
     }
 }
@@ -22,15 +22,20 @@
 
 #include <tox/tox.h>
 
+#include "fileprogressaggregator.h"
+#include "filetransferio.h"
 #include "toxfile.h"
 #include "src/core/core.h"
 #include "src/core/toxpk.h"
 #include "src/model/status.h"
 
+#include <QElapsedTimer>
 #include <QHash>
 #include <QMutex>
 #include <QObject>
+#include <QSet>
 #include <QString>
+#include <QVector>
 
 #include <cstddef>
 #include <cstdint>
@@ -60,6 +65,7 @@ public:
     void acceptFileRecvRequest(uint32_t friendId, uint32_t fileId, QString path);
 
     unsigned corefileIterationInterval();
+    void process();
 
 signals:
     void fileSendStarted(ToxFile file);
@@ -70,18 +76,24 @@ signals:
     void fileUploadFinished(const QString& path);
     void fileDownloadFinished(const QString& path);
     void fileTransferPaused(ToxFile file);
-    void fileTransferInfo(ToxFile file);
+    void fileTransferInfo(ToxFileProgressInfo info);
     void fileTransferRemotePausedUnpaused(ToxFile file, bool paused);
     void fileTransferBrokenUnbroken(ToxFile file, bool broken);
     void fileNameChanged(const ToxPk& friendPk);
     void fileSendFailed(uint32_t friendId, const QString& fname);
+    // internal, emitted from the I/O thread
+    void fileWritesDrained(uint32_t friendId, uint32_t fileId);
 
 private:
     CoreFile(Tox* core, QMutex& coreLoopLock);
+    ~CoreFile() override;
 
     ToxFile* findFile(uint32_t friendId, uint32_t fileId);
     void addFile(uint32_t friendId, uint32_t fileId, const ToxFile& file);
     void removeFile(uint32_t friendId, uint32_t fileId);
+    void setStatus(ToxFile& file, ToxFile::FileStatus status);
+    bool sendDataChunk(ToxFile& file, uint64_t pos, size_t length);
+    void pauseWrites(ToxFile& file);
     static constexpr uint64_t getFriendKey(uint32_t friendId, uint32_t fileId)
     {
         return (static_cast<std::uint64_t>(friendId) << 32) + fileId;
@@ -102,9 +114,28 @@ private:
 
 private slots:
     void onConnectionStatusChanged(uint32_t friendId, Status::Status state);
+    void onFileWritesDrained(uint32_t friendId, uint32_t fileId);
 
 private:
+    struct ChunkRequest
+    {
+        uint64_t pos;
+        size_t length;
+    };
+
     QHash<uint64_t, ToxFile> fileMap;
+    // chunks toxcore requested before they were read from disk, in request order
+    QHash<uint64_t, QVector<ChunkRequest>> deferredChunks;
+    // receives paused until their data has been written to disk
+    QSet<uint64_t> writePausedFiles;
+    FileTransferIo fileIo;
+    // number of transfers in TRANSMITTING state
+    int activeTransfers = 0;
+    // chunks sent or received in the current and the last Core iteration
+    int iterationChunks = 0;
+    int lastIterationChunks = 0;
+    FileProgressAggregator progressAggregator;
+    QElapsedTimer progressClock;
     Tox* tox;
     QMutex* coreLoopLock = nullptr;
 };
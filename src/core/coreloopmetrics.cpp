@@ -0,0 +1,109 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "coreloopmetrics.h"
+
+#include <QMutexLocker>
+
+/**
+ * @class CoreLoopMetrics
+ * @brief Measures how often the Core loop runs and how long it holds the core loop lock.
+ *
+ * Values are collected on the Core thread and summarized once per window. The summary
+ * of the last complete window can be read from any thread with getSnapshot().
+ *
+ * @class CoreLoopMetrics::CallbackScope
+ * @brief Adds the time until it goes out of scope as the cost of one toxcore callback.
+ */
+
+CoreLoopMetrics::CallbackScope::CallbackScope(CoreLoopMetrics& metrics)
+    : metrics{metrics}
+{
+    timer.start();
+}
+
+CoreLoopMetrics::CallbackScope::~CallbackScope()
+{
+    metrics.addCallback(timer.nsecsElapsed());
+}
+
+/**
+ * @param windowMs Time over which values are averaged.
+ */
+CoreLoopMetrics::CoreLoopMetrics(qint64 windowMs)
+    : windowMs{windowMs}
+{
+}
+
+/**
+ * @brief Records one Core iteration, publishes a new snapshot when the window is over.
+ * @param nowMs Current time of a monotonic clock in milliseconds.
+ * @param lockHoldNs Time the core loop lock was held during the iteration.
+ * @return True if a new snapshot has been published.
+ */
+bool CoreLoopMetrics::addIteration(qint64 nowMs, qint64 lockHoldNs)
+{
+    if (windowStartMs < 0) {
+        windowStartMs = nowMs;
+    }
+
+    ++iterations;
+    this->lockHoldNs += lockHoldNs;
+    maxLockHoldNs = qMax(maxLockHoldNs, lockHoldNs);
+
+    const qint64 elapsedMs = nowMs - windowStartMs;
+    if (elapsedMs < windowMs) {
+        return false;
+    }
+
+    Snapshot next;
+    next.iterationsPerSecond = iterations * 1000.0 / elapsedMs;
+    next.averageLockHoldUs = this->lockHoldNs / static_cast<qint64>(iterations) / 1000;
+    next.maxLockHoldUs = maxLockHoldNs / 1000;
+    next.callbacks = callbacks;
+    next.averageCallbackNs = callbacks ? callbackNs / static_cast<qint64>(callbacks) : 0;
+
+    {
+        QMutexLocker locker{&snapshotMutex};
+        snapshot = next;
+    }
+
+    windowStartMs = nowMs;
+    iterations = 0;
+    this->lockHoldNs = 0;
+    maxLockHoldNs = 0;
+    callbacks = 0;
+    callbackNs = 0;
+    return true;
+}
+
+void CoreLoopMetrics::addCallback(qint64 durationNs)
+{
+    ++callbacks;
+    callbackNs += durationNs;
+}
+
+/**
+ * @brief Returns the values of the last complete window, safe to call from any thread.
+ */
+CoreLoopMetrics::Snapshot CoreLoopMetrics::getSnapshot() const
+{
+    QMutexLocker locker{&snapshotMutex};
+    return snapshot;
+}
@@ -0,0 +1,67 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QMutex>
+
+class CoreLoopMetrics
+{
+public:
+    struct Snapshot
+    {
+        double iterationsPerSecond = 0.0;
+        qint64 averageLockHoldUs = 0;
+        qint64 maxLockHoldUs = 0;
+        quint64 callbacks = 0;
+        qint64 averageCallbackNs = 0;
+    };
+
+    class CallbackScope
+    {
+    public:
+        explicit CallbackScope(CoreLoopMetrics& metrics);
+        ~CallbackScope();
+
+    private:
+        CoreLoopMetrics& metrics;
+        QElapsedTimer timer;
+    };
+
+    static constexpr qint64 defaultWindowMs = 10000;
+
+    explicit CoreLoopMetrics(qint64 windowMs = defaultWindowMs);
+
+    bool addIteration(qint64 nowMs, qint64 lockHoldNs);
+    void addCallback(qint64 durationNs);
+    Snapshot getSnapshot() const;
+
+private:
+    const qint64 windowMs;
+    qint64 windowStartMs = -1;
+    quint64 iterations = 0;
+    qint64 lockHoldNs = 0;
+    qint64 maxLockHoldNs = 0;
+    quint64 callbacks = 0;
+    qint64 callbackNs = 0;
+
+    mutable QMutex snapshotMutex;
+    Snapshot snapshot;
+};
@@ -0,0 +1,87 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "fileprogressaggregator.h"
+
+namespace {
+uint64_t getTransferKey(uint32_t friendId, uint32_t fileNum)
+{
+    return (static_cast<uint64_t>(friendId) << 32) + fileNum;
+}
+} // namespace
+
+/**
+ * @class FileProgressAggregator
+ * @brief Collects per-chunk transfer progress and hands it out at a bounded rate.
+ *
+ * Toxcore reports every ~1.3 KB chunk separately. Only the latest position of each
+ * transfer is kept, and takeDue() releases it at most once per interval, so the number
+ * of progress events is bound by time instead of by the amount of data transferred.
+ */
+
+/**
+ * @param intervalMs Minimum time between two batches of progress updates.
+ */
+FileProgressAggregator::FileProgressAggregator(qint64 intervalMs)
+    : intervalMs{intervalMs}
+    , lastPublishMs{-intervalMs}
+{
+}
+
+/**
+ * @brief Records the current progress of a transfer, replacing any unpublished one.
+ */
+void FileProgressAggregator::addChunk(const ToxFile& file)
+{
+    ToxFileProgressInfo& info = pending[getTransferKey(file.friendId, file.fileNum)];
+    info.fileNum = file.fileNum;
+    info.friendId = file.friendId;
+    info.direction = file.direction;
+    info.bytesSent = file.bytesSent;
+    info.filesize = file.filesize;
+}
+
+/**
+ * @brief Drops unpublished progress of a transfer that was finished or cancelled.
+ */
+void FileProgressAggregator::removeFile(uint32_t friendId, uint32_t fileNum)
+{
+    pending.remove(getTransferKey(friendId, fileNum));
+}
+
+/**
+ * @brief Takes the pending progress updates if the interval has elapsed.
+ * @param nowMs Current time of a monotonic clock in milliseconds.
+ * @return Latest progress of every transfer that changed, or nothing if it's too early.
+ */
+QVector<ToxFileProgressInfo> FileProgressAggregator::takeDue(qint64 nowMs)
+{
+    if (pending.isEmpty() || nowMs - lastPublishMs < intervalMs) {
+        return {};
+    }
+
+    QVector<ToxFileProgressInfo> due;
+    due.reserve(pending.size());
+    for (const ToxFileProgressInfo& info : pending) {
+        due.append(info);
+    }
+    pending.clear();
+    lastPublishMs = nowMs;
+    return due;
+}
@@ -0,0 +1,44 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "toxfile.h"
+
+#include <QHash>
+#include <QVector>
+
+#include <cstdint>
+
+class FileProgressAggregator
+{
+public:
+    static constexpr qint64 defaultIntervalMs = 100;
+
+    explicit FileProgressAggregator(qint64 intervalMs = defaultIntervalMs);
+
+    void addChunk(const ToxFile& file);
+    void removeFile(uint32_t friendId, uint32_t fileNum);
+    QVector<ToxFileProgressInfo> takeDue(qint64 nowMs);
+
+private:
+    qint64 intervalMs;
+    qint64 lastPublishMs;
+    QHash<uint64_t, ToxFileProgressInfo> pending;
+};
@@ -0,0 +1,345 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "filetransferio.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QFile>
+
+/**
+ * @class FileTransferIo
+ * @brief Reads and writes the files of running transfers on a dedicated thread.
+ *
+ * Toxcore callbacks run with the core loop lock held, so disk access there stalls every
+ * other Tox packet. Sends are read ahead into a buffer the Core thread copies chunks out
+ * of, receives are collected into blocks that are written behind. Both directions are
+ * hashed on the I/O thread. Transfers are identified by the same key CoreFile uses.
+ *
+ * None of the calls made from the Core thread block on the disk: reads that aren't buffered
+ * yet are Pending, and writes report when the transfer should be paused until its backlog
+ * has been written.
+ *
+ * @var FileTransferIo::readAheadSize
+ * @brief Maximum amount of data buffered ahead of a send.
+ *
+ * @var FileTransferIo::writeBehindSize
+ * @brief Amount of received data waiting to be written, from which write() reports Full.
+ */
+
+FileTransferIo::~FileTransferIo()
+{
+    stop();
+}
+
+/**
+ * @brief Starts reading ahead a file that is being sent.
+ * @param file File opened for reading, only accessed by the I/O thread from now on.
+ * @param hash Hash the file content is added to.
+ */
+void FileTransferIo::startSend(uint64_t key, std::shared_ptr<QFile> file,
+                               std::shared_ptr<QCryptographicHash> hash, quint64 filesize)
+{
+    auto transfer = std::make_shared<Transfer>();
+    transfer->file = std::move(file);
+    transfer->hash = std::move(hash);
+    transfer->sending = true;
+    transfer->filesize = filesize;
+
+    QMutexLocker locker{&mutex};
+    transfers.insert(key, transfer);
+    workAvailable.wakeOne();
+}
+
+/**
+ * @brief Starts writing behind a file that is being received.
+ * @param file File opened for writing, only accessed by the I/O thread from now on.
+ * @param hash Hash the file content is added to.
+ * @param onDrained Called on the I/O thread once a transfer that was Full has written
+ * most of its backlog, and can be resumed.
+ */
+void FileTransferIo::startReceive(uint64_t key, std::shared_ptr<QFile> file,
+                                  std::shared_ptr<QCryptographicHash> hash,
+                                  std::function<void()> onDrained)
+{
+    auto transfer = std::make_shared<Transfer>();
+    transfer->file = std::move(file);
+    transfer->hash = std::move(hash);
+    transfer->onDrained = std::move(onDrained);
+
+    QMutexLocker locker{&mutex};
+    transfers.insert(key, transfer);
+}
+
+/**
+ * @brief Copies a chunk of a sent file out of the read-ahead buffer, never blocks.
+ *
+ * A position outside of the buffer, e.g. when the receiver resumes a transfer somewhere
+ * else, restarts the read-ahead from there.
+ * @param chunk Set to the requested data on success.
+ * @return Pending if the data hasn't been read from disk yet, Error if it can't be.
+ */
+FileTransferIo::ReadResult FileTransferIo::read(uint64_t key, quint64 position, size_t length,
+                                                QByteArray& chunk)
+{
+    QMutexLocker locker{&mutex};
+    auto it = transfers.find(key);
+    if (it == transfers.end() || !it.value()->sending) {
+        return ReadResult::Error;
+    }
+
+    Transfer& transfer = *it.value();
+    const quint64 end = position + length;
+    if (transfer.failed || end > transfer.filesize) {
+        return ReadResult::Error;
+    }
+
+    // toxcore requests chunks in order, anything else is a seek
+    const quint64 bufferEnd = transfer.bufferPos + static_cast<quint64>(transfer.buffer.size());
+    if (position < transfer.bufferPos || position > bufferEnd) {
+        transfer.buffer.clear();
+        transfer.bufferPos = position;
+        transfer.readPos = position;
+        workAvailable.wakeOne();
+        return ReadResult::Pending;
+    }
+
+    if (end > bufferEnd) {
+        return ReadResult::Pending;
+    }
+
+    const int offset = static_cast<int>(position - transfer.bufferPos);
+    chunk = transfer.buffer.mid(offset, static_cast<int>(length));
+
+    // drop consumed data a block at a time, instead of moving the buffer for every chunk
+    const int consumed = offset + static_cast<int>(length);
+    if (consumed >= blockSize) {
+        transfer.buffer.remove(0, consumed);
+        transfer.bufferPos += consumed;
+        workAvailable.wakeOne();
+    }
+
+    return ReadResult::Ok;
+}
+
+/**
+ * @brief Queues received data to be written, never blocks.
+ *
+ * The data is always queued. Once writeBehindSize bytes are waiting, the caller should pause
+ * the transfer until onDrained is called, so a disk that can't keep up slows the sender
+ * down instead of buffering without bound.
+ * @return Full if the transfer should be paused, Error if the transfer is unknown or
+ * writing to the file failed.
+ */
+FileTransferIo::WriteResult FileTransferIo::write(uint64_t key, const uint8_t* data, size_t length)
+{
+    QMutexLocker locker{&mutex};
+    auto it = transfers.find(key);
+    if (it == transfers.end() || it.value()->sending || it.value()->failed) {
+        return WriteResult::Error;
+    }
+
+    const std::shared_ptr<Transfer> transfer = it.value();
+
+    // collect chunks into blocks, so the disk sees few large writes
+    const char* bytes = reinterpret_cast<const char*>(data);
+    if (transfer->pendingWrites.isEmpty() || transfer->pendingWrites.last().size() >= blockSize) {
+        QByteArray block;
+        block.reserve(blockSize);
+        transfer->pendingWrites.append(block);
+    }
+    transfer->pendingWrites.last().append(bytes, static_cast<int>(length));
+    transfer->pendingBytes += static_cast<int>(length);
+
+    if (transfer->pendingBytes >= blockSize) {
+        workAvailable.wakeOne();
+    }
+
+    if (transfer->pendingBytes >= writeBehindSize) {
+        transfer->full = true;
+        return WriteResult::Full;
+    }
+
+    return WriteResult::Ok;
+}
+
+/**
+ * @brief Stops a transfer, its pending data is written and the file closed on the I/O thread.
+ * @param onClosed Called on the I/O thread once the file is complete on disk.
+ */
+void FileTransferIo::close(uint64_t key, std::function<void()> onClosed)
+{
+    QMutexLocker locker{&mutex};
+    auto it = transfers.find(key);
+    if (it == transfers.end()) {
+        locker.unlock();
+        if (onClosed) {
+            onClosed();
+        }
+        return;
+    }
+
+    it.value()->onClosed = std::move(onClosed);
+    closing.append(it.value());
+    transfers.erase(it);
+    workAvailable.wakeOne();
+}
+
+/**
+ * @brief Closes all transfers and waits for the I/O thread to finish.
+ */
+void FileTransferIo::stop()
+{
+    {
+        QMutexLocker locker{&mutex};
+        for (const auto& transfer : transfers) {
+            closing.append(transfer);
+        }
+        transfers.clear();
+        stopping = true;
+        workAvailable.wakeOne();
+    }
+
+    wait();
+}
+
+void FileTransferIo::run()
+{
+    QMutexLocker locker{&mutex};
+    while (true) {
+        if (!closing.isEmpty()) {
+            // closing transfers are no longer visible to the Core thread
+            const std::shared_ptr<Transfer> transfer = closing.takeFirst();
+            locker.unlock();
+            if (!transfer->sending && !writeBlocks(*transfer, transfer->pendingWrites)) {
+                qWarning() << "Failed to write" << transfer->file->fileName();
+            }
+            transfer->file->close();
+            if (transfer->onClosed) {
+                transfer->onClosed();
+            }
+            locker.relock();
+            continue;
+        }
+
+        if (stopping) {
+            return;
+        }
+
+        const std::shared_ptr<Transfer> transfer = nextActive();
+        if (!transfer) {
+            workAvailable.wait(&mutex);
+        } else if (transfer->sending) {
+            readAhead(locker, *transfer);
+        } else {
+            writeBehind(locker, *transfer);
+        }
+    }
+}
+
+std::shared_ptr<FileTransferIo::Transfer> FileTransferIo::nextActive() const
+{
+    for (const auto& transfer : transfers) {
+        if (transfer->failed) {
+            continue;
+        }
+
+        if (transfer->sending) {
+            if (transfer->readPos < transfer->filesize && transfer->buffer.size() < readAheadSize) {
+                return transfer;
+            }
+        } else if (transfer->pendingBytes >= blockSize) {
+            return transfer;
+        }
+    }
+
+    return {};
+}
+
+void FileTransferIo::readAhead(QMutexLocker& locker, Transfer& transfer)
+{
+    const quint64 position = transfer.readPos;
+    const qint64 size = qMin<quint64>(blockSize, transfer.filesize - position);
+    locker.unlock();
+    QByteArray block;
+    if (transfer.file->pos() == static_cast<qint64>(position)
+        || transfer.file->seek(static_cast<qint64>(position))) {
+        block = transfer.file->read(size);
+    }
+    // hash every byte once and in order, even if the receiver made us seek back
+    if (!block.isEmpty() && position == transfer.hashPos) {
+        transfer.hash->addData(block);
+        transfer.hashPos += static_cast<quint64>(block.size());
+    }
+    locker.relock();
+
+    // read() moved the transfer elsewhere while the block was being read
+    if (transfer.readPos != position) {
+        return;
+    }
+
+    if (block.isEmpty()) {
+        qWarning() << "Failed to read" << transfer.file->fileName();
+        transfer.failed = true;
+        return;
+    }
+
+    transfer.readPos += block.size();
+    transfer.buffer.append(block);
+}
+
+void FileTransferIo::writeBehind(QMutexLocker& locker, Transfer& transfer)
+{
+    QList<QByteArray> blocks;
+    blocks.swap(transfer.pendingWrites);
+    // data being written still counts towards writeBehindSize
+    const int bytes = transfer.pendingBytes;
+    locker.unlock();
+    const bool success = writeBlocks(transfer, blocks);
+    locker.relock();
+
+    transfer.pendingBytes -= bytes;
+    if (!success) {
+        qWarning() << "Failed to write" << transfer.file->fileName();
+        transfer.failed = true;
+        return;
+    }
+
+    // leave room for the chunks still in flight when the transfer gets resumed
+    if (transfer.full && transfer.pendingBytes < writeBehindSize / 2) {
+        transfer.full = false;
+        if (transfer.onDrained) {
+            locker.unlock();
+            transfer.onDrained();
+            locker.relock();
+        }
+    }
+}
+
+bool FileTransferIo::writeBlocks(Transfer& transfer, const QList<QByteArray>& blocks)
+{
+    for (const QByteArray& block : blocks) {
+        if (transfer.file->write(block) != block.size()) {
+            return false;
+        }
+        transfer.hash->addData(block);
+    }
+
+    return true;
+}
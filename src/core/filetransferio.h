@@ -0,0 +1,108 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+class QCryptographicHash;
+class QFile;
+
+class FileTransferIo : public QThread
+{
+public:
+    enum class ReadResult
+    {
+        Ok,
+        Pending,
+        Error
+    };
+
+    enum class WriteResult
+    {
+        Ok,
+        Full,
+        Error
+    };
+
+    static constexpr int blockSize = 64 * 1024;
+    static constexpr int readAheadSize = 1024 * 1024;
+    static constexpr int writeBehindSize = 4 * 1024 * 1024;
+
+    FileTransferIo() = default;
+    ~FileTransferIo() override;
+
+    void startSend(uint64_t key, std::shared_ptr<QFile> file,
+                   std::shared_ptr<QCryptographicHash> hash, quint64 filesize);
+    void startReceive(uint64_t key, std::shared_ptr<QFile> file,
+                      std::shared_ptr<QCryptographicHash> hash,
+                      std::function<void()> onDrained = {});
+    ReadResult read(uint64_t key, quint64 position, size_t length, QByteArray& chunk);
+    WriteResult write(uint64_t key, const uint8_t* data, size_t length);
+    void close(uint64_t key, std::function<void()> onClosed = {});
+    void stop();
+
+protected:
+    void run() override;
+
+private:
+    struct Transfer
+    {
+        std::shared_ptr<QFile> file;
+        std::shared_ptr<QCryptographicHash> hash;
+        bool sending = false;
+        bool failed = false;
+        std::function<void()> onClosed;
+
+        // sending: data read ahead of what toxcore requested so far
+        quint64 filesize = 0;
+        quint64 readPos = 0;
+        quint64 bufferPos = 0;
+        QByteArray buffer;
+        // only accessed by the I/O thread
+        quint64 hashPos = 0;
+
+        // receiving: data waiting to be written
+        QList<QByteArray> pendingWrites;
+        int pendingBytes = 0;
+        bool full = false;
+        std::function<void()> onDrained;
+    };
+
+    std::shared_ptr<Transfer> nextActive() const;
+    void readAhead(QMutexLocker& locker, Transfer& transfer);
+    void writeBehind(QMutexLocker& locker, Transfer& transfer);
+    static bool writeBlocks(Transfer& transfer, const QList<QByteArray>& blocks);
+
+private:
+    QMutex mutex;
+    QWaitCondition workAvailable;
+    QHash<uint64_t, std::shared_ptr<Transfer>> transfers;
+    QList<std::shared_ptr<Transfer>> closing;
+    bool stopping = false;
+};
@@ -0,0 +1,41 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "toxpk.h"
+
+#include <QMetaType>
+#include <QString>
+#include <QVector>
+
+#include <cstdint>
+
+/**
+ * @brief State of a friend as stored by toxcore, read in a single pass when Core starts.
+ */
+struct FriendSnapshot
+{
+    uint32_t friendId = 0;
+    ToxPk publicKey;
+    QString username;
+    QString statusMessage;
+};
+Q_DECLARE_METATYPE(FriendSnapshot)
+Q_DECLARE_METATYPE(QVector<FriendSnapshot>)
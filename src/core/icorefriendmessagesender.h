@@ -24,10 +24,19 @@
 #include <QString>
 #include <cstdint>
 
+enum class FriendSendResult
+{
+    Sent,
+    QueueFull, // toxcore's send queue is full, the message can be retried later
+    Failed
+};
+
 class ICoreFriendMessageSender
 {
 public:
     virtual ~ICoreFriendMessageSender() = default;
-    virtual bool sendAction(uint32_t friendId, const QString& action, ReceiptNum& receipt) = 0;
-    virtual bool sendMessage(uint32_t friendId, const QString& message, ReceiptNum& receipt) = 0;
+    virtual FriendSendResult sendAction(uint32_t friendId, const QString& action,
+                                        ReceiptNum& receipt) = 0;
+    virtual FriendSendResult sendMessage(uint32_t friendId, const QString& message,
+                                         ReceiptNum& receipt) = 0;
 };
@@ -25,9 +25,16 @@
 
 #include <QString>
 #include <QStringList>
+#include <QVector>
 
 #include <cstdint>
 
+struct GroupPeer
+{
+    ToxPk pk;
+    QString name;
+};
+
 class ICoreGroupQuery
 {
 public:
@@ -37,5 +44,6 @@ public:
     virtual QString getGroupPeerName(int groupId, int peerId) const = 0;
     virtual ToxPk getGroupPeerPk(int groupId, int peerId) const = 0;
     virtual QStringList getGroupPeerNames(int groupId) const = 0;
+    virtual QVector<GroupPeer> getGroupPeers(int groupId) const = 0;
     virtual bool getGroupAvEnabled(int groupId) const = 0;
 };
@@ -122,6 +122,7 @@ ToxFriendCall::ToxFriendCall(uint32_t FriendNum, bool VideoEnabled, CoreAV& av,
     : ToxCall(VideoEnabled, av, audio)
     , sink(audio.makeSink())
     , friendId{FriendNum}
+    , videoPacer{CoreAV::VIDEO_DEFAULT_BITRATE}
 {
     connect(audioSource.get(), &IAudioSource::frameAvailable, this,
                          [this](const int16_t* pcm, size_t samples, uint8_t chans, uint32_t rate) {
@@ -191,6 +192,16 @@ void ToxFriendCall::setState(const TOXAV_FRIEND_CALL_STATE& value)
     state = value;
 }
 
+VideoEncodePacer& ToxFriendCall::getVideoPacer()
+{
+    return videoPacer;
+}
+
+const VideoEncodePacer& ToxFriendCall::getVideoPacer() const
+{
+    return videoPacer;
+}
+
 void ToxFriendCall::playAudioBuffer(const int16_t* data, int samples, unsigned channels,
                                     int sampleRate) const
 {
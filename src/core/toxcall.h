@@ -22,6 +22,7 @@
 #include "audio/iaudiocontrol.h"
 #include "audio/iaudiosink.h"
 #include "audio/iaudiosource.h"
+#include "src/core/videoencodepacer.h"
 #include <src/core/toxpk.h>
 #include <tox/toxav.h>
 
@@ -29,6 +30,7 @@
 #include <QMetaObject>
 #include <QtGlobal>
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 
@@ -82,7 +84,7 @@ protected:
     CoreVideoSource* videoSource{nullptr};
     QMetaObject::Connection videoInConn;
     bool videoEnabled{false};
-    bool nullVideoBitrate{false};
+    std::atomic_bool nullVideoBitrate{false};
     std::unique_ptr<IAudioSource> audioSource;
 };
 
@@ -101,6 +103,9 @@ public:
 
     void playAudioBuffer(const int16_t* data, int samples, unsigned channels, int sampleRate) const;
 
+    VideoEncodePacer& getVideoPacer();
+    const VideoEncodePacer& getVideoPacer() const;
+
 private slots:
     void onAudioSourceInvalidated();
     void onAudioSinkInvalidated();
@@ -110,6 +115,7 @@ private:
     TOXAV_FRIEND_CALL_STATE state{TOXAV_FRIEND_CALL_STATE_NONE};
     std::unique_ptr<IAudioSink> sink;
     uint32_t friendId;
+    VideoEncodePacer videoPacer;
 };
 
 class ToxGroupCall : public ToxCall
@@ -75,3 +75,15 @@ struct ToxFile
     std::shared_ptr<QCryptographicHash> hashGenerator = std::make_shared<QCryptographicHash>(QCryptographicHash::Sha256);
     ToxFilePause pauseStatus;
 };
+
+/**
+ * @brief Progress of a running transfer, published instead of a full ToxFile copy.
+ */
+struct ToxFileProgressInfo
+{
+    uint32_t fileNum = 0;
+    uint32_t friendId = 0;
+    ToxFile::FileDirection direction = ToxFile::SENDING;
+    quint64 bytesSent = 0;
+    quint64 filesize = 0;
+};
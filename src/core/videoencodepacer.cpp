@@ -0,0 +1,178 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "videoencodepacer.h"
+
+#include <QMutexLocker>
+
+#include <array>
+
+/**
+ * @class VideoEncodePacer
+ * @brief Fits the video frames sent in a call to the bitrate toxav recommends.
+ *
+ * The lower the bitrate, the fewer frames per second are sent and the smaller they are scaled,
+ * so every frame still gets enough bits. Frames are spread evenly over time, a camera faster
+ * than the allowed frame rate gets every n-th frame dropped instead of bursts and pauses.
+ * Safe to use from any thread.
+ *
+ * @var VideoEncodePacer::windowMs
+ * @brief Time over which the frame rate in the statistics is measured.
+ */
+
+namespace {
+// a frame is sent when at least this much of a frame interval has passed, to absorb jitter
+constexpr double minFrameCredit = 0.75;
+// how many frames may be sent in quick succession after a pause
+constexpr double maxFrameCredit = 2.0;
+} // namespace
+
+/**
+ * @param bitrate Video bitrate in kbit/s the call starts with.
+ */
+VideoEncodePacer::VideoEncodePacer(uint32_t bitrate)
+    : bitrate{bitrate}
+{
+}
+
+/**
+ * @brief Sets the bitrate recommended by toxav, applied to the encoder by takeBitrateChange().
+ */
+void VideoEncodePacer::setBitrate(uint32_t bitrate)
+{
+    QMutexLocker locker{&mutex};
+    bitrateChanged = bitrateChanged || bitrate != this->bitrate;
+    this->bitrate = bitrate;
+}
+
+/**
+ * @brief Returns true once after the bitrate changed.
+ * @param bitrate Set to the new bitrate the encoder should use.
+ */
+bool VideoEncodePacer::takeBitrateChange(uint32_t& bitrate)
+{
+    QMutexLocker locker{&mutex};
+    if (!bitrateChanged) {
+        return false;
+    }
+
+    bitrateChanged = false;
+    bitrate = this->bitrate;
+    return true;
+}
+
+/**
+ * @brief Decides whether a frame from the camera is sent.
+ * @param nowMs Current time of a monotonic clock in milliseconds.
+ * @return False if the frame has to be dropped to keep to the frame rate.
+ */
+bool VideoEncodePacer::beginFrame(qint64 nowMs)
+{
+    QMutexLocker locker{&mutex};
+    if (windowStartMs < 0) {
+        windowStartMs = nowMs;
+    }
+
+    const qint64 elapsedMs = nowMs - windowStartMs;
+    if (elapsedMs >= windowMs) {
+        framesPerSecond = windowFrames * 1000.0 / elapsedMs;
+        windowStartMs = nowMs;
+        windowFrames = 0;
+    }
+
+    if (lastFrameMs >= 0) {
+        frameCredit += (nowMs - lastFrameMs) * currentLevel().maxFps / 1000.0;
+        frameCredit = qMin(frameCredit, maxFrameCredit);
+    }
+    lastFrameMs = nowMs;
+
+    if (frameCredit < minFrameCredit) {
+        ++droppedFrames;
+        return false;
+    }
+
+    frameCredit -= 1.0;
+    return true;
+}
+
+/**
+ * @brief Size to scale a frame to before sending it, invalid to keep the source size.
+ */
+QSize VideoEncodePacer::getFrameSize(QSize sourceSize) const
+{
+    QMutexLocker locker{&mutex};
+    const int maxHeight = currentLevel().maxHeight;
+    if (maxHeight == 0 || sourceSize.height() <= maxHeight) {
+        return {};
+    }
+
+    // the encoder needs even dimensions for YUV420
+    const int width = static_cast<int>(static_cast<qint64>(sourceSize.width()) * maxHeight
+                                       / sourceSize.height());
+    return {width & ~1, maxHeight & ~1};
+}
+
+/**
+ * @brief Records a frame that beginFrame() accepted.
+ * @param sent False if toxav failed to take the frame, it counts as dropped.
+ * @param encodeNs Time spent converting and encoding the frame.
+ */
+void VideoEncodePacer::endFrame(bool sent, qint64 encodeNs)
+{
+    QMutexLocker locker{&mutex};
+    if (!sent) {
+        ++droppedFrames;
+        return;
+    }
+
+    ++windowFrames;
+    ++encodedFrames;
+    this->encodeNs += encodeNs;
+}
+
+VideoEncodePacer::Stats VideoEncodePacer::getStats() const
+{
+    QMutexLocker locker{&mutex};
+    Stats stats;
+    stats.framesPerSecond = framesPerSecond;
+    stats.droppedFrames = droppedFrames;
+    stats.averageEncodeUs = encodedFrames ? encodeNs / static_cast<qint64>(encodedFrames) / 1000 : 0;
+    return stats;
+}
+
+const VideoEncodePacer::Level& VideoEncodePacer::currentLevel() const
+{
+    // bitrate in kbit/s, frames per second, height in pixels or 0 for any
+    static const std::array<Level, 5> levels{{
+        {2000, 60, 0},
+        {1000, 30, 720},
+        {500, 25, 480},
+        {250, 20, 360},
+        {0, 15, 240},
+    }};
+
+    for (const Level& level : levels) {
+        if (bitrate >= level.minBitrate) {
+            return level;
+        }
+    }
+
+    return levels.back();
+}
@@ -0,0 +1,74 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <QMutex>
+#include <QSize>
+
+#include <cstdint>
+
+class VideoEncodePacer
+{
+public:
+    struct Stats
+    {
+        double framesPerSecond = 0.0;
+        quint64 droppedFrames = 0;
+        qint64 averageEncodeUs = 0;
+    };
+
+    static constexpr qint64 windowMs = 5000;
+
+    explicit VideoEncodePacer(uint32_t bitrate);
+
+    void setBitrate(uint32_t bitrate);
+    bool takeBitrateChange(uint32_t& bitrate);
+
+    bool beginFrame(qint64 nowMs);
+    QSize getFrameSize(QSize sourceSize) const;
+    void endFrame(bool sent, qint64 encodeNs);
+    Stats getStats() const;
+
+private:
+    struct Level
+    {
+        uint32_t minBitrate;
+        int maxFps;
+        int maxHeight;
+    };
+
+    const Level& currentLevel() const;
+
+private:
+    mutable QMutex mutex;
+    uint32_t bitrate;
+    bool bitrateChanged = false;
+
+    qint64 lastFrameMs = -1;
+    double frameCredit = 1.0;
+
+    qint64 windowStartMs = -1;
+    quint64 windowFrames = 0;
+    double framesPerSecond = 0.0;
+    quint64 droppedFrames = 0;
+    quint64 encodedFrames = 0;
+    qint64 encodeNs = 0;
+};
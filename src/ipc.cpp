@@ -20,6 +20,9 @@
 #include "src/ipc.h"
 #include <QCoreApplication>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QLocalSocket>
 #include <QThread>
 
 #include <chrono>
@@ -54,6 +57,17 @@ namespace
         }
         return QString("qtox-" IPC_PROTOCOL_VERSION "-") + user;
     }
+
+    QString getDoorbellName(uint64_t id)
+    {
+        return getIpcKey() + "-" + QString::number(id);
+    }
+
+    bool isExpired(const IPC::IPCEvent& evt, time_t now, int timeout)
+    {
+        return (evt.processed && difftime(now, evt.processed) > timeout)
+               || (!evt.processed && difftime(now, evt.posted) > timeout);
+    }
 } // namespace
 
 /**
@@ -62,11 +76,26 @@ namespace
  *
  * @var time_t IPC::lastProcessed
  * @brief When processEvents() ran last time
+ *
+ * @var uint32_t IPC::IPCMemory::head
+ * @brief Sequence number of the oldest event in the ring buffer
+ *
+ * @var uint32_t IPC::IPCMemory::tail
+ * @brief Sequence number the next posted event gets, the event is stored at tail % EVENT_QUEUE_SIZE
+ *
+ * @var uint64_t IPC::IPCMemory::instances
+ * @brief Global IDs of the running instances, each one listens on its own doorbell
  */
 
 /**
  * @class IPC
  * @brief Inter-process communication
+ *
+ * Events are stored in shared memory. Whenever an instance posts an event, it rings the doorbell
+ * of every other instance, a local socket the instance listens on, so the event is handled right
+ * away. The instance that processed an event rings the doorbell of its sender in turn, which
+ * wakes up waitUntilAccepted(). The timer only keeps the ownership alive and catches events of
+ * instances that couldn't be reached.
  */
 
 IPC::IPC(uint32_t profileId)
@@ -78,6 +107,7 @@ IPC::IPC(uint32_t profileId)
     timer.setInterval(EVENT_TIMER_MS);
     timer.setSingleShot(true);
     connect(&timer, &QTimer::timeout, this, &IPC::processEvents);
+    connect(&doorbell, &QLocalServer::newConnection, this, &IPC::onDoorbell);
 
     // The first started instance gets to manage the shared memory by taking ownership
     // Every time it processes events it updates the global shared timestamp "lastProcessed"
@@ -110,6 +140,13 @@ IPC::IPC(uint32_t profileId)
         return; // We won't be able to do any IPC without being attached, let's get outta here
     }
 
+    const QString doorbellName = getDoorbellName(globalId);
+    QLocalServer::removeServer(doorbellName);
+    if (!doorbell.listen(doorbellName)) {
+        qWarning() << "Failed to listen for IPC events, falling back to polling:"
+                   << doorbell.errorString();
+    }
+
     processEvents();
 }
 
@@ -120,8 +157,15 @@ IPC::~IPC()
         return;
     }
 
+    IPCMemory* mem = global();
     if (isCurrentOwnerNoLock()) {
-        global()->globalId = 0;
+        mem->globalId = 0;
+    }
+
+    for (uint64_t& instance : mem->instances) {
+        if (instance == globalId) {
+            instance = 0;
+        }
     }
     globalMemory.unlock();
 }
@@ -153,12 +197,13 @@ time_t IPC::postEvent(const QString& name, const QByteArray& data, uint32_t dest
     IPCMemory* mem = global();
     time_t result = 0;
 
-    for (uint32_t i = 0; !evt && i < EVENT_QUEUE_SIZE; ++i) {
-        if (mem->events[i].posted == 0) {
-            evt = &mem->events[i];
-        }
+    collectGarbage();
+    if (mem->tail - mem->head < EVENT_QUEUE_SIZE) {
+        evt = &mem->events[mem->tail % EVENT_QUEUE_SIZE];
+        ++mem->tail;
     }
 
+    QVector<uint64_t> instances;
     if (evt) {
         memset(evt, 0, sizeof(IPCEvent));
         memcpy(evt->name, binName.constData(), binName.length());
@@ -166,10 +211,21 @@ time_t IPC::postEvent(const QString& name, const QByteArray& data, uint32_t dest
         mem->lastEvent = evt->posted = result = qMax(mem->lastEvent + 1, time(nullptr));
         evt->dest = dest;
         evt->sender = getpid();
+        evt->senderId = globalId;
         qDebug() << "postEvent " << name << "to" << dest;
+
+        registerInstance();
+        for (uint64_t instance : mem->instances) {
+            if (instance) {
+                instances.append(instance);
+            }
+        }
+    } else {
+        qWarning() << "IPC event queue is full, dropping" << name;
     }
 
     globalMemory.unlock();
+    ringDoorbells(instances);
     return result;
 }
 
@@ -201,13 +257,16 @@ bool IPC::isEventAccepted(time_t time)
         return result;
     }
 
-    if (difftime(global()->lastProcessed, time) > 0) {
-        IPCMemory* mem = global();
-        for (uint32_t i = 0; i < EVENT_QUEUE_SIZE; ++i) {
-            if (mem->events[i].posted == time && mem->events[i].processed) {
-                result = mem->events[i].accepted;
-                break;
+    IPCMemory* mem = global();
+    for (uint32_t seq = mem->head; seq != mem->tail; ++seq) {
+        IPCEvent& evt = mem->events[seq % EVENT_QUEUE_SIZE];
+        if (evt.posted == time && evt.processed) {
+            result = evt.accepted;
+            // the result was delivered, free the slot for the garbage collection
+            if (evt.senderId == globalId) {
+                evt.posted = 0;
             }
+            break;
         }
     }
     globalMemory.unlock();
@@ -215,21 +274,35 @@ bool IPC::isEventAccepted(time_t time)
     return result;
 }
 
+/**
+ * @brief Waits until the event was accepted by another instance.
+ * @param timeout Time in seconds to wait at most, -1 to wait forever.
+ * @return True if the event was accepted, false on timeout.
+ */
 bool IPC::waitUntilAccepted(time_t postTime, int32_t timeout /*=-1*/)
 {
-    bool result = false;
-    time_t start = time(nullptr);
+    QElapsedTimer elapsed;
+    elapsed.start();
     forever
     {
-        result = isEventAccepted(postTime);
-        if (result || (timeout > 0 && difftime(time(nullptr), start) >= timeout)) {
-            break;
+        if (isEventAccepted(postTime)) {
+            return true;
         }
 
-        qApp->processEvents();
-        QThread::msleep(0);
+        qint64 remainingMs = EVENT_TIMER_MS;
+        if (timeout > 0) {
+            remainingMs = qMin(remainingMs, timeout * 1000 - elapsed.elapsed());
+            if (remainingMs <= 0) {
+                return false;
+            }
+        }
+
+        // The instance processing the event rings our doorbell, wait for that or the timeout
+        QEventLoop loop;
+        connect(&doorbell, &QLocalServer::newConnection, &loop, &QEventLoop::quit);
+        QTimer::singleShot(static_cast<int>(remainingMs), &loop, &QEventLoop::quit);
+        loop.exec();
     }
-    return result;
 }
 
 bool IPC::isAttached() const
@@ -249,18 +322,12 @@ void IPC::setProfileId(uint32_t profileId)
 IPC::IPCEvent* IPC::fetchEvent()
 {
     IPCMemory* mem = global();
-    for (uint32_t i = 0; i < EVENT_QUEUE_SIZE; ++i) {
-        IPCEvent* evt = &mem->events[i];
-
-        // Garbage-collect events that were not processed in EVENT_GC_TIMEOUT
-        // and events that were processed and EVENT_GC_TIMEOUT passed after
-        // so sending instance has time to react to those events.
-        if ((evt->processed && difftime(time(nullptr), evt->processed) > EVENT_GC_TIMEOUT)
-            || (!evt->processed && difftime(time(nullptr), evt->posted) > EVENT_GC_TIMEOUT)) {
-            memset(evt, 0, sizeof(IPCEvent));
-        }
-
-        if (evt->posted && !evt->processed && evt->sender != getpid()
+    const time_t now = time(nullptr);
+    collectGarbage();
+    for (uint32_t seq = mem->head; seq != mem->tail; ++seq) {
+        IPCEvent* evt = &mem->events[seq % EVENT_QUEUE_SIZE];
+        if (evt->posted && !evt->processed && !isExpired(*evt, now, EVENT_GC_TIMEOUT)
+            && evt->sender != getpid()
             && (evt->dest == profileId || (evt->dest == 0 && isCurrentOwnerNoLock()))) {
             return evt;
         }
@@ -269,6 +336,97 @@ IPC::IPCEvent* IPC::fetchEvent()
     return nullptr;
 }
 
+/**
+ * @brief Only called when global memory IS LOCKED.
+ *
+ * Garbage-collects events at the head of the ring that were not processed in EVENT_GC_TIMEOUT
+ * and events that were processed and EVENT_GC_TIMEOUT passed after, so the sending instance has
+ * time to react to those events.
+ */
+void IPC::collectGarbage()
+{
+    IPCMemory* mem = global();
+    const time_t now = time(nullptr);
+    while (mem->head != mem->tail) {
+        IPCEvent& evt = mem->events[mem->head % EVENT_QUEUE_SIZE];
+        if (evt.posted && !isExpired(evt, now, EVENT_GC_TIMEOUT)) {
+            break;
+        }
+
+        memset(&evt, 0, sizeof(IPCEvent));
+        ++mem->head;
+    }
+}
+
+/**
+ * @brief Only called when global memory IS LOCKED. Makes other instances ring our doorbell.
+ */
+void IPC::registerInstance()
+{
+    if (!doorbell.isListening()) {
+        return;
+    }
+
+    uint64_t* freeSlot = nullptr;
+    for (uint64_t& instance : global()->instances) {
+        if (instance == globalId) {
+            return;
+        }
+
+        if (!instance && !freeSlot) {
+            freeSlot = &instance;
+        }
+    }
+
+    if (freeSlot) {
+        *freeSlot = globalId;
+    }
+}
+
+/**
+ * @brief Wakes up other instances to process their events.
+ * @param ids Global IDs of the instances, instances that can't be reached are unregistered.
+ */
+void IPC::ringDoorbells(const QVector<uint64_t>& ids)
+{
+    QVector<uint64_t> unreachable;
+    for (uint64_t id : ids) {
+        if (id == globalId) {
+            continue;
+        }
+
+        QLocalSocket socket;
+        socket.connectToServer(getDoorbellName(id));
+        if (socket.waitForConnected(DOORBELL_TIMEOUT_MS)) {
+            socket.disconnectFromServer();
+        } else if (socket.error() == QLocalSocket::ServerNotFoundError
+                   || socket.error() == QLocalSocket::ConnectionRefusedError) {
+            unreachable.append(id);
+        }
+    }
+
+    if (unreachable.isEmpty() || !globalMemory.lock()) {
+        return;
+    }
+
+    // most likely crashed, don't try them again
+    for (uint64_t& instance : global()->instances) {
+        if (unreachable.contains(instance)) {
+            instance = 0;
+        }
+    }
+    globalMemory.unlock();
+}
+
+void IPC::onDoorbell()
+{
+    while (QLocalSocket* socket = doorbell.nextPendingConnection()) {
+        socket->deleteLater();
+    }
+
+    processEvents();
+}
+
 bool IPC::runEventHandler(IPCEventHandler handler, const QByteArray& arg)
 {
     bool result = false;
@@ -309,6 +467,9 @@ void IPC::processEvents()
         // Non-main instance is limited to events destined for specific profile it runs
     }
 
+    registerInstance();
+
+    QVector<uint64_t> senders;
     while (IPCEvent* evt = fetchEvent()) {
         QString name = QString::fromUtf8(evt->name);
         auto it = eventHandlers.find(name);
@@ -326,6 +487,10 @@ void IPC::processEvents()
             } else {
                 evt->processed = time(nullptr);
             }
+
+            if (evt->processed && !senders.contains(evt->senderId)) {
+                senders.append(evt->senderId);
+            }
         } else {
             qDebug() << "Received event:" << name << "without handler";
             qDebug() << "Available handlers:" << eventHandlers.keys();
@@ -333,6 +498,7 @@ void IPC::processEvents()
     }
 
     globalMemory.unlock();
+    ringDoorbells(senders);
     timer.start();
 }
 
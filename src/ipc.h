@@ -20,16 +20,18 @@
 
 #pragma once
 
+#include <QLocalServer>
 #include <QMap>
 #include <QObject>
 #include <QSharedMemory>
 #include <QTimer>
+#include <QVector>
 #include <ctime>
 #include <functional>
 
 using IPCEventHandler = std::function<bool(const QByteArray&)>;
 
-#define IPC_PROTOCOL_VERSION "2"
+#define IPC_PROTOCOL_VERSION "3"
 
 class IPC : public QObject
 {
@@ -39,7 +41,9 @@ protected:
     static const int EVENT_TIMER_MS = 1000;
     static const int EVENT_GC_TIMEOUT = 5;
     static const int EVENT_QUEUE_SIZE = 32;
+    static const int MAX_INSTANCES = 16;
     static const int OWNERSHIP_TIMEOUT_S = 5;
+    static const int DOORBELL_TIMEOUT_MS = 100;
 
 public:
     IPC(uint32_t profileId);
@@ -49,6 +53,7 @@ public:
     {
         uint32_t dest;
         int32_t sender;
+        uint64_t senderId;
         char name[16];
         char data[128];
         time_t posted;
@@ -63,6 +68,9 @@ public:
         uint64_t globalId;
         time_t lastEvent;
         time_t lastProcessed;
+        uint32_t head;
+        uint32_t tail;
+        uint64_t instances[IPC::MAX_INSTANCES];
         IPCEvent events[IPC::EVENT_QUEUE_SIZE];
     };
 
@@ -76,15 +84,22 @@ public:
 public slots:
     void setProfileId(uint32_t profileId);
 
+private slots:
+    void onDoorbell();
+
 private:
     IPCMemory* global();
     bool runEventHandler(IPCEventHandler handler, const QByteArray& arg);
     IPCEvent* fetchEvent();
     void processEvents();
     bool isCurrentOwnerNoLock();
+    void collectGarbage();
+    void registerInstance();
+    void ringDoorbells(const QVector<uint64_t>& ids);
 
 private:
     QTimer timer;
+    QLocalServer doorbell;
     uint64_t globalId;
     uint32_t profileId;
     QSharedMemory globalMemory;
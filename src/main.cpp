@@ -21,6 +21,7 @@
 #include "src/ipc.h"
 #include "src/net/toxuri.h"
 #include "src/nexus.h"
+#include "src/persistence/logwriter.h"
 #include "src/persistence/profile.h"
 #include "src/persistence/settings.h"
 #include "src/persistence/toxsave.h"
@@ -35,10 +36,11 @@
 #include <QDir>
 #include <QFile>
 #include <QFontDatabase>
-#include <QMutex>
-#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QStringBuilder>
 
 #include <QtWidgets/QMessageBox>
+#include <cstdlib>
 #include <ctime>
 #include <sodium.h>
 #include <stdio.h>
@@ -47,12 +49,8 @@
 #include "platform/posixsignalnotifier.h"
 #endif
 
-#ifdef LOG_TO_FILE
-static QAtomicPointer<FILE> logFileFile = nullptr;
-static QList<QByteArray>* logBuffer =
-    new QList<QByteArray>(); // Store log messages until log file opened
-QMutex* logBufferMutex = new QMutex();
-#endif
+// Never deleted, messages can still be logged while static objects are destroyed
+static LogWriter* logWriter = nullptr;
 
 void cleanup()
 {
@@ -70,31 +68,38 @@ void cleanup()
     Settings::destroyInstance();
     qDebug() << "Cleanup success";
 
-#ifdef LOG_TO_FILE
-#if (QT_VERSION >= QT_VERSION_CHECK(5, 14, 0))
-    FILE* f = logFileFile.loadRelaxed();
-#else
-    FILE* f = logFileFile.load();
-#endif
-    if (f != nullptr) {
-        fclose(f);
-#if (QT_VERSION >= QT_VERSION_CHECK(5, 14, 0))
-        logFileFile.storeRelaxed(nullptr); // atomically disable logging to file
-#else
-        logFileFile.store(nullptr); // atomically disable logging to file
-#endif
+    logWriter->stop();
+}
+
+static QLatin1String logLevelName(QtMsgType type)
+{
+    switch (type) {
+    case QtDebugMsg:
+        return QLatin1String("Debug");
+    case QtInfoMsg:
+        return QLatin1String("Info");
+    case QtWarningMsg:
+        return QLatin1String("Warning");
+    case QtCriticalMsg:
+        return QLatin1String("Critical");
+    case QtFatalMsg:
+        return QLatin1String("Fatal");
+    default:
+        return QLatin1String("");
     }
-#endif
 }
 
 void logMessageHandler(QtMsgType type, const QMessageLogContext& ctxt, const QString& msg)
 {
     // Silence qWarning spam due to bug in QTextBrowser (trying to open a file for base64 images)
-    if (ctxt.function == QString("virtual bool QFSFileEngine::open(QIODevice::OpenMode)")
-        && msg == QString("QFSFileEngine::open: No file name specified"))
+    static const QLatin1String qfsFunction{"virtual bool QFSFileEngine::open(QIODevice::OpenMode)"};
+    static const QString qfsMessage = QStringLiteral("QFSFileEngine::open: No file name specified");
+    if (ctxt.function && QLatin1String(ctxt.function) == qfsFunction && msg == qfsMessage)
         return;
 
-    QRegExp snoreFilter{QStringLiteral("Snore::Notification.*was already closed")};
+    static const QRegularExpression snoreFilter{
+        QStringLiteral("Snore::Notification.*was already closed"),
+        QRegularExpression::OptimizeOnFirstUsageOption};
     if (type == QtWarningMsg
         && msg.contains(snoreFilter))
     {
@@ -107,68 +112,23 @@ void logMessageHandler(QtMsgType type, const QMessageLogContext& ctxt, const QSt
     QString file = ctxt.file;
     // We're not using QT_MESSAGELOG_FILE here, because that can be 0, NULL, or
     // nullptr in release builds.
-    QString path = QString(__FILE__);
-    path = path.left(path.lastIndexOf('/') + 1);
+    static const QString path = QString(__FILE__).left(QString(__FILE__).lastIndexOf('/') + 1);
     if (file.startsWith(path)) {
         file = file.mid(path.length());
     }
 
     // Time should be in UTC to save user privacy on log sharing
-    QTime time = QDateTime::currentDateTime().toUTC().time();
-    QString LogMsg =
-        QString("[%1 UTC] %2:%3 : ").arg(time.toString("HH:mm:ss.zzz")).arg(file).arg(ctxt.line);
-    switch (type) {
-    case QtDebugMsg:
-        LogMsg += "Debug";
-        break;
-    case QtInfoMsg:
-        LogMsg += "Info";
-        break;
-    case QtWarningMsg:
-        LogMsg += "Warning";
-        break;
-    case QtCriticalMsg:
-        LogMsg += "Critical";
-        break;
-    case QtFatalMsg:
-        LogMsg += "Fatal";
-        break;
-    default:
-        break;
+    const QTime time = QDateTime::currentDateTimeUtc().time();
+    const QString logMsg = QStringLiteral("[") % time.toString(QStringLiteral("HH:mm:ss.zzz"))
+                           % QStringLiteral(" UTC] ") % file % QLatin1Char(':')
+                           % QString::number(ctxt.line) % QStringLiteral(" : ")
+                           % logLevelName(type) % QStringLiteral(": ") % msg % QLatin1Char('\n');
+    logWriter->log(logMsg.toUtf8());
+
+    if (type == QtFatalMsg) {
+        // the application is aborted as soon as this returns
+        logWriter->stop();
     }
-
-    LogMsg += ": " + msg + "\n";
-    QByteArray LogMsgBytes = LogMsg.toUtf8();
-    fwrite(LogMsgBytes.constData(), 1, LogMsgBytes.size(), stderr);
-
-#ifdef LOG_TO_FILE
-#if (QT_VERSION >= QT_VERSION_CHECK(5, 14, 0))
-    FILE* logFilePtr = logFileFile.loadRelaxed(); // atomically load the file pointer
-#else
-    FILE* logFilePtr = logFileFile.load(); // atomically load the file pointer
-#endif
-    if (!logFilePtr) {
-        logBufferMutex->lock();
-        if (logBuffer)
-            logBuffer->append(LogMsgBytes);
-
-        logBufferMutex->unlock();
-    } else {
-        logBufferMutex->lock();
-        if (logBuffer) {
-            // empty logBuffer to file
-            foreach (QByteArray msg, *logBuffer)
-                fwrite(msg.constData(), 1, msg.size(), logFilePtr);
-
-            delete logBuffer; // no longer needed
-            logBuffer = nullptr;
-        }
-        logBufferMutex->unlock();
-
-        fwrite(LogMsgBytes.constData(), 1, LogMsgBytes.size(), logFilePtr);
-        fflush(logFilePtr);
-    }
-#endif
 }
 
 static std::unique_ptr<ToxURIDialog> uriDialog;
@@ -194,6 +154,14 @@ int main(int argc, char* argv[])
     QGuiApplication::setAttribute(Qt::AA_UseHighDpiPixmaps);
 #endif
 
+#ifdef LOG_TO_FILE
+    logWriter = new LogWriter(stderr, true);
+#else
+    logWriter = new LogWriter(stderr, false);
+#endif
+    logWriter->start();
+    // write what is still queued when returning early, before the log file is set
+    std::atexit([]() { logWriter->stop(); });
     qInstallMessageHandler(logMessageHandler);
 
     std::unique_ptr<QApplication> a(new QApplication(argc, argv));
@@ -279,40 +247,7 @@ int main(int argc, char* argv[])
     QString logFileDir = settings.getPaths().getAppCacheDirPath();
     QDir(logFileDir).mkpath(".");
 
-    QString logfile = logFileDir + "qtox.log";
-    FILE* mainLogFilePtr = fopen(logfile.toLocal8Bit().constData(), "a");
-
-    // Trim log file if over 1MB
-    if (QFileInfo(logfile).size() > 1000000) {
-        qDebug() << "Log file over 1MB, rotating...";
-
-        // close old logfile (need for windows)
-        if (mainLogFilePtr)
-            fclose(mainLogFilePtr);
-
-        QDir dir(logFileDir);
-
-        // Check if log.1 already exists, and if so, delete it
-        if (dir.remove(logFileDir + "qtox.log.1"))
-            qDebug() << "Removed old log successfully";
-        else
-            qWarning() << "Unable to remove old log file";
-
-        if (!dir.rename(logFileDir + "qtox.log", logFileDir + "qtox.log.1"))
-            qCritical() << "Unable to move logs";
-
-        // open a new logfile
-        mainLogFilePtr = fopen(logfile.toLocal8Bit().constData(), "a");
-    }
-
-    if (!mainLogFilePtr)
-        qCritical() << "Couldn't open logfile" << logfile;
-
-#if (QT_VERSION >= QT_VERSION_CHECK(5, 14, 0))
-    logFileFile.storeRelaxed(mainLogFilePtr); // atomically set the logFile
-#else
-    logFileFile.store(mainLogFilePtr); // atomically set the logFile
-#endif
+    logWriter->setFile(logFileDir + "qtox.log");
 #endif
 
     // Windows platform plugins DLL hell fix
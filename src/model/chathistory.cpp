@@ -22,6 +22,12 @@
 #include "src/widget/form/chatform.h"
 
 namespace {
+// Enough for a few screens of messages and the surrounding search results
+constexpr size_t maxCachedMessages = 16 * SessionChatLog::chunkSize;
+
+// Rows read from history per query of a background search
+constexpr size_t searchPageSize = 2000;
+
 /**
  * @brief Determines if the given idx needs to be loaded from history
  * @param[in] idx index to check
@@ -30,18 +36,20 @@ namespace {
  */
 bool needsLoadFromHistory(ChatLogIdx idx, const SessionChatLog& sessionChatLog)
 {
-    return idx < sessionChatLog.getFirstIdx();
+    return !sessionChatLog.contains(idx);
 }
 
 /**
- * @brief Finds the first item in sessionChatLog that contains a message
+ * @brief Finds the first message in the range of cached items that contains the given index
  * @param[in] sessionChatLog
+ * @param[in] idx
  * @return index of first message
  */
-ChatLogIdx findFirstMessage(const SessionChatLog& sessionChatLog)
+ChatLogIdx findFirstMessage(const SessionChatLog& sessionChatLog, ChatLogIdx idx)
 {
-    auto it = sessionChatLog.getFirstIdx();
-    while (it < sessionChatLog.getNextIdx()) {
+    auto it = sessionChatLog.getCachedRangeStart(idx);
+    const auto end = sessionChatLog.getCachedRangeEnd(idx);
+    while (it < end) {
         if (sessionChatLog.at(it).getContentType() == ChatLogItem::ContentType::message) {
             return it;
         }
@@ -102,7 +110,9 @@ ChatHistory::ChatHistory(Friend& f_, History* history_, const ICoreIdHandler& co
                                : sessionChatLog.getFirstIdx() - defaultNumMessagesToLoad;
 
     if (canUseHistory()) {
-        loadHistoryIntoSessionChatLog(firstChatLogIdx);
+        // Everything can be loaded again from history, so don't keep all of it around
+        sessionChatLog.setCacheLimit(maxCachedMessages);
+        loadHistoryIntoSessionChatLog(firstChatLogIdx, sessionChatLog.getNextIdx());
     }
 
     // We don't manage any of the item updates ourselves, we just forward along
@@ -128,23 +138,45 @@ SearchResult ChatHistory::searchForward(SearchPos startIdx, const QString& phras
         return res;
     }
 
-    if (canUseHistory()) {
+    if (!canUseHistory()) {
+        return sessionChatLog.searchForward(startIdx, phrase, parameter);
+    }
+
+    // The session chat log stops searching at items it doesn't hold, so evicted
+    // ranges are loaded one chunk at a time
+    while (startIdx.logIdx < getNextIdx()) {
         ensureIdxInSessionChatLog(startIdx.logIdx);
+
+        auto res = sessionChatLog.searchForward(startIdx, phrase, parameter);
+        if (res.found) {
+            return res;
+        }
+
+        startIdx.logIdx = sessionChatLog.getCachedRangeEnd(startIdx.logIdx);
+        startIdx.numMatches = 0;
     }
 
-    return sessionChatLog.searchForward(startIdx, phrase, parameter);
+    SearchResult res;
+    res.found = false;
+    return res;
 }
 
 SearchResult ChatHistory::searchBackward(SearchPos startIdx, const QString& phrase,
                                          const ParameterSearch& parameter) const
 {
+    if (canUseHistory() && startIdx.logIdx < getNextIdx()) {
+        ensureIdxInSessionChatLog(startIdx.logIdx);
+    }
+
     auto res = sessionChatLog.searchBackward(startIdx, phrase, parameter);
 
     if (res.found || !canUseHistory()) {
         return res;
     }
 
-    auto earliestMessage = findFirstMessage(sessionChatLog);
+    auto earliestMessage = startIdx.logIdx < getNextIdx()
+                               ? findFirstMessage(sessionChatLog, startIdx.logIdx)
+                               : ChatLogIdx(-1);
 
     auto earliestMessageDate =
         (earliestMessage == ChatLogIdx(-1))
@@ -162,7 +194,7 @@ SearchResult ChatHistory::searchBackward(SearchPos startIdx, const QString& phra
 
     if (dateWherePhraseFound.isValid()) {
         auto loadIdx = history->getNumMessagesForFriendBeforeDate(f.getPublicKey(), dateWherePhraseFound);
-        loadHistoryIntoSessionChatLog(ChatLogIdx(loadIdx));
+        ensureIdxInSessionChatLog(ChatLogIdx(loadIdx));
 
         // Reset search pos to the message we just loaded to avoid a double search
         startIdx.logIdx = ChatLogIdx(loadIdx);
@@ -175,6 +207,46 @@ SearchResult ChatHistory::searchBackward(SearchPos startIdx, const QString& phra
     return ret;
 }
 
+SearchTextReader ChatHistory::createSearchTextReader(SearchDirection direction) const
+{
+    if (!canUseHistory()) {
+        return sessionChatLog.createSearchTextReader(direction);
+    }
+
+    // Read history directly, loading everything through the session chat log would
+    // evict what the user is looking at
+    History* history = this->history;
+    const ToxPk friendPk = f.getPublicKey();
+    bool started = false;
+    RowId lastId{-1};
+    ChatLogIdx nextIdx{0};
+    return [history, friendPk, direction, started, lastId, nextIdx]() mutable {
+        if (!started && direction == SearchDirection::Up) {
+            // Pin the newest message, so messages arriving while we search don't shift indexes
+            const auto last = history->getNumMessagesAndLastIdForFriend(friendPk);
+            nextIdx = ChatLogIdx(last.first);
+            lastId = RowId{last.second.get() + 1};
+        }
+        started = true;
+
+        auto rows = history->getMessageTextsForFriend(friendPk, lastId, searchPageSize, direction);
+
+        std::vector<SearchText> page;
+        page.reserve(rows.size());
+        for (auto& row : rows) {
+            lastId = row.first;
+            handleActionPrefix(row.second);
+            if (direction == SearchDirection::Up) {
+                nextIdx = nextIdx - 1;
+                page.push_back({nextIdx, row.second});
+            } else {
+                page.push_back({nextIdx++, row.second});
+            }
+        }
+        return page;
+    };
+}
+
 ChatLogIdx ChatHistory::getFirstIdx() const
 {
     if (canUseHistory()) {
@@ -247,6 +319,12 @@ void ChatHistory::onFileUpdated(const ToxPk& sender, const ToxFile& file)
     sessionChatLog.onFileUpdated(sender, file);
 }
 
+void ChatHistory::onFileProgress(const ToxFileProgressInfo& info)
+{
+    // Progress is not persisted, history only records the start and the end of transfers
+    sessionChatLog.onFileProgress(info);
+}
+
 void ChatHistory::onFileTransferRemotePausedUnpaused(const ToxPk& sender, const ToxFile& file,
                                                      bool paused)
 {
@@ -315,7 +393,7 @@ void ChatHistory::onMessageBroken(DispatchedMessageId id, BrokenMessageReason re
 }
 
 /**
- * @brief Forces the given index and all future indexes to be in the chatlog
+ * @brief Forces the chunk of the given index to be in the chatlog
  * @param[in] idx
  * @note Marked const since this doesn't change _external_ state of the class. We
      still have all the same items at all the same indexes, we've just stuckem
@@ -324,27 +402,44 @@ void ChatHistory::onMessageBroken(DispatchedMessageId id, BrokenMessageReason re
 void ChatHistory::ensureIdxInSessionChatLog(ChatLogIdx idx) const
 {
     if (needsLoadFromHistory(idx, sessionChatLog)) {
-        loadHistoryIntoSessionChatLog(idx);
+        const auto chunkStart = ChatLogIdx(idx.get() - idx.get() % SessionChatLog::chunkSize);
+        const auto chunkEnd = std::min(chunkStart + SessionChatLog::chunkSize, getNextIdx());
+        loadHistoryIntoSessionChatLog(chunkStart, chunkEnd);
     }
 }
+
 /**
- * @brief Unconditionally loads the given index and all future messages that
- * are not in the session chat log into the session chat log
- * @param[in] idx
+ * @brief Loads all messages in [start, end) that are not in the session chat log
+ * into the session chat log
+ * @param[in] start
+ * @param[in] end
  * @note Marked const since this doesn't change _external_ state of the class. We
    still have all the same items at all the same indexes, we've just stuckem
    in ram
- * @note no end idx as we always load from start -> latest. In the future we
- * could have a less contiguous history
  */
-void ChatHistory::loadHistoryIntoSessionChatLog(ChatLogIdx start) const
+void ChatHistory::loadHistoryIntoSessionChatLog(ChatLogIdx start, ChatLogIdx end) const
 {
-    if (!needsLoadFromHistory(start, sessionChatLog)) {
-        return;
-    }
+    while (start < end) {
+        if (!needsLoadFromHistory(start, sessionChatLog)) {
+            start = sessionChatLog.getCachedRangeEnd(start);
+            continue;
+        }
+
+        auto rangeEnd = start + 1;
+        while (rangeEnd < end && needsLoadFromHistory(rangeEnd, sessionChatLog)) {
+            ++rangeEnd;
+        }
 
-    auto end = sessionChatLog.getFirstIdx();
+        loadRangeIntoSessionChatLog(start, rangeEnd);
+        start = rangeEnd;
+    }
+}
 
+/**
+ * @brief Loads [start, end) from history, none of these may be in the session chat log
+ */
+void ChatHistory::loadRangeIntoSessionChatLog(ChatLogIdx start, ChatLogIdx end) const
+{
     // We know that both history and us have a start index of 0 so the type
     // conversion should be safe
     assert(getFirstIdx() == ChatLogIdx(0));
@@ -39,12 +39,14 @@ public:
                                const ParameterSearch& parameter) const override;
     SearchResult searchBackward(SearchPos startIdx, const QString& phrase,
                                 const ParameterSearch& parameter) const override;
+    SearchTextReader createSearchTextReader(SearchDirection direction) const override;
     ChatLogIdx getFirstIdx() const override;
     ChatLogIdx getNextIdx() const override;
     std::vector<DateChatLogIdxPair> getDateIdxs(const QDate& startDate, size_t maxDates) const override;
 
 public slots:
     void onFileUpdated(const ToxPk& sender, const ToxFile& file);
+    void onFileProgress(const ToxFileProgressInfo& info);
     void onFileTransferRemotePausedUnpaused(const ToxPk& sender, const ToxFile& file, bool paused);
     void onFileTransferBrokenUnbroken(const ToxPk& sender, const ToxFile& file, bool broken);
 
@@ -56,7 +58,8 @@ private slots:
 
 private:
     void ensureIdxInSessionChatLog(ChatLogIdx idx) const;
-    void loadHistoryIntoSessionChatLog(ChatLogIdx start) const;
+    void loadHistoryIntoSessionChatLog(ChatLogIdx start, ChatLogIdx end) const;
+    void loadRangeIntoSessionChatLog(ChatLogIdx start, ChatLogIdx end) const;
     void dispatchUnsentMessages(IMessageDispatcher& messageDispatcher);
     void handleDispatchedMessage(DispatchedMessageId dispatchId, RowId historyId);
     void completeMessage(DispatchedMessageId id);
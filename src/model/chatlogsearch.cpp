@@ -0,0 +1,274 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "chatlogsearch.h"
+
+#include <QMutexLocker>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
+#include <limits>
+
+/**
+ * @class ChatLogSearch
+ * @brief Finds all matches of a phrase in a chat log on a background thread.
+ *
+ * Matches are streamed into a sorted index while the chat log is read, so the first
+ * results can be shown before the whole conversation has been searched. Once a match
+ * is known, stepping to the next or previous one doesn't search again.
+ *
+ * Results are only returned once everything between the given position and the result
+ * has been read. If findNext() or findPrevious() return nothing while isRunning() is
+ * true, try again on resultsUpdated() or finished().
+ */
+
+ChatLogSearch::ChatLogSearch(QObject* parent)
+    : QObject(parent)
+{
+    pool.setMaxThreadCount(1);
+}
+
+ChatLogSearch::~ChatLogSearch()
+{
+    cancel();
+}
+
+/**
+ * @brief Starts a new search, a running search is cancelled
+ * @param chatLog Chat log to search, only used to create its reader
+ * @param phrase Phrase to find
+ * @param parameter Search parameters, only the filter is used
+ * @param direction Down to read the oldest messages first, Up to read the newest first
+ */
+void ChatLogSearch::start(const IChatLog& chatLog, const QString& phrase,
+                          const ParameterSearch& parameter, SearchDirection direction)
+{
+    const quint64 searchGeneration = ++generation;
+    this->phrase = phrase;
+    this->parameter = parameter;
+    regexp = SearchExtraFunctions::getRegexpForPhrase(phrase, parameter.filter);
+
+    {
+        QMutexLocker locker{&resultsMutex};
+        results.clear();
+        cursor = 0;
+        running = true;
+        if (direction == SearchDirection::Down) {
+            scanBegin = ChatLogIdx(0);
+            scanEnd = ChatLogIdx(0);
+        } else {
+            scanBegin = ChatLogIdx(std::numeric_limits<size_t>::max());
+            scanEnd = ChatLogIdx(std::numeric_limits<size_t>::max());
+        }
+    }
+
+    auto reader = chatLog.createSearchTextReader(direction);
+    auto searchRegexp = regexp;
+    QtConcurrent::run(&pool, [this, reader, searchRegexp, direction, searchGeneration]() {
+        run(reader, searchRegexp, direction, searchGeneration);
+    });
+}
+
+/**
+ * @brief Stops the running search, results found so far are kept
+ */
+void ChatLogSearch::cancel()
+{
+    ++generation;
+
+    QMutexLocker locker{&resultsMutex};
+    running = false;
+}
+
+bool ChatLogSearch::isRunning() const
+{
+    QMutexLocker locker{&resultsMutex};
+    return running;
+}
+
+/**
+ * @return True if the last search was started for the given phrase and filter
+ */
+bool ChatLogSearch::isSearching(const QString& phrase, const ParameterSearch& parameter) const
+{
+    return this->phrase == phrase && this->parameter.filter == parameter.filter;
+}
+
+size_t ChatLogSearch::getNumResults() const
+{
+    QMutexLocker locker{&resultsMutex};
+    return results.size();
+}
+
+void ChatLogSearch::run(SearchTextReader reader, QRegularExpression searchRegexp,
+                        SearchDirection direction, quint64 searchGeneration)
+{
+    while (searchGeneration == generation) {
+        const auto page = reader();
+        if (page.empty()) {
+            break;
+        }
+
+        std::vector<Match> found;
+        for (const auto& text : page) {
+            if (text.text.isEmpty()) {
+                continue;
+            }
+
+            auto it = searchRegexp.globalMatch(text.text);
+            size_t numMatches = 0;
+            while (it.hasNext()) {
+                const auto match = it.next();
+                found.push_back({SearchPos{text.idx, ++numMatches}, match.capturedStart(),
+                                 match.capturedLength()});
+            }
+        }
+
+        {
+            QMutexLocker locker{&resultsMutex};
+            if (searchGeneration != generation) {
+                return;
+            }
+
+            if (direction == SearchDirection::Down) {
+                results.insert(results.end(), found.begin(), found.end());
+                scanEnd = page.back().idx + 1;
+            } else {
+                // Pages come newest first, but matches in a message are still in order
+                std::sort(found.begin(), found.end(), [](const Match& a, const Match& b) {
+                    return a.pos < b.pos;
+                });
+                results.insert(results.begin(), found.begin(), found.end());
+                cursor += found.size();
+                scanBegin = page.back().idx;
+            }
+        }
+
+        emit resultsUpdated();
+    }
+
+    {
+        QMutexLocker locker{&resultsMutex};
+        if (searchGeneration != generation) {
+            return;
+        }
+        running = false;
+    }
+
+    emit finished();
+}
+
+/**
+ * @return True if all matches after idx are known
+ * @note resultsMutex must be held
+ */
+bool ChatLogSearch::isCoveredAfter(ChatLogIdx idx) const
+{
+    return !running || scanBegin <= idx;
+}
+
+/**
+ * @return True if all matches up to and including idx are known
+ * @note resultsMutex must be held
+ */
+bool ChatLogSearch::isCoveredBefore(ChatLogIdx idx) const
+{
+    return !running || idx < scanEnd;
+}
+
+/**
+ * @brief Finds the first match after pos
+ * @param pos Position of the current match, or numMatches 0 to include all matches at logIdx
+ */
+SearchResult ChatLogSearch::findNext(SearchPos pos) const
+{
+    QMutexLocker locker{&resultsMutex};
+    if (!isCoveredAfter(pos.logIdx)) {
+        return SearchResult{};
+    }
+
+    size_t next;
+    if (cursor < results.size() && results[cursor].pos == pos) {
+        next = cursor + 1;
+    } else {
+        auto it = std::upper_bound(results.begin(), results.end(), pos,
+                                   [](const SearchPos& p, const Match& match) {
+                                       return p < match.pos;
+                                   });
+        next = static_cast<size_t>(it - results.begin());
+    }
+
+    if (next >= results.size()) {
+        return SearchResult{};
+    }
+
+    cursor = next;
+    return makeResult(next);
+}
+
+/**
+ * @brief Finds the last match before pos
+ * @param pos Position of the current match, or numMatches 0 to include all matches at logIdx
+ */
+SearchResult ChatLogSearch::findPrevious(SearchPos pos) const
+{
+    QMutexLocker locker{&resultsMutex};
+    if (!isCoveredBefore(pos.logIdx)) {
+        return SearchResult{};
+    }
+
+    if (pos.numMatches == 0) {
+        pos.numMatches = std::numeric_limits<size_t>::max();
+    }
+
+    size_t end;
+    if (cursor < results.size() && results[cursor].pos == pos) {
+        end = cursor;
+    } else {
+        auto it = std::lower_bound(results.begin(), results.end(), pos,
+                                   [](const Match& match, const SearchPos& p) {
+                                       return match.pos < p;
+                                   });
+        end = static_cast<size_t>(it - results.begin());
+    }
+
+    if (end == 0) {
+        return SearchResult{};
+    }
+
+    cursor = end - 1;
+    return makeResult(cursor);
+}
+
+/**
+ * @note resultsMutex must be held
+ */
+SearchResult ChatLogSearch::makeResult(size_t resultIdx) const
+{
+    const auto& match = results[resultIdx];
+
+    SearchResult result;
+    result.found = true;
+    result.pos = match.pos;
+    result.start = static_cast<size_t>(match.start);
+    result.len = static_cast<size_t>(match.len);
+    result.exp = regexp;
+    return result;
+}
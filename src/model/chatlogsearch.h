@@ -0,0 +1,86 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "ichatlog.h"
+
+#include <QMutex>
+#include <QObject>
+#include <QThreadPool>
+
+#include <atomic>
+#include <deque>
+
+class ChatLogSearch : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ChatLogSearch(QObject* parent = nullptr);
+    ~ChatLogSearch();
+
+    void start(const IChatLog& chatLog, const QString& phrase, const ParameterSearch& parameter,
+               SearchDirection direction);
+    void cancel();
+    bool isRunning() const;
+    bool isSearching(const QString& phrase, const ParameterSearch& parameter) const;
+    size_t getNumResults() const;
+
+    SearchResult findNext(SearchPos pos) const;
+    SearchResult findPrevious(SearchPos pos) const;
+
+signals:
+    void resultsUpdated();
+    void finished();
+
+private:
+    struct Match
+    {
+        SearchPos pos;
+        int start;
+        int len;
+    };
+
+    void run(SearchTextReader reader, QRegularExpression searchRegexp, SearchDirection direction,
+             quint64 searchGeneration);
+    SearchResult makeResult(size_t resultIdx) const;
+    bool isCoveredAfter(ChatLogIdx idx) const;
+    bool isCoveredBefore(ChatLogIdx idx) const;
+
+private:
+    QString phrase;
+    ParameterSearch parameter;
+    QRegularExpression regexp;
+
+    // Bumped for every new search, running jobs of older searches stop at their next page
+    std::atomic<quint64> generation{0};
+
+    mutable QMutex resultsMutex;
+    bool running = false;
+    // Matches sorted by position, complete for all indexes in [scanBegin, scanEnd)
+    std::deque<Match> results;
+    ChatLogIdx scanBegin;
+    ChatLogIdx scanEnd;
+    // Result returned last, so stepping through results doesn't need a lookup
+    mutable size_t cursor = 0;
+
+    // declared last, so running jobs are finished before anything else is destroyed
+    QThreadPool pool;
+};
@@ -0,0 +1,1285 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "friendlistmodel.h"
+
+#include "src/model/friend.h"
+#include "src/model/group.h"
+#include "src/model/status.h"
+#include "src/persistence/icirclesettings.h"
+#include "src/persistence/ifriendsettings.h"
+
+#include <QCoreApplication>
+#include <QDate>
+#include <QDateTime>
+#include <QMap>
+#include <QMimeData>
+#include <QTimer>
+
+#include <algorithm>
+#include <numeric>
+
+/**
+ * @class FriendListModel
+ * @brief Contact list shown in the main window, as a two level tree.
+ *
+ * Top level rows are groups, friends outside of circles and the sections: circles when sorting
+ * by name, activity categories when sorting by activity. Section rows hold their friends,
+ * online first. Friends and groups filtered out by the search, and sections without anything to
+ * show, have no row at all, so the view only lays out what is displayed.
+ *
+ * Changes are coalesced and applied once per event loop iteration. Rows that disappear are
+ * removed and new rows inserted, and rows that only changed their order are moved with a layout
+ * change that keeps persistent indexes on the same contacts. That keeps the view's scroll
+ * position, hover and open editors across updates.
+ *
+ * Sections always come after the top level contacts, and the internal id of a section's child
+ * identifies the section rather than its row, so children keep valid indexes while rows above
+ * their section are inserted or removed.
+ */
+
+namespace {
+
+enum class Time
+{
+    Today,
+    Yesterday,
+    ThisWeek,
+    ThisMonth,
+    Month1Ago,
+    Month2Ago,
+    Month3Ago,
+    Month4Ago,
+    Month5Ago,
+    LongAgo,
+    Never
+};
+
+const int LAST_TIME = static_cast<int>(Time::Never);
+
+Time getTimeBucket(const QDateTime& date)
+{
+    if (date == QDateTime()) {
+        return Time::Never;
+    }
+
+    QDate today = QDate::currentDate();
+    // clang-format off
+    const QMap<Time, QDate> dates {
+        { Time::Today,     today.addDays(0)    },
+        { Time::Yesterday, today.addDays(-1)   },
+        { Time::ThisWeek,  today.addDays(-6)   },
+        { Time::ThisMonth, today.addMonths(-1) },
+        { Time::Month1Ago, today.addMonths(-2) },
+        { Time::Month2Ago, today.addMonths(-3) },
+        { Time::Month3Ago, today.addMonths(-4) },
+        { Time::Month4Ago, today.addMonths(-5) },
+        { Time::Month5Ago, today.addMonths(-6) },
+    };
+    // clang-format on
+
+    for (Time time : dates.keys()) {
+        if (dates[time] <= date.date()) {
+            return time;
+        }
+    }
+
+    return Time::LongAgo;
+}
+
+qint64 timeUntilTomorrow()
+{
+    QDateTime now = QDateTime::currentDateTime();
+    QDateTime tomorrow = now.addDays(1); // Tomorrow.
+    tomorrow.setTime(QTime());           // Midnight.
+    return now.msecsTo(tomorrow);
+}
+
+bool isOnline(const Contact* contact)
+{
+    const Friend* frnd = qobject_cast<const Friend*>(contact);
+    return frnd == nullptr || Status::isOnline(frnd->getStatus());
+}
+
+} // namespace
+
+FriendListModel::FriendListModel(IFriendSettings& friendSettings, ICircleSettings& circleSettings,
+                                 QObject* parent)
+    : QAbstractItemModel(parent)
+    , friendSettings{friendSettings}
+    , circleSettings{circleSettings}
+    , dayTimer{new QTimer(this)}
+{
+    collator.setNumericMode(true);
+
+    dayTimer->setTimerType(Qt::VeryCoarseTimer);
+    dayTimer->setSingleShot(true);
+    connect(dayTimer, &QTimer::timeout, this, &FriendListModel::dayTimeout);
+    dayTimer->start(timeUntilTomorrow());
+}
+
+FriendListModel::~FriendListModel() = default;
+
+QModelIndex FriendListModel::index(int row, int column, const QModelIndex& parent) const
+{
+    if (column != 0 || row < 0) {
+        return {};
+    }
+
+    if (!parent.isValid()) {
+        return row < items.size() ? createIndex(row, column, quintptr(0)) : QModelIndex();
+    }
+
+    // Only top level sections have children
+    if (parent.internalId() != 0 || parent.row() >= items.size()
+        || row >= items[parent.row()].children.size()) {
+        return {};
+    }
+
+    return createIndex(row, column, sectionTag(items[parent.row()]));
+}
+
+QModelIndex FriendListModel::parent(const QModelIndex& child) const
+{
+    if (!child.isValid() || child.internalId() == 0) {
+        return {};
+    }
+
+    const int row = sectionRows.value(child.internalId(), -1);
+    return row < 0 ? QModelIndex() : createIndex(row, 0, quintptr(0));
+}
+
+int FriendListModel::rowCount(const QModelIndex& parent) const
+{
+    if (!parent.isValid()) {
+        return items.size();
+    }
+
+    if (parent.internalId() != 0 || parent.column() != 0 || parent.row() >= items.size()) {
+        return 0;
+    }
+
+    return items[parent.row()].children.size();
+}
+
+int FriendListModel::columnCount(const QModelIndex& parent) const
+{
+    Q_UNUSED(parent)
+    return 1;
+}
+
+QVariant FriendListModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= rowCount(index.parent())) {
+        return {};
+    }
+
+    const ItemType type = getItemType(index);
+    if (role == ItemTypeRole) {
+        return static_cast<int>(type);
+    }
+
+    if (type == ItemType::Circle || type == ItemType::Category) {
+        const Item& item = items[index.row()];
+        switch (role) {
+        case Qt::DisplayRole:
+        case Qt::EditRole:
+            return type == ItemType::Circle ? circleSettings.getCircleName(item.id)
+                                            : getCategoryName(item.id);
+        case OnlineCountRole:
+            return item.onlineCount;
+        case TotalCountRole:
+            return item.totalCount;
+        case ExpandedRole:
+            return isExpanded(index);
+        default:
+            return {};
+        }
+    }
+
+    const Contact* contact = getContact(index);
+    const Friend* frnd = qobject_cast<const Friend*>(contact);
+    const Group* group = qobject_cast<const Group*>(contact);
+    switch (role) {
+    case Qt::DisplayRole:
+    case Qt::EditRole:
+        return contact->getDisplayedName();
+    case StatusRole:
+        return static_cast<int>(frnd != nullptr ? frnd->getStatus() : Status::Status::Online);
+    case EventRole:
+        return contact->getEventFlag();
+    case ActiveRole:
+        return contact == activeContact;
+    case StatusMessageRole:
+        if (frnd != nullptr) {
+            return frnd->getStatusMessage();
+        }
+
+        // Keep the context the translations have for this string
+        return QCoreApplication::translate("GroupWidget", "%n user(s) in chat",
+                                           "Number of users in chat", group->getPeersCount());
+    default:
+        return {};
+    }
+}
+
+bool FriendListModel::setData(const QModelIndex& index, const QVariant& value, int role)
+{
+    if (role != Qt::EditRole || !index.isValid()) {
+        return false;
+    }
+
+    const QString name = value.toString();
+    switch (getItemType(index)) {
+    case ItemType::Friend:
+        static_cast<Friend*>(getContact(index))->setAlias(name);
+        return true;
+    case ItemType::Group:
+        static_cast<Group*>(getContact(index))->setName(name);
+        return true;
+    case ItemType::Circle:
+        if (name.isEmpty()) {
+            return false;
+        }
+
+        circleSettings.setCircleName(getSectionId(index), name);
+        // Circles are sorted by name
+        scheduleRebuild();
+        return true;
+    case ItemType::Category:
+        break;
+    }
+
+    return false;
+}
+
+Qt::ItemFlags FriendListModel::flags(const QModelIndex& index) const
+{
+    if (!index.isValid()) {
+        return Qt::ItemIsDropEnabled;
+    }
+
+    switch (getItemType(index)) {
+    case ItemType::Friend:
+    case ItemType::Group:
+        return Qt::ItemIsEnabled | Qt::ItemIsEditable | Qt::ItemIsDragEnabled;
+    case ItemType::Circle:
+        return Qt::ItemIsEnabled | Qt::ItemIsEditable | Qt::ItemIsDropEnabled;
+    case ItemType::Category:
+        break;
+    }
+
+    return Qt::ItemIsEnabled;
+}
+
+QStringList FriendListModel::mimeTypes() const
+{
+    return {QStringLiteral("toxPk"), QStringLiteral("groupId")};
+}
+
+QMimeData* FriendListModel::mimeData(const QModelIndexList& indexes) const
+{
+    const Contact* contact = indexes.isEmpty() ? nullptr : getContact(indexes.first());
+    if (contact == nullptr) {
+        return nullptr;
+    }
+
+    QMimeData* mimeData = new QMimeData;
+    mimeData->setText(contact->getDisplayedName());
+    if (const Friend* frnd = qobject_cast<const Friend*>(contact)) {
+        mimeData->setData("toxPk", frnd->getPublicKey().getByteArray());
+    } else {
+        const Group* group = static_cast<const Group*>(contact);
+        mimeData->setData("groupId", group->getPersistentId().getByteArray());
+    }
+
+    return mimeData;
+}
+
+void FriendListModel::addFriend(Friend* frnd)
+{
+    const ToxPk& pk = frnd->getPublicKey();
+    const int circleId = friendSettings.getFriendCircleID(pk);
+    if (circleId >= circleSettings.getCircleCount()) {
+        friendSettings.setFriendCircleID(pk, -1);
+    }
+
+    friends.append(frnd);
+    sortKeys.emplace(frnd, collator.sortKey(frnd->getDisplayedName()));
+
+    connect(frnd, &Contact::displayedNameChanged, this, [this, frnd]() { onDisplayedNameChanged(frnd); });
+    connect(frnd, &Friend::onlineOfflineChanged, this, &FriendListModel::scheduleRebuild);
+    connect(frnd, &Friend::statusChanged, this, [this, frnd]() { emitContactChanged(frnd); });
+    connect(frnd, &Friend::statusMessageChanged, this, [this, frnd]() { emitContactChanged(frnd); });
+
+    scheduleRebuild();
+}
+
+void FriendListModel::removeFriend(const Friend* frnd)
+{
+    disconnect(frnd, nullptr, this, nullptr);
+    friends.removeOne(const_cast<Friend*>(frnd));
+    sortKeys.erase(frnd);
+    if (activeContact == frnd) {
+        activeContact = nullptr;
+    }
+
+    // The friend is deleted right after, don't leave rows pointing to it
+    rebuild();
+}
+
+void FriendListModel::addGroup(Group* group)
+{
+    groups.append(group);
+    sortKeys.emplace(group, collator.sortKey(group->getDisplayedName()));
+
+    connect(group, &Contact::displayedNameChanged, this, [this, group]() { onDisplayedNameChanged(group); });
+    connect(group, &Group::numPeersChanged, this, [this, group]() { emitContactChanged(group); });
+
+    scheduleRebuild();
+}
+
+void FriendListModel::removeGroup(const Group* group)
+{
+    disconnect(group, nullptr, this, nullptr);
+    groups.removeOne(const_cast<Group*>(group));
+    sortKeys.erase(group);
+    if (activeContact == group) {
+        activeContact = nullptr;
+    }
+
+    rebuild();
+}
+
+void FriendListModel::setMode(SortingMode mode)
+{
+    if (this->mode == mode) {
+        return;
+    }
+
+    this->mode = mode;
+    scheduleRebuild();
+}
+
+FriendListModel::SortingMode FriendListModel::getMode() const
+{
+    return mode;
+}
+
+void FriendListModel::setGroupsOnTop(bool top)
+{
+    if (groupsOnTop == top) {
+        return;
+    }
+
+    groupsOnTop = top;
+    scheduleRebuild();
+}
+
+void FriendListModel::setLocale(const QLocale& locale)
+{
+    this->locale = locale;
+    if (mode == SortingMode::Activity) {
+        scheduleRebuild();
+    }
+}
+
+void FriendListModel::setFilter(const QString& searchString, bool hideOnline, bool hideOffline,
+                                bool hideGroups)
+{
+    this->searchString = searchString;
+    this->hideOnline = hideOnline;
+    this->hideOffline = hideOffline;
+    this->hideGroups = hideGroups;
+    scheduleRebuild();
+}
+
+void FriendListModel::setActiveContact(const Contact* contact)
+{
+    if (activeContact == contact) {
+        return;
+    }
+
+    const Contact* previous = activeContact;
+    activeContact = contact;
+    emitContactChanged(previous);
+    emitContactChanged(contact);
+}
+
+void FriendListModel::updateContact(const Contact* contact)
+{
+    emitContactChanged(contact);
+}
+
+/**
+ * @brief Moves a friend to its new activity category, if its last activity changed it.
+ */
+void FriendListModel::updateActivity(const Friend* frnd)
+{
+    if (mode != SortingMode::Activity || rebuildPending) {
+        return;
+    }
+
+    const int category = getTimeBucket(frnd);
+    const auto it = positions.constFind(frnd);
+    if (it != positions.constEnd() && it->parent >= 0 && items[it->parent].id == category) {
+        return;
+    }
+
+    const Item section{ItemType::Category, nullptr, category, {}, 0, 0};
+    const bool filtered = !searchString.isEmpty() || hideOnline || hideOffline;
+    if (it == positions.constEnd() || it->parent < 0
+        || (filtered && !sectionRows.contains(sectionTag(section)))) {
+        // Sections count the friends that are filtered out, only a rebuild knows about them
+        scheduleRebuild();
+        return;
+    }
+
+    moveToCategory(items[it->parent].children[it->row], category);
+}
+
+/**
+ * @brief Moves a visible friend from its category to another one.
+ *
+ * Only the friend row is removed and inserted, and its old category if it becomes empty or its new
+ * one if it didn't exist, the rest of the list stays as is.
+ */
+void FriendListModel::moveToCategory(Contact* contact, int category)
+{
+    const bool online = isOnline(contact);
+    const Position old = positions.value(contact);
+    bool sectionsChanged = false;
+
+    beginRemoveRows(createIndex(old.parent, 0, quintptr(0)), old.row, old.row);
+    items[old.parent].children.remove(old.row);
+    endRemoveRows();
+    positions.remove(contact);
+
+    Item& oldSection = items[old.parent];
+    --oldSection.totalCount;
+    oldSection.onlineCount -= online ? 1 : 0;
+    if (oldSection.children.isEmpty()) {
+        beginRemoveRows({}, old.parent, old.parent);
+        items.remove(old.parent);
+        updateSectionRows();
+        endRemoveRows();
+        sectionsChanged = true;
+    } else {
+        const QModelIndex index = createIndex(old.parent, 0, quintptr(0));
+        emit dataChanged(index, index, {OnlineCountRole, TotalCountRole});
+        updateChildPositions(old.parent);
+    }
+
+    const Item section{ItemType::Category, nullptr, category, {contact}, online ? 1 : 0, 1};
+    int parentRow = sectionRows.value(sectionTag(section), -1);
+    if (parentRow < 0) {
+        // Categories come after the groups, in their order
+        parentRow = items.size();
+        while (parentRow > 0 && items[parentRow - 1].contact == nullptr
+               && items[parentRow - 1].id > category) {
+            --parentRow;
+        }
+
+        beginInsertRows({}, parentRow, parentRow);
+        items.insert(parentRow, section);
+        updateSectionRows();
+        endInsertRows();
+        sectionsChanged = true;
+    } else {
+        // Online friends come first, each part is sorted by name
+        QVector<Contact*>& children = items[parentRow].children;
+        const auto before = [this](const Contact* a, const Contact* b) {
+            const bool aOnline = isOnline(a);
+            return aOnline != isOnline(b) ? aOnline : lessThan(a, b);
+        };
+        const int row = static_cast<int>(
+            std::lower_bound(children.begin(), children.end(), contact, before) - children.begin());
+
+        const QModelIndex parent = createIndex(parentRow, 0, quintptr(0));
+        beginInsertRows(parent, row, row);
+        children.insert(row, contact);
+        endInsertRows();
+
+        ++items[parentRow].totalCount;
+        items[parentRow].onlineCount += online ? 1 : 0;
+        emit dataChanged(parent, parent, {OnlineCountRole, TotalCountRole});
+    }
+
+    if (sectionsChanged) {
+        rebuildPositions();
+    } else {
+        updateChildPositions(parentRow);
+    }
+}
+
+/**
+ * @brief Creates a new circle.
+ * @param name Name of the circle, a default one is used if empty.
+ * @return Id of the circle.
+ */
+int FriendListModel::addCircle(const QString& name)
+{
+    const int circleId = circleSettings.addCircle(name);
+    scheduleRebuild();
+    return circleId;
+}
+
+/**
+ * @brief Removes a circle, its friends go back to the top level.
+ *
+ * Settings keep circle ids contiguous by moving the last circle into the removed id, so the
+ * friends of the last circle follow it.
+ */
+void FriendListModel::removeCircle(int circleId)
+{
+    const int lastId = circleSettings.getCircleCount() - 1;
+    for (const Friend* frnd : friends) {
+        const ToxPk& pk = frnd->getPublicKey();
+        const int friendCircleId = friendSettings.getFriendCircleID(pk);
+        if (friendCircleId == circleId) {
+            friendSettings.setFriendCircleID(pk, -1);
+        } else if (friendCircleId == lastId) {
+            friendSettings.setFriendCircleID(pk, circleId);
+        }
+    }
+
+    circleSettings.removeCircle(circleId);
+    rebuild();
+}
+
+/**
+ * @brief Moves a friend into a circle.
+ * @param circleId Id of the circle, -1 to move the friend out of its circle.
+ */
+void FriendListModel::moveToCircle(const Friend* frnd, int circleId)
+{
+    const ToxPk& pk = frnd->getPublicKey();
+    if (friendSettings.getFriendCircleID(pk) == circleId) {
+        return;
+    }
+
+    friendSettings.setFriendCircleID(pk, circleId);
+    if (circleId >= 0) {
+        circleSettings.setCircleExpanded(circleId, true);
+    }
+
+    friendSettings.saveFriendSettings(pk);
+    scheduleRebuild();
+}
+
+QVector<const Friend*> FriendListModel::getCircleFriends(int circleId) const
+{
+    QVector<const Friend*> circleFriends;
+    for (const Friend* frnd : friends) {
+        if (getCircleId(frnd) == circleId) {
+            circleFriends.append(frnd);
+        }
+    }
+
+    std::sort(circleFriends.begin(), circleFriends.end(),
+              [this](const Friend* a, const Friend* b) { return lessThan(a, b); });
+    return circleFriends;
+}
+
+bool FriendListModel::isExpanded(const QModelIndex& index) const
+{
+    switch (getItemType(index)) {
+    case ItemType::Circle:
+        return circleSettings.getCircleExpanded(getSectionId(index));
+    case ItemType::Category:
+        return !collapsedCategories.contains(getSectionId(index));
+    default:
+        return false;
+    }
+}
+
+void FriendListModel::setExpanded(const QModelIndex& index, bool expanded)
+{
+    const int sectionId = getSectionId(index);
+    switch (getItemType(index)) {
+    case ItemType::Circle:
+        circleSettings.setCircleExpanded(sectionId, expanded);
+        break;
+    case ItemType::Category:
+        if (expanded) {
+            collapsedCategories.remove(sectionId);
+        } else {
+            collapsedCategories.insert(sectionId);
+        }
+        break;
+    default:
+        return;
+    }
+
+    emit dataChanged(index, index, {ExpandedRole});
+}
+
+Contact* FriendListModel::getContact(const QModelIndex& index) const
+{
+    if (!index.isValid()) {
+        return nullptr;
+    }
+
+    if (index.internalId() == 0) {
+        return index.row() < items.size() ? items[index.row()].contact : nullptr;
+    }
+
+    const int parentRow = sectionRows.value(index.internalId(), -1);
+    if (parentRow < 0 || index.row() >= items[parentRow].children.size()) {
+        return nullptr;
+    }
+
+    return items[parentRow].children[index.row()];
+}
+
+FriendListModel::ItemType FriendListModel::getItemType(const QModelIndex& index) const
+{
+    if (index.isValid() && index.internalId() == 0 && index.row() < items.size()) {
+        return items[index.row()].type;
+    }
+
+    // Section children are always friends
+    return ItemType::Friend;
+}
+
+/**
+ * @brief Id of a section, or of the section holding a friend.
+ * @return Circle id or activity category, -1 for top level contacts.
+ */
+int FriendListModel::getSectionId(const QModelIndex& index) const
+{
+    if (!index.isValid()) {
+        return -1;
+    }
+
+    const int row = index.internalId() == 0 ? index.row() : sectionRows.value(index.internalId(), -1);
+    return row >= 0 && row < items.size() ? items[row].id : -1;
+}
+
+QModelIndex FriendListModel::indexOf(const Contact* contact) const
+{
+    const auto it = positions.constFind(contact);
+    if (it == positions.constEnd()) {
+        return {};
+    }
+
+    return createIndex(it->row, 0, it->parent < 0 ? quintptr(0) : sectionTag(items[it->parent]));
+}
+
+QModelIndex FriendListModel::indexOfCircle(int circleId) const
+{
+    return indexOfSection(ItemType::Circle, circleId);
+}
+
+/**
+ * @brief Contact after or before another one, in display order, wrapping around.
+ *
+ * Friends in collapsed sections are included, as they are when cycling with keyboard shortcuts.
+ * @return Next contact, or nullptr if the current contact isn't displayed.
+ */
+Contact* FriendListModel::nextContact(const Contact* current, bool forward) const
+{
+    QVector<Contact*> order;
+    order.reserve(positions.size());
+    for (const Item& item : items) {
+        if (item.contact != nullptr) {
+            order.append(item.contact);
+        } else {
+            order += item.children;
+        }
+    }
+
+    const int index = order.indexOf(const_cast<Contact*>(current));
+    if (index < 0) {
+        return nullptr;
+    }
+
+    const int step = forward ? 1 : -1;
+    return order[(index + step + order.size()) % order.size()];
+}
+
+/**
+ * @brief Applies the coalesced changes right away, e.g. before looking up rows.
+ */
+void FriendListModel::applyPendingChanges()
+{
+    if (rebuildPending) {
+        rebuild();
+    }
+}
+
+void FriendListModel::scheduleRebuild()
+{
+    if (rebuildPending) {
+        return;
+    }
+
+    rebuildPending = true;
+    QTimer::singleShot(0, this, &FriendListModel::applyPendingChanges);
+}
+
+/**
+ * @brief Brings the rows in line with the contacts, settings and filter.
+ *
+ * Rows that are gone are removed first, then the remaining rows are put in their new order,
+ * then new rows are inserted at their place.
+ */
+void FriendListModel::rebuild()
+{
+    rebuildPending = false;
+
+    const QVector<Item> target = build();
+    QHash<const Contact*, Position> targetPositions;
+    QHash<quintptr, int> targetSections;
+    indexItems(target, targetPositions, targetSections);
+
+    removeStaleRows(target, targetPositions, targetSections);
+    reorderRows(target);
+    insertNewRows(target);
+    updateSectionCounts(target);
+}
+
+/**
+ * @brief Computes the rows to show, sections always come after the top level contacts.
+ */
+QVector<FriendListModel::Item> FriendListModel::build() const
+{
+    QVector<Item> result;
+
+    const auto contactLess = [this](const Contact* a, const Contact* b) { return lessThan(a, b); };
+    const auto appendContacts = [&result](ItemType type, const QVector<Contact*>& contacts) {
+        for (Contact* contact : contacts) {
+            result.append(Item{type, contact, -1, {}, 0, 0});
+        }
+    };
+
+    QVector<Contact*> visibleGroups;
+    for (Group* group : groups) {
+        if (isVisible(group)) {
+            visibleGroups.append(group);
+        }
+    }
+
+    std::sort(visibleGroups.begin(), visibleGroups.end(), contactLess);
+
+    QVector<Contact*> sortedFriends;
+    sortedFriends.reserve(friends.size());
+    for (Friend* frnd : friends) {
+        sortedFriends.append(frnd);
+    }
+
+    std::sort(sortedFriends.begin(), sortedFriends.end(), contactLess);
+
+    if (mode == SortingMode::Activity) {
+        appendContacts(ItemType::Group, visibleGroups);
+
+        QVector<QVector<Contact*>> categories(LAST_TIME + 1);
+        for (Contact* frnd : sortedFriends) {
+            categories[getTimeBucket(static_cast<Friend*>(frnd))].append(frnd);
+        }
+
+        for (int i = 0; i <= LAST_TIME; ++i) {
+            appendSection(result, ItemType::Category, i, categories[i], false);
+        }
+
+        return result;
+    }
+
+    QVector<Contact*> online;
+    QVector<Contact*> offline;
+    QVector<QVector<Contact*>> circles(circleSettings.getCircleCount());
+    for (Contact* contact : sortedFriends) {
+        const Friend* frnd = static_cast<Friend*>(contact);
+        const int circleId = getCircleId(frnd);
+        if (circleId >= 0) {
+            circles[circleId].append(contact);
+        } else if (isVisible(frnd)) {
+            (isOnline(frnd) ? online : offline).append(contact);
+        }
+    }
+
+    if (groupsOnTop) {
+        appendContacts(ItemType::Group, visibleGroups);
+        appendContacts(ItemType::Friend, online);
+    } else {
+        appendContacts(ItemType::Friend, online);
+        appendContacts(ItemType::Group, visibleGroups);
+    }
+
+    appendContacts(ItemType::Friend, offline);
+
+    QVector<QString> circleNames;
+    QVector<int> circleIds(circles.size());
+    std::iota(circleIds.begin(), circleIds.end(), 0);
+    for (int id : circleIds) {
+        circleNames.append(circleSettings.getCircleName(id));
+    }
+
+    std::sort(circleIds.begin(), circleIds.end(), [this, &circleNames](int a, int b) {
+        const int result = collator.compare(circleNames[a], circleNames[b]);
+        return result != 0 ? result < 0 : a < b;
+    });
+
+    // Empty circles stay visible, to be able to drop friends in them, unless the user is
+    // looking for something
+    const bool showEmptyCircles = searchString.isEmpty() && !(hideOnline && hideOffline);
+    for (int id : circleIds) {
+        appendSection(result, ItemType::Circle, id, circles[id], showEmptyCircles);
+    }
+
+    return result;
+}
+
+/**
+ * @brief Appends a section with its visible members, online first.
+ * @param members All friends of the section, sorted.
+ * @param forceVisible Append the section even if none of its members is visible.
+ */
+void FriendListModel::appendSection(QVector<Item>& result, ItemType type, int id,
+                                    const QVector<Contact*>& members, bool forceVisible) const
+{
+    Item section{type, nullptr, id, {}, 0, members.size()};
+    QVector<Contact*> offline;
+    for (Contact* contact : members) {
+        const Friend* frnd = static_cast<const Friend*>(contact);
+        const bool online = isOnline(frnd);
+        section.onlineCount += online ? 1 : 0;
+        if (isVisible(frnd)) {
+            (online ? section.children : offline).append(contact);
+        }
+    }
+
+    section.children += offline;
+    if (section.children.isEmpty() && !forceVisible) {
+        return;
+    }
+
+    result.append(section);
+}
+
+/**
+ * @brief Removes the rows that are not in the target, bottom up so rows above keep their place.
+ */
+void FriendListModel::removeStaleRows(const QVector<Item>& target,
+                                      const QHash<const Contact*, Position>& targetPositions,
+                                      const QHash<quintptr, int>& targetSections)
+{
+    const auto isTopLevelKept = [&](const Item& item) {
+        if (item.contact == nullptr) {
+            return targetSections.contains(sectionTag(item));
+        }
+
+        const auto it = targetPositions.constFind(item.contact);
+        return it != targetPositions.constEnd() && it->parent < 0;
+    };
+
+    for (int last = items.size() - 1; last >= 0; --last) {
+        if (isTopLevelKept(items[last])) {
+            continue;
+        }
+
+        int first = last;
+        while (first > 0 && !isTopLevelKept(items[first - 1])) {
+            --first;
+        }
+
+        beginRemoveRows({}, first, last);
+        items.remove(first, last - first + 1);
+        updateSectionRows();
+        endRemoveRows();
+        last = first;
+    }
+
+    for (int parentRow = 0; parentRow < items.size(); ++parentRow) {
+        if (items[parentRow].contact != nullptr) {
+            continue;
+        }
+
+        const quintptr tag = sectionTag(items[parentRow]);
+        const auto isChildKept = [&](const Contact* contact) {
+            const auto it = targetPositions.constFind(contact);
+            return it != targetPositions.constEnd() && it->parent >= 0
+                   && sectionTag(target[it->parent]) == tag;
+        };
+
+        QVector<Contact*>& children = items[parentRow].children;
+        const QModelIndex parent = createIndex(parentRow, 0, quintptr(0));
+        for (int last = children.size() - 1; last >= 0; --last) {
+            if (isChildKept(children[last])) {
+                continue;
+            }
+
+            int first = last;
+            while (first > 0 && !isChildKept(children[first - 1])) {
+                --first;
+            }
+
+            beginRemoveRows(parent, first, last);
+            children.remove(first, last - first + 1);
+            endRemoveRows();
+            last = first;
+        }
+    }
+
+    rebuildPositions();
+}
+
+/**
+ * @brief Puts the remaining rows in the order of the target, with a layout change if needed.
+ */
+void FriendListModel::reorderRows(const QVector<Item>& target)
+{
+    QVector<Item> reordered;
+    reordered.reserve(items.size());
+    bool changed = false;
+    for (const Item& targetItem : target) {
+        int row;
+        if (targetItem.contact != nullptr) {
+            const auto it = positions.constFind(targetItem.contact);
+            if (it == positions.constEnd() || it->parent >= 0) {
+                continue;
+            }
+            row = it->row;
+        } else {
+            row = sectionRows.value(sectionTag(targetItem), -1);
+            if (row < 0) {
+                continue;
+            }
+        }
+
+        Item item = items[row];
+        if (item.contact == nullptr) {
+            QVector<Contact*> children;
+            children.reserve(item.children.size());
+            for (Contact* contact : targetItem.children) {
+                const auto it = positions.constFind(contact);
+                if (it != positions.constEnd() && it->parent == row) {
+                    children.append(contact);
+                }
+            }
+
+            changed = changed || children != item.children;
+            item.children = children;
+        }
+
+        changed = changed || row != reordered.size();
+        reordered.append(item);
+    }
+
+    if (!changed) {
+        return;
+    }
+
+    emit layoutAboutToBeChanged();
+
+    const QModelIndexList oldIndexes = persistentIndexList();
+    QVector<ItemKey> keys;
+    keys.reserve(oldIndexes.size());
+    for (const QModelIndex& index : oldIndexes) {
+        keys.append(keyOf(index));
+    }
+
+    items = reordered;
+    updateSectionRows();
+    rebuildPositions();
+
+    QModelIndexList newIndexes;
+    newIndexes.reserve(keys.size());
+    for (const ItemKey& key : keys) {
+        newIndexes.append(indexOf(key));
+    }
+
+    changePersistentIndexList(oldIndexes, newIndexes);
+
+    emit layoutChanged();
+}
+
+/**
+ * @brief Inserts the rows of the target that are missing, the others are already in order.
+ */
+void FriendListModel::insertNewRows(const QVector<Item>& target)
+{
+    const auto isTopLevelPresent = [this](const Item& item) {
+        if (item.contact == nullptr) {
+            return sectionRows.contains(sectionTag(item));
+        }
+
+        const auto it = positions.constFind(item.contact);
+        return it != positions.constEnd() && it->parent < 0;
+    };
+
+    QSet<quintptr> oldSections;
+    QVector<bool> present(target.size());
+    for (int row = 0; row < target.size(); ++row) {
+        present[row] = isTopLevelPresent(target[row]);
+        if (present[row] && target[row].contact == nullptr) {
+            oldSections.insert(sectionTag(target[row]));
+        }
+    }
+
+    for (int first = 0; first < target.size(); ++first) {
+        if (present[first]) {
+            continue;
+        }
+
+        int last = first;
+        while (last + 1 < target.size() && !present[last + 1]) {
+            ++last;
+        }
+
+        // New sections come with their children
+        beginInsertRows({}, first, last);
+        items.insert(first, last - first + 1, Item{});
+        std::copy(target.begin() + first, target.begin() + last + 1, items.begin() + first);
+        updateSectionRows();
+        endInsertRows();
+        first = last;
+    }
+
+    for (int parentRow = 0; parentRow < items.size(); ++parentRow) {
+        if (items[parentRow].contact != nullptr
+            || !oldSections.contains(sectionTag(items[parentRow]))) {
+            continue;
+        }
+
+        const QVector<Contact*>& targetChildren = target[parentRow].children;
+        QVector<Contact*>& children = items[parentRow].children;
+        if (children.size() == targetChildren.size()) {
+            continue;
+        }
+
+        // The children that are left are in target order already
+        QSet<Contact*> existing;
+        existing.reserve(children.size());
+        for (Contact* contact : children) {
+            existing.insert(contact);
+        }
+
+        const QModelIndex parent = createIndex(parentRow, 0, quintptr(0));
+        for (int first = 0; first < targetChildren.size(); ++first) {
+            if (existing.contains(targetChildren[first])) {
+                continue;
+            }
+
+            int last = first;
+            while (last + 1 < targetChildren.size() && !existing.contains(targetChildren[last + 1])) {
+                ++last;
+            }
+
+            beginInsertRows(parent, first, last);
+            children.insert(first, last - first + 1, nullptr);
+            std::copy(targetChildren.begin() + first, targetChildren.begin() + last + 1,
+                      children.begin() + first);
+            endInsertRows();
+            first = last;
+        }
+    }
+
+    rebuildPositions();
+}
+
+/**
+ * @brief Updates the online and total counts shown on the section rows.
+ */
+void FriendListModel::updateSectionCounts(const QVector<Item>& target)
+{
+    for (int row = 0; row < items.size(); ++row) {
+        Item& item = items[row];
+        if (item.contact != nullptr) {
+            continue;
+        }
+
+        if (item.onlineCount != target[row].onlineCount || item.totalCount != target[row].totalCount) {
+            item.onlineCount = target[row].onlineCount;
+            item.totalCount = target[row].totalCount;
+            const QModelIndex index = createIndex(row, 0, quintptr(0));
+            emit dataChanged(index, index, {OnlineCountRole, TotalCountRole});
+        }
+    }
+}
+
+/**
+ * @brief Id of the children of a section, unique among all sections and never 0.
+ */
+quintptr FriendListModel::sectionTag(const Item& section)
+{
+    return quintptr(1 + (section.type == ItemType::Category ? 1 : 0) + 2 * section.id);
+}
+
+/**
+ * @brief Finds the rows of the contacts and sections of a list of rows.
+ */
+void FriendListModel::indexItems(const QVector<Item>& list, QHash<const Contact*, Position>& contacts,
+                                 QHash<quintptr, int>& sections)
+{
+    contacts.reserve(list.size());
+    for (int row = 0; row < list.size(); ++row) {
+        const Item& item = list[row];
+        if (item.contact != nullptr) {
+            contacts.insert(item.contact, {-1, row});
+            continue;
+        }
+
+        sections.insert(sectionTag(item), row);
+        for (int childRow = 0; childRow < item.children.size(); ++childRow) {
+            contacts.insert(item.children[childRow], {row, childRow});
+        }
+    }
+}
+
+void FriendListModel::updateChildPositions(int parentRow)
+{
+    const QVector<Contact*>& children = items[parentRow].children;
+    for (int row = 0; row < children.size(); ++row) {
+        positions.insert(children[row], {parentRow, row});
+    }
+}
+
+void FriendListModel::rebuildPositions()
+{
+    positions.clear();
+    QHash<quintptr, int> sections;
+    indexItems(items, positions, sections);
+}
+
+/**
+ * @brief Updates the rows of the sections, needed to find the parent of their children.
+ *
+ * Only looks at the sections at the end, it is called for every batch of inserted or removed rows.
+ */
+void FriendListModel::updateSectionRows()
+{
+    sectionRows.clear();
+    for (int row = items.size() - 1; row >= 0 && items[row].contact == nullptr; --row) {
+        sectionRows.insert(sectionTag(items[row]), row);
+    }
+}
+
+void FriendListModel::emitContactChanged(const Contact* contact)
+{
+    const QModelIndex index = indexOf(contact);
+    if (index.isValid()) {
+        emit dataChanged(index, index);
+    }
+}
+
+void FriendListModel::onDisplayedNameChanged(Contact* contact)
+{
+    sortKeys.erase(contact);
+    sortKeys.emplace(contact, collator.sortKey(contact->getDisplayedName()));
+    scheduleRebuild();
+}
+
+void FriendListModel::dayTimeout()
+{
+    // Categories are relative to today
+    if (mode == SortingMode::Activity) {
+        scheduleRebuild();
+    }
+
+    dayTimer->start(timeUntilTomorrow());
+}
+
+bool FriendListModel::isVisible(const Friend* frnd) const
+{
+    const bool online = isOnline(frnd);
+    if ((online && hideOnline) || (!online && hideOffline)) {
+        return false;
+    }
+
+    return frnd->getDisplayedName().contains(searchString, Qt::CaseInsensitive);
+}
+
+bool FriendListModel::isVisible(const Group* group) const
+{
+    return !hideGroups && group->getDisplayedName().contains(searchString, Qt::CaseInsensitive);
+}
+
+bool FriendListModel::lessThan(const Contact* a, const Contact* b) const
+{
+    const int result = sortKeys.at(a).compare(sortKeys.at(b));
+    return result != 0 ? result < 0 : std::less<const Contact*>()(a, b);
+}
+
+int FriendListModel::getCircleId(const Friend* frnd) const
+{
+    const int circleId = friendSettings.getFriendCircleID(frnd->getPublicKey());
+    return circleId < circleSettings.getCircleCount() ? circleId : -1;
+}
+
+int FriendListModel::getTimeBucket(const Friend* frnd) const
+{
+    return static_cast<int>(::getTimeBucket(friendSettings.getFriendActivity(frnd->getPublicKey())));
+}
+
+QString FriendListModel::getCategoryName(int category) const
+{
+    const QDate today = QDate::currentDate();
+// Keep the context the translations have for these strings
+#define COMMENT "Category for sorting friends by activity"
+    switch (static_cast<Time>(category)) {
+    case Time::Today:
+        return QCoreApplication::translate("FriendListWidget", "Today", COMMENT);
+    case Time::Yesterday:
+        return QCoreApplication::translate("FriendListWidget", "Yesterday", COMMENT);
+    case Time::ThisWeek:
+        return QCoreApplication::translate("FriendListWidget", "Last 7 days", COMMENT);
+    case Time::ThisMonth:
+        return QCoreApplication::translate("FriendListWidget", "This month", COMMENT);
+    case Time::LongAgo:
+        return QCoreApplication::translate("FriendListWidget", "Older than 6 months", COMMENT);
+    case Time::Never:
+        return QCoreApplication::translate("FriendListWidget", "Never", COMMENT);
+    default:
+        // Month1Ago to Month5Ago
+        return locale.monthName(today.addMonths(static_cast<int>(Time::ThisMonth) - category).month());
+    }
+#undef COMMENT
+}
+
+FriendListModel::ItemKey FriendListModel::keyOf(const QModelIndex& index) const
+{
+    const Contact* contact = getContact(index);
+    if (contact != nullptr) {
+        return {getItemType(index), contact, -1};
+    }
+
+    return {getItemType(index), nullptr, getSectionId(index)};
+}
+
+QModelIndex FriendListModel::indexOf(const ItemKey& key) const
+{
+    if (key.contact != nullptr) {
+        return indexOf(key.contact);
+    }
+
+    return indexOfSection(key.type, key.id);
+}
+
+QModelIndex FriendListModel::indexOfSection(ItemType type, int id) const
+{
+    for (int row = 0; row < items.size(); ++row) {
+        if (items[row].type == type && items[row].id == id) {
+            return createIndex(row, 0, quintptr(0));
+        }
+    }
+
+    return {};
+}
@@ -0,0 +1,192 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "src/persistence/settings.h"
+
+#include <QAbstractItemModel>
+#include <QCollator>
+#include <QHash>
+#include <QLocale>
+#include <QSet>
+#include <QVector>
+
+#include <unordered_map>
+
+class Contact;
+class Friend;
+class Group;
+class ICircleSettings;
+class IFriendSettings;
+class QMimeData;
+class QTimer;
+
+class FriendListModel : public QAbstractItemModel
+{
+    Q_OBJECT
+public:
+    using SortingMode = Settings::FriendListSortingMode;
+
+    enum class ItemType
+    {
+        Friend,
+        Group,
+        Circle,
+        Category
+    };
+
+    enum Role
+    {
+        ItemTypeRole = Qt::UserRole,
+        StatusRole,
+        EventRole,
+        ActiveRole,
+        StatusMessageRole,
+        OnlineCountRole,
+        TotalCountRole,
+        ExpandedRole
+    };
+
+    FriendListModel(IFriendSettings& friendSettings, ICircleSettings& circleSettings,
+                    QObject* parent = nullptr);
+    ~FriendListModel() override;
+
+    QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex& child) const override;
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole) override;
+    Qt::ItemFlags flags(const QModelIndex& index) const override;
+    QStringList mimeTypes() const override;
+    QMimeData* mimeData(const QModelIndexList& indexes) const override;
+
+    void addFriend(Friend* frnd);
+    void removeFriend(const Friend* frnd);
+    void addGroup(Group* group);
+    void removeGroup(const Group* group);
+
+    void setMode(SortingMode mode);
+    SortingMode getMode() const;
+    void setGroupsOnTop(bool top);
+    void setLocale(const QLocale& locale);
+    void setFilter(const QString& searchString, bool hideOnline, bool hideOffline, bool hideGroups);
+
+    void setActiveContact(const Contact* contact);
+    void updateContact(const Contact* contact);
+    void updateActivity(const Friend* frnd);
+
+    int addCircle(const QString& name = QString());
+    void removeCircle(int circleId);
+    void moveToCircle(const Friend* frnd, int circleId);
+    QVector<const Friend*> getCircleFriends(int circleId) const;
+
+    bool isExpanded(const QModelIndex& index) const;
+    void setExpanded(const QModelIndex& index, bool expanded);
+
+    Contact* getContact(const QModelIndex& index) const;
+    ItemType getItemType(const QModelIndex& index) const;
+    int getSectionId(const QModelIndex& index) const;
+    QModelIndex indexOf(const Contact* contact) const;
+    QModelIndex indexOfCircle(int circleId) const;
+    Contact* nextContact(const Contact* current, bool forward) const;
+
+    void applyPendingChanges();
+
+private:
+    struct Item
+    {
+        ItemType type;
+        Contact* contact;
+        int id;
+        QVector<Contact*> children;
+        int onlineCount;
+        int totalCount;
+    };
+
+    struct Position
+    {
+        int parent;
+        int row;
+    };
+
+    struct ItemKey
+    {
+        ItemType type;
+        const Contact* contact;
+        int id;
+    };
+
+    void scheduleRebuild();
+    void rebuild();
+    QVector<Item> build() const;
+    void removeStaleRows(const QVector<Item>& target,
+                         const QHash<const Contact*, Position>& targetPositions,
+                         const QHash<quintptr, int>& targetSections);
+    void reorderRows(const QVector<Item>& target);
+    void insertNewRows(const QVector<Item>& target);
+    void updateSectionCounts(const QVector<Item>& target);
+    void moveToCategory(Contact* contact, int category);
+    void updateChildPositions(int parentRow);
+    void rebuildPositions();
+    void updateSectionRows();
+    static quintptr sectionTag(const Item& section);
+    static void indexItems(const QVector<Item>& list, QHash<const Contact*, Position>& contacts,
+                           QHash<quintptr, int>& sections);
+    void emitContactChanged(const Contact* contact);
+    void onDisplayedNameChanged(Contact* contact);
+    void dayTimeout();
+
+    bool isVisible(const Friend* frnd) const;
+    bool isVisible(const Group* group) const;
+    bool lessThan(const Contact* a, const Contact* b) const;
+    int getCircleId(const Friend* frnd) const;
+    int getTimeBucket(const Friend* frnd) const;
+    QString getCategoryName(int category) const;
+    void appendSection(QVector<Item>& result, ItemType type, int id,
+                       const QVector<Contact*>& members, bool forceVisible) const;
+    ItemKey keyOf(const QModelIndex& index) const;
+    QModelIndex indexOf(const ItemKey& key) const;
+    QModelIndex indexOfSection(ItemType type, int id) const;
+
+    IFriendSettings& friendSettings;
+    ICircleSettings& circleSettings;
+    SortingMode mode = SortingMode::Name;
+    bool groupsOnTop = true;
+    QLocale locale;
+    QString searchString;
+    bool hideOnline = false;
+    bool hideOffline = false;
+    bool hideGroups = false;
+    const Contact* activeContact = nullptr;
+    bool rebuildPending = false;
+    QTimer* dayTimer;
+
+    QCollator collator;
+    std::unordered_map<const Contact*, QCollatorSortKey> sortKeys;
+    QVector<Friend*> friends;
+    QVector<Group*> groups;
+    QSet<int> collapsedCategories;
+
+    QVector<Item> items;
+    QHash<const Contact*, Position> positions;
+    QHash<quintptr, int> sectionRows;
+};
@@ -21,6 +21,19 @@
 #include "src/persistence/settings.h"
 #include "src/model/status.h"
 
+namespace {
+// messages handed to toxcore per event loop iteration, so resending a long backlog doesn't
+// block the GUI thread
+const int maxMessagesPerDrain = 32;
+// time to wait for toxcore's send queue to empty after it refused a message
+const int sendRetryIntervalMs = 250;
+
+bool isExtendedMessage(Message const& message)
+{
+    return message.extensionSet[ExtensionType::messages] && !message.isAction;
+}
+} // namespace
+
 FriendMessageDispatcher::FriendMessageDispatcher(Friend& f_, MessageProcessor processor_,
                                                  ICoreFriendMessageSender& messageSender_,
                                                  ICoreExtPacketAllocator& coreExtPacketAllocator_)
@@ -30,6 +43,9 @@ FriendMessageDispatcher::FriendMessageDispatcher(Friend& f_, MessageProcessor pr
     , coreExtPacketAllocator(coreExtPacketAllocator_)
 {
     connect(&f, &Friend::onlineOfflineChanged, this, &FriendMessageDispatcher::onFriendOnlineOfflineChanged);
+
+    drainTimer.setSingleShot(true);
+    connect(&drainTimer, &QTimer::timeout, this, &FriendMessageDispatcher::drainOutboundQueue);
 }
 
 /**
@@ -110,10 +126,18 @@ void FriendMessageDispatcher::onExtReceiptReceived(uint64_t receiptId)
 void FriendMessageDispatcher::onFriendOnlineOfflineChanged(const ToxPk&, bool isOnline)
 {
     if (isOnline) {
-        auto messagesToResend = offlineMsgEngine.removeAllMessages();
-        for (auto const& message : messagesToResend) {
-            sendProcessedMessage(message.message, message.callback);
-        }
+        resendOfflineMessages();
+        return;
+    }
+
+    // keep the order, queued messages were authored after the ones already sent
+    drainTimer.stop();
+    for (auto const& queued : outboundQueue) {
+        offlineMsgEngine.addUnsentMessage(queued.message, queued.completionFn);
+    }
+    if (!outboundQueue.empty()) {
+        outboundQueue.clear();
+        emit outboundQueueDepthChanged(0);
     }
 }
 
@@ -122,9 +146,18 @@ void FriendMessageDispatcher::onFriendOnlineOfflineChanged(const ToxPk&, bool is
  */
 void FriendMessageDispatcher::clearOutgoingMessages()
 {
+    drainTimer.stop();
+    outboundQueue.clear();
     offlineMsgEngine.removeAllMessages();
 }
 
+/**
+ * @brief Number of messages waiting to be accepted by toxcore while the friend is online.
+ */
+size_t FriendMessageDispatcher::getOutboundQueueDepth() const
+{
+    return outboundQueue.size();
+}
 
 void FriendMessageDispatcher::sendProcessedMessage(Message const& message, OfflineMsgEngine::CompletionFn onOfflineMsgComplete)
 {
@@ -133,43 +166,140 @@ void FriendMessageDispatcher::sendProcessedMessage(Message const& message, Offli
         return;
     }
 
-    if (message.extensionSet[ExtensionType::messages] && !message.isAction) {
-        sendExtendedProcessedMessage(message, onOfflineMsgComplete);
+    // messages must not overtake the ones still waiting in the queue
+    outboundQueue.push_back(OutboundMessage{message, onOfflineMsgComplete});
+    if (drainTimer.isActive()) {
+        emit outboundQueueDepthChanged(outboundQueue.size());
     } else {
-        sendCoreProcessedMessage(message, onOfflineMsgComplete);
+        drainOutboundQueue();
     }
 }
 
+/**
+ * @brief Sends the messages kept while the friend was offline, in order.
+ *
+ * The whole backlog is queued before the queue is drained once, so it goes out in full
+ * drains instead of one drain per message.
+ */
+void FriendMessageDispatcher::resendOfflineMessages()
+{
+    const auto messagesToResend = offlineMsgEngine.removeAllMessages();
+    if (!Status::isOnline(f.getStatus())) {
+        for (auto const& message : messagesToResend) {
+            offlineMsgEngine.addUnsentMessage(message.message, message.callback);
+        }
+        return;
+    }
+
+    for (auto const& message : messagesToResend) {
+        outboundQueue.push_back(OutboundMessage{message.message, message.callback});
+    }
 
+    if (drainTimer.isActive()) {
+        emit outboundQueueDepthChanged(outboundQueue.size());
+    } else {
+        drainOutboundQueue();
+    }
+}
 
-void FriendMessageDispatcher::sendExtendedProcessedMessage(Message const& message, OfflineMsgEngine::CompletionFn onOfflineMsgComplete)
+/**
+ * @brief Hands queued messages to toxcore until its send queue is full or the batch is full.
+ *
+ * A message refused because of a full send queue stays at the front of the queue and is
+ * retried after a delay, which gives toxcore time to empty it. Messages refused for any other
+ * reason would be refused again, they are kept as unsent until the friend comes online again.
+ */
+void FriendMessageDispatcher::drainOutboundQueue()
 {
-    assert(!message.isAction); // Actions not supported with extensions
+    int numSent = 0;
+    while (!outboundQueue.empty() && Status::isOnline(f.getStatus())) {
+        if (numSent == maxMessagesPerDrain) {
+            drainTimer.start(0);
+            break;
+        }
 
-    if ((f.getSupportedExtensions() & message.extensionSet) != message.extensionSet) {
-        onOfflineMsgComplete(false);
-        return;
+        if (isExtendedMessage(outboundQueue.front().message)) {
+            const int numTaken = sendExtendedProcessedMessages(maxMessagesPerDrain - numSent);
+            if (numTaken < 0) {
+                drainTimer.start(sendRetryIntervalMs);
+                break;
+            }
+
+            numSent += numTaken;
+            continue;
+        }
+
+        const OutboundMessage next = outboundQueue.front();
+        outboundQueue.pop_front();
+        const FriendSendResult result = sendCoreProcessedMessage(next.message, next.completionFn);
+        if (result == FriendSendResult::QueueFull) {
+            outboundQueue.push_front(next);
+            drainTimer.start(sendRetryIntervalMs);
+            break;
+        }
+
+        if (result == FriendSendResult::Failed) {
+            offlineMsgEngine.addUnsentMessage(next.message, next.completionFn);
+        }
+
+        ++numSent;
     }
 
-    auto receipt = ExtendedReceiptNum();
+    emit outboundQueueDepthChanged(outboundQueue.size());
+}
+
+/**
+ * @brief Sends the extended messages at the front of the queue in a single toxext packet.
+ * @param maxMessages Max number of messages to take from the queue.
+ * @return Number of messages taken from the queue, -1 if toxext didn't accept the packet and
+ * the messages should be retried.
+ */
+int FriendMessageDispatcher::sendExtendedProcessedMessages(int maxMessages)
+{
+    // the extension set only changes on negotiation, don't look it up for every message
+    const ExtensionSet supportedExtensions = f.getSupportedExtensions();
+
+    std::unique_ptr<ICoreExtPacket> packet;
+    std::vector<OutboundMessage> batch;
+    std::vector<ExtendedReceiptNum> receipts;
+    int numTaken = 0;
+    while (numTaken < maxMessages && !outboundQueue.empty()
+           && isExtendedMessage(outboundQueue.front().message)) {
+        OutboundMessage next = std::move(outboundQueue.front());
+        outboundQueue.pop_front();
+        ++numTaken;
+
+        if ((supportedExtensions & next.message.extensionSet) != next.message.extensionSet) {
+            next.completionFn(false);
+            continue;
+        }
 
-    const auto friendId = f.getId();
-    auto packet = coreExtPacketAllocator.getPacket(friendId);
+        if (!packet) {
+            packet = coreExtPacketAllocator.getPacket(f.getId());
+        }
 
-    if (message.extensionSet[ExtensionType::messages]) {
-        receipt.get() = packet->addExtendedMessage(message.content);
+        receipts.push_back(ExtendedReceiptNum(packet->addExtendedMessage(next.message.content)));
+        batch.push_back(std::move(next));
     }
 
-    const auto messageSent = packet->send();
+    if (!packet) {
+        return numTaken;
+    }
 
-    if (messageSent) {
-        offlineMsgEngine.addSentExtendedMessage(receipt, message, onOfflineMsgComplete);
-    } else {
-        offlineMsgEngine.addUnsentMessage(message, onOfflineMsgComplete);
+    if (!packet->send()) {
+        for (auto it = batch.rbegin(); it != batch.rend(); ++it) {
+            outboundQueue.push_front(std::move(*it));
+        }
+        return -1;
+    }
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+        offlineMsgEngine.addSentExtendedMessage(receipts[i], batch[i].message, batch[i].completionFn);
     }
+    return numTaken;
 }
 
-void FriendMessageDispatcher::sendCoreProcessedMessage(Message const& message, OfflineMsgEngine::CompletionFn onOfflineMsgComplete)
+FriendSendResult FriendMessageDispatcher::sendCoreProcessedMessage(Message const& message, OfflineMsgEngine::CompletionFn onOfflineMsgComplete)
 {
     auto receipt = ReceiptNum();
 
@@ -178,13 +308,12 @@ void FriendMessageDispatcher::sendCoreProcessedMessage(Message const& message, O
     auto sendFn = message.isAction ? std::mem_fn(&ICoreFriendMessageSender::sendAction)
                                    : std::mem_fn(&ICoreFriendMessageSender::sendMessage);
 
-    const auto messageSent = sendFn(messageSender, friendId, message.content, receipt);
+    const auto result = sendFn(messageSender, friendId, message.content, receipt);
 
-    if (messageSent) {
+    if (result == FriendSendResult::Sent) {
         offlineMsgEngine.addSentCoreMessage(receipt, message, onOfflineMsgComplete);
-    } else {
-        offlineMsgEngine.addUnsentMessage(message, onOfflineMsgComplete);
     }
+    return result;
 }
 
 OfflineMsgEngine::CompletionFn FriendMessageDispatcher::getCompletionFn(DispatchedMessageId messageId)
@@ -27,8 +27,11 @@
 
 #include <QObject>
 #include <QString>
+#include <QTimer>
 
 #include <cstdint>
+#include <deque>
+#include <vector>
 
 class FriendMessageDispatcher : public IMessageDispatcher
 {
@@ -47,13 +50,26 @@ public:
     void onExtMessageReceived(const QString& message);
     void onExtReceiptReceived(uint64_t receiptId);
     void clearOutgoingMessages();
+    size_t getOutboundQueueDepth() const;
+
+signals:
+    void outboundQueueDepthChanged(size_t depth);
+
 private slots:
     void onFriendOnlineOfflineChanged(const ToxPk& key, bool isOnline);
+    void drainOutboundQueue();
 
 private:
+    struct OutboundMessage
+    {
+        Message message;
+        OfflineMsgEngine::CompletionFn completionFn;
+    };
+
     void sendProcessedMessage(Message const& msg, OfflineMsgEngine::CompletionFn fn);
-    void sendExtendedProcessedMessage(Message const& msg, OfflineMsgEngine::CompletionFn fn);
-    void sendCoreProcessedMessage(Message const& msg, OfflineMsgEngine::CompletionFn fn);
+    void resendOfflineMessages();
+    int sendExtendedProcessedMessages(int maxMessages);
+    FriendSendResult sendCoreProcessedMessage(Message const& msg, OfflineMsgEngine::CompletionFn fn);
     OfflineMsgEngine::CompletionFn getCompletionFn(DispatchedMessageId messageId);
 
     Friend& f;
@@ -63,4 +79,8 @@ private:
     ICoreFriendMessageSender& messageSender;
     OfflineMsgEngine offlineMsgEngine;
     MessageProcessor processor;
+
+    // messages waiting for toxcore to accept them while the friend is online
+    std::deque<OutboundMessage> outboundQueue;
+    QTimer drainTimer;
 };
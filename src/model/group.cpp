@@ -25,8 +25,12 @@
 #include "src/friendlist.h"
 
 #include <cassert>
+#include <tuple>
 
 #include <QDebug>
+#include <QPair>
+#include <QSet>
+#include <QVector>
 
 static const int MAX_GROUP_TITLE_LENGTH = 128;
 
@@ -88,35 +92,50 @@ void Group::regeneratePeerList()
     // receive the name changed signal a little later, we will emit userJoined before we have their
     // username, using just their ToxPk, then shortly after emit another peerNameChanged signal.
     // This can cause double-updated to UI and chatlog, but is unavoidable given the API of toxcore.
-    QStringList peers = groupQuery.getGroupPeerNames(toxGroupNum);
-    const auto oldPeerNames = peerDisplayNames;
-    peerDisplayNames.clear();
-    const int nPeers = peers.size();
-    for (int i = 0; i < nPeers; ++i) {
-        const auto pk = groupQuery.getGroupPeerPk(toxGroupNum, i);
-        if (pk == idHandler.getSelfPublicKey()) {
-            peerDisplayNames[pk] = idHandler.getUsername();
-        } else {
-            peerDisplayNames[pk] = FriendList::decideNickname(pk, peers[i]);
+    const QVector<GroupPeer> peers = groupQuery.getGroupPeers(toxGroupNum);
+    const ToxPk selfPk = idHandler.getSelfPublicKey();
+    const int oldCount = peerDisplayNames.size();
+
+    // update the existing peer set in place and only collect what changed
+    QSet<ToxPk> present;
+    present.reserve(peers.size());
+    QVector<ToxPk> joined;
+    QVector<std::tuple<ToxPk, QString, QString>> renamed;
+    for (const GroupPeer& peer : peers) {
+        present.insert(peer.pk);
+        const QString name = peer.pk == selfPk ? idHandler.getUsername()
+                                               : FriendList::decideNickname(peer.pk, peer.name);
+        auto it = peerDisplayNames.find(peer.pk);
+        if (it == peerDisplayNames.end()) {
+            peerDisplayNames.insert(peer.pk, name);
+            joined.append(peer.pk);
+        } else if (it.value() != name) {
+            renamed.append(std::make_tuple(peer.pk, it.value(), name));
+            it.value() = name;
         }
     }
-    for (const auto& pk : oldPeerNames.keys()) {
-        if (!peerDisplayNames.contains(pk)) {
-            emit userLeft(pk, oldPeerNames.value(pk));
+
+    QVector<QPair<ToxPk, QString>> left;
+    for (auto it = peerDisplayNames.begin(); it != peerDisplayNames.end();) {
+        if (present.contains(it.key())) {
+            ++it;
+        } else {
+            left.append(qMakePair(it.key(), it.value()));
+            it = peerDisplayNames.erase(it);
         }
     }
-    for (const auto& pk : peerDisplayNames.keys()) {
-        if (!oldPeerNames.contains(pk)) {
-            emit userJoined(pk, peerDisplayNames.value(pk));
-        }
+
+    for (const auto& peer : left) {
+        emit userLeft(peer.first, peer.second);
     }
-    for (const auto& pk : peerDisplayNames.keys()) {
-        if (oldPeerNames.contains(pk) && oldPeerNames.value(pk) != peerDisplayNames.value(pk)) {
-            emit peerNameChanged(pk, oldPeerNames.value(pk), peerDisplayNames.value(pk));
-        }
+    for (const auto& pk : joined) {
+        emit userJoined(pk, peerDisplayNames.value(pk));
+    }
+    for (const auto& peer : renamed) {
+        emit peerNameChanged(std::get<0>(peer), std::get<1>(peer), std::get<2>(peer));
     }
-    if (oldPeerNames.size() != nPeers) {
-        emit numPeersChanged(nPeers);
+    if (oldCount != peerDisplayNames.size()) {
+        emit numPeersChanged(peerDisplayNames.size());
     }
 }
 
@@ -31,6 +31,7 @@ GroupMessageDispatcher::GroupMessageDispatcher(Group& g_, MessageProcessor proce
     , idHandler(idHandler_)
     , messageSender(messageSender_)
     , groupSettings(groupSettings_)
+    , blockedPeers(groupSettings_.getPeerBlackList())
 {
     processor.enableMentions();
 }
@@ -90,7 +91,7 @@ void GroupMessageDispatcher::onMessageReceived(const ToxPk& sender, bool isActio
         return;
     }
 
-    if (groupSettings.getBlackList().contains(sender.toString())) {
+    if (blockedPeers.contains(sender)) {
         qDebug() << "onGroupMessageReceived: Filtered:" << sender.toString();
         return;
     }
@@ -24,6 +24,7 @@
 #include "src/model/group.h"
 #include "src/model/imessagedispatcher.h"
 #include "src/model/message.h"
+#include "src/persistence/peerblacklist.h"
 
 #include <QObject>
 #include <QString>
@@ -53,5 +54,6 @@ private:
     ICoreIdHandler& idHandler;
     ICoreGroupMessageSender& messageSender;
     const IGroupSettings& groupSettings;
+    PeerBlackList::Reader blockedPeers;
     DispatchedMessageId nextMessageId{0};
 };
@@ -33,6 +33,7 @@
 #include "src/widget/searchtypes.h"
 
 #include <cassert>
+#include <functional>
 
 using ChatLogIdx =
     NamedType<size_t, struct ChatLogIdxTag, Orderable, UnderlyingAddable, UnitlessDifferencable, Incrementable>;
@@ -80,6 +81,18 @@ struct SearchResult
     QRegularExpression exp;
 };
 
+struct SearchText
+{
+    ChatLogIdx idx;
+    QString text;
+};
+
+/**
+ * Returns the next page of message contents in the direction it was created for and an
+ * empty page once there are no more messages. It's called from a background thread.
+ */
+using SearchTextReader = std::function<std::vector<SearchText>()>;
+
 class IChatLog : public QObject
 {
     Q_OBJECT
@@ -112,6 +125,13 @@ public:
     virtual SearchResult searchBackward(SearchPos startIdx, const QString& phrase,
                                         const ParameterSearch& parameter) const = 0;
 
+    /**
+     * @brief Creates a reader over the contents of all messages for background searches
+     * @param[in] direction Down to start with the oldest message, Up to start with the newest
+     * @return Reader that is safe to call from any thread
+     */
+    virtual SearchTextReader createSearchTextReader(SearchDirection direction) const = 0;
+
     /**
      * @brief The underlying chat log instance may not want to start at 0
      * @return Current first valid index to call at() with
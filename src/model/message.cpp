@@ -21,11 +21,19 @@
 #include "friend.h"
 #include "src/core/core.h"
 
+#include <atomic>
 #include <cassert>
 
 namespace {
     QStringList splitMessage(const QString& message, uint64_t maxLength)
     {
+        // a UTF-16 code unit never takes more than 3 bytes in UTF-8, short messages can be
+        // passed on without encoding them here as well
+        constexpr uint64_t maxUtf8BytesPerChar = 3;
+        if (static_cast<uint64_t>(message.size()) * maxUtf8BytesPerChar <= maxLength) {
+            return {message};
+        }
+
         QStringList splittedMsgs;
         QByteArray ba_message{message.toUtf8()};
         while (static_cast<uint64_t>(ba_message.size()) > maxLength) {
@@ -55,14 +63,23 @@ namespace {
         return splittedMsgs;
     }
 }
+
+/**
+ * @brief Returns the expression matching any mention of ourself, safe to call from any thread
+ */
+std::shared_ptr<const QRegularExpression> MessageProcessor::SharedParams::getMentionMatcher() const
+{
+    return std::atomic_load(&mentionMatcher);
+}
+
 void MessageProcessor::SharedParams::onUserNameSet(const QString& username)
 {
-    QString sanename = username;
-    sanename.remove(QRegularExpression("[\\t\\n\\v\\f\\r\\x0000]"));
-    nameMention = QRegularExpression("\\b" + QRegularExpression::escape(username) + "\\b",
-                                     QRegularExpression::CaseInsensitiveOption);
-    sanitizedNameMention = QRegularExpression("\\b" + QRegularExpression::escape(sanename) + "\\b",
-                                              QRegularExpression::CaseInsensitiveOption);
+    if (username == userName) {
+        return;
+    }
+
+    userName = username;
+    updateMentionMatcher();
 }
 
 /**
@@ -71,9 +88,43 @@ void MessageProcessor::SharedParams::onUserNameSet(const QString& username)
  */
 void MessageProcessor::SharedParams::setPublicKey(const QString& pk)
 {
-    // no sanitization needed, we expect a ToxPk in its string form
-    pubKeyMention = QRegularExpression("\\b" + pk + "\\b",
-                                       QRegularExpression::CaseInsensitiveOption);
+    if (pk == publicKey) {
+        return;
+    }
+
+    publicKey = pk;
+    updateMentionMatcher();
+}
+
+/**
+ * @brief Compiles our name, its sanitized form and our public key into one expression.
+ */
+void MessageProcessor::SharedParams::updateMentionMatcher()
+{
+    QString sanename = userName;
+    sanename.remove(QRegularExpression("[\\t\\n\\v\\f\\r\\x0000]"));
+
+    QStringList alternatives;
+    for (const QString& name : {userName, sanename}) {
+        if (!name.isEmpty()) {
+            alternatives << QRegularExpression::escape(name);
+        }
+    }
+    // no escaping needed, we expect a ToxPk in its string form
+    if (!publicKey.isEmpty()) {
+        alternatives << publicKey;
+    }
+    alternatives.removeDuplicates();
+
+    // an empty expression would match on everything
+    auto matcher = std::make_shared<QRegularExpression>();
+    if (!alternatives.isEmpty()) {
+        matcher->setPattern("\\b(?:" + alternatives.join('|') + ")\\b");
+        matcher->setPatternOptions(QRegularExpression::CaseInsensitiveOption);
+        matcher->optimize();
+    }
+
+    std::atomic_store(&mentionMatcher, std::shared_ptr<const QRegularExpression>{std::move(matcher)});
 }
 
 MessageProcessor::MessageProcessor(const MessageProcessor::SharedParams& sharedParams)
@@ -124,28 +175,14 @@ Message MessageProcessor::processIncomingCoreMessage(bool isAction, QString cons
     ret.timestamp = timestamp;
 
     if (detectingMentions) {
-        auto nameMention = sharedParams.getNameMention();
-        auto sanitizedNameMention = sharedParams.getSanitizedNameMention();
-        auto pubKeyMention = sharedParams.getPublicKeyMention();
-
-        for (auto const& mention : {nameMention, sanitizedNameMention, pubKeyMention}) {
-            auto matchIt = mention.globalMatch(ret.content);
-            if (!matchIt.hasNext()) {
-                continue;
-            }
-
-            auto match = matchIt.next();
+        const auto mentionMatcher = sharedParams.getMentionMatcher();
+        const auto match = mentionMatcher->match(ret.content);
 
+        // skip matches of the empty expression used while we have no name
+        if (match.hasMatch() && match.capturedLength() > 0) {
             auto pos = static_cast<size_t>(match.capturedStart());
             auto length = static_cast<size_t>(match.capturedLength());
-
-            // skip matches on empty usernames
-            if (length == 0) {
-                continue;
-            }
-
             ret.metadata.push_back({MessageMetadataType::selfMention, pos, pos + length});
-            break;
         }
     }
 
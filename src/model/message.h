@@ -26,6 +26,7 @@
 #include <QRegularExpression>
 #include <QString>
 
+#include <memory>
 #include <vector>
 
 class Friend;
@@ -74,20 +75,10 @@ public:
         SharedParams(uint64_t maxCoreMessageSize_, uint64_t maxExtendedMessageSize_)
             : maxCoreMessageSize(maxCoreMessageSize_)
             , maxExtendedMessageSize(maxExtendedMessageSize_)
+            , mentionMatcher(std::make_shared<const QRegularExpression>())
         {}
 
-        QRegularExpression getNameMention() const
-        {
-            return nameMention;
-        }
-        QRegularExpression getSanitizedNameMention() const
-        {
-            return sanitizedNameMention;
-        }
-        QRegularExpression getPublicKeyMention() const
-        {
-            return pubKeyMention;
-        }
+        std::shared_ptr<const QRegularExpression> getMentionMatcher() const;
         void onUserNameSet(const QString& username);
         void setPublicKey(const QString& pk);
 
@@ -102,11 +93,14 @@ public:
         }
 
     private:
+        void updateMentionMatcher();
+
         uint64_t maxCoreMessageSize;
         uint64_t maxExtendedMessageSize;
-        QRegularExpression nameMention;
-        QRegularExpression sanitizedNameMention;
-        QRegularExpression pubKeyMention;
+        QString userName;
+        QString publicKey;
+        // swapped atomically, processors may read it while it's rebuilt
+        std::shared_ptr<const QRegularExpression> mentionMatcher;
     };
 
     MessageProcessor(const SharedParams& sharedParams);
@@ -23,6 +23,8 @@
 
 #include <QDebug>
 #include <QtGlobal>
+
+#include <algorithm>
 #include <mutex>
 
 namespace {
@@ -34,7 +36,7 @@ namespace {
 struct MessageDateAdaptor
 {
     static const QDateTime invalidDateTime;
-    MessageDateAdaptor(const std::pair<const ChatLogIdx, ChatLogItem>& item)
+    MessageDateAdaptor(const std::pair<ChatLogIdx, ChatLogItem>& item)
         : timestamp(item.second.getContentType() == ChatLogItem::ContentType::message
                         ? item.second.getContentAsMessage().message.timestamp
                         : invalidDateTime)
@@ -49,32 +51,8 @@ struct MessageDateAdaptor
 
 const QDateTime MessageDateAdaptor::invalidDateTime;
 
-/**
- * @brief The search types all can be represented as some regular expression. This function
- *   takes the input phrase and filter and generates the appropriate regular expression
- * @return Regular expression which finds the input
- */
-QRegularExpression getRegexpForPhrase(const QString& phrase, FilterSearch filter)
-{
-    constexpr auto regexFlags = QRegularExpression::UseUnicodePropertiesOption;
-    constexpr auto caseInsensitiveFlags = QRegularExpression::CaseInsensitiveOption;
-
-    switch (filter) {
-    case FilterSearch::Register:
-        return QRegularExpression(QRegularExpression::escape(phrase), regexFlags);
-    case FilterSearch::WordsOnly:
-        return QRegularExpression(SearchExtraFunctions::generateFilterWordsOnly(phrase),
-                                  caseInsensitiveFlags);
-    case FilterSearch::RegisterAndWordsOnly:
-        return QRegularExpression(SearchExtraFunctions::generateFilterWordsOnly(phrase), regexFlags);
-    case FilterSearch::RegisterAndRegular:
-        return QRegularExpression(phrase, regexFlags);
-    case FilterSearch::Regular:
-        return QRegularExpression(phrase, caseInsensitiveFlags);
-    default:
-        return QRegularExpression(QRegularExpression::escape(phrase), caseInsensitiveFlags);
-    }
-}
+// Small enough that searches can be cancelled quickly
+constexpr size_t searchPageSize = 1000;
 
 /**
  * @return True if the given status indicates no future updates will come in
@@ -94,17 +72,15 @@ bool toxFileIsComplete(ToxFile::FileStatus status)
     }
 }
 
-std::map<ChatLogIdx, ChatLogItem>::const_iterator
-firstItemAfterDate(QDate date, const std::map<ChatLogIdx, ChatLogItem>& items)
+bool isBeforeDate(const MessageDateAdaptor& a, const MessageDateAdaptor& b)
 {
-#if (QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
-    return std::lower_bound(items.begin(), items.end(), QDateTime(date.startOfDay()),
-#else
-    return std::lower_bound(items.begin(), items.end(), QDateTime(date),
-#endif
-                            [](const MessageDateAdaptor& a, MessageDateAdaptor const& b) {
-                                return a.timestamp.date() < b.timestamp.date();
-                            });
+    return a.timestamp.date() < b.timestamp.date();
+}
+
+template <typename Entry>
+bool hasIdx(const Entry& entry, ChatLogIdx idx)
+{
+    return entry.first < idx;
 }
 
 QString resolveToxPk(const ToxPk& pk)
@@ -139,6 +115,8 @@ SessionChatLog::SessionChatLog(ChatLogIdx initialIdx, const ICoreIdHandler& core
 
 SessionChatLog::~SessionChatLog() = default;
 
+constexpr size_t SessionChatLog::chunkSize;
+
 QString SessionChatLog::resolveSenderNameFromSender(const ToxPk& sender)
 {
     bool isSelf = sender == coreIdHandler.getSelfPublicKey();
@@ -147,14 +125,199 @@ QString SessionChatLog::resolveSenderNameFromSender(const ToxPk& sender)
     return isSelf ? myNickName : resolveToxPk(sender);
 }
 
+/**
+ * @note The returned reference stays valid until an item is inserted before it in the same
+ * chunk, which moves the items after it, or until items of two other chunks have been
+ * accessed or inserted, after that its chunk may be evicted. Appending to a chunk keeps it
+ * valid, chunks reserve room for all of their items.
+ */
 const ChatLogItem& SessionChatLog::at(ChatLogIdx idx) const
 {
-    auto item = items.find(idx);
-    if (item == items.end()) {
+    auto item = findItem(idx);
+    if (!item) {
         std::terminate();
     }
 
-    return item->second;
+    chunks.find(idx.get() / chunkSize)->second.lastUse = ++useCounter;
+    return *item;
+}
+
+const ChatLogItem* SessionChatLog::findItem(ChatLogIdx idx) const
+{
+    auto chunkIt = chunks.find(idx.get() / chunkSize);
+    if (chunkIt == chunks.end()) {
+        return nullptr;
+    }
+
+    const auto& entries = chunkIt->second.entries;
+    // Chunks are usually contiguous, so the offset from the first entry is the position
+    const size_t offset = idx - entries.front().first;
+    if (idx >= entries.front().first && offset < entries.size() && entries[offset].first == idx) {
+        return &entries[offset].second;
+    }
+
+    auto it = std::lower_bound(entries.begin(), entries.end(), idx, hasIdx<Entry>);
+    if (it == entries.end() || it->first != idx) {
+        return nullptr;
+    }
+
+    return &it->second;
+}
+
+ChatLogItem* SessionChatLog::findItem(ChatLogIdx idx)
+{
+    return const_cast<ChatLogItem*>(static_cast<const SessionChatLog*>(this)->findItem(idx));
+}
+
+/**
+ * @brief Adds an item to its chunk, an existing item at the same index is kept
+ */
+void SessionChatLog::insertItem(ChatLogIdx idx, ChatLogItem item)
+{
+    auto& chunk = chunks[idx.get() / chunkSize];
+    auto& entries = chunk.entries;
+    chunk.lastUse = ++useCounter;
+    if (entries.empty()) {
+        entries.reserve(chunkSize);
+    }
+
+    if (entries.empty() || entries.back().first < idx) {
+        entries.emplace_back(idx, std::move(item));
+    } else {
+        auto it = std::lower_bound(entries.begin(), entries.end(), idx, hasIdx<Entry>);
+        if (it->first == idx) {
+            return;
+        }
+        entries.emplace(it, idx, std::move(item));
+    }
+
+    ++numCachedItems;
+    if (cacheLimit != 0 && numCachedItems > cacheLimit) {
+        evictColdChunks();
+    }
+}
+
+/**
+ * @return True if the given index is currently held in memory
+ */
+bool SessionChatLog::contains(ChatLogIdx idx) const
+{
+    return findItem(idx) != nullptr;
+}
+
+/**
+ * @return First index of the uninterrupted range of cached items that contains idx
+ */
+ChatLogIdx SessionChatLog::getCachedRangeStart(ChatLogIdx idx) const
+{
+    while (idx.get() > 0 && contains(idx - 1)) {
+        idx = idx - 1;
+    }
+
+    return idx;
+}
+
+/**
+ * @return First index after idx that is not cached, or idx if it isn't cached itself
+ */
+ChatLogIdx SessionChatLog::getCachedRangeEnd(ChatLogIdx idx) const
+{
+    while (idx < nextIdx && contains(idx)) {
+        ++idx;
+    }
+
+    return idx;
+}
+
+/**
+ * @brief Limits the number of items held in memory. Least recently used chunks are
+ * evicted first, chunks with pending messages, running file transfers and the newest
+ * chunk are always kept.
+ * @param maxItems Maximum number of cached items, 0 disables eviction
+ * @note The owner has to re-insert evicted items before calling at() for them
+ */
+void SessionChatLog::setCacheLimit(size_t maxItems)
+{
+    cacheLimit = maxItems;
+    if (cacheLimit != 0 && numCachedItems > cacheLimit) {
+        evictColdChunks();
+    }
+}
+
+size_t SessionChatLog::getNumCachedItems() const
+{
+    return numCachedItems;
+}
+
+bool SessionChatLog::isPinned(size_t chunkNum) const
+{
+    if (nextIdx.get() > 0 && (nextIdx.get() - 1) / chunkSize == chunkNum) {
+        return true;
+    }
+
+    for (auto it = outgoingMessages.begin(); it != outgoingMessages.end(); ++it) {
+        if (it.value().get() / chunkSize != chunkNum) {
+            continue;
+        }
+
+        const auto item = findItem(it.value());
+        if (item && item->getContentAsMessage().state == MessageState::pending) {
+            return true;
+        }
+    }
+
+    for (const auto& transfer : currentFileTransfers) {
+        if (transfer.idx.get() / chunkSize == chunkNum) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void SessionChatLog::evictColdChunks()
+{
+    while (numCachedItems > cacheLimit) {
+        // Callers may still hold references into the two most recently used chunks
+        quint64 newest = 0;
+        quint64 secondNewest = 0;
+        for (const auto& chunk : chunks) {
+            const auto lastUse = chunk.second.lastUse;
+            if (lastUse > newest) {
+                secondNewest = newest;
+                newest = lastUse;
+            } else if (lastUse > secondNewest) {
+                secondNewest = lastUse;
+            }
+        }
+
+        auto victim = chunks.end();
+        for (auto it = chunks.begin(); it != chunks.end(); ++it) {
+            if (it->second.lastUse >= secondNewest || isPinned(it->first)) {
+                continue;
+            }
+
+            if (victim == chunks.end() || it->second.lastUse < victim->second.lastUse) {
+                victim = it;
+            }
+        }
+
+        if (victim == chunks.end()) {
+            return;
+        }
+
+        // Only completed or broken messages are left, they won't be updated again
+        for (auto it = outgoingMessages.begin(); it != outgoingMessages.end();) {
+            if (it.value().get() / chunkSize == victim->first) {
+                it = outgoingMessages.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        numCachedItems -= victim->second.entries.size();
+        chunks.erase(victim);
+    }
 }
 
 SearchResult SessionChatLog::searchForward(SearchPos startPos, const QString& phrase,
@@ -168,17 +331,20 @@ SearchResult SessionChatLog::searchForward(SearchPos startPos, const QString& ph
 
     auto currentPos = startPos;
 
-    auto regexp = getRegexpForPhrase(phrase, parameter.filter);
+    auto regexp = SearchExtraFunctions::getRegexpForPhrase(phrase, parameter.filter);
 
-    for (auto it = items.find(currentPos.logIdx); it != items.end(); ++it) {
-        const auto& key = it->first;
-        const auto& item = it->second;
+    // Stops at the first item that isn't cached, the owner has to load it first
+    for (auto key = currentPos.logIdx; key < nextIdx; ++key) {
+        const auto item = findItem(key);
+        if (!item) {
+            break;
+        }
 
-        if (item.getContentType() != ChatLogItem::ContentType::message) {
+        if (item->getContentType() != ChatLogItem::ContentType::message) {
             continue;
         }
 
-        const auto& content = item.getContentAsMessage();
+        const auto& content = item->getContentAsMessage();
 
         auto match = regexp.globalMatch(content.message.content, 0);
 
@@ -214,27 +380,23 @@ SearchResult SessionChatLog::searchBackward(SearchPos startPos, const QString& p
                                             const ParameterSearch& parameter) const
 {
     auto currentPos = startPos;
-    auto regexp = getRegexpForPhrase(phrase, parameter.filter);
-    auto startIt = items.find(currentPos.logIdx);
+    auto regexp = SearchExtraFunctions::getRegexpForPhrase(phrase, parameter.filter);
+    auto startIdx = currentPos.logIdx;
 
     // If we don't have it we'll start at the end
-    if (startIt == items.end()) {
-        if (items.empty()) {
+    if (!contains(startIdx)) {
+        if (chunks.empty()) {
             SearchResult ret;
             ret.found = false;
             return ret;
         }
-        startIt = std::prev(items.end());
+        startIdx = chunks.rbegin()->second.entries.back().first;
         startPos.numMatches = 0;
     }
 
-    // Off by 1 due to reverse_iterator api
-    auto rStartIt = std::reverse_iterator<decltype(startIt)>(std::next(startIt));
-    auto rEnd = std::reverse_iterator<decltype(startIt)>(items.begin());
-
-    for (auto it = rStartIt; it != rEnd; ++it) {
-        const auto& key = it->first;
-        const auto& item = it->second;
+    // Stops at the first item that isn't cached, the owner has to load it first
+    for (auto key = startIdx; contains(key); key = key - 1) {
+        const auto& item = *findItem(key);
 
         if (item.getContentType() != ChatLogItem::ContentType::message) {
             continue;
@@ -277,13 +439,40 @@ SearchResult SessionChatLog::searchBackward(SearchPos startPos, const QString& p
     return ret;
 }
 
+SearchTextReader SessionChatLog::createSearchTextReader(SearchDirection direction) const
+{
+    // Contents are implicitly shared, so copying them is cheap and the copy can be read
+    // from any thread
+    auto texts = std::make_shared<std::vector<SearchText>>();
+    texts->reserve(numCachedItems);
+    for (const auto& chunk : chunks) {
+        for (const auto& entry : chunk.second.entries) {
+            if (entry.second.getContentType() == ChatLogItem::ContentType::message) {
+                texts->push_back({entry.first, entry.second.getContentAsMessage().message.content});
+            }
+        }
+    }
+
+    if (direction == SearchDirection::Up) {
+        std::reverse(texts->begin(), texts->end());
+    }
+
+    size_t pos = 0;
+    return [texts, pos]() mutable {
+        const auto end = std::min(pos + searchPageSize, texts->size());
+        std::vector<SearchText> page(texts->begin() + pos, texts->begin() + end);
+        pos = end;
+        return page;
+    };
+}
+
 ChatLogIdx SessionChatLog::getFirstIdx() const
 {
-    if (items.empty()) {
+    if (chunks.empty()) {
         return nextIdx;
     }
 
-    return items.begin()->first;
+    return chunks.begin()->second.entries.front().first;
 }
 
 ChatLogIdx SessionChatLog::getNextIdx() const
@@ -298,15 +487,15 @@ std::vector<IChatLog::DateChatLogIdxPair> SessionChatLog::getDateIdxs(const QDat
     auto dateIt = startDate;
 
     while (true) {
-        auto it = firstItemAfterDate(dateIt, items);
+        auto idx = firstIdxAfterDate(dateIt);
 
-        if (it == items.end()) {
+        if (idx == nextIdx) {
             break;
         }
 
         DateChatLogIdxPair pair;
         pair.date = dateIt;
-        pair.idx = it->first;
+        pair.idx = idx;
 
         ret.push_back(std::move(pair));
 
@@ -319,6 +508,29 @@ std::vector<IChatLog::DateChatLogIdxPair> SessionChatLog::getDateIdxs(const QDat
     return ret;
 }
 
+/**
+ * @return Index of the first cached item on or after the given date, nextIdx if there is none
+ */
+ChatLogIdx SessionChatLog::firstIdxAfterDate(QDate date) const
+{
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
+    const QDateTime dateTime = date.startOfDay();
+#else
+    const QDateTime dateTime = QDateTime(date);
+#endif
+
+    for (const auto& chunk : chunks) {
+        const auto& entries = chunk.second.entries;
+        if (isBeforeDate(entries.back(), dateTime)) {
+            continue;
+        }
+
+        return std::lower_bound(entries.begin(), entries.end(), dateTime, isBeforeDate)->first;
+    }
+
+    return nextIdx;
+}
+
 void SessionChatLog::insertCompleteMessageAtIdx(ChatLogIdx idx, const ToxPk& sender, QString senderName,
                                                 const ChatLogMessage& message)
 {
@@ -326,7 +538,7 @@ void SessionChatLog::insertCompleteMessageAtIdx(ChatLogIdx idx, const ToxPk& sen
 
     assert(message.state == MessageState::complete);
 
-    items.emplace(idx, std::move(item));
+    insertItem(idx, std::move(item));
 }
 
 void SessionChatLog::insertIncompleteMessageAtIdx(ChatLogIdx idx, const ToxPk& sender, QString senderName,
@@ -337,7 +549,7 @@ void SessionChatLog::insertIncompleteMessageAtIdx(ChatLogIdx idx, const ToxPk& s
 
     assert(message.state == MessageState::pending);
 
-    items.emplace(idx, std::move(item));
+    insertItem(idx, std::move(item));
     outgoingMessages.insert(dispatchId, idx);
 }
 
@@ -348,14 +560,14 @@ void SessionChatLog::insertBrokenMessageAtIdx(ChatLogIdx idx, const ToxPk& sende
 
     assert(message.state == MessageState::broken);
 
-    items.emplace(idx, std::move(item));
+    insertItem(idx, std::move(item));
 }
 
 void SessionChatLog::insertFileAtIdx(ChatLogIdx idx, const ToxPk& sender, QString senderName, const ChatLogFile& file)
 {
     auto item = ChatLogItem(sender, senderName, file);
 
-    items.emplace(idx, std::move(item));
+    insertItem(idx, std::move(item));
 }
 
 /**
@@ -369,7 +581,7 @@ void SessionChatLog::onMessageReceived(const ToxPk& sender, const Message& messa
     ChatLogMessage chatLogMessage;
     chatLogMessage.state = MessageState::complete;
     chatLogMessage.message = message;
-    items.emplace(messageIdx, ChatLogItem(sender, resolveSenderNameFromSender(sender), chatLogMessage));
+    insertItem(messageIdx, ChatLogItem(sender, resolveSenderNameFromSender(sender), chatLogMessage));
 
     emit this->itemUpdated(messageIdx);
 }
@@ -387,7 +599,7 @@ void SessionChatLog::onMessageSent(DispatchedMessageId id, const Message& messag
     chatLogMessage.message = message;
     const ToxPk selfPk = coreIdHandler.getSelfPublicKey();
     const QString selfName = resolveSenderNameFromSender(selfPk);
-    items.emplace(messageIdx, ChatLogItem(selfPk, selfName, chatLogMessage));
+    insertItem(messageIdx, ChatLogItem(selfPk, selfName, chatLogMessage));
 
     outgoingMessages.insert(id, messageIdx);
 
@@ -407,17 +619,17 @@ void SessionChatLog::onMessageComplete(DispatchedMessageId id)
         return;
     }
 
-    const auto& chatLogIdx = *chatLogIdxIt;
-    auto messageIt = items.find(chatLogIdx);
+    const auto chatLogIdx = *chatLogIdxIt;
+    auto message = findItem(chatLogIdx);
 
-    if (messageIt == items.end()) {
+    if (!message) {
         qWarning() << "Failed to look up message in chat log";
         return;
     }
 
-    messageIt->second.getContentAsMessage().state = MessageState::complete;
+    message->getContentAsMessage().state = MessageState::complete;
 
-    emit this->itemUpdated(messageIt->first);
+    emit this->itemUpdated(chatLogIdx);
 }
 
 void SessionChatLog::onMessageBroken(DispatchedMessageId id, BrokenMessageReason)
@@ -429,18 +641,18 @@ void SessionChatLog::onMessageBroken(DispatchedMessageId id, BrokenMessageReason
         return;
     }
 
-    const auto& chatLogIdx = *chatLogIdxIt;
-    auto messageIt = items.find(chatLogIdx);
+    const auto chatLogIdx = *chatLogIdxIt;
+    auto message = findItem(chatLogIdx);
 
-    if (messageIt == items.end()) {
+    if (!message) {
         qWarning() << "Failed to look up message in chat log";
         return;
     }
 
     // NOTE: Reason for broken message not currently shown in UI, but it could be
-    messageIt->second.getContentAsMessage().state = MessageState::broken;
+    message->getContentAsMessage().state = MessageState::broken;
 
-    emit this->itemUpdated(messageIt->first);
+    emit this->itemUpdated(chatLogIdx);
 }
 
 /**
@@ -463,13 +675,13 @@ void SessionChatLog::onFileUpdated(const ToxPk& sender, const ToxFile& file)
         currentFileTransfers.push_back(currentTransfer);
 
         const auto chatLogFile = ChatLogFile{QDateTime::currentDateTime(), file};
-        items.emplace(currentTransfer.idx, ChatLogItem(sender, resolveSenderNameFromSender(sender), chatLogFile));
+        insertItem(currentTransfer.idx, ChatLogItem(sender, resolveSenderNameFromSender(sender), chatLogFile));
         messageIdx = currentTransfer.idx;
     } else if (fileIt != currentFileTransfers.end()) {
         messageIdx = fileIt->idx;
         fileIt->file = file;
 
-        items.at(messageIdx).getContentAsFile().file = file;
+        findItem(messageIdx)->getContentAsFile().file = file;
     } else {
         // This may be a file unbroken message that we don't handle ATM
         return;
@@ -482,6 +694,34 @@ void SessionChatLog::onFileUpdated(const ToxPk& sender, const ToxFile& file)
     emit this->itemUpdated(messageIdx);
 }
 
+/**
+ * @brief Updates the progress of a running file transfer in the chatlog
+ * @note Updates for transfers we don't track are ignored, e.g. ones that just completed
+ */
+void SessionChatLog::onFileProgress(const ToxFileProgressInfo& info)
+{
+    auto fileIt =
+        std::find_if(currentFileTransfers.begin(), currentFileTransfers.end(),
+                     [&](const CurrentFileTransfer& transfer) {
+                         return transfer.file.fileNum == info.fileNum
+                                && transfer.file.friendId == info.friendId
+                                && transfer.file.direction == info.direction;
+                     });
+
+    if (fileIt == currentFileTransfers.end()) {
+        return;
+    }
+
+    fileIt->file.bytesSent = info.bytesSent;
+    fileIt->file.filesize = info.filesize;
+
+    ToxFile& file = findItem(fileIt->idx)->getContentAsFile().file;
+    file.bytesSent = info.bytesSent;
+    file.filesize = info.filesize;
+
+    emit this->itemUpdated(fileIt->idx);
+}
+
 void SessionChatLog::onFileTransferRemotePausedUnpaused(const ToxPk& sender, const ToxFile& file,
                                                         bool /*paused*/)
 {
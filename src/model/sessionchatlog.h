@@ -25,6 +25,9 @@
 #include <QList>
 #include <QObject>
 
+#include <map>
+#include <vector>
+
 struct SessionChatLogMetadata;
 
 
@@ -36,11 +39,15 @@ public:
     SessionChatLog(ChatLogIdx initialIdx, const ICoreIdHandler& coreIdHandler);
 
     ~SessionChatLog();
+
+    static constexpr size_t chunkSize = 256;
+
     const ChatLogItem& at(ChatLogIdx idx) const override;
     SearchResult searchForward(SearchPos startIdx, const QString& phrase,
                                const ParameterSearch& parameter) const override;
     SearchResult searchBackward(SearchPos startIdx, const QString& phrase,
                                 const ParameterSearch& parameter) const override;
+    SearchTextReader createSearchTextReader(SearchDirection direction) const override;
     ChatLogIdx getFirstIdx() const override;
     ChatLogIdx getNextIdx() const override;
     std::vector<DateChatLogIdxPair> getDateIdxs(const QDate& startDate, size_t maxDates) const override;
@@ -53,6 +60,12 @@ public:
                                   const ChatLogMessage& message);
     void insertFileAtIdx(ChatLogIdx idx, const ToxPk& sender, QString senderName, const ChatLogFile& file);
 
+    bool contains(ChatLogIdx idx) const;
+    ChatLogIdx getCachedRangeStart(ChatLogIdx idx) const;
+    ChatLogIdx getCachedRangeEnd(ChatLogIdx idx) const;
+    void setCacheLimit(size_t maxItems);
+    size_t getNumCachedItems() const;
+
 public slots:
     void onMessageReceived(const ToxPk& sender, const Message& message);
     void onMessageSent(DispatchedMessageId id, const Message& message);
@@ -60,11 +73,30 @@ public slots:
     void onMessageBroken(DispatchedMessageId id, BrokenMessageReason reason);
 
     void onFileUpdated(const ToxPk& sender, const ToxFile& file);
+    void onFileProgress(const ToxFileProgressInfo& info);
     void onFileTransferRemotePausedUnpaused(const ToxPk& sender, const ToxFile& file, bool paused);
     void onFileTransferBrokenUnbroken(const ToxPk& sender, const ToxFile& file, bool broken);
 
 private:
+    using Entry = std::pair<ChatLogIdx, ChatLogItem>;
+
+    /**
+     * Items of one aligned range of chunkSize indexes, sorted by index. Chunks are
+     * loaded and evicted as a whole, so they are usually contiguous.
+     */
+    struct Chunk
+    {
+        std::vector<Entry> entries;
+        mutable quint64 lastUse = 0;
+    };
+
     QString resolveSenderNameFromSender(const ToxPk &sender);
+    const ChatLogItem* findItem(ChatLogIdx idx) const;
+    ChatLogItem* findItem(ChatLogIdx idx);
+    void insertItem(ChatLogIdx idx, ChatLogItem item);
+    ChatLogIdx firstIdxAfterDate(QDate date) const;
+    bool isPinned(size_t chunkNum) const;
+    void evictColdChunks();
 
 
 private:
@@ -72,7 +104,15 @@ private:
 
     ChatLogIdx nextIdx = ChatLogIdx(0);
 
-    std::map<ChatLogIdx, ChatLogItem> items;
+    std::map<size_t, Chunk> chunks;
+    size_t numCachedItems = 0;
+
+    /**
+     * Maximum number of cached items, 0 keeps everything. Only set this if the
+     * owner can re-insert evicted items, e.g. from History
+     */
+    size_t cacheLimit = 0;
+    mutable quint64 useCounter = 0;
 
     struct CurrentFileTransfer
     {
@@ -100,8 +100,10 @@ void Nexus::start()
     qRegisterMetaType<ToxAV*>("ToxAV*");
     qRegisterMetaType<ToxFile>("ToxFile");
     qRegisterMetaType<ToxFile::FileDirection>("ToxFile::FileDirection");
+    qRegisterMetaType<ToxFileProgressInfo>("ToxFileProgressInfo");
     qRegisterMetaType<std::shared_ptr<VideoFrame>>("std::shared_ptr<VideoFrame>");
     qRegisterMetaType<ToxPk>("ToxPk");
+    qRegisterMetaType<QVector<FriendSnapshot>>("QVector<FriendSnapshot>");
     qRegisterMetaType<ToxId>("ToxId");
     qRegisterMetaType<ToxPk>("GroupId");
     qRegisterMetaType<ToxPk>("ContactId");
@@ -308,7 +310,8 @@ void Nexus::onCreateNewProfile(const QString& name, const QString& pass)
  */
 void Nexus::onLoadProfile(const QString& name, const QString& pass)
 {
-    setProfile(Profile::loadProfile(name, pass, *settings, parser));
+    Profile::loadProfileAsync(name, pass, *settings, parser, this,
+                              [this](Profile* p) { setProfile(p); });
     parser = nullptr; // only apply cmdline proxy settings once
 }
 /**
@@ -85,10 +85,23 @@
  * Otherwise we will use toxencryptsave to derive a key and encrypt the database.
  */
 RawDatabase::RawDatabase(const QString& path, const QString& password, const QByteArray& salt)
+    : RawDatabase(path, password, salt, deriveKey(password, salt))
+{
+}
+
+/**
+ * @brief Tries to open a database with a key that was already derived from the password.
+ * @param path Path to database.
+ * @param password Password the key was derived from, used for the legacy salt fallback.
+ * @param salt Salt the key was derived with.
+ * @param hexKey Result of deriveKey(password, salt).
+ */
+RawDatabase::RawDatabase(const QString& path, const QString& password, const QByteArray& salt,
+                         const QString& hexKey)
     : workerThread{new QThread}
     , path{path}
     , currentSalt{salt} // we need the salt later if a new password should be set
-    , currentHexKey{deriveKey(password, salt)}
+    , currentHexKey{hexKey}
 {
     workerThread->setObjectName("qTox Database");
     moveToThread(workerThread.get());
@@ -98,6 +98,8 @@ public:
     };
 
     RawDatabase(const QString& path, const QString& password, const QByteArray& salt);
+    RawDatabase(const QString& path, const QString& password, const QByteArray& salt,
+                const QString& hexKey);
     ~RawDatabase();
     bool isOpen();
 
@@ -126,6 +128,8 @@ public:
         return {};
     }
 
+    static QString deriveKey(const QString& password, const QByteArray& salt);
+
 public slots:
     bool setPassword(const QString& password);
     bool rename(const QString& newPath);
@@ -151,7 +155,6 @@ private:
     bool testUsable();
 
 protected:
-    static QString deriveKey(const QString& password, const QByteArray& salt);
     static QString deriveKey(const QString& password);
     static QVariant extractData(sqlite3_stmt* stmt, int col);
     static void regexpInsensitive(sqlite3_context* ctx, int argc, sqlite3_value** argv);
@@ -18,6 +18,8 @@
 */
 
 #include <QDebug>
+#include <QStringList>
+#include <QTimer>
 #include <cassert>
 
 #include "history.h"
@@ -442,6 +444,8 @@ History::~History()
         return;
     }
 
+    flushDeliveredMessages();
+
     // We could have execLater requests pending with a lambda attached,
     // so clear the pending transactions first
     db->sync();
@@ -770,6 +774,8 @@ QList<History::HistMessage> History::getMessagesForFriend(const ToxPk& friendPk,
         return {};
     }
 
+    flushDeliveredMessages();
+
     QList<HistMessage> messages;
 
     // Don't forget to update the rowCallback if you change the selected columns!
@@ -834,6 +840,8 @@ QList<History::HistMessage> History::getUndeliveredMessagesForFriend(const ToxPk
         return {};
     }
 
+    flushDeliveredMessages();
+
     auto queryText =
         QString("SELECT history.id, faux_offline_pending.id, timestamp, chat.public_key, "
                 "aliases.display_name, sender.public_key, message, broken_messages.id, "
@@ -871,6 +879,75 @@ QList<History::HistMessage> History::getUndeliveredMessagesForFriend(const ToxPk
     return ret;
 }
 
+/**
+ * @brief Counts the messages with a friend and finds the id of the newest one in one query,
+ * so both match even while messages are added.
+ * @param friendPk Friend public key
+ * @return Number of messages and id of the newest one, RowId{-1} if there are none
+ * @note Safe to call from any thread
+ */
+QPair<size_t, RowId> History::getNumMessagesAndLastIdForFriend(const ToxPk& friendPk)
+{
+    if (historyAccessBlocked()) {
+        return qMakePair(size_t{0}, RowId{-1});
+    }
+
+    QPair<size_t, RowId> result{0, RowId{-1}};
+    auto rowCallback = [&result](const QVector<QVariant>& row) {
+        result.first = row[0].toULongLong();
+        result.second = RowId{row[1].isNull() ? -1 : row[1].toLongLong()};
+    };
+
+    QString queryText = QString("SELECT COUNT(history.id), MAX(history.id) FROM history "
+                                "JOIN peers chat ON history.chat_id = chat.id "
+                                "WHERE chat.public_key='%1';")
+                            .arg(friendPk.toString());
+
+    db->execNow({queryText, rowCallback});
+
+    return result;
+}
+
+/**
+ * @brief Reads only the message texts of a conversation, for searching all of it.
+ * @param friendPk Friend public key
+ * @param fromId Only rows after (Down) or before (Up) this one are read
+ * @param maxNum Maximum number of rows to read
+ * @param direction Down to read in the order of getMessagesForFriend, Up for the reverse
+ * @return Row ids and texts, file transfers have empty texts
+ * @note Safe to call from any thread
+ */
+QList<QPair<RowId, QString>> History::getMessageTextsForFriend(const ToxPk& friendPk, RowId fromId,
+                                                               size_t maxNum, SearchDirection direction)
+{
+    if (historyAccessBlocked()) {
+        return {};
+    }
+
+    QList<QPair<RowId, QString>> texts;
+    auto rowCallback = [&texts](const QVector<QVariant>& row) {
+        texts.append(qMakePair(RowId{row[0].toLongLong()}, row[1].toString()));
+    };
+
+    const bool down = direction == SearchDirection::Down;
+
+    // Paging by id instead of an offset so reading the whole conversation stays linear
+    QString queryText =
+        QString("SELECT history.id, message FROM history "
+                "JOIN peers chat ON history.chat_id = chat.id "
+                "WHERE chat.public_key='%1' AND history.id %2 %3 "
+                "ORDER BY history.id %4 LIMIT %5;")
+            .arg(friendPk.toString())
+            .arg(down ? ">" : "<")
+            .arg(fromId.get())
+            .arg(down ? "ASC" : "DESC")
+            .arg(maxNum);
+
+    db->execNow({queryText, rowCallback});
+
+    return texts;
+}
+
 /**
  * @brief Search phrase in chat messages
  * @param friendPk Friend public key
@@ -1043,7 +1120,32 @@ void History::markAsDelivered(RowId messageId)
         return;
     }
 
-    db->execLater(QString("DELETE FROM faux_offline_pending WHERE id=%1;").arg(messageId.get()));
+    // receipts of resent messages tend to arrive in bursts, update them in one transaction
+    if (deliveredMessages.isEmpty()) {
+        QTimer::singleShot(0, this, &History::flushDeliveredMessages);
+    }
+    deliveredMessages.append(messageId);
+}
+
+/**
+ * @brief Removes all messages marked as delivered since the last call from the
+ * faux-offline pending messages list.
+ * @note Has to be called before reading the pending state of messages.
+ */
+void History::flushDeliveredMessages()
+{
+    if (deliveredMessages.isEmpty() || !isValid()) {
+        return;
+    }
+
+    QStringList ids;
+    ids.reserve(deliveredMessages.size());
+    for (const RowId& messageId : deliveredMessages) {
+        ids << QString::number(messageId.get());
+    }
+    deliveredMessages.clear();
+
+    db->execLater(QString("DELETE FROM faux_offline_pending WHERE id IN (%1);").arg(ids.join(',')));
 }
 
 /**
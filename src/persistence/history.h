@@ -182,6 +182,9 @@ public:
     size_t getNumMessagesForFriendBeforeDate(const ToxPk& friendPk, const QDateTime& date);
     QList<HistMessage> getMessagesForFriend(const ToxPk& friendPk, size_t firstIdx, size_t lastIdx);
     QList<HistMessage> getUndeliveredMessagesForFriend(const ToxPk& friendPk);
+    QList<QPair<RowId, QString>> getMessageTextsForFriend(const ToxPk& friendPk, RowId fromId,
+                                                          size_t maxNum, SearchDirection direction);
+    QPair<size_t, RowId> getNumMessagesAndLastIdForFriend(const ToxPk& friendPk);
     QDateTime getDateWhereFindPhrase(const ToxPk& friendPk, const QDateTime& from, QString phrase,
                                      const ParameterSearch& parameter);
     QList<DateIdx> getNumMessagesForFriendBeforeDateBoundaries(const ToxPk& friendPk,
@@ -203,6 +206,7 @@ signals:
 private slots:
     void onFileInsertionReady(FileDbInsertionData data);
     void onFileInserted(RowId dbId, QString fileId);
+    void flushDeliveredMessages();
 
 private:
     bool historyAccessBlocked();
@@ -222,4 +226,6 @@ private:
 
     // This needs to be a shared pointer to avoid callback lifetime issues
     QHash<QString, FileInfo> fileInfos;
+    // delivered messages that still need to be removed from faux_offline_pending
+    QVector<RowId> deliveredMessages;
 };
@@ -21,10 +21,13 @@
 
 #include <QStringList>
 
+class PeerBlackList;
+
 class IGroupSettings
 {
 public:
     virtual ~IGroupSettings() = default;
     virtual QStringList getBlackList() const = 0;
     virtual void setBlackList(const QStringList& blist) = 0;
+    virtual const PeerBlackList& getPeerBlackList() const = 0;
 };
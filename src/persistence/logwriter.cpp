@@ -0,0 +1,280 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "logwriter.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+/**
+ * @class LogWriter
+ * @brief Writes log messages to the console and the log file on a dedicated thread.
+ *
+ * Logging only appends the formatted message to a queue, so threads that log a lot, like
+ * the Core and audio threads, never wait for the disk. The writer thread takes all queued
+ * messages at once and writes them with a single call, the log file is flushed at most
+ * every flushIntervalMs and when stopping. Messages that would grow the queue beyond its
+ * size limit are dropped and reported by a note in the log.
+ *
+ * @var LogWriter::defaultMaxFileSize
+ * @brief Size after which the log file is moved to "<path>.1" and a new one is started.
+ */
+
+/**
+ * @param console Stream every message is written to as well, nullptr for none.
+ * @param waitForFile Keep messages written before setFile() was called, to write them to the file.
+ * @param maxQueuedBytes Maximum amount of messages waiting to be written.
+ */
+LogWriter::LogWriter(FILE* console, bool waitForFile, int maxQueuedBytes)
+    : console{console}
+    , maxQueuedBytes{maxQueuedBytes}
+    , waitForFile{waitForFile}
+{
+}
+
+LogWriter::~LogWriter()
+{
+    stop();
+}
+
+/**
+ * @brief Queues a formatted message, safe to call from any thread.
+ *
+ * After stop() the message is written to the console directly.
+ */
+void LogWriter::log(const QByteArray& line)
+{
+    QMutexLocker locker{&mutex};
+    if (stopping) {
+        locker.unlock();
+        if (console) {
+            fwrite(line.constData(), 1, static_cast<size_t>(line.size()), console);
+        }
+        return;
+    }
+
+    if (queuedBytes + line.size() > maxQueuedBytes) {
+        ++numDropped;
+        return;
+    }
+
+    // the writer only waits while the queue is empty
+    const bool wasEmpty = queue.isEmpty();
+    queue.append(line);
+    queuedBytes += line.size();
+    if (wasEmpty) {
+        workAvailable.wakeOne();
+    }
+}
+
+/**
+ * @brief Starts writing to a log file, rotating it when it grows beyond maxFileSize.
+ */
+void LogWriter::setFile(const QString& path, qint64 maxFileSize)
+{
+    QMutexLocker locker{&mutex};
+    pendingPath = path;
+    pendingMaxFileSize = maxFileSize;
+    workAvailable.wakeOne();
+}
+
+/**
+ * @brief Writes all queued messages, closes the log file and ends the writer thread.
+ */
+void LogWriter::stop()
+{
+    {
+        QMutexLocker locker{&mutex};
+        stopping = true;
+        workAvailable.wakeOne();
+    }
+
+    wait();
+}
+
+/**
+ * @brief Number of messages that were dropped because the queue was full.
+ */
+quint64 LogWriter::getNumDropped() const
+{
+    return numDropped;
+}
+
+void LogWriter::run()
+{
+    QElapsedTimer sinceFlush;
+    sinceFlush.start();
+
+    QMutexLocker locker{&mutex};
+    while (true) {
+        if (queue.isEmpty() && pendingPath.isNull() && !stopping) {
+            workAvailable.wait(&mutex, flushIntervalMs);
+        }
+
+        QList<QByteArray> lines;
+        lines.swap(queue);
+        const int batchSize = queuedBytes;
+        queuedBytes = 0;
+        const QString path = pendingPath;
+        pendingPath = QString{};
+        const qint64 newMaxFileSize = pendingMaxFileSize;
+        const bool stop = stopping;
+        locker.unlock();
+
+        if (!path.isNull()) {
+            filePath = path;
+            maxFileSize = newMaxFileSize;
+            openFile();
+        }
+
+        QByteArray batch;
+        const quint64 dropped = numDropped - reportedDropped;
+        if (dropped > 0) {
+            reportedDropped += dropped;
+            const QTime time = QDateTime::currentDateTimeUtc().time();
+            batch = QStringLiteral("[%1 UTC] Warning: Dropped %2 log messages\n")
+                        .arg(time.toString("HH:mm:ss.zzz"))
+                        .arg(dropped)
+                        .toUtf8();
+        }
+
+        batch.reserve(batch.size() + batchSize);
+        for (const QByteArray& line : lines) {
+            batch.append(line);
+        }
+        writeBatch(batch);
+
+        if (stop) {
+            closeFile();
+            return;
+        }
+
+        if (file && sinceFlush.elapsed() >= static_cast<qint64>(flushIntervalMs)) {
+            fflush(file);
+            sinceFlush.restart();
+        }
+
+        locker.relock();
+    }
+}
+
+/**
+ * @brief Opens filePath, writes the messages kept until then and rotates the file if needed.
+ */
+void LogWriter::openFile()
+{
+    closeFile();
+    file = fopen(filePath.toLocal8Bit().constData(), "a");
+    if (!file) {
+        qCritical() << "Couldn't open logfile" << filePath;
+        waitForFile = false;
+        unsaved.clear();
+        unsavedBytes = 0;
+        return;
+    }
+
+    fileSize = QFileInfo{filePath}.size();
+    if (fileSize > maxFileSize) {
+        rotateFile();
+    }
+
+    waitForFile = false;
+    for (const QByteArray& batch : unsaved) {
+        writeToFile(batch);
+    }
+    unsaved.clear();
+    unsavedBytes = 0;
+}
+
+void LogWriter::rotateFile()
+{
+    qDebug() << "Log file over" << maxFileSize << "bytes, rotating...";
+    closeFile();
+
+    const QString oldPath = filePath + QStringLiteral(".1");
+    if (QFile::exists(oldPath) && !QFile::remove(oldPath)) {
+        qWarning() << "Unable to remove old log file";
+    }
+
+    if (!QFile::rename(filePath, oldPath)) {
+        qCritical() << "Unable to move logs";
+    }
+
+    file = fopen(filePath.toLocal8Bit().constData(), "a");
+    if (!file) {
+        qCritical() << "Couldn't open logfile" << filePath;
+        return;
+    }
+
+    fileSize = QFileInfo{filePath}.size();
+}
+
+void LogWriter::writeBatch(const QByteArray& batch)
+{
+    if (batch.isEmpty()) {
+        return;
+    }
+
+    if (console) {
+        fwrite(batch.constData(), 1, static_cast<size_t>(batch.size()), console);
+    }
+
+    writeToFile(batch);
+}
+
+void LogWriter::writeToFile(const QByteArray& batch)
+{
+    if (file) {
+        fwrite(batch.constData(), 1, static_cast<size_t>(batch.size()), file);
+        fileSize += batch.size();
+        if (fileSize > maxFileSize) {
+            rotateFile();
+        }
+        return;
+    }
+
+    if (!waitForFile) {
+        return;
+    }
+
+    // keep the newest messages if the file takes too long to be set
+    unsaved.append(batch);
+    unsavedBytes += batch.size();
+    while (unsavedBytes > maxQueuedBytes) {
+        const QByteArray oldest = unsaved.takeFirst();
+        unsavedBytes -= oldest.size();
+        numDropped += static_cast<quint64>(oldest.count('\n'));
+    }
+}
+
+void LogWriter::closeFile()
+{
+    if (!file) {
+        return;
+    }
+
+    fflush(file);
+    fclose(file);
+    file = nullptr;
+}
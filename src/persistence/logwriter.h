@@ -0,0 +1,81 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <cstdio>
+
+class LogWriter : public QThread
+{
+public:
+    static constexpr int defaultMaxQueuedBytes = 4 * 1024 * 1024;
+    static constexpr qint64 defaultMaxFileSize = 1000000;
+    static constexpr unsigned long flushIntervalMs = 1000;
+
+    explicit LogWriter(FILE* console, bool waitForFile,
+                       int maxQueuedBytes = defaultMaxQueuedBytes);
+    ~LogWriter() override;
+
+    void log(const QByteArray& line);
+    void setFile(const QString& path, qint64 maxFileSize = defaultMaxFileSize);
+    void stop();
+    quint64 getNumDropped() const;
+
+protected:
+    void run() override;
+
+private:
+    void openFile();
+    void rotateFile();
+    void writeBatch(const QByteArray& batch);
+    void writeToFile(const QByteArray& batch);
+    void closeFile();
+
+private:
+    FILE* const console;
+    const int maxQueuedBytes;
+
+    mutable QMutex mutex;
+    QWaitCondition workAvailable;
+    QList<QByteArray> queue;
+    int queuedBytes = 0;
+    QString pendingPath;
+    qint64 pendingMaxFileSize = defaultMaxFileSize;
+    bool stopping = false;
+    std::atomic<quint64> numDropped{0};
+
+    // only accessed by the writer thread
+    QString filePath;
+    qint64 maxFileSize = defaultMaxFileSize;
+    FILE* file = nullptr;
+    qint64 fileSize = 0;
+    bool waitForFile;
+    QList<QByteArray> unsaved;
+    int unsavedBytes = 0;
+    quint64 reportedDropped = 0;
+};
@@ -29,8 +29,14 @@
 #include <QCoreApplication>
 #include <chrono>
 
-OfflineMsgEngine::OfflineMsgEngine()
-    : mutex(QMutex::Recursive)
+constexpr std::chrono::minutes OfflineMsgEngine::defaultMaxReceiptAge;
+
+/**
+* @param maxReceiptAge How long to keep a receipt that arrived before its message was added.
+*/
+OfflineMsgEngine::OfflineMsgEngine(std::chrono::milliseconds maxReceiptAge)
+    : receiptResolver(maxReceiptAge)
+    , extendedReceiptResolver(maxReceiptAge)
 {}
 
 /**
@@ -40,14 +46,12 @@ OfflineMsgEngine::OfflineMsgEngine()
 */
 void OfflineMsgEngine::onReceiptReceived(ReceiptNum receipt)
 {
-    QMutexLocker ml(&mutex);
-    receiptResolver.notifyReceiptReceived(receipt);
+    receiptResolver.notifyReceiptReceived(receipt, Clock::now());
 }
 
 void OfflineMsgEngine::onExtendedReceiptReceived(ExtendedReceiptNum receipt)
 {
-    QMutexLocker ml(&mutex);
-    extendedReceiptResolver.notifyReceiptReceived(receipt);
+    extendedReceiptResolver.notifyReceiptReceived(receipt, Clock::now());
 }
 
 /**
@@ -78,15 +82,13 @@ void OfflineMsgEngine::addUnsentMessage(Message const& message, CompletionFn com
 void OfflineMsgEngine::addSentCoreMessage(ReceiptNum receipt, Message const& message,
                                       CompletionFn completionCallback)
 {
-    QMutexLocker ml(&mutex);
-    receiptResolver.notifyMessageSent(receipt, {message, std::chrono::steady_clock::now(), completionCallback});
+    receiptResolver.notifyMessageSent(receipt, {message, Clock::now(), completionCallback});
 }
 
 void OfflineMsgEngine::addSentExtendedMessage(ExtendedReceiptNum receipt, Message const& message,
                                       CompletionFn completionCallback)
 {
-    QMutexLocker ml(&mutex);
-    extendedReceiptResolver.notifyMessageSent(receipt, {message, std::chrono::steady_clock::now(), completionCallback});
+    extendedReceiptResolver.notifyMessageSent(receipt, {message, Clock::now(), completionCallback});
 }
 
 /**
@@ -94,7 +96,6 @@ void OfflineMsgEngine::addSentExtendedMessage(ExtendedReceiptNum receipt, Messag
 */
 std::vector<OfflineMsgEngine::RemovedMessage> OfflineMsgEngine::removeAllMessages()
 {
-    QMutexLocker ml(&mutex);
     auto messages = receiptResolver.clear();
     auto extendedMessages = extendedReceiptResolver.clear();
 
@@ -103,14 +104,17 @@ std::vector<OfflineMsgEngine::RemovedMessage> OfflineMsgEngine::removeAllMessage
         std::make_move_iterator(extendedMessages.begin()),
         std::make_move_iterator(extendedMessages.end()));
 
-    messages.insert(
-        messages.end(),
-        std::make_move_iterator(unsentMessages.begin()),
-        std::make_move_iterator(unsentMessages.end()));
+    {
+        QMutexLocker ml(&mutex);
+        messages.insert(
+            messages.end(),
+            std::make_move_iterator(unsentMessages.begin()),
+            std::make_move_iterator(unsentMessages.end()));
 
-    unsentMessages.clear();
+        unsentMessages.clear();
+    }
 
-    std::sort(messages.begin(), messages.end(), [] (const OfflineMessage& a, const OfflineMessage& b) {
+    std::stable_sort(messages.begin(), messages.end(), [] (const OfflineMessage& a, const OfflineMessage& b) {
         return a.authorshipTime < b.authorshipTime;
     });
 
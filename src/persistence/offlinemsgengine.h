@@ -24,11 +24,12 @@
 #include "src/model/message.h"
 #include "src/persistence/db/rawdatabase.h"
 #include <QDateTime>
-#include <QMap>
+#include <QHash>
 #include <QMutex>
 #include <QObject>
-#include <QSet>
+#include <algorithm>
 #include <chrono>
+#include <deque>
 
 
 class OfflineMsgEngine : public QObject
@@ -36,7 +37,9 @@ class OfflineMsgEngine : public QObject
     Q_OBJECT
 public:
     using CompletionFn = std::function<void(bool)>;
-    OfflineMsgEngine();
+    static constexpr std::chrono::minutes defaultMaxReceiptAge{5};
+
+    explicit OfflineMsgEngine(std::chrono::milliseconds maxReceiptAge = defaultMaxReceiptAge);
     void addUnsentMessage(Message const& message, CompletionFn completionCallback);
     void addSentCoreMessage(ReceiptNum receipt, Message const& message, CompletionFn completionCallback);
     void addSentExtendedMessage(ExtendedReceiptNum receipt, Message const& message, CompletionFn completionCallback);
@@ -60,58 +63,100 @@ private:
         CompletionFn completionFn;
     };
 
-    QMutex mutex;
+    using Clock = std::chrono::steady_clock;
 
+    /**
+     * @brief Matches sent messages with their receipts, in whichever order they arrive.
+     *
+     * Receipts without a message are kept for maxReceiptAge, receipts of messages that were
+     * removed with clear() would otherwise pile up. Completion callbacks are run without
+     * holding the lock.
+     */
     template <class ReceiptT>
     class ReceiptResolver
     {
     public:
+        explicit ReceiptResolver(std::chrono::milliseconds maxReceiptAge)
+            : maxReceiptAge{maxReceiptAge}
+        {}
+
         void notifyMessageSent(ReceiptT receipt, OfflineMessage const& message)
         {
-            auto receivedReceiptIt = std::find(
-                    receivedReceipts.begin(), receivedReceipts.end(), receipt);
-
-            if (receivedReceiptIt != receivedReceipts.end()) {
-                receivedReceipts.erase(receivedReceiptIt);
-                message.completionFn(true);
-                return;
+            {
+                QMutexLocker ml{&mutex};
+                if (!receivedReceipts.remove(receipt)) {
+                    unAckedMessages.insert(receipt, message);
+                    return;
+                }
             }
 
-            unAckedMessages[receipt] = message;
+            message.completionFn(true);
         }
 
-        void notifyReceiptReceived(ReceiptT receipt)
+        void notifyReceiptReceived(ReceiptT receipt, Clock::time_point now)
         {
-            auto unackedMessageIt = unAckedMessages.find(receipt);
-            if (unackedMessageIt != unAckedMessages.end()) {
-                unackedMessageIt->second.completionFn(true);
+            CompletionFn completionFn;
+            {
+                QMutexLocker ml{&mutex};
+                const auto unackedMessageIt = unAckedMessages.find(receipt);
+                if (unackedMessageIt == unAckedMessages.end()) {
+                    evictReceipts(now);
+                    receivedReceipts.insert(receipt, now);
+                    receiptQueue.emplace_back(receipt, now);
+                    return;
+                }
+
+                completionFn = std::move(unackedMessageIt->completionFn);
                 unAckedMessages.erase(unackedMessageIt);
-                return;
             }
 
-            receivedReceipts.push_back(receipt);
+            completionFn(true);
         }
 
         std::vector<OfflineMessage> clear()
         {
+            QMutexLocker ml{&mutex};
+            // in the order they were sent, for messages with the same authorship time
+            auto receipts = unAckedMessages.keys();
+            std::sort(receipts.begin(), receipts.end());
+
             auto ret = std::vector<OfflineMessage>();
-            std::transform(
-                std::make_move_iterator(unAckedMessages.begin()), std::make_move_iterator(unAckedMessages.end()),
-                std::back_inserter(ret),
-                [] (const std::pair<ReceiptT, OfflineMessage>& pair) {
-                    return std::move(pair.second);
-                });
+            ret.reserve(static_cast<size_t>(receipts.size()));
+            for (const auto& receipt : receipts) {
+                ret.push_back(unAckedMessages.value(receipt));
+            }
 
             receivedReceipts.clear();
+            receiptQueue.clear();
             unAckedMessages.clear();
             return ret;
         }
 
-        std::vector<ReceiptT> receivedReceipts;
-        std::map<ReceiptT, OfflineMessage> unAckedMessages;
+    private:
+        void evictReceipts(Clock::time_point now)
+        {
+            while (!receiptQueue.empty() && now - receiptQueue.front().second > maxReceiptAge) {
+                const auto& oldest = receiptQueue.front();
+                // the receipt may have been matched or received again since
+                const auto receivedIt = receivedReceipts.find(oldest.first);
+                if (receivedIt != receivedReceipts.end() && *receivedIt == oldest.second) {
+                    receivedReceipts.erase(receivedIt);
+                }
+                receiptQueue.pop_front();
+            }
+        }
+
+        QMutex mutex;
+        const std::chrono::milliseconds maxReceiptAge;
+        QHash<ReceiptT, Clock::time_point> receivedReceipts;
+        // receipts in the order they were received, to find the ones to evict
+        std::deque<std::pair<ReceiptT, Clock::time_point>> receiptQueue;
+        QHash<ReceiptT, OfflineMessage> unAckedMessages;
     };
 
     ReceiptResolver<ReceiptNum> receiptResolver;
     ReceiptResolver<ExtendedReceiptNum> extendedReceiptResolver;
+    // protects unsentMessages, the resolvers have their own locks
+    QMutex mutex;
     std::vector<OfflineMessage> unsentMessages;
 };
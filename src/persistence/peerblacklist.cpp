@@ -0,0 +1,97 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "peerblacklist.h"
+
+#include <tox/tox.h>
+
+#include <atomic>
+
+/**
+ * @class PeerBlackList
+ * @brief Blocked peers as a set of public keys that can be read without taking a lock.
+ *
+ * The set is replaced as a whole on every change and tagged with a new version, so readers
+ * on hot paths only need to load the version to know whether their copy is still current.
+ *
+ * @class PeerBlackList::Reader
+ * @brief Keeps a copy of the blocked peers for one thread and refreshes it when outdated.
+ * @note A reader must only be used from one thread at a time.
+ */
+
+PeerBlackList::Reader::Reader(const PeerBlackList& blackList)
+    : blackList{blackList}
+    // load the version first, a list published in between is only fetched again
+    , version{blackList.version.loadAcquire()}
+    , peers{blackList.getPeers()}
+{
+}
+
+/**
+ * @brief Checks if a peer is blocked.
+ *
+ * In the common case this loads an atomic integer and does one hash lookup.
+ */
+bool PeerBlackList::Reader::contains(const ToxPk& peerPk)
+{
+    const int current = blackList.version.loadAcquire();
+    if (current != version) {
+        version = current;
+        peers = blackList.getPeers();
+    }
+
+    return peers->contains(peerPk);
+}
+
+PeerBlackList::PeerBlackList()
+    : peers{std::make_shared<const Peers>()}
+{
+}
+
+/**
+ * @brief Replaces the blocked peers, entries that aren't a public key are ignored.
+ * @param blackList Public keys as shown by ToxPk::toString.
+ */
+void PeerBlackList::publish(const QStringList& blackList)
+{
+    auto next = std::make_shared<Peers>();
+    for (const QString& entry : blackList) {
+        const QByteArray rawId = QByteArray::fromHex(entry.toLatin1());
+        if (rawId.length() != TOX_PUBLIC_KEY_SIZE) {
+            continue;
+        }
+
+        const ToxPk peerPk{rawId};
+        // keep matching entries exactly, like comparing to ToxPk::toString did
+        if (peerPk.toString() == entry) {
+            next->insert(peerPk);
+        }
+    }
+
+    std::atomic_store(&peers, std::shared_ptr<const Peers>{std::move(next)});
+    version.fetchAndAddRelease(1);
+}
+
+/**
+ * @brief Returns the current set of blocked peers, safe to call from any thread.
+ */
+std::shared_ptr<const PeerBlackList::Peers> PeerBlackList::getPeers() const
+{
+    return std::atomic_load(&peers);
+}
@@ -0,0 +1,54 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "src/core/toxpk.h"
+
+#include <QAtomicInt>
+#include <QSet>
+#include <QStringList>
+
+#include <memory>
+
+class PeerBlackList
+{
+public:
+    using Peers = QSet<ToxPk>;
+
+    class Reader
+    {
+    public:
+        explicit Reader(const PeerBlackList& blackList);
+        bool contains(const ToxPk& peerPk);
+
+    private:
+        const PeerBlackList& blackList;
+        int version;
+        std::shared_ptr<const Peers> peers;
+    };
+
+    PeerBlackList();
+    void publish(const QStringList& blackList);
+    std::shared_ptr<const Peers> getPeers() const;
+
+private:
+    QAtomicInt version{0};
+    std::shared_ptr<const Peers> peers;
+};
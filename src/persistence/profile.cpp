@@ -20,13 +20,18 @@
 #include <QBuffer>
 #include <QDebug>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFileInfo>
+#include <QFutureWatcher>
 #include <QObject>
 #include <QSaveFile>
 #include <QThread>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtEndian>
 
 #include <cassert>
 #include <sodium.h>
+#include <tox/tox.h>
 
 #include "profile.h"
 #include "profilelocker.h"
@@ -37,6 +42,8 @@
 #include "src/net/avatarbroadcaster.h"
 #include "src/net/bootstrapnodeupdater.h"
 #include "src/nexus.h"
+#include "src/persistence/db/rawdatabase.h"
+#include "src/persistence/thumbnailcache.h"
 #include "src/widget/gui.h"
 #include "src/widget/tool/identicon.h"
 #include "src/widget/widget.h"
@@ -162,6 +169,79 @@ std::unique_ptr<ToxEncrypt> createToxData(const QString& name, const QString& pa
     return newKey;
 }
 
+/**
+ * The tox save of a profile, decrypted on the thread pool.
+ */
+struct UnlockedSave
+{
+    // owned by whoever takes the result, QFuture needs a copyable type
+    ToxEncrypt* passkey = nullptr;
+    QByteArray toxsave;
+    LoadToxDataError error = LoadToxDataError::OK;
+    qint64 elapsedMs = 0;
+};
+
+/**
+ * Derives the key of a tox save and decrypts it, safe to run on any thread.
+ * @param password The password to use to unlock the tox file.
+ * @param filePath The path to the tox save file.
+ * @return The decrypted save, its key and the time it took.
+ */
+UnlockedSave unlockToxSave(const QString& password, const QString& filePath)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    UnlockedSave save;
+    save.passkey = loadToxData(password, filePath, save.toxsave, save.error).release();
+    save.elapsedMs = timer.elapsed();
+    return save;
+}
+
+/**
+ * Reads our public key from a decrypted tox save without starting toxcore.
+ * @param toxsave Plaintext tox save data.
+ * @return The public key, or an empty QByteArray if the save couldn't be parsed.
+ *
+ * The save is a list of sections, see toxcore/state.c; all fields are little endian.
+ */
+QByteArray getSavePublicKey(const QByteArray& toxsave)
+{
+    constexpr quint32 globalCookie = 0x15ed1b1f;
+    constexpr quint32 sectionCookie = 0x01ce;
+    constexpr quint32 nospamKeysType = 1;
+    constexpr int nospamSize = 4;
+
+    const auto readUint32 = [&toxsave](int pos) {
+        return qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(toxsave.constData() + pos));
+    };
+
+    if (toxsave.size() < 8 || readUint32(0) != 0 || readUint32(4) != globalCookie) {
+        return {};
+    }
+
+    int pos = 8;
+    while (pos + 8 <= toxsave.size()) {
+        const quint32 length = readUint32(pos);
+        const quint32 type = readUint32(pos + 4);
+        pos += 8;
+        if ((type >> 16) != sectionCookie || length > static_cast<quint32>(toxsave.size() - pos)) {
+            return {};
+        }
+
+        if ((type & 0xffff) == nospamKeysType) {
+            if (length < nospamSize + TOX_PUBLIC_KEY_SIZE) {
+                return {};
+            }
+            return toxsave.mid(pos + nospamSize, TOX_PUBLIC_KEY_SIZE);
+        }
+
+        pos += static_cast<int>(length);
+    }
+
+    return {};
+}
+
 bool logLoadToxDataError(const LoadToxDataError& error, const QString& path)
 {
     switch (error) {
@@ -300,7 +380,9 @@ Profile::Profile(const QString& name, std::unique_ptr<ToxEncrypt> passkey, Paths
     , encrypted{this->passkey != nullptr}
     , paths{paths_}
     , settings{settings_}
-{}
+{
+    updateThumbnailCache();
+}
 
 /**
  * @brief Locks and loads an existing profile and creates the associate Core* instance.
@@ -309,37 +391,135 @@ Profile::Profile(const QString& name, std::unique_ptr<ToxEncrypt> passkey, Paths
  * @return Returns a nullptr on error. Profile pointer otherwise.
  *
  * @note If the profile is already in use return nullptr.
+ * @note Derives the keys on the calling thread, use loadProfileAsync() for encrypted profiles.
  */
 Profile* Profile::loadProfile(const QString& name, const QString& password, Settings& settings,
                               const QCommandLineParser* parser)
+{
+    if (!lockProfile(name)) {
+        return nullptr;
+    }
+
+    const QString path = settings.getPaths().getSettingsDirPath() + name + ".tox";
+    UnlockedSave save = unlockToxSave(password, path);
+    std::unique_ptr<ToxEncrypt> passkey{save.passkey};
+    if (logLoadToxDataError(save.error, path)) {
+        ProfileLocker::unlock();
+        return nullptr;
+    }
+
+    Profile* p = openUnlocked(name, std::move(passkey), save.toxsave, save.elapsedMs, settings, parser);
+    p->loadDatabase(password);
+    return p;
+}
+
+/**
+ * @brief Like loadProfile(), but derives the keys on the thread pool and returns at once.
+ * @param name Profile name.
+ * @param password Profile password.
+ * @param receiver The callback is dropped if the receiver is destroyed first.
+ * @param onLoaded Called on the thread of the receiver with the profile, nullptr on error.
+ *
+ * The profile is only handed out once it is completely loaded, the event loop keeps running in
+ * between and can't see it half initialized.
+ */
+void Profile::loadProfileAsync(const QString& name, const QString& password, Settings& settings,
+                               const QCommandLineParser* parser, QObject* receiver,
+                               LoadCallback onLoaded)
+{
+    if (!lockProfile(name)) {
+        onLoaded(nullptr);
+        return;
+    }
+
+    const QString path = settings.getPaths().getSettingsDirPath() + name + ".tox";
+    auto saveWatcher = new QFutureWatcher<UnlockedSave>(receiver);
+    QObject::connect(saveWatcher, &QFutureWatcher<UnlockedSave>::finished, receiver, [=, &settings]() {
+        saveWatcher->deleteLater();
+        UnlockedSave save = saveWatcher->result();
+        std::unique_ptr<ToxEncrypt> passkey{save.passkey};
+        if (logLoadToxDataError(save.error, path)) {
+            ProfileLocker::unlock();
+            onLoaded(nullptr);
+            return;
+        }
+
+        // The chat history key is salted with our public key, derive it while Core is starting
+        const QByteArray dbSalt = password.isEmpty() ? QByteArray() : getSavePublicKey(save.toxsave);
+        if (dbSalt.isEmpty()) {
+            Profile* p =
+                openUnlocked(name, std::move(passkey), save.toxsave, save.elapsedMs, settings, parser);
+            p->loadDatabase(password);
+            onLoaded(p);
+            return;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        const QFuture<QString> dbKey = QtConcurrent::run([password, dbSalt]() {
+            return RawDatabase::deriveKey(password, dbSalt);
+        });
+
+        Profile* p =
+            openUnlocked(name, std::move(passkey), save.toxsave, save.elapsedMs, settings, parser);
+
+        auto keyWatcher = new QFutureWatcher<QString>(receiver);
+        QObject::connect(keyWatcher, &QFutureWatcher<QString>::finished, receiver, [=]() {
+            keyWatcher->deleteLater();
+            p->loadDatabase(password, dbSalt, keyWatcher->result());
+            qDebug() << "Profile database opened" << timer.elapsed() << "ms after the tox save";
+            onLoaded(p);
+        });
+        keyWatcher->setFuture(dbKey);
+    });
+    saveWatcher->setFuture(QtConcurrent::run(&unlockToxSave, password, path));
+}
+
+/**
+ * @brief Takes the lock of a profile before loading it.
+ * @param name Profile name.
+ * @return False if this or another profile is already locked.
+ */
+bool Profile::lockProfile(const QString& name)
 {
     if (ProfileLocker::hasLock()) {
         qCritical() << "Tried to load profile " << name << ", but another profile is already locked!";
-        return nullptr;
+        return false;
     }
 
     if (!ProfileLocker::lock(name)) {
         qWarning() << "Failed to lock profile " << name;
-        return nullptr;
+        return false;
     }
 
-    LoadToxDataError error;
-    QByteArray toxsave = QByteArray();
-    Paths& paths = settings.getPaths();
-    QString path = paths.getSettingsDirPath() + name + ".tox";
-    std::unique_ptr<ToxEncrypt> tmpKey = loadToxData(password, path, toxsave, error);
-    if (logLoadToxDataError(error, path)) {
-        ProfileLocker::unlock();
-        return nullptr;
-    }
+    return true;
+}
 
-    Profile* p = new Profile(name, std::move(tmpKey), paths, settings);
+/**
+ * @brief Creates the profile and its Core from a decrypted tox save, without the database.
+ * @param name Profile name.
+ * @param passkey Key the tox save was encrypted with, if any.
+ * @param toxsave Decrypted tox save.
+ * @param toxSaveMs Time it took to decrypt the tox save, for the timing log.
+ */
+Profile* Profile::openUnlocked(const QString& name, std::unique_ptr<ToxEncrypt> passkey,
+                               const QByteArray& toxsave, qint64 toxSaveMs, Settings& settings,
+                               const QCommandLineParser* parser)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    Profile* p = new Profile(name, std::move(passkey), settings.getPaths(), settings);
 
     // Core settings are saved per profile, need to load them before starting Core
     settings.updateProfileData(p, parser);
+    const qint64 settingsTime = timer.restart();
 
     p->initCore(toxsave, settings, /*isNewProfile*/ false);
-    p->loadDatabase(password);
+    const qint64 coreTime = timer.elapsed();
+
+    qDebug() << "Profile unlock timings: tox save" << toxSaveMs << "ms, settings" << settingsTime
+             << "ms, core" << coreTime << "ms";
 
     return p;
 }
@@ -521,6 +701,30 @@ bool Profile::saveToxSave(QByteArray data)
     return true;
 }
 
+/**
+ * @brief Directory the file transfer icons of this profile are stored in.
+ */
+QString Profile::thumbnailDir() const
+{
+    return paths.getSettingsDirPath() + "thumbnails" + QDir::separator() + name;
+}
+
+/**
+ * @brief Lets the thumbnail cache store icons on disk, unless the profile is encrypted.
+ *
+ * Icons show the content of received files, so for encrypted profiles they are only kept in
+ * memory, and icons stored before the profile was encrypted are removed.
+ */
+void Profile::updateThumbnailCache()
+{
+    if (encrypted) {
+        ThumbnailCache::getInstance().setCacheDir({});
+        QDir{thumbnailDir()}.removeRecursively();
+    } else {
+        ThumbnailCache::getInstance().setCacheDir(thumbnailDir());
+    }
+}
+
 /**
  * @brief Gets the path of the avatar file cached by this profile and corresponding to this owner
  * ID.
@@ -614,7 +818,13 @@ QByteArray Profile::loadAvatarData(const ToxPk& owner)
     return pic;
 }
 
-void Profile::loadDatabase(QString password)
+/**
+ * @brief Opens the chat history database.
+ * @param password Profile password.
+ * @param keySalt Salt the database key was derived with in advance, if any.
+ * @param hexKey Database key derived in advance with keySalt.
+ */
+void Profile::loadDatabase(QString password, const QByteArray& keySalt, const QString& hexKey)
 {
     assert(core);
 
@@ -629,10 +839,18 @@ void Profile::loadDatabase(QString password)
         GUI::showError(QObject::tr("Error"),
                        QObject::tr("qTox couldn't open your chat logs, they will be disabled."));
     }
+
+    QString key;
+    if (!keySalt.isEmpty() && keySalt == salt) {
+        key = hexKey;
+    } else {
+        key = RawDatabase::deriveKey(password, salt);
+    }
+
     // At this point it's too early to load the personal settings (Nexus will do it), so we always
     // load
     // the history, and if it fails we can't change the setting now, but we keep a nullptr
-    database = std::make_shared<RawDatabase>(getDbPath(name), password, salt);
+    database = std::make_shared<RawDatabase>(getDbPath(name), password, salt, key);
     if (database && database->isOpen()) {
         history.reset(new History(database));
     } else {
@@ -886,6 +1104,9 @@ QStringList Profile::remove()
     history.reset();
     database.reset();
 
+    ThumbnailCache::getInstance().setCacheDir({});
+    QDir{thumbnailDir()}.removeRecursively();
+
     return ret;
 }
 
@@ -909,6 +1130,11 @@ bool Profile::rename(QString newName)
         database->rename(newName);
     }
 
+    const QString oldThumbnailDir = thumbnailDir();
+    name = newName;
+    QDir{}.rename(oldThumbnailDir, thumbnailDir());
+    updateThumbnailCache();
+
     bool resetAutorun = settings.getAutorun();
     settings.setAutorun(false);
     settings.setCurrentProfile(newName);
@@ -916,7 +1142,6 @@ bool Profile::rename(QString newName)
         settings.setAutorun(true); // fixes -p flag in autostart command line
     }
 
-    name = newName;
     return true;
 }
 
@@ -952,6 +1177,7 @@ QString Profile::setPassword(const QString& newPassword)
 
     // apply new encryption
     onSaveToxSave();
+    updateThumbnailCache();
 
     bool dbSuccess = false;
 
@@ -34,6 +34,7 @@
 #include <QPixmap>
 #include <QString>
 #include <QVector>
+#include <functional>
 #include <memory>
 
 class Settings;
@@ -44,8 +45,13 @@ class Profile : public QObject
     Q_OBJECT
 
 public:
+    using LoadCallback = std::function<void(Profile* profile)>;
+
     static Profile* loadProfile(const QString& name, const QString& password, Settings& settings,
                                 const QCommandLineParser* parser);
+    static void loadProfileAsync(const QString& name, const QString& password, Settings& settings,
+                                 const QCommandLineParser* parser, QObject* receiver,
+                                 LoadCallback onLoaded);
     static Profile* createProfile(const QString& name, const QString& password, Settings& settings,
                                   const QCommandLineParser* parser);
     ~Profile();
@@ -96,7 +102,6 @@ public slots:
     void onRequestSent(const ToxPk& friendPk, const QString& message);
 
 private slots:
-    void loadDatabase(QString password);
     void saveAvatar(const ToxPk& owner, const QByteArray& avatar);
     void removeAvatar(const ToxPk& owner);
     void onSaveToxSave();
@@ -105,10 +110,18 @@ private slots:
 
 private:
     Profile(const QString& name, std::unique_ptr<ToxEncrypt> passkey, Paths& paths, Settings &settings_);
+    static bool lockProfile(const QString& name);
+    static Profile* openUnlocked(const QString& name, std::unique_ptr<ToxEncrypt> passkey,
+                                 const QByteArray& toxsave, qint64 toxSaveMs, Settings& settings,
+                                 const QCommandLineParser* parser);
     static QStringList getFilesByExt(QString extension);
     QString avatarPath(const ToxPk& owner, bool forceUnencrypted = false);
+    QString thumbnailDir() const;
+    void updateThumbnailCache();
     bool saveToxSave(QByteArray data);
     void initCore(const QByteArray& toxsave, Settings &s, bool isNewProfile);
+    void loadDatabase(QString password, const QByteArray& keySalt = {},
+                      const QString& hexKey = {});
 
 private:
     std::unique_ptr<AvatarBroadcaster> avatarBroadcaster;
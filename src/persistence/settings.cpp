@@ -254,6 +254,7 @@ void Settings::loadGlobal()
         screenRegion = s.value("screenRegion", QRect()).toRect();
         screenGrabbed = s.value("screenGrabbed", false).toBool();
         camVideoFPS = static_cast<quint16>(s.value("camVideoFPS", 0).toUInt());
+        camDecodeThreads = s.value("camDecodeThreads", 0).toInt();
     }
     s.endGroup();
 
@@ -496,6 +497,7 @@ void Settings::loadPersonal(QString profileName, const ToxEncrypt* passKey)
         typingNotification = ps.value("typingNotification", true).toBool();
         enableLogging = ps.value("enableLogging", true).toBool();
         blackList = ps.value("blackList").toString().split('\n');
+        peerBlackList.publish(blackList);
     }
     ps.endGroup();
 
@@ -719,6 +721,7 @@ void Settings::saveGlobal()
         s.setValue("videoDev", videoDev);
         s.setValue("camVideoRes", camVideoRes);
         s.setValue("camVideoFPS", camVideoFPS);
+        s.setValue("camDecodeThreads", camDecodeThreads);
         s.setValue("screenRegion", screenRegion);
         s.setValue("screenGrabbed", screenGrabbed);
     }
@@ -1687,10 +1690,19 @@ QStringList Settings::getBlackList() const
 void Settings::setBlackList(const QStringList& blist)
 {
     if (setVal(blackList, blist)) {
+        peerBlackList.publish(blist);
         emit blackListChanged(blist);
     }
 }
 
+/**
+ * @brief Blocked peers for lookups that happen too often to copy the black list each time.
+ */
+const PeerBlackList& Settings::getPeerBlackList() const
+{
+    return peerBlackList;
+}
+
 QString Settings::getInDev() const
 {
     QMutexLocker locker{&bigLock};
@@ -1860,6 +1872,22 @@ void Settings::setCamVideoFPS(float newValue)
     }
 }
 
+/**
+ * @brief Number of threads used to decode camera frames, 0 to choose automatically.
+ */
+int Settings::getCamDecodeThreads() const
+{
+    QMutexLocker locker{&bigLock};
+    return camDecodeThreads;
+}
+
+void Settings::setCamDecodeThreads(int newValue)
+{
+    if (setVal(camDecodeThreads, newValue)) {
+        emit camDecodeThreadsChanged(newValue);
+    }
+}
+
 QString Settings::getFriendAddress(const QString& publicKey) const
 {
     QMutexLocker locker{&bigLock};
@@ -25,9 +25,11 @@
 #include "src/core/toxencrypt.h"
 #include "src/core/toxfile.h"
 #include "src/persistence/paths.h"
+#include "src/persistence/icirclesettings.h"
 #include "src/persistence/ifriendsettings.h"
 #include "src/persistence/igroupsettings.h"
 #include "src/persistence/inotificationsettings.h"
+#include "src/persistence/peerblacklist.h"
 #include "src/video/ivideosettings.h"
 
 #include <QDateTime>
@@ -49,6 +51,7 @@ enum class syncType;
 class Settings : public QObject,
                  public ICoreSettings,
                  public IFriendSettings,
+                 public ICircleSettings,
                  public IGroupSettings,
                  public IAudioSettings,
                  public IVideoSettings,
@@ -127,6 +130,8 @@ class Settings : public QObject,
     Q_PROPERTY(QRect screenRegion READ getScreenRegion WRITE setScreenRegion NOTIFY screenRegionChanged FINAL)
     Q_PROPERTY(bool screenGrabbed READ getScreenGrabbed WRITE setScreenGrabbed NOTIFY screenGrabbedChanged FINAL)
     Q_PROPERTY(float camVideoFPS READ getCamVideoFPS WRITE setCamVideoFPS NOTIFY camVideoFPSChanged FINAL)
+    Q_PROPERTY(int camDecodeThreads READ getCamDecodeThreads WRITE setCamDecodeThreads NOTIFY
+                   camDecodeThreadsChanged FINAL)
 
 public:
     enum class StyleType
@@ -232,6 +237,9 @@ signals:
     void dbSyncTypeChanged(Db::syncType type);
     void blackListChanged(QStringList const& blist);
 
+    // Video
+    void camDecodeThreadsChanged(int threads);
+
 public:
     bool applyCommandLineOptions(const QCommandLineParser& parser);
     static bool verifyProxySettings(const QCommandLineParser& parser);
@@ -396,6 +404,9 @@ public:
     float getCamVideoFPS() const override;
     void setCamVideoFPS(float newValue) override;
 
+    int getCamDecodeThreads() const;
+    void setCamDecodeThreads(int newValue);
+
     SIGNAL_IMPL(Settings, videoDevChanged, const QString& device)
     SIGNAL_IMPL(Settings, screenRegionChanged, const QRect& region)
     SIGNAL_IMPL(Settings, screenGrabbedChanged, bool enabled)
@@ -462,6 +473,7 @@ public:
     void setTypingNotification(bool enabled);
     QStringList getBlackList() const override;
     void setBlackList(const QStringList& blist) override;
+    const PeerBlackList& getPeerBlackList() const override;
 
     // State
     QByteArray getWindowGeometry() const;
@@ -525,13 +537,13 @@ public:
     void setEnableGroupChatsColor(bool state);
     bool getEnableGroupChatsColor() const;
 
-    int getCircleCount() const;
-    int addCircle(const QString& name = QString());
-    int removeCircle(int id);
-    QString getCircleName(int id) const;
-    void setCircleName(int id, const QString& name);
-    bool getCircleExpanded(int id) const;
-    void setCircleExpanded(int id, bool expanded);
+    int getCircleCount() const override;
+    int addCircle(const QString& name = QString()) override;
+    int removeCircle(int id) override;
+    QString getCircleName(int id) const override;
+    void setCircleName(int id, const QString& name) override;
+    bool getCircleExpanded(int id) const override;
+    void setCircleExpanded(int id, bool expanded) override;
 
     bool addFriendRequest(const QString& friendAddress, const QString& message);
     unsigned int getUnreadFriendRequests() const;
@@ -659,6 +671,7 @@ private:
     bool typingNotification;
     Db::syncType dbSyncType;
     QStringList blackList;
+    PeerBlackList peerBlackList;
 
     // Audio
     QString inDev;
@@ -677,6 +690,7 @@ private:
     QRect screenRegion;
     bool screenGrabbed;
     float camVideoFPS;
+    int camDecodeThreads;
 
     struct friendProp
     {
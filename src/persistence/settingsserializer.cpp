@@ -38,6 +38,13 @@
  * The file is only written to disk if save() is called, the destructor does not save to disk
  * All member functions are reentrant, but not thread safe.
  *
+ * Files are saved in an indexed format: the "QTXI" magic is followed by a vuint format version,
+ * a vuint section count, and for each group a QString name (empty for the root group), a vuint
+ * payload offset and a vuint payload length. The payload holds one RecordTag stream per group,
+ * without GroupStart records. Unencrypted files are memory-mapped while they are parsed instead
+ * of being read into memory.
+ * Files in the legacy "QTOX" stream format and plain .ini files are still read.
+ *
  * @enum SettingsSerializer::RecordTag
  * @var Value
  * Followed by a QString key then a QVariant value
@@ -60,6 +67,18 @@ enum class RecordTag : uint8_t
  */
 const char SettingsSerializer::magic[] = {0x51, 0x54, 0x4F, 0x58};
 
+/**
+ * @var static const char indexedMagic[];
+ * @brief Little endian ASCII "QTXI" magic of the indexed format
+ */
+const char SettingsSerializer::indexedMagic[] = {0x51, 0x54, 0x58, 0x49};
+
+uint qHash(const SettingsSerializer::ValueKey& k, uint seed)
+{
+    return qHash(k.key, seed) ^ qHash(k.group, seed) ^ qHash(static_cast<uint>(k.array) << 20, seed)
+           ^ qHash(k.arrayIndex, seed);
+}
+
 QDataStream& writeStream(QDataStream& dataStream, const SettingsSerializer::RecordTag& tag)
 {
     return dataStream << static_cast<uint8_t>(tag);
@@ -181,6 +200,7 @@ void SettingsSerializer::setValue(const QString& key, const QVariant& value)
         Value nv{group, array, arrayIndex, key, value};
         if (array >= 0)
             arrays[array].values.append(values.size());
+        valueIndex.insert(makeKey(key), values.size());
         values.append(nv);
     }
 }
@@ -196,23 +216,11 @@ QVariant SettingsSerializer::value(const QString& key, const QVariant& defaultVa
 
 const SettingsSerializer::Value* SettingsSerializer::findValue(const QString& key) const
 {
-    if (array != -1) {
-        for (const Array& a : arrays) {
-            if (a.group != group)
-                continue;
+    auto it = valueIndex.constFind(makeKey(key));
+    if (it == valueIndex.constEnd())
+        return nullptr;
 
-            for (int vi : a.values) {
-                const Value& v = values[vi];
-                if (v.arrayIndex == arrayIndex && v.key == key)
-                    return &v;
-            }
-        }
-    } else {
-        for (const Value& v : values)
-            if (v.group == group && v.array == -1 && v.key == key)
-                return &v;
-    }
-    return nullptr;
+    return &values[it.value()];
 }
 
 SettingsSerializer::Value* SettingsSerializer::findValue(const QString& key)
@@ -220,6 +228,26 @@ SettingsSerializer::Value* SettingsSerializer::findValue(const QString& key)
     return const_cast<Value*>(const_cast<const SettingsSerializer*>(this)->findValue(key));
 }
 
+SettingsSerializer::ValueKey SettingsSerializer::makeKey(const QString& key) const
+{
+    return {group, array, array != -1 ? arrayIndex : -1, key};
+}
+
+/**
+ * @brief Rebuilds the value lookup index after values were moved around.
+ */
+void SettingsSerializer::rebuildIndex()
+{
+    valueIndex.clear();
+    valueIndex.reserve(values.size());
+    for (int i = 0; i < values.size(); ++i) {
+        const Value& v = values[i];
+        const ValueKey k{v.group, v.array, v.array != -1 ? v.arrayIndex : -1, v.key};
+        if (!valueIndex.contains(k))
+            valueIndex.insert(k, i);
+    }
+}
+
 /**
  * @brief Checks if the file is serialized settings.
  * @param filePath Path to file to check.
@@ -233,7 +261,8 @@ bool SettingsSerializer::isSerializedFormat(QString filePath)
     char fmagic[8];
     if (f.read(fmagic, sizeof(fmagic)) != sizeof(fmagic))
         return false;
-    return !memcmp(fmagic, magic, 4) || tox_is_data_encrypted(reinterpret_cast<uint8_t*>(fmagic));
+    return !memcmp(fmagic, magic, 4) || !memcmp(fmagic, indexedMagic, 4)
+           || tox_is_data_encrypted(reinterpret_cast<uint8_t*>(fmagic));
 }
 
 /**
@@ -241,10 +270,26 @@ bool SettingsSerializer::isSerializedFormat(QString filePath)
  */
 void SettingsSerializer::load()
 {
-    if (isSerializedFormat(path))
-        readSerialized();
-    else
+    if (!isSerializedFormat(path)) {
         readIni();
+        return;
+    }
+
+    const QByteArray data = readPlaintext();
+    if (data.size() < 4) {
+        return;
+    }
+
+    if (!memcmp(data.constData(), indexedMagic, 4)) {
+        readIndexed(data);
+    } else if (!memcmp(data.constData(), magic, 4)) {
+        readSerialized(data);
+    } else {
+        qWarning() << "Bad magic!";
+    }
+
+    // Everything has been parsed, the mapping is not needed anymore
+    mappedFile.reset();
 }
 
 /**
@@ -258,49 +303,30 @@ void SettingsSerializer::save()
         return;
     }
 
-    QByteArray data(magic, 4);
-    QDataStream stream(&data, QIODevice::ReadWrite | QIODevice::Append);
-    stream.setVersion(QDataStream::Qt_5_0);
+    QByteArray payload;
+    QVector<Section> index;
 
     // prevent signed overflow and the associated warning
     int numGroups = std::max(0, groups.size());
     for (int g = -1; g < numGroups; ++g) {
-        // Save the group name, if any
-        if (g != -1) {
-            writeStream(stream, RecordTag::GroupStart);
-            writeStream(stream, groups[g].toUtf8());
-        }
-
-        // Save all the arrays of this group
-        for (const Array& a : arrays) {
-            if (a.group != g)
-                continue;
-            if (a.size <= 0)
-                continue;
-            writeStream(stream, RecordTag::ArrayStart);
-            writeStream(stream, a.name.toUtf8());
-            writeStream(stream, vintToData(a.size));
-
-            for (int vi : a.values) {
-                const Value& v = values[vi];
-                writeStream(stream, RecordTag::ArrayValue);
-                writeStream(stream, vintToData(values[vi].arrayIndex));
-                writeStream(stream, v.key.toUtf8());
-                writePackedVariant(stream, v.value);
-            }
-            writeStream(stream, RecordTag::ArrayEnd);
-        }
+        const QByteArray body = serializeGroup(g);
+        index.append({g == -1 ? QString() : groups[g], payload.size(), body.size()});
+        payload.append(body);
+    }
 
-        // Save all the values of this group that aren't in an array
-        for (const Value& v : values) {
-            if (v.group != g || v.array != -1)
-                continue;
-            writeStream(stream, RecordTag::Value);
-            writeStream(stream, v.key.toUtf8());
-            writePackedVariant(stream, v.value);
-        }
+    QByteArray data(indexedMagic, 4);
+    QDataStream stream(&data, QIODevice::ReadWrite | QIODevice::Append);
+    stream.setVersion(QDataStream::Qt_5_0);
+    writeStream(stream, vintToData(indexedFormatVersion));
+    writeStream(stream, vintToData(index.size()));
+    for (const Section& section : index) {
+        writeStream(stream, section.name.toUtf8());
+        writeStream(stream, vintToData(section.offset));
+        writeStream(stream, vintToData(section.length));
     }
 
+    data.append(payload);
+
     // Encrypt
     if (passKey) {
         data = passKey->encrypt(data);
@@ -317,42 +343,147 @@ void SettingsSerializer::save()
     }
 }
 
-void SettingsSerializer::readSerialized()
+/**
+ * @brief Reads and decrypts the serialized settings file.
+ * @return Plaintext file content, empty on error.
+ *
+ * Unencrypted files are memory-mapped, the mapping is kept alive until load() parsed them.
+ */
+QByteArray SettingsSerializer::readPlaintext()
 {
-    QFile f(path);
-    if (!f.open(QIODevice::ReadOnly)) {
+    std::unique_ptr<QFile> f{new QFile(path)};
+    if (!f->open(QIODevice::ReadOnly)) {
         qWarning() << "Couldn't open file";
-        return;
+        return {};
+    }
+
+    QByteArray data;
+    const qint64 size = f->size();
+    uchar* mapped = size > 0 ? f->map(0, size) : nullptr;
+    if (mapped) {
+        data = QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), static_cast<int>(size));
+    } else {
+        data = f->readAll();
     }
-    QByteArray data = f.readAll();
-    f.close();
 
     // Decrypt
     if (ToxEncrypt::isEncrypted(data)) {
         if (!passKey) {
             qCritical() << "The settings file is encrypted, but we don't have a passkey!";
-            return;
+            return {};
         }
 
         data = passKey->decrypt(data);
         if (data.isEmpty()) {
             qCritical() << "Failed to decrypt the settings file";
-            return;
+            return {};
         }
+        return data;
     } else {
         if (passKey)
             qWarning() << "We have a password, but the settings file is not encrypted";
     }
 
-    if (memcmp(data.data(), magic, 4)) {
-        qWarning() << "Bad magic!";
-        return;
+    if (mapped) {
+        mappedFile = std::move(f);
     }
-    data = data.mid(4);
+    return data;
+}
+
+/**
+ * @brief Reads a file in the legacy, unindexed format.
+ * @param data Plaintext file content, starting with the magic.
+ */
+void SettingsSerializer::readSerialized(const QByteArray& data)
+{
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream.skipRawData(4);
 
-    QDataStream stream(&data, QIODevice::ReadOnly);
+    if (!readRecords(stream)) {
+        qWarning("The personal save file is corrupted!");
+    }
+
+    group = array = -1;
+}
+
+/**
+ * @brief Reads a file in the indexed format.
+ * @param data Plaintext file content, starting with the magic.
+ */
+void SettingsSerializer::readIndexed(const QByteArray& data)
+{
+    QDataStream stream(data);
     stream.setVersion(QDataStream::Qt_5_0);
+    stream.skipRawData(4);
 
+    QByteArray versionData;
+    readStream(stream, versionData);
+    if (versionData.isEmpty() || dataToVInt(versionData) != indexedFormatVersion) {
+        qWarning() << "Unsupported settings format version";
+        return;
+    }
+
+    QByteArray countData;
+    readStream(stream, countData);
+    if (countData.isEmpty()) {
+        qWarning("The personal save file is corrupted!");
+        return;
+    }
+
+    const int count = dataToVInt(countData);
+    QVector<Section> index;
+    index.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        QByteArray name;
+        QByteArray offsetData;
+        QByteArray lengthData;
+        readStream(stream, name);
+        readStream(stream, offsetData);
+        readStream(stream, lengthData);
+        if (stream.status() != QDataStream::Ok || offsetData.isEmpty() || lengthData.isEmpty()) {
+            qWarning("The personal save file is corrupted!");
+            return;
+        }
+        index.append({QString::fromUtf8(name), dataToVInt(offsetData), dataToVInt(lengthData)});
+    }
+
+    const qint64 payloadStart = stream.device()->pos();
+    for (const Section& section : index) {
+        if (section.offset < 0 || section.length < 0
+            || payloadStart + section.offset + section.length > data.size()) {
+            qWarning("The personal save file is corrupted!");
+            return;
+        }
+    }
+
+    for (const Section& section : index) {
+        if (section.name.isEmpty()) {
+            group = -1;
+        } else {
+            beginGroup(section.name);
+        }
+
+        const QByteArray chunk =
+            QByteArray::fromRawData(data.constData() + payloadStart + section.offset, section.length);
+        QDataStream sectionStream(chunk);
+        sectionStream.setVersion(QDataStream::Qt_5_0);
+        array = arrayIndex = -1;
+        if (!readRecords(sectionStream)) {
+            qWarning("The personal save file is corrupted!");
+        }
+    }
+
+    group = array = arrayIndex = -1;
+}
+
+/**
+ * @brief Parses RecordTag records into the current group.
+ * @param stream Stream positioned at the first record.
+ * @return False if the records are corrupted, true otherwise.
+ */
+bool SettingsSerializer::readRecords(QDataStream& stream)
+{
     while (!stream.atEnd()) {
         RecordTag tag;
         readStream(stream, tag);
@@ -373,8 +504,7 @@ void SettingsSerializer::readSerialized()
             QByteArray sizeData;
             readStream(stream, sizeData);
             if (sizeData.isEmpty()) {
-                qWarning("The personal save file is corrupted!");
-                return;
+                return false;
             }
             int size = dataToVInt(sizeData);
             arrays[array].size = qMax(size, arrays[array].size);
@@ -382,8 +512,7 @@ void SettingsSerializer::readSerialized()
             QByteArray indexData;
             readStream(stream, indexData);
             if (indexData.isEmpty()) {
-                qWarning("The personal save file is corrupted!");
-                return;
+                return false;
             }
             setArrayIndex(dataToVInt(indexData));
             QByteArray key;
@@ -396,7 +525,50 @@ void SettingsSerializer::readSerialized()
         }
     }
 
-    group = array = -1;
+    return stream.status() == QDataStream::Ok;
+}
+
+/**
+ * @brief Serializes the arrays and values of a group.
+ * @param g ID of the group, -1 for the root group.
+ * @return RecordTag stream of the group.
+ */
+QByteArray SettingsSerializer::serializeGroup(int g)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    // Save all the arrays of this group
+    for (const Array& a : arrays) {
+        if (a.group != g)
+            continue;
+        if (a.size <= 0)
+            continue;
+        writeStream(stream, RecordTag::ArrayStart);
+        writeStream(stream, a.name.toUtf8());
+        writeStream(stream, vintToData(a.size));
+
+        for (int vi : a.values) {
+            const Value& v = values[vi];
+            writeStream(stream, RecordTag::ArrayValue);
+            writeStream(stream, vintToData(values[vi].arrayIndex));
+            writeStream(stream, v.key.toUtf8());
+            writePackedVariant(stream, v.value);
+        }
+        writeStream(stream, RecordTag::ArrayEnd);
+    }
+
+    // Save all the values of this group that aren't in an array
+    for (const Value& v : values) {
+        if (v.group != g || v.array != -1)
+            continue;
+        writeStream(stream, RecordTag::Value);
+        writeStream(stream, v.key.toUtf8());
+        writePackedVariant(stream, v.value);
+    }
+
+    return data;
 }
 
 void SettingsSerializer::readIni()
@@ -525,6 +697,7 @@ void SettingsSerializer::readIni()
         removeGroup(g);
     }
 
+    rebuildIndex();
     group = array = -1;
 }
 
@@ -22,10 +22,14 @@
 #include "src/core/toxencrypt.h"
 
 #include <QDataStream>
+#include <QFile>
+#include <QHash>
 #include <QSettings>
 #include <QString>
 #include <QVector>
 
+#include <memory>
+
 class SettingsSerializer
 {
 public:
@@ -56,6 +60,7 @@ private:
         ArrayValue = 3,
         ArrayEnd = 4,
     };
+    static constexpr int indexedFormatVersion = 1;
     friend QDataStream& writeStream(QDataStream& dataStream, const SettingsSerializer::RecordTag& tag);
     friend QDataStream& readStream(QDataStream& dataStream, SettingsSerializer::RecordTag& tag);
 
@@ -92,10 +97,38 @@ private:
         QVector<int> values;
     };
 
+    struct ValueKey
+    {
+        qint64 group;
+        qint64 array;
+        int arrayIndex;
+        QString key;
+
+        bool operator==(const ValueKey& other) const
+        {
+            return group == other.group && array == other.array
+                   && arrayIndex == other.arrayIndex && key == other.key;
+        }
+    };
+    friend uint qHash(const ValueKey& k, uint seed);
+
+    struct Section
+    {
+        QString name;
+        int offset;
+        int length;
+    };
+
 private:
     const Value* findValue(const QString& key) const;
     Value* findValue(const QString& key);
-    void readSerialized();
+    ValueKey makeKey(const QString& key) const;
+    void rebuildIndex();
+    QByteArray readPlaintext();
+    void readSerialized(const QByteArray& data);
+    void readIndexed(const QByteArray& data);
+    bool readRecords(QDataStream& stream);
+    QByteArray serializeGroup(int g);
     void readIni();
     void removeValue(const QString& key);
     void removeGroup(int group);
@@ -108,5 +141,8 @@ private:
     QStringList groups;
     QVector<Array> arrays;
     QVector<Value> values;
+    QHash<ValueKey, int> valueIndex;
+    std::unique_ptr<QFile> mappedFile;
     static const char magic[];
+    static const char indexedMagic[];
 };
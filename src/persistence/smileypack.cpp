@@ -22,9 +22,7 @@
 
 #include <QDir>
 #include <QDomElement>
-#include <QRegularExpression>
 #include <QStandardPaths>
-#include <QStringBuilder>
 #include <QtConcurrent/QtConcurrentRun>
 #include <QTimer>
 
@@ -252,70 +250,130 @@ bool SmileyPack::load(const QString& filename)
         emoticons.append(emoticonList);
     }
 
-    constructRegex();
+    constructMatcher();
 
     loadingMutex.unlock();
     return true;
 }
 
 /**
- * @brief Creates the regex for replacing emoticons with the path to their pictures
+ * @brief Builds the trie used to find emoticons in messages
+ *
+ * Every emoticon is a path from the root node, the node at its end records whether the
+ * emoticon may appear anywhere or only delimited by whitespace.
  */
-void SmileyPack::constructRegex()
+void SmileyPack::constructMatcher()
 {
-    QString allPattern = QStringLiteral("(");
-    QString regularPatterns;
-    QString multiCharacterEmojiPatterns;
-
-    // construct one big regex that matches on every emoticon
-    for (const QString& emote : emoticonToPath.keys()) {
-        if (!isAscii(emote)) {
-            if (emote.toUcs4().length() == 1) {
-                regularPatterns.append(emote);
-                regularPatterns.append(QStringLiteral("|"));
-            }
-            else {
-                multiCharacterEmojiPatterns.append(emote);
-                multiCharacterEmojiPatterns.append(QStringLiteral("|"));
+    matcherNodes.clear();
+    matcherEdges.clear();
+    matcherNodes.append(MatchKind::None);
+
+    for (auto it = emoticonToPath.constBegin(); it != emoticonToPath.constEnd(); ++it) {
+        const QString& emote = it.key();
+        if (emote.isEmpty()) {
+            continue;
+        }
+
+        int node = 0;
+        for (const QChar c : emote) {
+            int next = nextMatcherNode(node, c);
+            if (next < 0) {
+                next = matcherNodes.size();
+                matcherNodes.append(MatchKind::None);
+                matcherEdges.insert((static_cast<quint64>(node) << 16) | c.unicode(), next);
             }
-        } else {
-            // patterns like ":)" or ":smile:", don't match inside a word or else will hit punctuation and html tags
-            regularPatterns.append(QStringLiteral(R"((?<=^|\s))") % QRegularExpression::escape(emote) % QStringLiteral(R"((?=$|\s))"));
-            regularPatterns.append(QStringLiteral("|"));
+            node = next;
         }
+
+        // patterns like ":)" or ":smile:", don't match inside a word or else will hit punctuation and html tags
+        matcherNodes[node] = isAscii(emote) ? MatchKind::Delimited : MatchKind::Anywhere;
     }
+}
+
+int SmileyPack::nextMatcherNode(int node, QChar c) const
+{
+    return matcherEdges.value((static_cast<quint64>(node) << 16) | c.unicode(), -1);
+}
+
+namespace {
+/**
+ * @brief Same characters as \s of a regular expression without unicode properties
+ */
+bool isDelimiter(QChar c)
+{
+    const ushort code = c.unicode();
+    return code == ' ' || (code >= '\t' && code <= '\r');
+}
+} // namespace
 
-    // Regexps are evaluated from left to right, insert multichar emojis first so they are evaluated first
-    allPattern.append(multiCharacterEmojiPatterns);
-    allPattern.append(regularPatterns);
-    allPattern[allPattern.size() - 1] = QChar(')');
+/**
+ * @brief Finds the longest emoticon starting at a position of the message
+ * @param msg Message to search in
+ * @param start Position the emoticon has to start at
+ * @return Length of the emoticon, 0 if there is none
+ */
+int SmileyPack::findLongestMatch(const QString& msg, int start) const
+{
+    const bool delimitedStart = start == 0 || isDelimiter(msg[start - 1]);
+    int length = 0;
+    int node = 0;
+    for (int i = start; i < msg.size(); ++i) {
+        node = nextMatcherNode(node, msg[i]);
+        if (node < 0) {
+            break;
+        }
 
-    // compile and optimize regex
-    smilify.setPattern(allPattern);
-    smilify.optimize();
+        const MatchKind kind = matcherNodes[node];
+        const int end = i + 1;
+        if (kind == MatchKind::Anywhere
+            || (kind == MatchKind::Delimited && delimitedStart
+                && (end == msg.size() || isDelimiter(msg[end])))) {
+            length = end - start;
+        }
+    }
+
+    return length;
 }
 
 /**
  * @brief Replaces all found text emoticons to HTML reference with its according icon filename
  * @param msg Message where to search for emoticons
  * @return Formatted copy of message
+ *
+ * The longest emoticon starting at a position wins, so multi character emojis are not split
+ * into their single character counterparts.
  */
 QString SmileyPack::smileyfied(const QString& msg)
 {
     QMutexLocker locker(&loadingMutex);
-    QString result(msg);
-
-    int replaceDiff = 0;
-    QRegularExpressionMatchIterator iter = smilify.globalMatch(result);
-    while (iter.hasNext()) {
-        QRegularExpressionMatch match = iter.next();
-        int startPos = match.capturedStart();
-        int keyLength = match.capturedLength();
-        QString imgRichText = getAsRichText(match.captured());
-        result.replace(startPos + replaceDiff, keyLength, imgRichText);
-        replaceDiff += imgRichText.length() - keyLength;
+    if (matcherNodes.isEmpty()) {
+        return msg;
+    }
+
+    QString result;
+    int copied = 0;
+    for (int i = 0; i < msg.size();) {
+        const int length = findLongestMatch(msg, i);
+        if (length == 0) {
+            ++i;
+            continue;
+        }
+
+        if (copied == 0) {
+            result.reserve(msg.size() * 2);
+        }
+
+        result.append(msg.midRef(copied, i - copied));
+        result.append(getAsRichText(msg.mid(i, length)));
+        i += length;
+        copied = i;
+    }
+
+    if (copied == 0) {
+        return msg;
     }
 
+    result.append(msg.midRef(copied));
     return result;
 }
 
@@ -19,10 +19,11 @@
 
 #pragma once
 
+#include <QHash>
 #include <QIcon>
 #include <QMap>
 #include <QMutex>
-#include <QRegularExpression>
+#include <QVector>
 
 #include <memory>
 
@@ -51,14 +52,24 @@ private:
     SmileyPack& operator=(const SmileyPack&) = delete;
     ~SmileyPack() override;
 
+    enum class MatchKind : quint8
+    {
+        None,
+        Anywhere,
+        Delimited
+    };
+
     bool load(const QString& filename);
-    void constructRegex();
+    void constructMatcher();
+    int nextMatcherNode(int node, QChar c) const;
+    int findLongestMatch(const QString& msg, int start) const;
 
     mutable std::map<QString, std::shared_ptr<QIcon>> cachedIcon;
     QHash<QString, QString> emoticonToPath;
     QList<QStringList> emoticons;
     QString path;
     QTimer* cleanupTimer;
-    QRegularExpression smilify;
+    QVector<MatchKind> matcherNodes;
+    QHash<quint64, int> matcherEdges;
     mutable QMutex loadingMutex;
 };
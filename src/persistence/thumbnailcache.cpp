@@ -0,0 +1,350 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "thumbnailcache.h"
+
+#include "src/model/exiftransform.h"
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QtConcurrent/QtConcurrentRun>
+
+/**
+ * @class ThumbnailCache
+ * @brief Decodes previews of image files on worker threads and keeps small icons around.
+ *
+ * Images are decoded with QImageReader at the size they are shown at, which lets the JPEG
+ * decoder skip most of the work for large photos. Icons are cached under a hash of the file
+ * path, size, modification time and icon size, so a file that changed gets a new icon.
+ *
+ * Icons are kept in memory up to maxMemoryBytes. If the cache has a directory, which is
+ * only set for profiles that aren't encrypted, they are also stored there as PNG up to
+ * maxDiskBytes, dropping the oldest ones first.
+ *
+ * Each result is delivered to the callback of its own request, on the thread of the cache,
+ * and only if the receiver of the request still exists.
+ */
+
+namespace {
+// Exif data is in the APP1 segment at the start of the file, which is limited to 64KiB
+const qint64 exifHeaderSize = 128 * 1024;
+const int maxDecodeThreads = 2;
+// once the disk cache is full, it's trimmed to this share of its size
+const int diskTrimPercent = 75;
+
+ExifTransform::Orientation readOrientation(const QString& filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return ExifTransform::Orientation::TopLeft;
+    }
+
+    return ExifTransform::getOrientation(file.read(exifHeaderSize));
+}
+
+bool isTransposed(ExifTransform::Orientation orientation)
+{
+    return orientation >= ExifTransform::Orientation::LeftTop;
+}
+
+QImage cropIntoSquare(const QImage& source, int targetSize)
+{
+    QImage result = source;
+
+    // Make sure smaller-than-icon images (at least one dimension is smaller) will not be
+    // upscaled
+    if (source.width() > targetSize && source.height() > targetSize) {
+        result = source.scaled(targetSize, targetSize, Qt::KeepAspectRatioByExpanding,
+                               Qt::SmoothTransformation);
+    }
+
+    // Only one dimension will be bigger after Qt::KeepAspectRatioByExpanding, unlike
+    // QPixmap::copy QImage::copy doesn't clip the other one
+    const int width = qMin(result.width(), targetSize);
+    const int height = qMin(result.height(), targetSize);
+    if (result.width() > targetSize) {
+        return result.copy((result.width() - targetSize) / 2, 0, width, height);
+    } else if (result.height() > targetSize) {
+        return result.copy(0, (result.height() - targetSize) / 2, width, height);
+    }
+
+    return result;
+}
+
+QString getCacheKey(const QString& filePath, int size)
+{
+    const QFileInfo info{filePath};
+    const QString key = QStringLiteral("%1\n%2\n%3\n%4")
+                            .arg(info.absoluteFilePath())
+                            .arg(info.size())
+                            .arg(info.lastModified().toMSecsSinceEpoch())
+                            .arg(size);
+    const QByteArray hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha256);
+    return QString::fromLatin1(hash.toHex());
+}
+
+int getImageBytes(const QImage& image)
+{
+    return image.bytesPerLine() * image.height();
+}
+} // namespace
+
+ThumbnailCache& ThumbnailCache::getInstance()
+{
+    // icons stay in memory until a profile sets a directory
+    static ThumbnailCache thumbnailCache;
+    return thumbnailCache;
+}
+
+/**
+ * @brief Checks if a file looks like an image that can be previewed.
+ */
+bool ThumbnailCache::canPreview(const QString& filePath)
+{
+    static const QStringList previewExtensions = {"png", "jpeg", "jpg", "gif", "svg",
+                                                  "PNG", "JPEG", "JPG", "GIF", "SVG"};
+
+    return previewExtensions.contains(QFileInfo(filePath).suffix());
+}
+
+/**
+ * @param cacheDir Directory to store icons in, created when the first icon is stored. Icons
+ * are only kept in memory if it's empty.
+ * @param maxDiskBytes Size of the icons stored in the directory at which the oldest are removed.
+ */
+ThumbnailCache::ThumbnailCache(const QString& cacheDir, qint64 maxDiskBytes)
+    : cacheDir{cacheDir}
+    , memoryCache{maxMemoryBytes}
+    , maxDiskBytes{maxDiskBytes}
+{
+    pool.setMaxThreadCount(maxDecodeThreads);
+    connect(this, &ThumbnailCache::iconLoaded, this, &ThumbnailCache::onIconLoaded,
+            Qt::QueuedConnection);
+    connect(this, &ThumbnailCache::previewLoaded, this, &ThumbnailCache::onPreviewLoaded,
+            Qt::QueuedConnection);
+}
+
+/**
+ * @brief Changes the directory icons are stored in, e.g. when another profile is loaded.
+ * @param cacheDir New directory, empty to only keep icons in memory.
+ *
+ * Icons in memory are dropped, so they don't show up for another profile.
+ */
+void ThumbnailCache::setCacheDir(const QString& cacheDir)
+{
+    this->cacheDir = cacheDir;
+
+    QMutexLocker locker{&mutex};
+    memoryCache.clear();
+    diskBytes = -1;
+}
+
+/**
+ * @brief Loads a square icon of an image.
+ * @param filePath Image to load.
+ * @param size Width and height of the icon, smaller images are not upscaled.
+ * @param receiver onReady isn't called anymore once it's destroyed.
+ * @param onReady Called with the icon on the thread of the cache, not if it can't be loaded.
+ */
+void ThumbnailCache::requestIcon(const QString& filePath, int size, QObject* receiver,
+                                 IconCallback onReady)
+{
+    const quint64 requestId = addRequest(receiver, std::move(onReady), {});
+    const QString dir = cacheDir;
+    QtConcurrent::run(&pool, [this, requestId, dir, filePath, size]() {
+        emit iconLoaded(requestId, loadIcon(dir, filePath, size));
+    });
+}
+
+/**
+ * @brief Encodes an image as PNG for a tooltip.
+ * @param filePath Image to load.
+ * @param maxSize The image is scaled down to fit into this size, keeping its aspect ratio.
+ * @param receiver onReady isn't called anymore once it's destroyed.
+ * @param onReady Called with the PNG on the thread of the cache, not if it can't be loaded.
+ */
+void ThumbnailCache::requestPreview(const QString& filePath, QSize maxSize, QObject* receiver,
+                                    PreviewCallback onReady)
+{
+    const quint64 requestId = addRequest(receiver, {}, std::move(onReady));
+    QtConcurrent::run(&pool, [this, requestId, filePath, maxSize]() {
+        emit previewLoaded(requestId, loadPreview(filePath, maxSize));
+    });
+}
+
+quint64 ThumbnailCache::addRequest(QObject* receiver, IconCallback onIcon,
+                                   PreviewCallback onPreview)
+{
+    const quint64 requestId = nextRequestId++;
+    requests.insert(requestId, Request{receiver, std::move(onIcon), std::move(onPreview)});
+    return requestId;
+}
+
+void ThumbnailCache::onIconLoaded(quint64 requestId, const QImage& icon)
+{
+    const Request request = requests.take(requestId);
+    if (request.receiver && !icon.isNull()) {
+        request.onIcon(icon);
+    }
+}
+
+void ThumbnailCache::onPreviewLoaded(quint64 requestId, const QByteArray& png)
+{
+    const Request request = requests.take(requestId);
+    if (request.receiver && !png.isEmpty()) {
+        request.onPreview(png);
+    }
+}
+
+QImage ThumbnailCache::loadIcon(const QString& cacheDir, const QString& filePath, int size)
+{
+    if (!QFileInfo::exists(filePath)) {
+        return {};
+    }
+
+    const QString key = getCacheKey(filePath, size);
+    {
+        QMutexLocker locker{&mutex};
+        const QImage* cached = memoryCache.object(key);
+        if (cached) {
+            return *cached;
+        }
+    }
+
+    const QString cachePath =
+        cacheDir.isEmpty() ? QString() : cacheDir + QDir::separator() + key + ".png";
+    QImage icon;
+    if (!cachePath.isEmpty()) {
+        icon.load(cachePath);
+    }
+
+    const bool stored = !icon.isNull();
+    if (!stored) {
+        QImageReader reader{filePath};
+        const QSize original = reader.size();
+        if (original.width() > size && original.height() > size) {
+            reader.setScaledSize(original.scaled(size, size, Qt::KeepAspectRatioByExpanding));
+        }
+
+        QImage image = reader.read();
+        if (image.isNull()) {
+            qWarning() << "Can't decode" << filePath << ":" << reader.errorString();
+            return {};
+        }
+
+        image = ExifTransform::applyTransformation(image, readOrientation(filePath));
+        icon = cropIntoSquare(image, size);
+    }
+
+    {
+        QMutexLocker locker{&mutex};
+        memoryCache.insert(key, new QImage{icon}, getImageBytes(icon));
+    }
+
+    if (!stored && !cachePath.isEmpty()) {
+        storeIcon(cacheDir, cachePath, icon);
+    }
+
+    return icon;
+}
+
+void ThumbnailCache::storeIcon(const QString& cacheDir, const QString& cachePath,
+                               const QImage& icon)
+{
+    QDir{}.mkpath(cacheDir);
+    QSaveFile cacheFile{cachePath};
+    if (!cacheFile.open(QIODevice::WriteOnly) || !icon.save(&cacheFile, "PNG")
+        || !cacheFile.commit()) {
+        qWarning() << "Failed to store an icon in" << cacheDir;
+        return;
+    }
+
+    QMutexLocker locker{&mutex};
+    if (diskBytes < 0) {
+        // counted on the first store, includes the new icon
+        locker.unlock();
+        trimDiskCache(cacheDir);
+        return;
+    }
+
+    diskBytes += QFileInfo{cachePath}.size();
+    if (diskBytes > maxDiskBytes) {
+        locker.unlock();
+        trimDiskCache(cacheDir);
+    }
+}
+
+/**
+ * @brief Counts the size of the stored icons, removes the oldest ones if there are too many.
+ */
+void ThumbnailCache::trimDiskCache(const QString& cacheDir)
+{
+    const QFileInfoList icons =
+        QDir{cacheDir}.entryInfoList({"*.png"}, QDir::Files, QDir::Time | QDir::Reversed);
+    qint64 bytes = 0;
+    for (const QFileInfo& icon : icons) {
+        bytes += icon.size();
+    }
+
+    const qint64 limit = bytes > maxDiskBytes ? maxDiskBytes * diskTrimPercent / 100 : bytes;
+    for (auto it = icons.begin(); bytes > limit && it != icons.end(); ++it) {
+        if (QFile::remove(it->filePath())) {
+            bytes -= it->size();
+        }
+    }
+
+    QMutexLocker locker{&mutex};
+    diskBytes = bytes;
+}
+
+QByteArray ThumbnailCache::loadPreview(const QString& filePath, QSize maxSize)
+{
+    const auto orientation = readOrientation(filePath);
+    if (isTransposed(orientation)) {
+        maxSize.transpose();
+    }
+
+    QImageReader reader{filePath};
+    const QSize original = reader.size();
+    if (original.width() > maxSize.width() || original.height() > maxSize.height()) {
+        reader.setScaledSize(original.scaled(maxSize, Qt::KeepAspectRatio));
+    }
+
+    QImage image = reader.read();
+    if (image.isNull()) {
+        return {};
+    }
+
+    image = ExifTransform::applyTransformation(image, orientation);
+
+    QByteArray png;
+    QBuffer buffer{&png};
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "PNG");
+    buffer.close();
+    return png;
+}
@@ -0,0 +1,90 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QPointer>
+#include <QSize>
+#include <QThreadPool>
+
+#include <functional>
+
+class ThumbnailCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    using IconCallback = std::function<void(const QImage& icon)>;
+    using PreviewCallback = std::function<void(const QByteArray& png)>;
+
+    static constexpr int maxMemoryBytes = 8 * 1024 * 1024;
+    static constexpr qint64 defaultMaxDiskBytes = 32 * 1024 * 1024;
+
+    static ThumbnailCache& getInstance();
+    static bool canPreview(const QString& filePath);
+
+    explicit ThumbnailCache(const QString& cacheDir = QString(),
+                            qint64 maxDiskBytes = defaultMaxDiskBytes);
+
+    void setCacheDir(const QString& cacheDir);
+    void requestIcon(const QString& filePath, int size, QObject* receiver, IconCallback onReady);
+    void requestPreview(const QString& filePath, QSize maxSize, QObject* receiver,
+                        PreviewCallback onReady);
+
+signals:
+    // internal, emitted on the decode threads
+    void iconLoaded(quint64 requestId, const QImage& icon);
+    void previewLoaded(quint64 requestId, const QByteArray& png);
+
+private:
+    struct Request
+    {
+        QPointer<QObject> receiver;
+        IconCallback onIcon;
+        PreviewCallback onPreview;
+    };
+
+    quint64 addRequest(QObject* receiver, IconCallback onIcon, PreviewCallback onPreview);
+    void onIconLoaded(quint64 requestId, const QImage& icon);
+    void onPreviewLoaded(quint64 requestId, const QByteArray& png);
+    QImage loadIcon(const QString& cacheDir, const QString& filePath, int size);
+    void storeIcon(const QString& cacheDir, const QString& cachePath, const QImage& icon);
+    void trimDiskCache(const QString& cacheDir);
+    static QByteArray loadPreview(const QString& filePath, QSize maxSize);
+
+private:
+    // only used on the thread of the cache
+    QString cacheDir;
+    quint64 nextRequestId = 0;
+    QHash<quint64, Request> requests;
+
+    // shared with the decode threads
+    QMutex mutex;
+    QCache<QString, QImage> memoryCache;
+    const qint64 maxDiskBytes;
+    qint64 diskBytes = -1;
+
+    // declared last, so running jobs are finished before anything else is destroyed
+    QThreadPool pool;
+};
@@ -22,7 +22,16 @@
 
 #include "v4l2.h"
 
+#include <QCoreApplication>
 #include <QDebug>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QTimer>
+#include <QWaitCondition>
+#include <QtConcurrent/QtConcurrentRun>
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
@@ -122,7 +131,7 @@ static QVector<float> getDeviceModeFramerates(int fd, unsigned w, unsigned h,
     return rates;
 }
 
-QVector<VideoMode> v4l2::getDeviceModes(QString devName)
+static QVector<VideoMode> probeDeviceModes(const QString& devName)
 {
     QVector<VideoMode> modes;
 
@@ -177,17 +186,20 @@ QVector<VideoMode> v4l2::getDeviceModes(QString devName)
         }
     }
 
+    close(fd);
     return modes;
 }
 
-QVector<QPair<QString, QString>> v4l2::getDeviceList()
+/**
+ * @brief Lists the video device nodes in /dev, sorted.
+ */
+static QStringList listDeviceFiles()
 {
-    QVector<QPair<QString, QString>> devices;
     QStringList deviceFiles;
 
     DIR* dir = opendir("/dev");
     if (!dir)
-        return devices;
+        return deviceFiles;
 
     dirent* e;
     while ((e = readdir(dir)))
@@ -195,23 +207,225 @@ QVector<QPair<QString, QString>> v4l2::getDeviceList()
             deviceFiles += QString("/dev/") + e->d_name;
     closedir(dir);
 
-    for (QString file : deviceFiles) {
+    deviceFiles.sort();
+    return deviceFiles;
+}
+
+static QVector<QPair<QString, QString>> probeDeviceList()
+{
+    QVector<QPair<QString, QString>> devices;
+    for (QString file : listDeviceFiles()) {
         const std::string filePath = file.toStdString();
         int fd = open(filePath.c_str(), O_RDWR);
         if (fd < 0) {
             continue;
         }
 
-        v4l2_capability caps;
-        ioctl(fd, VIDIOC_QUERYCAP, &caps);
+        v4l2_capability caps{};
+        const int result = ioctl(fd, VIDIOC_QUERYCAP, &caps);
         close(fd);
 
-        if (caps.device_caps & V4L2_CAP_VIDEO_CAPTURE)
+        if (!result && (caps.device_caps & V4L2_CAP_VIDEO_CAPTURE))
             devices += {file, reinterpret_cast<const char*>(caps.card)};
     }
     return devices;
 }
 
+/**
+ * Probing a device takes an ioctl for every format, size and frame interval it supports, which
+ * adds up to hundreds of milliseconds with several cameras. The results are cached and only
+ * probed again in the background when a device node is added or removed.
+ */
+struct DeviceCache
+{
+    QMutex mutex;
+    // bumped on every hotplug, so results of an outdated probe are thrown away
+    quint64 generation = 0;
+    bool hasDeviceList = false;
+    QVector<QPair<QString, QString>> devices;
+    QHash<QString, QVector<VideoMode>> modes;
+    bool refreshing = false;
+    // woken when a background probe finished
+    QWaitCondition refreshed;
+    bool watching = false;
+    // device nodes in /dev when the watcher last looked, only used by the GUI thread
+    QStringList deviceFiles;
+};
+
+static DeviceCache& deviceCache()
+{
+    static DeviceCache cache;
+    return cache;
+}
+
+/**
+ * @brief Probes all devices and their modes, runs in the thread pool.
+ */
+static void refreshDeviceCache()
+{
+    DeviceCache& cache = deviceCache();
+    forever
+    {
+        quint64 generation;
+        {
+            QMutexLocker locker{&cache.mutex};
+            generation = cache.generation;
+        }
+
+        const QVector<QPair<QString, QString>> devices = probeDeviceList();
+        QHash<QString, QVector<VideoMode>> modes;
+        for (const QPair<QString, QString>& device : devices) {
+            modes.insert(device.first, probeDeviceModes(device.first));
+        }
+
+        QMutexLocker locker{&cache.mutex};
+        if (generation == cache.generation) {
+            cache.devices = devices;
+            cache.hasDeviceList = true;
+            cache.modes = modes;
+            cache.refreshing = false;
+            cache.refreshed.wakeAll();
+            return;
+        }
+    }
+}
+
+static void scheduleRefresh()
+{
+    DeviceCache& cache = deviceCache();
+    QMutexLocker locker{&cache.mutex};
+    if (cache.refreshing) {
+        return;
+    }
+
+    cache.refreshing = true;
+    QtConcurrent::run(&refreshDeviceCache);
+}
+
+static void onDevicesChanged()
+{
+    DeviceCache& cache = deviceCache();
+
+    // Any node added or removed in /dev triggers the watcher, not only video devices
+    QStringList deviceFiles = listDeviceFiles();
+    if (deviceFiles == cache.deviceFiles) {
+        return;
+    }
+    cache.deviceFiles = std::move(deviceFiles);
+
+    {
+        QMutexLocker locker{&cache.mutex};
+        ++cache.generation;
+        cache.hasDeviceList = false;
+        cache.modes.clear();
+    }
+
+    qDebug() << "Video devices changed, probing them again";
+    scheduleRefresh();
+}
+
+/**
+ * @brief Watches /dev for hotplugged devices and probes all devices in the background, once.
+ * @note The watcher lives in the GUI thread, it needs an event loop.
+ */
+static void startWatching()
+{
+    DeviceCache& cache = deviceCache();
+    {
+        QMutexLocker locker{&cache.mutex};
+        if (cache.watching || !qApp) {
+            return;
+        }
+        cache.watching = true;
+    }
+
+    auto createWatcher = []() {
+        deviceCache().deviceFiles = listDeviceFiles();
+        QFileSystemWatcher* watcher = new QFileSystemWatcher{QStringList{"/dev"}, qApp};
+        QObject::connect(watcher, &QFileSystemWatcher::directoryChanged, &onDevicesChanged);
+    };
+
+    if (QThread::currentThread() == qApp->thread()) {
+        createWatcher();
+    } else {
+        QTimer::singleShot(0, qApp, createWatcher);
+    }
+
+    scheduleRefresh();
+}
+
+/**
+ * @brief Starts probing the devices in the background, so they are cached when first needed.
+ */
+void v4l2::warmCache()
+{
+    startWatching();
+}
+
+/**
+ * @brief Lists the modes of a device, from the cache if it was probed before.
+ * @note Waits for a running background probe instead of probing the device a second time.
+ */
+QVector<VideoMode> v4l2::getDeviceModes(QString devName)
+{
+    startWatching();
+
+    DeviceCache& cache = deviceCache();
+    quint64 generation;
+    {
+        QMutexLocker locker{&cache.mutex};
+        while (cache.refreshing && !cache.modes.contains(devName)) {
+            cache.refreshed.wait(&cache.mutex);
+        }
+
+        auto it = cache.modes.constFind(devName);
+        if (it != cache.modes.constEnd()) {
+            return it.value();
+        }
+        generation = cache.generation;
+    }
+
+    const QVector<VideoMode> modes = probeDeviceModes(devName);
+
+    QMutexLocker locker{&cache.mutex};
+    if (generation == cache.generation) {
+        cache.modes.insert(devName, modes);
+    }
+    return modes;
+}
+
+/**
+ * @brief Lists the capture devices, from the cache if they were probed before.
+ * @note Waits for a running background probe instead of probing the devices a second time.
+ */
+QVector<QPair<QString, QString>> v4l2::getDeviceList()
+{
+    startWatching();
+
+    DeviceCache& cache = deviceCache();
+    quint64 generation;
+    {
+        QMutexLocker locker{&cache.mutex};
+        while (cache.refreshing && !cache.hasDeviceList) {
+            cache.refreshed.wait(&cache.mutex);
+        }
+
+        if (cache.hasDeviceList) {
+            return cache.devices;
+        }
+        generation = cache.generation;
+    }
+
+    const QVector<QPair<QString, QString>> devices = probeDeviceList();
+
+    QMutexLocker locker{&cache.mutex};
+    if (generation == cache.generation) {
+        cache.devices = devices;
+        cache.hasDeviceList = true;
+    }
+    return devices;
+}
+
 QString v4l2::getPixelFormatString(uint32_t pixel_format)
 {
     if (pixFmtToName.find(pixel_format) == pixFmtToName.end()) {
@@ -28,6 +28,7 @@
 #endif
 
 namespace v4l2 {
+void warmCache();
 QVector<VideoMode> getDeviceModes(QString devName);
 QVector<QPair<QString, QString>> getDeviceList();
 QString getPixelFormatString(uint32_t pixel_format);
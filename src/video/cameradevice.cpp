@@ -471,6 +471,21 @@ QVector<VideoMode> CameraDevice::getVideoModes(QString devName)
     return {};
 }
 
+/**
+ * @brief Starts listing the devices and their modes in the background, where the platform
+ * caches them, so opening the settings or starting a call doesn't wait for the probe.
+ */
+void CameraDevice::warmDeviceCache()
+{
+    if (!getDefaultInputFormat() || !iformat)
+        return;
+
+#if USING_V4L
+    if (iformat->name == QString("video4linux2,v4l2"))
+        v4l2::warmCache();
+#endif
+}
+
 /**
  * @brief Get the name of the pixel format of a video mode.
  * @param pixel_format Pixel format to get the name from.
@@ -42,6 +42,7 @@ public:
     static QVector<QPair<QString, QString>> getDeviceList();
 
     static QVector<VideoMode> getVideoModes(QString devName);
+    static void warmDeviceCache();
     static QString getPixelFormatString(uint32_t pixel_format);
     static bool betterPixelFormat(uint32_t a, uint32_t b);
 
@@ -23,6 +23,8 @@ extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavdevice/avdevice.h>
 #include <libavformat/avformat.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
 #include <libswscale/swscale.h>
 #pragma GCC diagnostic pop
 }
@@ -31,6 +33,7 @@ extern "C" {
 #include "videoframe.h"
 #include "src/persistence/settings.h"
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QReadLocker>
 #include <QWriteLocker>
 #include <QtConcurrent/QtConcurrentRun>
@@ -88,6 +91,18 @@ extern "C" {
  *
  * @var std::atomic_int CameraSource::subscriptions
  * @brief Remember how many times we subscribed for RAII
+ *
+ * @var AVFrame* CameraSource::pendingFrame
+ * @brief Newest decoded frame that wasn't emitted yet, replaced when the consumers lag behind
+ *
+ * @var CameraSource::maxAutoDecodeThreads
+ * @brief Decoder threads used when not configured, each frame thread adds one frame of latency
+ *
+ * @var FrameDamageTracker CameraSource::damageTracker
+ * @brief Last captured screen frame, to skip frames that show the same picture
+ *
+ * @var CameraSource::screenRefreshMs
+ * @brief Interval to deliver unchanged screen frames in, so a call recovers from lost frames
  */
 
 CameraSource* CameraSource::instance{nullptr};
@@ -103,14 +118,24 @@ CameraSource::CameraSource()
     , cctxOrig{nullptr}
 #endif
     , videoStreamIndex{-1}
+    , pendingFrame{nullptr}
+    , delivering{false}
     , _isNone{true}
     , subscriptions{0}
+    , decodedFrames{0}
+    , droppedFrames{0}
+    , unchangedFrames{0}
+    , decodeNs{0}
 {
     qRegisterMetaType<VideoMode>("VideoMode");
     deviceThread->setObjectName("Device thread");
     deviceThread->start();
     moveToThread(deviceThread);
 
+    // one thread for the lifetime of the source, reused by every stream
+    deliverPool.setMaxThreadCount(1);
+    deliverPool.setExpiryTimeout(-1);
+
     subscriptions = 0;
 
 // TODO(sudden6): remove code when minimum ffmpeg version >= 4.0
@@ -118,6 +143,9 @@ CameraSource::CameraSource()
     av_register_all();
 #endif
     avdevice_register_all();
+
+    // the source is created with the main window, probe the cameras before they are needed
+    CameraDevice::warmDeviceCache();
 }
 
 // clang-format on
@@ -195,6 +223,20 @@ bool CameraSource::isNone() const
     return _isNone;
 }
 
+/**
+ * @brief Decoder statistics of the current or last stream, safe to call from any thread.
+ */
+CameraSource::Stats CameraSource::getStats() const
+{
+    Stats stats;
+    stats.decodedFrames = decodedFrames;
+    stats.droppedFrames = droppedFrames;
+    stats.unchangedFrames = unchangedFrames;
+    stats.averageDecodeUs =
+        stats.decodedFrames ? decodeNs / static_cast<qint64>(stats.decodedFrames) / 1000 : 0;
+    return stats;
+}
+
 CameraSource::~CameraSource()
 {
     QWriteLocker locker{&streamMutex};
@@ -350,6 +392,12 @@ void CameraSource::openDevice()
     }
 #endif
 
+    // Decode on several threads, a camera can deliver more than one core is able to decode
+    const int threads = Settings::getInstance().getCamDecodeThreads();
+    cctx->thread_count =
+        threads > 0 ? threads : qBound(1, QThread::idealThreadCount(), maxAutoDecodeThreads);
+    cctx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
     // Open codec
     if (avcodec_open2(cctx, codec, nullptr) < 0) {
         qWarning() << "Can't open codec";
@@ -404,48 +452,81 @@ void CameraSource::closeDevice()
 }
 
 /**
- * @brief Blocking. Decodes video stream and emits new frames.
+ * @brief Blocking. Decodes video stream and hands the frames to deliverFrames().
  * @note Designed to run in its own thread.
  */
 void CameraSource::stream()
 {
-    auto streamLoop = [=]() {
+    decodedFrames = 0;
+    droppedFrames = 0;
+    unchangedFrames = 0;
+    decodeNs = 0;
+
+    // A shared screen is mostly static, only frames that changed are worth encoding
+    const bool trackDamage = CameraDevice::isScreen(deviceName);
+    damageTracker.reset();
+    lastScreenRefresh.invalidate();
+    {
+        QMutexLocker locker{&frameMutex};
+        delivering = true;
+    }
+    QFuture<void> deliverFuture =
+        QtConcurrent::run(&deliverPool, std::bind(&CameraSource::deliverFrames, this));
+
+    // Frame to decode into, a frame that was replaced before being emitted is reused
+    AVFrame* frame = nullptr;
+    QElapsedTimer decodeTimer;
+
+    auto streamLoop = [&]() {
         AVPacket packet;
         if (av_read_frame(device->context, &packet) != 0) {
             return;
         }
 
+        // Only keep packets from the right stream;
+        if (packet.stream_index != videoStreamIndex) {
+            av_packet_unref(&packet);
+            return;
+        }
+
+        decodeTimer.start();
 #if LIBAVCODEC_VERSION_INT < 3747941
-        AVFrame* frame = av_frame_alloc();
-        if (!frame) {
+        if (!frame && !(frame = av_frame_alloc())) {
+            av_packet_unref(&packet);
             return;
         }
 
-        // Only keep packets from the right stream;
-        if (packet.stream_index == videoStreamIndex) {
-            // Decode video frame
-            int frameFinished;
-            avcodec_decode_video2(cctx, frame, &frameFinished, &packet);
-            if (!frameFinished) {
-                return;
+        // Decode video frame
+        int frameFinished = 0;
+        avcodec_decode_video2(cctx, frame, &frameFinished, &packet);
+        if (frameFinished) {
+            decodeNs += decodeTimer.nsecsElapsed();
+            ++decodedFrames;
+            if (trackDamage && isUnchangedScreen(frame)) {
+                av_frame_unref(frame);
+                ++unchangedFrames;
+            } else {
+                pushFrame(frame);
             }
-
-            VideoFrame* vframe = new VideoFrame(id, frame);
-            emit frameAvailable(vframe->trackFrame());
         }
 #else
-
-        // Forward packets to the decoder and grab the decoded frame
-        bool isVideo = packet.stream_index == videoStreamIndex;
-        bool readyToRecive = isVideo && !avcodec_send_packet(cctx, &packet);
-
-        if (readyToRecive) {
-            AVFrame* frame = av_frame_alloc();
-            if (frame && !avcodec_receive_frame(cctx, frame)) {
-                VideoFrame* vframe = new VideoFrame(id, frame);
-                emit frameAvailable(vframe->trackFrame());
-            } else {
-                av_frame_free(&frame);
+        // Forward packets to the decoder and grab all frames it has ready, with several
+        // decoder threads a packet can complete none or more than one frame
+        if (!avcodec_send_packet(cctx, &packet)) {
+            while (frame || (frame = av_frame_alloc())) {
+                if (avcodec_receive_frame(cctx, frame)) {
+                    break;
+                }
+
+                decodeNs += decodeTimer.nsecsElapsed();
+                ++decodedFrames;
+                if (trackDamage && isUnchangedScreen(frame)) {
+                    av_frame_unref(frame);
+                    ++unchangedFrames;
+                } else {
+                    pushFrame(frame);
+                }
+                decodeTimer.restart();
             }
         }
 #endif
@@ -464,4 +545,101 @@ void CameraSource::stream()
 
         streamLoop();
     }
+
+    {
+        QMutexLocker locker{&frameMutex};
+        delivering = false;
+        av_frame_free(&pendingFrame);
+        frameReady.wakeOne();
+    }
+    deliverFuture.waitForFinished();
+    av_frame_free(&frame);
+
+    const Stats stats = getStats();
+    qDebug() << "Camera stream decoded" << stats.decodedFrames << "frames in"
+             << stats.averageDecodeUs << "us on average," << stats.droppedFrames
+             << "frames dropped," << stats.unchangedFrames << "unchanged frames skipped";
+    damageTracker.reset();
+}
+
+/**
+ * @brief Checks if a captured screen frame shows the same picture as the previous one.
+ * @return True if the frame doesn't need to be converted and encoded again.
+ *
+ * Frames of packed pixel formats, which screen grabbers produce, are compared row by row.
+ * An unchanged frame is still delivered every screenRefreshMs.
+ */
+bool CameraSource::isUnchangedScreen(const AVFrame* frame)
+{
+    const AVPixelFormat format = static_cast<AVPixelFormat>(frame->format);
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(format);
+    if (!desc || (desc->flags & AV_PIX_FMT_FLAG_PLANAR)) {
+        return false;
+    }
+
+    const int rowBytes = av_image_get_linesize(format, frame->width, 0);
+    const bool changed = damageTracker.update(frame->data[0], frame->linesize[0], rowBytes, frame->height);
+    if (changed || !lastScreenRefresh.isValid() || lastScreenRefresh.hasExpired(screenRefreshMs)) {
+        lastScreenRefresh.start();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Makes a decoded frame the next one to emit.
+ * @param frame Decoded frame, replaced by the frame it displaces or nullptr.
+ *
+ * If the previous frame wasn't emitted yet, the consumers can't keep up with the camera.
+ * That frame is stale by now, it's dropped and its AVFrame is reused for decoding.
+ */
+void CameraSource::pushFrame(AVFrame*& frame)
+{
+    QMutexLocker locker{&frameMutex};
+    AVFrame* stale = pendingFrame;
+    pendingFrame = frame;
+    frame = stale;
+    if (stale) {
+        av_frame_unref(stale);
+        ++droppedFrames;
+    }
+
+    frameReady.wakeOne();
+}
+
+/**
+ * @brief Blocking. Emits the newest decoded frame whenever the previous one was consumed.
+ * @note Runs in its own thread while stream() is running, so slow consumers like the video
+ * encoder of a call don't hold back decoding.
+ */
+void CameraSource::deliverFrames()
+{
+    forever
+    {
+        AVFrame* frame;
+        {
+            QMutexLocker locker{&frameMutex};
+            while (delivering && !pendingFrame) {
+                frameReady.wait(&frameMutex);
+            }
+
+            if (!delivering) {
+                return;
+            }
+
+            frame = pendingFrame;
+            pendingFrame = nullptr;
+        }
+
+        // Frames are released when the device is closed, which needs the write lock
+        QReadLocker locker{&streamMutex};
+        if (!device) {
+            av_frame_free(&frame);
+            continue;
+        }
+
+        VideoFrame* vframe = new VideoFrame(id, frame);
+        emit frameAvailable(vframe->trackFrame());
+    }
 }
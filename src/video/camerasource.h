@@ -19,27 +19,45 @@
 
 #pragma once
 
+#include "src/video/framedamagetracker.h"
 #include "src/video/videomode.h"
 #include "src/video/videosource.h"
+#include <QElapsedTimer>
 #include <QFuture>
 #include <QHash>
+#include <QMutex>
 #include <QReadWriteLock>
 #include <QString>
+#include <QThreadPool>
 #include <QVector>
+#include <QWaitCondition>
 #include <atomic>
 
 class CameraDevice;
 struct AVCodecContext;
+struct AVFrame;
 
 class CameraSource : public VideoSource
 {
     Q_OBJECT
 
 public:
+    struct Stats
+    {
+        quint64 decodedFrames = 0;
+        quint64 droppedFrames = 0;
+        quint64 unchangedFrames = 0;
+        qint64 averageDecodeUs = 0;
+    };
+
+    static constexpr int maxAutoDecodeThreads = 4;
+    static constexpr qint64 screenRefreshMs = 1000;
+
     static CameraSource& getInstance();
     static void destroyInstance();
     void setupDefault();
     bool isNone() const;
+    Stats getStats() const;
 
     // VideoSource interface
     void subscribe() override;
@@ -56,6 +74,9 @@ private:
     CameraSource();
     ~CameraSource();
     void stream();
+    void pushFrame(AVFrame*& frame);
+    bool isUnchangedScreen(const AVFrame* frame);
+    void deliverFrames();
 
 private slots:
     void openDevice();
@@ -76,8 +97,22 @@ private:
     QReadWriteLock deviceMutex;
     QReadWriteLock streamMutex;
 
+    QMutex frameMutex;
+    QWaitCondition frameReady;
+    AVFrame* pendingFrame;
+    bool delivering;
+    // keeps deliverFrames off the global pool, where it would hold a thread while streaming
+    QThreadPool deliverPool;
+
+    FrameDamageTracker damageTracker;
+    QElapsedTimer lastScreenRefresh;
+
     std::atomic_bool _isNone;
     std::atomic_int subscriptions;
+    std::atomic<quint64> decodedFrames;
+    std::atomic<quint64> droppedFrames;
+    std::atomic<quint64> unchangedFrames;
+    std::atomic<qint64> decodeNs;
 
     static CameraSource* instance;
 };
@@ -0,0 +1,79 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "framedamagetracker.h"
+
+#include <cstddef>
+#include <cstring>
+
+/**
+ * @class FrameDamageTracker
+ * @brief Tells whether a frame changed since the previous frame.
+ *
+ * Keeps a copy of the last frame and compares new frames against it row by row. Only rows
+ * that changed are copied, so a static picture or a small change like a moving cursor costs
+ * little more than the comparison.
+ */
+
+/**
+ * @brief Compares a frame against the previous one and remembers it.
+ * @param data First row of the frame.
+ * @param linesize Distance between two rows in bytes.
+ * @param rowBytes Number of bytes of picture data in each row.
+ * @param height Number of rows.
+ * @return True if any row changed, always true if the frame size changed.
+ */
+bool FrameDamageTracker::update(const uint8_t* data, int linesize, int rowBytes, int height)
+{
+    if (rowBytes != this->rowBytes || height != this->height) {
+        this->rowBytes = rowBytes;
+        this->height = height;
+        previous.resize(static_cast<size_t>(rowBytes) * height);
+        for (int y = 0; y < height; ++y) {
+            memcpy(previous.data() + static_cast<size_t>(y) * rowBytes,
+                   data + static_cast<ptrdiff_t>(y) * linesize, rowBytes);
+        }
+
+        return true;
+    }
+
+    bool changed = false;
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* row = data + static_cast<ptrdiff_t>(y) * linesize;
+        uint8_t* previousRow = previous.data() + static_cast<size_t>(y) * rowBytes;
+        if (memcmp(row, previousRow, rowBytes)) {
+            memcpy(previousRow, row, rowBytes);
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+/**
+ * @brief Forgets the previous frame, the next frame counts as changed.
+ */
+void FrameDamageTracker::reset()
+{
+    previous.clear();
+    previous.shrink_to_fit();
+    rowBytes = 0;
+    height = 0;
+}
@@ -24,6 +24,16 @@ extern "C" {
 #include <libswscale/swscale.h>
 }
 
+namespace {
+struct SwsContextDeleter
+{
+    void operator()(SwsContext* ctx)
+    {
+        sws_freeContext(ctx);
+    }
+};
+} // namespace
+
 /**
  * @struct ToxYUVFrame
  * @brief A simple structure to represent a ToxYUV video frame (corresponds to a frame encoded
@@ -593,11 +603,16 @@ AVFrame* VideoFrame::generateAVFrame(const QSize& dimensions, const int pixelFor
     // Bilinear is better for shrinking, bicubic better for upscaling
     int resizeAlgo = sourceDimensions.width() > dimensions.width() ? SWS_BILINEAR : SWS_BICUBIC;
 
+    // Consecutive frames of a stream are converted the same way, so every thread keeps its last
+    // context around, sws_getCachedContext() only creates a new one when the parameters differ
+    thread_local std::unique_ptr<SwsContext, SwsContextDeleter> cachedSwsCtx;
     SwsContext* swsCtx =
-        sws_getContext(sourceDimensions.width(), sourceDimensions.height(),
-                       static_cast<AVPixelFormat>(sourcePixelFormat), dimensions.width(),
-                       dimensions.height(), static_cast<AVPixelFormat>(pixelFormat), resizeAlgo,
-                       nullptr, nullptr, nullptr);
+        sws_getCachedContext(cachedSwsCtx.release(), sourceDimensions.width(),
+                             sourceDimensions.height(), static_cast<AVPixelFormat>(sourcePixelFormat),
+                             dimensions.width(), dimensions.height(),
+                             static_cast<AVPixelFormat>(pixelFormat), resizeAlgo, nullptr, nullptr,
+                             nullptr);
+    cachedSwsCtx.reset(swsCtx);
 
     if (!swsCtx) {
         av_freep(&ret->data[0]);
@@ -612,7 +627,6 @@ AVFrame* VideoFrame::generateAVFrame(const QSize& dimensions, const int pixelFor
 
     sws_scale(swsCtx, source->data, source->linesize, 0, sourceDimensions.height(), ret->data,
               ret->linesize);
-    sws_freeContext(swsCtx);
 
     return ret;
 }
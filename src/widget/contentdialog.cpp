@@ -471,11 +471,12 @@ bool ContentDialog::event(QEvent* event)
 
 void ContentDialog::dragEnterEvent(QDragEnterEvent* event)
 {
-    QObject* o = event->source();
-    FriendWidget* frnd = qobject_cast<FriendWidget*>(o);
-    GroupWidget* group = qobject_cast<GroupWidget*>(o);
-    if (frnd) {
-        assert(event->mimeData()->hasFormat("toxPk"));
+    // Check, that the element is dragged from qTox
+    if (!event->source()) {
+        return;
+    }
+
+    if (event->mimeData()->hasFormat("toxPk")) {
         ToxPk toxPk{event->mimeData()->data("toxPk")};
         Friend* contact = FriendList::findFriend(toxPk);
         if (!contact) {
@@ -488,8 +489,7 @@ void ContentDialog::dragEnterEvent(QDragEnterEvent* event)
         if (!hasContact(friendId)) {
             event->acceptProposedAction();
         }
-    } else if (group) {
-        assert(event->mimeData()->hasFormat("groupId"));
+    } else if (event->mimeData()->hasFormat("groupId")) {
         GroupId groupId = GroupId{event->mimeData()->data("groupId")};
         Group* contact = GroupList::findGroup(groupId);
         if (!contact) {
@@ -504,11 +504,12 @@ void ContentDialog::dragEnterEvent(QDragEnterEvent* event)
 
 void ContentDialog::dropEvent(QDropEvent* event)
 {
-    QObject* o = event->source();
-    FriendWidget* frnd = qobject_cast<FriendWidget*>(o);
-    GroupWidget* group = qobject_cast<GroupWidget*>(o);
-    if (frnd) {
-        assert(event->mimeData()->hasFormat("toxPk"));
+    // Check, that the element is dragged from qTox
+    if (!event->source()) {
+        return;
+    }
+
+    if (event->mimeData()->hasFormat("toxPk")) {
         const ToxPk toxId(event->mimeData()->data("toxPk"));
         Friend* contact = FriendList::findFriend(toxId);
         if (!contact) {
@@ -517,8 +518,7 @@ void ContentDialog::dropEvent(QDropEvent* event)
 
         emit addFriendDialog(contact, this);
         ensureSplitterVisible();
-    } else if (group) {
-        assert(event->mimeData()->hasFormat("groupId"));
+    } else if (event->mimeData()->hasFormat("groupId")) {
         const GroupId groupId(event->mimeData()->data("groupId"));
         Group* contact = GroupList::findGroup(groupId);
         if (!contact) {
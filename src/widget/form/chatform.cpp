@@ -688,6 +688,7 @@ void ChatForm::reloadTheme()
 
 void ChatForm::showEvent(QShowEvent* event)
 {
+    emit avatarRequested(f->getPublicKey());
     GenericChatForm::showEvent(event);
 }
 
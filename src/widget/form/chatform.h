@@ -65,6 +65,7 @@ signals:
     void rejectCall(uint32_t friendId);
     void acceptCall(uint32_t friendId);
     void updateFriendActivity(Friend& frnd);
+    void avatarRequested(const ToxPk& friendPk);
 
 public slots:
     void onAvInvite(uint32_t friendId, bool video);
@@ -333,6 +333,8 @@ GenericChatForm::GenericChatForm(const Core& _core, const Contact* contact, ICha
     connect(searchForm, &SearchForm::searchDown, this, &GenericChatForm::onSearchDown);
     connect(searchForm, &SearchForm::visibleChanged, this, &GenericChatForm::onSearchTriggered);
     connect(this, &GenericChatForm::messageNotFoundShow, searchForm, &SearchForm::showMessageNotFound);
+    connect(&chatLogSearch, &ChatLogSearch::resultsUpdated, this, &GenericChatForm::onSearchResultsUpdated);
+    connect(&chatLogSearch, &ChatLogSearch::finished, this, &GenericChatForm::onSearchResultsUpdated);
 
     connect(&chatLog, &IChatLog::itemUpdated, this, &GenericChatForm::renderMessage);
 
@@ -918,6 +920,8 @@ void GenericChatForm::onSearchTriggered()
     if (searchForm->isHidden()) {
         searchResult.found = false;
         searchForm->removeSearchPhrase();
+        chatLogSearch.cancel();
+        searchPending = false;
     }
     disableSearchText();
 }
@@ -926,6 +930,8 @@ void GenericChatForm::searchInBegin(const QString& phrase, const ParameterSearch
 {
     if (phrase.isEmpty()) {
         disableSearchText();
+        chatLogSearch.cancel();
+        searchPending = false;
 
         return;
     }
@@ -969,23 +975,52 @@ void GenericChatForm::searchInBegin(const QString& phrase, const ParameterSearch
     }
     }
 
-    if (bForwardSearch) {
-        onSearchDown(phrase, parameter);
-    } else {
-        onSearchUp(phrase, parameter);
-    }
+    // A new phrase replaces the running search, matches are then looked up in its results
+    const auto direction = bForwardSearch ? SearchDirection::Down : SearchDirection::Up;
+    chatLogSearch.start(chatLog, phrase, parameter, direction);
+    findSearchResult(direction);
 }
 
 void GenericChatForm::onSearchUp(const QString& phrase, const ParameterSearch& parameter)
 {
-    auto result = chatLog.searchBackward(searchResult.pos, phrase, parameter);
-    handleSearchResult(result, SearchDirection::Up);
+    if (!chatLogSearch.isSearching(phrase, parameter)) {
+        chatLogSearch.start(chatLog, phrase, parameter, SearchDirection::Up);
+    }
+    findSearchResult(SearchDirection::Up);
 }
 
 void GenericChatForm::onSearchDown(const QString& phrase, const ParameterSearch& parameter)
 {
-    auto result = chatLog.searchForward(searchResult.pos, phrase, parameter);
-    handleSearchResult(result, SearchDirection::Down);
+    if (!chatLogSearch.isSearching(phrase, parameter)) {
+        chatLogSearch.start(chatLog, phrase, parameter, SearchDirection::Down);
+    }
+    findSearchResult(SearchDirection::Down);
+}
+
+/**
+ * @brief Jumps to the next match in the given direction, or waits for the background
+ * search to find it
+ */
+void GenericChatForm::findSearchResult(SearchDirection direction)
+{
+    // Checked first, so results that arrive in between are picked up on finished()
+    const bool wasRunning = chatLogSearch.isRunning();
+    const auto result = direction == SearchDirection::Up
+                            ? chatLogSearch.findPrevious(searchResult.pos)
+                            : chatLogSearch.findNext(searchResult.pos);
+
+    searchPending = !result.found && wasRunning;
+    pendingSearchDirection = direction;
+    if (!searchPending) {
+        handleSearchResult(result, direction);
+    }
+}
+
+void GenericChatForm::onSearchResultsUpdated()
+{
+    if (searchPending) {
+        findSearchResult(pendingSearchDirection);
+    }
 }
 
 void GenericChatForm::handleSearchResult(SearchResult result, SearchDirection direction)
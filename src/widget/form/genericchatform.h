@@ -21,6 +21,7 @@
 
 #include "src/chatlog/chatmessage.h"
 #include "src/core/toxpk.h"
+#include "src/model/chatlogsearch.h"
 #include "src/model/ichatlog.h"
 #include "src/widget/form/loadhistorydialog.h"
 #include "src/widget/searchtypes.h"
@@ -115,6 +116,7 @@ protected slots:
     void searchInBegin(const QString& phrase, const ParameterSearch& parameter);
     void onSearchUp(const QString& phrase, const ParameterSearch& parameter);
     void onSearchDown(const QString& phrase, const ParameterSearch& parameter);
+    void onSearchResultsUpdated();
     void handleSearchResult(SearchResult result, SearchDirection direction);
     void renderMessage(ChatLogIdx idx);
     void renderMessages(ChatLogIdx begin, ChatLogIdx end,
@@ -150,6 +152,7 @@ protected:
     void disableSearchText();
     void enableSearchText();
     bool searchInText(const QString& phrase, const ParameterSearch& parameter, SearchDirection direction);
+    void findSearchResult(SearchDirection direction);
     std::pair<int, int> indexForSearchInLine(const QString& txt, const QString& phrase, const ParameterSearch& parameter, SearchDirection direction);
 
 protected:
@@ -190,6 +193,10 @@ protected:
     IChatLog& chatLog;
     IMessageDispatcher& messageDispatcher;
     SearchResult searchResult;
+    ChatLogSearch chatLogSearch;
+    // Set while waiting for the background search to reach the next match
+    bool searchPending = false;
+    SearchDirection pendingSearchDirection = SearchDirection::Up;
     std::map<ChatLogIdx, ChatMessage::Ptr> messages;
     bool colorizeNames = false;
 };
@@ -186,30 +186,9 @@ void GroupChatForm::updateUserNames()
     /* we store the peer labels by their ToxPk, but the namelist layout
      * needs it in alphabetical order, so we first create and store the labels
      * and then sort them by their text and add them to the layout in that order */
-    const auto selfPk = core.getSelfPublicKey();
+    const auto blockedPeers = Settings::getInstance().getPeerBlackList().getPeers();
     for (const auto& peerPk : peers.keys()) {
-        const QString peerName = peers.value(peerPk);
-        const QString editedName = editName(peerName);
-        QLabel* const label = new QLabel(editedName + QLatin1String(", "));
-        if (editedName != peerName) {
-            label->setToolTip(peerName + " (" + peerPk.toString() + ")");
-        } else if (peerName != peerPk.toString()) {
-            label->setToolTip(peerPk.toString());
-        } // else their name is just their Pk, no tooltip needed
-        label->setTextFormat(Qt::PlainText);
-        label->setContextMenuPolicy(Qt::CustomContextMenu);
-
-        const Settings& s = Settings::getInstance();
-        connect(label, &QLabel::customContextMenuRequested, this, &GroupChatForm::onLabelContextMenuRequested);
-
-        if (peerPk == selfPk) {
-            label->setProperty("peerType", LABEL_PEER_TYPE_OUR);
-        } else if (s.getBlackList().contains(peerPk.toString())) {
-            label->setProperty("peerType", LABEL_PEER_TYPE_MUTED);
-        }
-
-        label->setStyleSheet(Style::getStylesheet(PEER_LABEL_STYLE_SHEET_PATH));
-        peerLabels.insert(peerPk, label);
+        peerLabels.insert(peerPk, createPeerLabel(peerPk, peers.value(peerPk), *blockedPeers));
     }
 
     // add the labels in alphabetical order into the layout
@@ -220,32 +199,128 @@ void GroupChatForm::updateUserNames()
         return a->text().toLower() < b->text().toLower();
     });
 
-    // remove comma from last sorted label
-    QLabel* const lastLabel = nickLabelList.last();
-    QString labelText = lastLabel->text();
-    labelText.chop(2);
-    lastLabel->setText(labelText);
     for (QLabel* l : nickLabelList) {
         namesListLayout->addWidget(l);
     }
+    updatePeerLabelSeparators();
+}
+
+/**
+ * @brief Creates the label of a peer for the names list, its text ends with a separator
+ */
+QLabel* GroupChatForm::createPeerLabel(const ToxPk& peerPk, const QString& peerName,
+                                       const PeerBlackList::Peers& blockedPeers)
+{
+    const QString editedName = editName(peerName);
+    QLabel* const label = new QLabel(editedName + QLatin1String(", "));
+    if (editedName != peerName) {
+        label->setToolTip(peerName + " (" + peerPk.toString() + ")");
+    } else if (peerName != peerPk.toString()) {
+        label->setToolTip(peerPk.toString());
+    } // else their name is just their Pk, no tooltip needed
+    label->setTextFormat(Qt::PlainText);
+    label->setContextMenuPolicy(Qt::CustomContextMenu);
+
+    connect(label, &QLabel::customContextMenuRequested, this, &GroupChatForm::onLabelContextMenuRequested);
+
+    if (peerPk == core.getSelfPublicKey()) {
+        label->setProperty("peerType", LABEL_PEER_TYPE_OUR);
+    } else if (blockedPeers.contains(peerPk)) {
+        label->setProperty("peerType", LABEL_PEER_TYPE_MUTED);
+    }
+
+    label->setStyleSheet(Style::getStylesheet(PEER_LABEL_STYLE_SHEET_PATH));
+    return label;
+}
+
+/**
+ * @brief Inserts the label of a single peer at its alphabetical position
+ */
+void GroupChatForm::addPeerLabel(const ToxPk& peerPk, const QString& peerName)
+{
+    removePeerLabel(peerPk);
+
+    const auto blockedPeers = Settings::getInstance().getPeerBlackList().getPeers();
+    QLabel* const label = createPeerLabel(peerPk, peerName, *blockedPeers);
+    peerLabels.insert(peerPk, label);
+
+    // the layout is sorted, the separator of the last label doesn't change the order
+    const QString key = label->text().toLower();
+    int low = 0;
+    int high = namesListLayout->count();
+    while (low < high) {
+        const int mid = (low + high) / 2;
+        QString text = static_cast<QLabel*>(namesListLayout->itemAt(mid)->widget())->text();
+        if (!text.endsWith(QLatin1String(", "))) {
+            text += QLatin1String(", ");
+        }
+        if (text.toLower() < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    namesListLayout->insertWidget(low, label);
+    updatePeerLabelSeparators();
+}
+
+/**
+ * @brief Removes the label of a single peer, if it has one
+ */
+void GroupChatForm::removePeerLabel(const ToxPk& peerPk)
+{
+    QLabel* const label = peerLabels.take(peerPk);
+    if (!label) {
+        return;
+    }
+
+    delete namesListLayout->takeAt(namesListLayout->indexOf(label));
+    label->hide();
+    delete label;
+    updatePeerLabelSeparators();
+}
+
+/**
+ * @brief Separates all labels by a comma, except for the last one
+ */
+void GroupChatForm::updatePeerLabelSeparators()
+{
+    const QLatin1String separator{", "};
+    const int count = namesListLayout->count();
+    if (count >= 2) {
+        QLabel* const label = static_cast<QLabel*>(namesListLayout->itemAt(count - 2)->widget());
+        if (!label->text().endsWith(separator)) {
+            label->setText(label->text() + separator);
+        }
+    }
+
+    if (count >= 1) {
+        QLabel* const label = static_cast<QLabel*>(namesListLayout->itemAt(count - 1)->widget());
+        if (label->text().endsWith(separator)) {
+            QString text = label->text();
+            text.chop(2);
+            label->setText(text);
+        }
+    }
 }
 
 void GroupChatForm::onUserJoined(const ToxPk& user, const QString& name)
 {
     addSystemInfoMessage(tr("%1 has joined the group").arg(name), ChatMessage::INFO, QDateTime::currentDateTime());
-    updateUserNames();
+    addPeerLabel(user, name);
 }
 
 void GroupChatForm::onUserLeft(const ToxPk& user, const QString& name)
 {
     addSystemInfoMessage(tr("%1 has left the group").arg(name), ChatMessage::INFO, QDateTime::currentDateTime());
-    updateUserNames();
+    removePeerLabel(user);
 }
 
 void GroupChatForm::onPeerNameChanged(const ToxPk& peer, const QString& oldName, const QString& newName)
 {
     addSystemInfoMessage(tr("%1 is now known as %2").arg(oldName, newName), ChatMessage::INFO, QDateTime::currentDateTime());
-    updateUserNames();
+    addPeerLabel(peer, newName);
 }
 
 void GroupChatForm::peerAudioPlaying(ToxPk peerPk)
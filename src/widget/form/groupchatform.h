@@ -21,6 +21,7 @@
 
 #include "genericchatform.h"
 #include "src/core/toxpk.h"
+#include "src/persistence/peerblacklist.h"
 #include <QMap>
 
 namespace Ui {
@@ -66,6 +67,11 @@ private:
     void retranslateUi();
     void updateUserCount(int numPeers);
     void updateUserNames();
+    QLabel* createPeerLabel(const ToxPk& peerPk, const QString& peerName,
+                            const PeerBlackList::Peers& blockedPeers);
+    void addPeerLabel(const ToxPk& peerPk, const QString& peerName);
+    void removePeerLabel(const ToxPk& peerPk);
+    void updatePeerLabelSeparators();
     void joinGroupCall();
     void leaveGroupCall();
 
@@ -0,0 +1,133 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "friendcontextmenu.h"
+
+#include "src/model/chatroom/friendchatroom.h"
+
+#include <QCoreApplication>
+#include <QFileDialog>
+
+/**
+ * @class FriendContextMenu
+ * @brief Context menu of a friend, shared by the contact list and content dialogs.
+ *
+ * Actions only involving the friend chatroom are handled here, the others are signals for the
+ * owner of the menu.
+ */
+
+FriendContextMenu::FriendContextMenu(std::shared_ptr<FriendChatroom> chatroom, QWidget* parent)
+    : QMenu(parent)
+    , chatroom{chatroom}
+{
+    // The entries keep the FriendWidget context, which the translations have them under
+    if (chatroom->possibleToOpenInNewWindow()) {
+        const auto openChatWindow =
+            addAction(QCoreApplication::translate("FriendWidget", "Open chat in new window"));
+        connect(openChatWindow, &QAction::triggered, this, &FriendContextMenu::newWindowRequested);
+    }
+
+    if (chatroom->canBeRemovedFromWindow()) {
+        const auto removeChatWindow =
+            addAction(QCoreApplication::translate("FriendWidget", "Remove chat from this window"));
+        connect(removeChatWindow, &QAction::triggered, chatroom.get(),
+                &FriendChatroom::removeFriendFromDialogs);
+    }
+
+    addSeparator();
+    QMenu* inviteMenu = addMenu(QCoreApplication::translate(
+        "FriendWidget", "Invite to group", "Menu to invite a friend to a groupchat"));
+    inviteMenu->setEnabled(chatroom->canBeInvited());
+    const auto newGroupAction =
+        inviteMenu->addAction(QCoreApplication::translate("FriendWidget", "To new group"));
+    connect(newGroupAction, &QAction::triggered, chatroom.get(), &FriendChatroom::inviteToNewGroup);
+    inviteMenu->addSeparator();
+
+    for (const auto& group : chatroom->getGroups()) {
+        const auto groupAction = inviteMenu->addAction(
+            QCoreApplication::translate("FriendWidget", "Invite to group '%1'").arg(group.name));
+        connect(groupAction, &QAction::triggered, [=]() { chatroom->inviteFriend(group.group); });
+    }
+
+    const auto circleId = chatroom->getCircleId();
+    auto circleMenu =
+        addMenu(QCoreApplication::translate("FriendWidget", "Move to circle...",
+                                            "Menu to move a friend into a different circle"));
+
+    const auto newCircleAction =
+        circleMenu->addAction(QCoreApplication::translate("FriendWidget", "To new circle"));
+    connect(newCircleAction, &QAction::triggered, this,
+            &FriendContextMenu::moveToNewCircleRequested);
+
+    if (circleId != -1) {
+        const auto circleName = chatroom->getCircleName();
+        const auto removeCircleAction = circleMenu->addAction(
+            QCoreApplication::translate("FriendWidget", "Remove from circle '%1'").arg(circleName));
+        connect(removeCircleAction, &QAction::triggered, this,
+                [this]() { emit moveToCircleRequested(-1); });
+    }
+
+    circleMenu->addSeparator();
+
+    for (const auto& circle : chatroom->getOtherCircles()) {
+        QAction* action = new QAction(
+            QCoreApplication::translate("FriendWidget", "Move to circle \"%1\"").arg(circle.name),
+            circleMenu);
+        connect(action, &QAction::triggered, this,
+                [this, circle]() { emit moveToCircleRequested(circle.circleId); });
+        circleMenu->addAction(action);
+    }
+
+    const auto setAlias = addAction(QCoreApplication::translate("FriendWidget", "Set alias..."));
+    connect(setAlias, &QAction::triggered, this, &FriendContextMenu::aliasEditRequested);
+
+    addSeparator();
+    auto autoAccept = addAction(QCoreApplication::translate(
+        "FriendWidget", "Auto accept files from this friend", "context menu entry"));
+    autoAccept->setCheckable(true);
+    autoAccept->setChecked(!chatroom->autoAcceptEnabled());
+    connect(autoAccept, &QAction::triggered, this, &FriendContextMenu::changeAutoAccept);
+    addSeparator();
+
+    if (chatroom->friendCanBeRemoved()) {
+        const auto removeAction = addAction(QCoreApplication::translate(
+            "FriendWidget", "Remove friend", "Menu to remove the friend from the friend list"));
+        connect(removeAction, &QAction::triggered, this, &FriendContextMenu::removeFriendRequested);
+    }
+
+    addSeparator();
+    const auto aboutWindow = addAction(QCoreApplication::translate("FriendWidget", "Show details"));
+    connect(aboutWindow, &QAction::triggered, this, &FriendContextMenu::detailsRequested);
+}
+
+void FriendContextMenu::changeAutoAccept(bool enable)
+{
+    if (enable) {
+        const auto oldDir = chatroom->getAutoAcceptDir();
+        const auto newDir = QFileDialog::getExistingDirectory(
+            Q_NULLPTR,
+            QCoreApplication::translate("FriendWidget", "Choose an auto accept directory",
+                                        "popup title"),
+            oldDir);
+        chatroom->setAutoAcceptDir(newDir);
+    } else {
+        chatroom->disableAutoAccept();
+    }
+}
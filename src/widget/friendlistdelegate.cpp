@@ -0,0 +1,290 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "friendlistdelegate.h"
+
+#include "friendlistwidget.h"
+#include "src/model/friendlistmodel.h"
+#include "src/widget/style.h"
+
+#include <QFontMetrics>
+#include <QLineEdit>
+#include <QPainter>
+
+#include <algorithm>
+
+/**
+ * @class FriendListDelegate
+ * @brief Paints the rows of the contact list.
+ *
+ * Contacts are drawn like the chatroom widgets of content dialogs, sections like their header.
+ * Only the rows in the viewport are painted, and avatars are asked to the view, which loads them
+ * the first time they are needed.
+ */
+
+namespace {
+const int CONTACT_HEIGHT = 55;
+const int COMPACT_CONTACT_HEIGHT = 25;
+const int SECTION_HEIGHT = 25;
+const int AVATAR_SIZE = 40;
+const int COMPACT_AVATAR_SIZE = 20;
+
+int textWidth(const QFontMetrics& metrics, const QString& text)
+{
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 11, 0))
+    return metrics.horizontalAdvance(text);
+#else
+    return metrics.width(text);
+#endif
+}
+
+/**
+ * @brief Draws text on one line, elided to fit the rectangle.
+ * @return Width actually used by the text.
+ */
+int drawElidedText(QPainter* painter, const QRect& rect, const QFont& font, const QColor& color,
+                   const QString& text)
+{
+    if (rect.width() <= 0) {
+        return 0;
+    }
+
+    const QFontMetrics metrics{font};
+    QString line = text;
+    line.replace(QLatin1Char('\n'), QLatin1Char(' '));
+    const QString elided = metrics.elidedText(line, Qt::ElideRight, rect.width());
+
+    painter->setFont(font);
+    painter->setPen(color);
+    painter->drawText(rect, Qt::AlignLeft | Qt::AlignAbsolute | Qt::AlignVCenter | Qt::TextSingleLine, elided);
+    return std::min(textWidth(metrics, elided), rect.width());
+}
+} // namespace
+
+FriendListDelegate::FriendListDelegate(FriendListWidget* view)
+    : QStyledItemDelegate(view)
+    , view{view}
+{
+}
+
+void FriendListDelegate::setCompact(bool compact)
+{
+    this->compact = compact;
+}
+
+bool FriendListDelegate::isCompact() const
+{
+    return compact;
+}
+
+void FriendListDelegate::reloadTheme()
+{
+    pixmaps.clear();
+}
+
+void FriendListDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option,
+                               const QModelIndex& index) const
+{
+    painter->save();
+    painter->setRenderHint(QPainter::SmoothPixmapTransform);
+    painter->setClipRect(option.rect);
+
+    if (isSection(index)) {
+        paintSection(painter, option, index);
+    } else {
+        paintContact(painter, option, index);
+    }
+
+    painter->restore();
+}
+
+QSize FriendListDelegate::sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+    Q_UNUSED(option)
+
+    // Constant heights, the view asks them for every row to size its scroll bar
+    if (isSection(index)) {
+        return {0, SECTION_HEIGHT};
+    }
+
+    return {0, compact ? COMPACT_CONTACT_HEIGHT : CONTACT_HEIGHT};
+}
+
+QWidget* FriendListDelegate::createEditor(QWidget* parent, const QStyleOptionViewItem& option,
+                                          const QModelIndex& index) const
+{
+    Q_UNUSED(option)
+    Q_UNUSED(index)
+
+    QLineEdit* editor = new QLineEdit(parent);
+    // The view is right to left to keep its scroll bar on the left
+    editor->setLayoutDirection(Qt::LeftToRight);
+    editor->setFrame(false);
+    return editor;
+}
+
+void FriendListDelegate::updateEditorGeometry(QWidget* editor, const QStyleOptionViewItem& option,
+                                              const QModelIndex& index) const
+{
+    int left;
+    if (isSection(index)) {
+        left = 18 + getArrow(true).width() + 5;
+    } else if (compact) {
+        left = 18 + COMPACT_AVATAR_SIZE + 5;
+    } else {
+        left = 20 + AVATAR_SIZE + 10;
+    }
+
+    const int height = editor->sizeHint().height();
+    QRect rect = option.rect;
+    rect.setLeft(rect.left() + left);
+    rect.setRight(rect.right() - 10);
+    rect.setTop(rect.top() + (option.rect.height() - height) / 2);
+    rect.setHeight(height);
+    editor->setGeometry(rect);
+}
+
+void FriendListDelegate::paintContact(QPainter* painter, const QStyleOptionViewItem& option,
+                                      const QModelIndex& index) const
+{
+    const bool active = index.data(FriendListModel::ActiveRole).toBool();
+    QColor background = Style::getColor(Style::ThemeMedium);
+    if (active) {
+        background = Style::getColor(Style::GroundBase);
+    } else if (isHighlighted(option, index)) {
+        background = Style::getColor(Style::ThemeLight);
+    }
+
+    const QRect& rect = option.rect;
+    painter->fillRect(rect, background);
+
+    const int avatarSize = compact ? COMPACT_AVATAR_SIZE : AVATAR_SIZE;
+    const QRect avatarRect{rect.left() + (compact ? 18 : 20),
+                           rect.top() + (rect.height() - avatarSize) / 2, avatarSize, avatarSize};
+    const Contact* contact = static_cast<const FriendListModel*>(index.model())->getContact(index);
+    painter->drawPixmap(avatarRect, view->getAvatar(contact, active));
+
+    const int spacing = compact ? 5 : 10;
+    const bool event = index.data(FriendListModel::EventRole).toBool();
+    const auto status = static_cast<Status::Status>(index.data(FriendListModel::StatusRole).toInt());
+    const QPixmap& statusIcon = getStatusIcon(status, event);
+    const int iconMargin = event ? 1 : 3;
+    const int iconLeft = rect.right() + 1 - spacing - iconMargin - statusIcon.width();
+    painter->drawPixmap(iconLeft, rect.top() + (rect.height() - statusIcon.height()) / 2, statusIcon);
+
+    const QColor nameColor = active ? Style::getColor(Style::NameActive) : view->getNameColor();
+    const QColor statusColor = Style::getColor(active ? Style::StatusActive : Style::GroundExtra);
+    const QString name = index.data(Qt::DisplayRole).toString();
+    const QString statusMessage = index.data(FriendListModel::StatusMessageRole).toString();
+    const int textLeft = avatarRect.right() + 1 + (compact ? 5 : 10);
+    const int textRight = iconLeft - iconMargin - spacing;
+
+    if (compact) {
+        const QRect textRect{QPoint{textLeft, rect.top()}, QPoint{textRight, rect.bottom()}};
+        const int nameWidth = drawElidedText(painter, textRect, Style::getFont(Style::Medium),
+                                             nameColor, name);
+        QRect statusRect = textRect;
+        statusRect.setLeft(textLeft + nameWidth + 5);
+        drawElidedText(painter, statusRect, Style::getFont(Style::Small), statusColor, statusMessage);
+        return;
+    }
+
+    const QFont nameFont = Style::getFont(Style::Big);
+    const QFont statusFont = Style::getFont(Style::Medium);
+    const int nameHeight = QFontMetrics{nameFont}.height();
+    const int statusHeight = QFontMetrics{statusFont}.height();
+    const int top = rect.top() + (rect.height() - nameHeight - statusHeight) / 2;
+    const int width = textRight - textLeft + 1;
+    drawElidedText(painter, {textLeft, top, width, nameHeight}, nameFont, nameColor, name);
+    drawElidedText(painter, {textLeft, top + nameHeight, width, statusHeight}, statusFont,
+                   statusColor, statusMessage);
+}
+
+void FriendListDelegate::paintSection(QPainter* painter, const QStyleOptionViewItem& option,
+                                      const QModelIndex& index) const
+{
+    const QRect& rect = option.rect;
+    const QColor background =
+        Style::getColor(isHighlighted(option, index) ? Style::ThemeLight : Style::ThemeMedium);
+    painter->fillRect(rect, background);
+
+    const bool expanded = index.data(FriendListModel::ExpandedRole).toBool();
+    const QPixmap& arrow = getArrow(expanded);
+    const int arrowLeft = rect.left() + 18;
+    painter->drawPixmap(arrowLeft, rect.top() + (rect.height() - arrow.height()) / 2, arrow);
+
+    const QFont countFont = Style::getFont(Style::Small);
+    const QString count = QString::number(index.data(FriendListModel::OnlineCountRole).toInt())
+                          + QStringLiteral(" / ")
+                          + QString::number(index.data(FriendListModel::TotalCountRole).toInt());
+    const int countWidth = textWidth(QFontMetrics{countFont}, count);
+    const int countLeft = rect.right() + 1 - 5 - countWidth;
+    drawElidedText(painter, {countLeft, rect.top(), countWidth, rect.height()}, countFont,
+                   view->getSectionCountColor(), count);
+
+    const int nameLeft = arrowLeft + arrow.width() + 5;
+    const QRect nameRect{QPoint{nameLeft, rect.top()}, QPoint{countLeft - 5 - 1, rect.bottom()}};
+    const int nameWidth = drawElidedText(painter, nameRect, Style::getFont(Style::Big),
+                                         view->getSectionNameColor(),
+                                         index.data(Qt::DisplayRole).toString());
+
+    const int lineLeft = nameLeft + nameWidth;
+    if (lineLeft < nameRect.right()) {
+        const int y = rect.top() + rect.height() / 2;
+        painter->setPen(view->getSectionLineColor());
+        painter->drawLine(lineLeft, y, nameRect.right(), y);
+    }
+}
+
+bool FriendListDelegate::isSection(const QModelIndex& index) const
+{
+    const auto type = static_cast<FriendListModel::ItemType>(
+        index.data(FriendListModel::ItemTypeRole).toInt());
+    return type == FriendListModel::ItemType::Circle || type == FriendListModel::ItemType::Category;
+}
+
+bool FriendListDelegate::isHighlighted(const QStyleOptionViewItem& option,
+                                       const QModelIndex& index) const
+{
+    return option.state & QStyle::State_MouseOver || view->getDropIndex() == index;
+}
+
+const QPixmap& FriendListDelegate::getStatusIcon(Status::Status status, bool event) const
+{
+    const QString path = Status::getIconPath(status, event);
+    auto it = pixmaps.find(path);
+    if (it == pixmaps.end()) {
+        it = pixmaps.insert(path, QPixmap{path});
+    }
+
+    return *it;
+}
+
+const QPixmap& FriendListDelegate::getArrow(bool expanded) const
+{
+    const QString path = Style::getImagePath(expanded ? "chatArea/scrollBarDownArrow.svg"
+                                                      : "chatArea/scrollBarRightArrow.svg");
+    auto it = pixmaps.find(path);
+    if (it == pixmaps.end()) {
+        it = pixmaps.insert(path, QPixmap{path});
+    }
+
+    return *it;
+}
@@ -0,0 +1,62 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "src/model/status.h"
+
+#include <QHash>
+#include <QPixmap>
+#include <QStyledItemDelegate>
+
+class FriendListWidget;
+
+class FriendListDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+public:
+    explicit FriendListDelegate(FriendListWidget* view);
+
+    void setCompact(bool compact);
+    bool isCompact() const;
+    void reloadTheme();
+
+    void paint(QPainter* painter, const QStyleOptionViewItem& option,
+               const QModelIndex& index) const override;
+    QSize sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+    QWidget* createEditor(QWidget* parent, const QStyleOptionViewItem& option,
+                          const QModelIndex& index) const override;
+    void updateEditorGeometry(QWidget* editor, const QStyleOptionViewItem& option,
+                              const QModelIndex& index) const override;
+
+private:
+    void paintContact(QPainter* painter, const QStyleOptionViewItem& option,
+                      const QModelIndex& index) const;
+    void paintSection(QPainter* painter, const QStyleOptionViewItem& option,
+                      const QModelIndex& index) const;
+    bool isSection(const QModelIndex& index) const;
+    bool isHighlighted(const QStyleOptionViewItem& option, const QModelIndex& index) const;
+    const QPixmap& getStatusIcon(Status::Status status, bool event) const;
+    const QPixmap& getArrow(bool expanded) const;
+
+    FriendListWidget* view;
+    bool compact = false;
+    mutable QHash<QString, QPixmap> pixmaps;
+};
@@ -18,7 +18,6 @@
 */
 
 #include "friendlistlayout.h"
-#include "friendlistwidget.h"
 #include "friendwidget.h"
 #include "src/model/friend.h"
 #include "src/model/status.h"
@@ -73,6 +72,13 @@ void FriendListLayout::removeFriendWidget(FriendWidget* widget, Status::Status s
         friendOnlineLayout.removeSortedWidget(widget);
 }
 
+bool FriendListLayout::containsFriendWidget(GenericChatItemWidget* widget, Status::Status s) const
+{
+    if (s == Status::Status::Offline)
+        return friendOfflineLayout.existsSortedWidget(widget);
+    return friendOnlineLayout.existsSortedWidget(widget);
+}
+
 int FriendListLayout::indexOfFriendWidget(GenericChatItemWidget* widget, bool online) const
 {
     if (online)
@@ -80,24 +86,6 @@ int FriendListLayout::indexOfFriendWidget(GenericChatItemWidget* widget, bool on
     return friendOfflineLayout.indexOfSortedWidget(widget);
 }
 
-void FriendListLayout::moveFriendWidgets(FriendListWidget* listWidget)
-{
-    while (!friendOnlineLayout.getLayout()->isEmpty()) {
-        QWidget* getWidget = friendOnlineLayout.getLayout()->takeAt(0)->widget();
-
-        FriendWidget* friendWidget = qobject_cast<FriendWidget*>(getWidget);
-        const Friend* f = friendWidget->getFriend();
-        listWidget->moveWidget(friendWidget, f->getStatus(), true);
-    }
-    while (!friendOfflineLayout.getLayout()->isEmpty()) {
-        QWidget* getWidget = friendOfflineLayout.getLayout()->takeAt(0)->widget();
-
-        FriendWidget* friendWidget = qobject_cast<FriendWidget*>(getWidget);
-        const Friend* f = friendWidget->getFriend();
-        listWidget->moveWidget(friendWidget, f->getStatus(), true);
-    }
-}
-
 int FriendListLayout::friendOnlineCount() const
 {
     return friendOnlineLayout.getLayout()->count();
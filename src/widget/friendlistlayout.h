@@ -25,7 +25,6 @@
 #include <QBoxLayout>
 
 class FriendWidget;
-class FriendListWidget;
 
 class FriendListLayout : public QVBoxLayout
 {
@@ -36,8 +35,8 @@ public:
 
     void addFriendWidget(FriendWidget* widget, Status::Status s);
     void removeFriendWidget(FriendWidget* widget, Status::Status s);
+    bool containsFriendWidget(GenericChatItemWidget* widget, Status::Status s) const;
     int indexOfFriendWidget(GenericChatItemWidget* widget, bool online) const;
-    void moveFriendWidgets(FriendListWidget* listWidget);
     int friendOnlineCount() const;
     int friendTotalCount() const;
 
@@ -17,714 +17,933 @@
     along with qTox.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+
 #include "friendlistwidget.h"
-#include "circlewidget.h"
-#include "friendlistlayout.h"
-#include "friendwidget.h"
-#include "groupwidget.h"
-#include "widget.h"
+#include "friendcontextmenu.h"
+#include "friendlistdelegate.h"
+#include "notificationedgewidget.h"
+#include "style.h"
+#include "translator.h"
 #include "src/friendlist.h"
+#include "src/model/about/aboutfriend.h"
+#include "src/model/chatroom/friendchatroom.h"
+#include "src/model/chatroom/groupchatroom.h"
 #include "src/model/friend.h"
 #include "src/model/group.h"
-#include "src/model/status.h"
 #include "src/persistence/settings.h"
-#include "src/widget/categorywidget.h"
+#include "src/widget/about/aboutfriendform.h"
 
+#include <QApplication>
+#include <QContextMenuEvent>
+#include <QDrag>
 #include <QDragEnterEvent>
 #include <QDragLeaveEvent>
-#include <QGridLayout>
+#include <QMenu>
 #include <QMimeData>
-#include <QTimer>
+#include <QPainter>
+#include <QScrollBar>
 #include <cassert>
 
-enum class Time
-{
-    Today,
-    Yesterday,
-    ThisWeek,
-    ThisMonth,
-    Month1Ago,
-    Month2Ago,
-    Month3Ago,
-    Month4Ago,
-    Month5Ago,
-    LongAgo,
-    Never
-};
-
-static const int LAST_TIME = static_cast<int>(Time::Never);
-
-Time getTimeBucket(const QDateTime& date)
-{
-    if (date == QDateTime()) {
-        return Time::Never;
-    }
-
-    QDate today = QDate::currentDate();
-    // clang-format off
-    const QMap<Time, QDate> dates {
-        { Time::Today,     today.addDays(0)    },
-        { Time::Yesterday, today.addDays(-1)   },
-        { Time::ThisWeek,  today.addDays(-6)   },
-        { Time::ThisMonth, today.addMonths(-1) },
-        { Time::Month1Ago, today.addMonths(-2) },
-        { Time::Month2Ago, today.addMonths(-3) },
-        { Time::Month3Ago, today.addMonths(-4) },
-        { Time::Month4Ago, today.addMonths(-5) },
-        { Time::Month5Ago, today.addMonths(-6) },
-    };
-    // clang-format on
-
-    for (Time time : dates.keys()) {
-        if (dates[time] <= date.date()) {
-            return time;
-        }
+/**
+ * @class FriendListWidget
+ * @brief View of the contact list of the main window.
+ *
+ * Contacts, circles and activity categories live in a FriendListModel, FriendListDelegate paints
+ * the rows, so only the visible rows cost anything regardless of the number of contacts. The view
+ * handles everything the chatroom widgets used to: activation, context menus, drag and drop,
+ * avatars and the notification edges for contacts scrolled out of sight.
+ */
+
+namespace {
+const int AVATAR_SIZE = 40;
+const QString AVATAR_MASK = QStringLiteral(":/img/avatar_mask.svg");
+}
+
+FriendListWidget::FriendListWidget(QWidget* parent)
+    : QTreeView(parent)
+    , model{new FriendListModel(Settings::getInstance(), Settings::getInstance(), this)}
+    , delegate{new FriendListDelegate(this)}
+    , nameColor{Style::getColor(Style::GroundBase)}
+    , sectionNameColor{Style::getColor(Style::GroundBase)}
+    , sectionCountColor{Style::getColor(Style::GroundExtra)}
+    , sectionLineColor{Qt::white}
+{
+    const Settings& s = Settings::getInstance();
+    model->setMode(s.getFriendSortingMode());
+    model->setGroupsOnTop(s.getGroupchatPosition());
+    model->setLocale(QLocale(s.getTranslation()));
+    delegate->setCompact(s.getCompactLayout());
+
+    setModel(model);
+    setItemDelegate(delegate);
+    setRootIsDecorated(false);
+    setIndentation(0);
+    setHeaderHidden(true);
+    setUniformRowHeights(false);
+    setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    setSelectionMode(QAbstractItemView::NoSelection);
+    setEditTriggers(QAbstractItemView::NoEditTriggers);
+    setExpandsOnDoubleClick(false);
+    setFocusPolicy(Qt::NoFocus);
+    setFrameShape(QFrame::NoFrame);
+    setMouseTracking(true);
+    // The scroll bar goes left in the main window, the rows are never mirrored
+    viewport()->setLayoutDirection(Qt::LeftToRight);
+    viewport()->setAttribute(Qt::WA_Hover);
+    setAcceptDrops(true);
+    viewport()->setAcceptDrops(true);
+
+    connect(model, &QAbstractItemModel::layoutChanged, this, &FriendListWidget::syncExpansion);
+    connect(model, &QAbstractItemModel::modelReset, this, &FriendListWidget::syncExpansion);
+    connect(model, &QAbstractItemModel::rowsInserted, this, &FriendListWidget::onRowsInserted);
+    // The model may still be halfway through an update while it emits row changes
+    connect(model, &QAbstractItemModel::rowsInserted, this, &FriendListWidget::updateVisualTracking,
+            Qt::QueuedConnection);
+    connect(model, &QAbstractItemModel::rowsRemoved, this, &FriendListWidget::updateVisualTracking,
+            Qt::QueuedConnection);
+    connect(verticalScrollBar(), &QAbstractSlider::valueChanged, this,
+            &FriendListWidget::updateVisualTracking);
+    connect(verticalScrollBar(), &QAbstractSlider::rangeChanged, this,
+            &FriendListWidget::updateVisualTracking);
+
+    syncExpansion();
+    Translator::registerHandler(std::bind(&FriendListWidget::retranslateUi, this), this);
+}
+
+FriendListWidget::~FriendListWidget()
+{
+    Translator::unregister(this);
+}
+
+void FriendListWidget::setMode(SortingMode mode)
+{
+    if (model->getMode() == mode) {
+        return;
     }
 
-    return Time::LongAgo;
+    Settings::getInstance().setFriendSortingMode(mode);
+    model->setMode(mode);
 }
 
-QDateTime getActiveTimeFriend(const Friend* contact)
+FriendListWidget::SortingMode FriendListWidget::getMode() const
 {
-    return Settings::getInstance().getFriendActivity(contact->getPublicKey());
+    return model->getMode();
 }
 
-qint64 timeUntilTomorrow()
+void FriendListWidget::addFriend(std::shared_ptr<FriendChatroom> chatroom)
 {
-    QDateTime now = QDateTime::currentDateTime();
-    QDateTime tomorrow = now.addDays(1); // Tomorrow.
-    tomorrow.setTime(QTime());           // Midnight.
-    return now.msecsTo(tomorrow);
+    Friend* frnd = chatroom->getFriend();
+    friendChatrooms.insert(frnd, chatroom);
+    model->addFriend(frnd);
 }
 
-FriendListWidget::FriendListWidget(const Core &_core, Widget* parent, bool groupsOnTop)
-    : QWidget(parent)
-    , groupsOnTop(groupsOnTop)
-    , core{_core}
+void FriendListWidget::removeFriend(const Friend* frnd)
 {
-    listLayout = new FriendListLayout();
-    setLayout(listLayout);
-    setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Fixed);
+    updateTracking(frnd);
+    const ToxPk& friendPk = frnd->getPublicKey();
+    avatars.remove(friendPk);
+    requestedAvatars.remove(friendPk);
+    model->removeFriend(frnd);
+    friendChatrooms.remove(frnd);
+}
 
-    groupLayout.getLayout()->setSpacing(0);
-    groupLayout.getLayout()->setMargin(0);
+void FriendListWidget::addGroup(std::shared_ptr<GroupChatroom> chatroom)
+{
+    Group* group = chatroom->getGroup();
+    groupChatrooms.insert(group, chatroom);
+    model->addGroup(group);
+}
 
-    // Prevent QLayout's add child warning before setting the mode.
-    listLayout->removeItem(listLayout->getLayoutOnline());
-    listLayout->removeItem(listLayout->getLayoutOffline());
+void FriendListWidget::removeGroup(const Group* group)
+{
+    updateTracking(group);
+    model->removeGroup(group);
+    groupChatrooms.remove(group);
+}
 
-    mode = Settings::getInstance().getFriendSortingMode();
-    sortByMode(mode);
-    if (mode != SortingMode::Name) {
-        listLayout->insertLayout(0, groupLayout.getLayout());
+/**
+ * @brief Creates a new circle and, if the window is in use, starts renaming it.
+ */
+void FriendListWidget::addCircle()
+{
+    const int circleId = model->addCircle();
+    if (window()->isActiveWindow()) {
+        editCircle(circleId);
     }
+}
 
-    dayTimer = new QTimer(this);
-    dayTimer->setTimerType(Qt::VeryCoarseTimer);
-    connect(dayTimer, &QTimer::timeout, this, &FriendListWidget::dayTimeout);
-    dayTimer->start(timeUntilTomorrow());
-
-    setAcceptDrops(true);
+void FriendListWidget::searchChatrooms(const QString& searchString, bool hideOnline,
+                                       bool hideOffline, bool hideGroups)
+{
+    model->setFilter(searchString, hideOnline, hideOffline, hideGroups);
 }
 
-FriendListWidget::~FriendListWidget()
+/**
+ * @brief Activates the contact before or after the active one, in display order.
+ * @param activeContact Currently active contact.
+ * @param forward True to go down the list, false to go up.
+ */
+void FriendListWidget::cycleContacts(const Contact* activeContact, bool forward)
 {
-    if (activityLayout != nullptr) {
-        QLayoutItem* item;
-        while ((item = activityLayout->takeAt(0)) != nullptr) {
-            delete item->widget();
-            delete item;
-        }
-        delete activityLayout;
+    if (!activeContact) {
+        return;
     }
 
-    if (circleLayout != nullptr) {
-        QLayoutItem* item;
-        while ((item = circleLayout->getLayout()->takeAt(0)) != nullptr) {
-            delete item->widget();
-            delete item;
-        }
-        delete circleLayout;
+    model->applyPendingChanges();
+    const Contact* next = model->nextContact(activeContact, forward);
+    if (!next || next == activeContact) {
+        return;
     }
+
+    expandSectionOf(next);
+    scrollTo(model->indexOf(next));
+    emit chatroomActivated(next);
 }
 
-void FriendListWidget::setMode(SortingMode mode)
+void FriendListWidget::setActiveContact(const Contact* contact)
+{
+    model->setActiveContact(contact);
+}
+
+/**
+ * @brief Repaints a contact after its status or event flag changed.
+ *
+ * A new message opens the circle the friend is in, like it did before the list was a view.
+ */
+void FriendListWidget::updateContact(const Contact* contact)
 {
-    if (this->mode == mode)
+    model->updateContact(contact);
+
+    const auto it = friendChatrooms.constFind(contact);
+    if (it == friendChatrooms.constEnd() || !it.value()->getFriend()->getEventFlag()) {
         return;
+    }
 
-    this->mode = mode;
-    Settings::getInstance().setFriendSortingMode(mode);
+    const int circleId = it.value()->getCircleId();
+    if (circleId < 0 || Settings::getInstance().getCircleExpanded(circleId)) {
+        return;
+    }
 
-    sortByMode(mode);
+    model->applyPendingChanges();
+    setSectionExpanded(model->indexOfCircle(circleId), true);
 }
 
-void FriendListWidget::sortByMode(SortingMode mode)
+void FriendListWidget::updateActivity(const Friend* frnd)
 {
-    if (mode == SortingMode::Name) {
-        circleLayout = new GenericChatItemLayout;
-        circleLayout->getLayout()->setSpacing(0);
-        circleLayout->getLayout()->setMargin(0);
+    model->updateActivity(frnd);
+}
 
-        for (int i = 0; i < Settings::getInstance().getCircleCount(); ++i) {
-            addCircleWidget(i);
-            CircleWidget::getFromID(i)->setVisible(false);
-        }
+/**
+ * @brief Starts editing the alias of a friend or the title of a group in place.
+ */
+void FriendListWidget::editName(const Contact* contact)
+{
+    model->applyPendingChanges();
+    const QModelIndex index = model->indexOf(contact);
+    if (!index.isValid()) {
+        return;
+    }
 
-        // Only display circles once all created to avoid artifacts.
-        for (int i = 0; i < Settings::getInstance().getCircleCount(); ++i)
-            CircleWidget::getFromID(i)->setVisible(true);
+    expandSectionOf(contact);
+    scrollTo(index);
+    edit(index);
+}
 
-        int count = activityLayout ? activityLayout->count() : 0;
-        for (int i = 0; i < count; i++) {
-            QWidget* widget = activityLayout->itemAt(i)->widget();
-            CategoryWidget* categoryWidget = qobject_cast<CategoryWidget*>(widget);
-            if (categoryWidget) {
-                categoryWidget->moveFriendWidgets(this);
-            } else {
-                qWarning() << "Unexpected widget";
-            }
-        }
+/**
+ * @brief Shows a notification edge while the contact is scrolled out of sight.
+ */
+void FriendListWidget::trackContact(const Contact* contact)
+{
+    if (trackedContacts.contains(contact)) {
+        return;
+    }
 
-        listLayout->addLayout(listLayout->getLayoutOnline());
-        listLayout->addLayout(listLayout->getLayoutOffline());
-        listLayout->addLayout(circleLayout->getLayout());
-        onGroupchatPositionChanged(groupsOnTop);
+    const Visibility visibility = contactVisibility(contact);
+    if (visibility == Visible) {
+        return;
+    }
 
-        if (activityLayout != nullptr) {
-            QLayoutItem* item;
-            while ((item = activityLayout->takeAt(0)) != nullptr) {
-                delete item->widget();
-                delete item;
-            }
-            delete activityLayout;
-            activityLayout = nullptr;
+    if (visibility == Above) {
+        if (referencesAbove++ == 0) {
+            assert(topEdge == nullptr);
+            topEdge = new NotificationEdgeWidget(NotificationEdgeWidget::Top, this);
+            connect(topEdge, &NotificationEdgeWidget::clicked, this,
+                    &FriendListWidget::findPreviousContact);
+            recalculateTopEdge();
+            topEdge->show();
         }
-
-        reDraw();
-    } else if (mode == SortingMode::Activity) {
-        QLocale ql(Settings::getInstance().getTranslation());
-        QDate today = QDate::currentDate();
-#define COMMENT "Category for sorting friends by activity"
-        // clang-format off
-        const QMap<Time, QString> names {
-            { Time::Today,     tr("Today",                      COMMENT) },
-            { Time::Yesterday, tr("Yesterday",                  COMMENT) },
-            { Time::ThisWeek,  tr("Last 7 days",                COMMENT) },
-            { Time::ThisMonth, tr("This month",                 COMMENT) },
-            { Time::LongAgo,   tr("Older than 6 months",        COMMENT) },
-            { Time::Never,     tr("Never",                      COMMENT) },
-            { Time::Month1Ago, ql.monthName(today.addMonths(-1).month()) },
-            { Time::Month2Ago, ql.monthName(today.addMonths(-2).month()) },
-            { Time::Month3Ago, ql.monthName(today.addMonths(-3).month()) },
-            { Time::Month4Ago, ql.monthName(today.addMonths(-4).month()) },
-            { Time::Month5Ago, ql.monthName(today.addMonths(-5).month()) },
-        };
-// clang-format on
-#undef COMMENT
-
-        activityLayout = new QVBoxLayout();
-        bool compact = Settings::getInstance().getCompactLayout();
-        for (Time t : names.keys()) {
-            CategoryWidget* category = new CategoryWidget(compact, this);
-            category->setName(names[t]);
-            activityLayout->addWidget(category);
+        topEdge->updateNotificationCount(referencesAbove);
+    } else {
+        if (referencesBelow++ == 0) {
+            assert(bottomEdge == nullptr);
+            bottomEdge = new NotificationEdgeWidget(NotificationEdgeWidget::Bottom, this);
+            connect(bottomEdge, &NotificationEdgeWidget::clicked, this,
+                    &FriendListWidget::findNextContact);
+            recalculateBottomEdge();
+            bottomEdge->show();
         }
+        bottomEdge->updateNotificationCount(referencesBelow);
+    }
 
-        moveFriends(listLayout->getLayoutOffline());
-        moveFriends(listLayout->getLayoutOnline());
-        if (circleLayout != nullptr) {
-            moveFriends(circleLayout->getLayout());
-        }
+    trackedContacts.insert(contact, visibility);
+}
 
-        for (int i = 0; i < activityLayout->count(); ++i) {
-            QWidget* widget = activityLayout->itemAt(i)->widget();
-            CategoryWidget* categoryWidget = qobject_cast<CategoryWidget*>(widget);
-            categoryWidget->setVisible(categoryWidget->hasChatrooms());
+/**
+ * @brief Stops tracking the contact, and every tracked contact that became visible.
+ * @param contact Contact to stop tracking, nullptr to only drop the visible ones.
+ */
+void FriendListWidget::updateTracking(const Contact* contact)
+{
+    auto i = trackedContacts.begin();
+    while (i != trackedContacts.end()) {
+        if (i.key() != contact && contactVisibility(i.key()) != Visible) {
+            ++i;
+            continue;
         }
 
-        listLayout->removeItem(listLayout->getLayoutOnline());
-        listLayout->removeItem(listLayout->getLayoutOffline());
-
-        if (circleLayout != nullptr) {
-            listLayout->removeItem(circleLayout->getLayout());
-
-            QLayoutItem* item;
-            while ((item = circleLayout->getLayout()->takeAt(0)) != nullptr) {
-                delete item->widget();
-                delete item;
+        if (i.value() == Above) {
+            if (--referencesAbove == 0) {
+                topEdge->deleteLater();
+                topEdge = nullptr;
+            } else {
+                topEdge->updateNotificationCount(referencesAbove);
+            }
+        } else {
+            if (--referencesBelow == 0) {
+                bottomEdge->deleteLater();
+                bottomEdge = nullptr;
+            } else {
+                bottomEdge->updateNotificationCount(referencesBelow);
             }
-            delete circleLayout;
-            circleLayout = nullptr;
         }
+        i = trackedContacts.erase(i);
+    }
+}
+
+void FriendListWidget::updateVisualTracking()
+{
+    updateTracking(nullptr);
+}
 
-        listLayout->insertLayout(1, activityLayout);
+/**
+ * @brief Returns the avatar of a contact, as painted in the list.
+ *
+ * Friend avatars are loaded the first time they are painted, so the avatars of contacts that are
+ * never scrolled into view are never decoded.
+ */
+QPixmap FriendListWidget::getAvatar(const Contact* contact, bool active)
+{
+    const Friend* frnd = qobject_cast<const Friend*>(contact);
+    if (!frnd) {
+        const QString path = active ? QStringLiteral(":img/group_dark.svg")
+                                    : QStringLiteral(":img/group.svg");
+        return getDefaultAvatar(path, true);
+    }
+
+    const ToxPk& friendPk = frnd->getPublicKey();
+    const auto it = avatars.constFind(friendPk);
+    if (it != avatars.constEnd()) {
+        return it.value();
+    }
 
-        reDraw();
+    if (!requestedAvatars.contains(friendPk)) {
+        requestedAvatars.insert(friendPk);
+        emit avatarRequested(friendPk);
     }
+
+    const QString path = active ? QStringLiteral(":img/contact_dark.svg")
+                                : QStringLiteral(":img/contact.svg");
+    return getDefaultAvatar(path, false);
 }
 
-void FriendListWidget::moveFriends(QLayout* layout)
+QModelIndex FriendListWidget::getDropIndex() const
 {
-    while (!layout->isEmpty()) {
-        QWidget* widget = layout->itemAt(0)->widget();
-        FriendWidget* friendWidget = qobject_cast<FriendWidget*>(widget);
-        CircleWidget* circleWidget = qobject_cast<CircleWidget*>(widget);
-        if (circleWidget) {
-            circleWidget->moveFriendWidgets(this);
-        } else if (friendWidget) {
-            const Friend* contact = friendWidget->getFriend();
-            auto* categoryWidget = getTimeCategoryWidget(contact);
-            categoryWidget->addFriendWidget(friendWidget, contact->getStatus());
-        }
-    }
+    return dropIndex;
 }
 
-CategoryWidget* FriendListWidget::getTimeCategoryWidget(const Friend* frd) const
+QColor FriendListWidget::getNameColor() const
 {
-    const auto activityTime = getActiveTimeFriend(frd);
-    int timeIndex = static_cast<int>(getTimeBucket(activityTime));
-    QWidget* widget = activityLayout->itemAt(timeIndex)->widget();
-    return qobject_cast<CategoryWidget*>(widget);
+    return nameColor;
 }
 
-FriendListWidget::SortingMode FriendListWidget::getMode() const
+void FriendListWidget::setNameColor(const QColor& color)
 {
-    return mode;
+    nameColor = color;
+    viewport()->update();
 }
 
-void FriendListWidget::addGroupWidget(GroupWidget* widget)
+QColor FriendListWidget::getSectionNameColor() const
 {
-    groupLayout.addSortedWidget(widget);
-    Group* g = widget->getGroup();
-    connect(g, &Group::titleChanged, [=](const QString& author, const QString& name) {
-        Q_UNUSED(author)
-        renameGroupWidget(widget, name);
-    });
+    return sectionNameColor;
 }
 
-void FriendListWidget::addFriendWidget(FriendWidget* w, Status::Status s, int circleIndex)
+void FriendListWidget::setSectionNameColor(const QColor& color)
 {
-    CircleWidget* circleWidget = CircleWidget::getFromID(circleIndex);
-    if (circleWidget == nullptr)
-        moveWidget(w, s, true);
-    else
-        circleWidget->addFriendWidget(w, s);
-    connect(w, &FriendWidget::friendWidgetRenamed, this, &FriendListWidget::onFriendWidgetRenamed);
+    sectionNameColor = color;
+    viewport()->update();
 }
 
-void FriendListWidget::removeGroupWidget(GroupWidget* w)
+QColor FriendListWidget::getSectionCountColor() const
 {
-    groupLayout.removeSortedWidget(w);
-    w->deleteLater();
+    return sectionCountColor;
 }
 
-void FriendListWidget::removeFriendWidget(FriendWidget* w)
+void FriendListWidget::setSectionCountColor(const QColor& color)
 {
-    const Friend* contact = w->getFriend();
+    sectionCountColor = color;
+    viewport()->update();
+}
 
-    if (mode == SortingMode::Activity) {
-        auto* categoryWidget = getTimeCategoryWidget(contact);
-        categoryWidget->removeFriendWidget(w, contact->getStatus());
-        categoryWidget->setVisible(categoryWidget->hasChatrooms());
-    } else {
-        int id = Settings::getInstance().getFriendCircleID(contact->getPublicKey());
-        CircleWidget* circleWidget = CircleWidget::getFromID(id);
-        if (circleWidget != nullptr) {
-            circleWidget->removeFriendWidget(w, contact->getStatus());
-            emit searchCircle(*circleWidget);
-        }
-    }
+QColor FriendListWidget::getSectionLineColor() const
+{
+    return sectionLineColor;
 }
 
-void FriendListWidget::addCircleWidget(int id)
+void FriendListWidget::setSectionLineColor(const QColor& color)
 {
-    createCircleWidget(id);
+    sectionLineColor = color;
+    viewport()->update();
 }
 
-void FriendListWidget::addCircleWidget(FriendWidget* friendWidget)
+void FriendListWidget::onCompactChanged(bool compact)
 {
-    CircleWidget* circleWidget = createCircleWidget();
-    if (circleWidget != nullptr) {
-        if (friendWidget != nullptr) {
-            const Friend* f = friendWidget->getFriend();
-            ToxPk toxPk = f->getPublicKey();
-            int circleId = Settings::getInstance().getFriendCircleID(toxPk);
-            CircleWidget* circleOriginal = CircleWidget::getFromID(circleId);
+    delegate->setCompact(compact);
+    scheduleDelayedItemsLayout();
+    viewport()->update();
+}
 
-            circleWidget->addFriendWidget(friendWidget, f->getStatus());
-            circleWidget->setExpanded(true);
+void FriendListWidget::onGroupchatPositionChanged(bool top)
+{
+    model->setGroupsOnTop(top);
+}
 
-            if (circleOriginal != nullptr)
-                emit searchCircle(*circleOriginal);
-        }
+void FriendListWidget::onAvatarSet(const ToxPk& friendPk, const QPixmap& pic)
+{
+    if (pic.isNull()) {
+        return;
+    }
 
-        emit searchCircle(*circleWidget);
+    avatars.insert(friendPk, renderAvatar(pic));
+    viewport()->update();
+}
 
-        if (window()->isActiveWindow())
-            circleWidget->editName();
+void FriendListWidget::onAvatarRemoved(const ToxPk& friendPk)
+{
+    if (avatars.remove(friendPk) > 0) {
+        viewport()->update();
     }
-    reDraw();
 }
 
-void FriendListWidget::removeCircleWidget(CircleWidget* widget)
+void FriendListWidget::moveToNewCircle(const ToxPk& friendPk)
 {
-    circleLayout->removeSortedWidget(widget);
-    widget->deleteLater();
+    const Friend* frnd = FriendList::findFriend(friendPk);
+    if (!frnd) {
+        return;
+    }
+
+    const int circleId = model->addCircle();
+    model->moveToCircle(frnd, circleId);
+    if (window()->isActiveWindow()) {
+        editCircle(circleId);
+    }
 }
 
-void FriendListWidget::searchChatrooms(const QString& searchString, bool hideOnline,
-                                       bool hideOffline, bool hideGroups)
+/**
+ * @brief Moves a friend into a circle.
+ * @param friendPk Friend to move.
+ * @param circleId Destination circle, -1 to take the friend out of its circle.
+ */
+void FriendListWidget::moveToCircle(const ToxPk& friendPk, int circleId)
 {
-    groupLayout.search(searchString, hideGroups);
-    listLayout->searchChatrooms(searchString, hideOnline, hideOffline);
-
-    if (circleLayout != nullptr) {
-        for (int i = 0; i != circleLayout->getLayout()->count(); ++i) {
-            CircleWidget* circleWidget =
-                static_cast<CircleWidget*>(circleLayout->getLayout()->itemAt(i)->widget());
-            circleWidget->search(searchString, true, hideOnline, hideOffline);
-        }
-    } else if (activityLayout != nullptr) {
-        for (int i = 0; i != activityLayout->count(); ++i) {
-            CategoryWidget* categoryWidget =
-                static_cast<CategoryWidget*>(activityLayout->itemAt(i)->widget());
-            categoryWidget->search(searchString, true, hideOnline, hideOffline);
-            categoryWidget->setVisible(categoryWidget->hasChatrooms());
-        }
+    const Friend* frnd = FriendList::findFriend(friendPk);
+    if (frnd) {
+        model->moveToCircle(frnd, circleId);
     }
 }
 
-void FriendListWidget::renameGroupWidget(GroupWidget* groupWidget, const QString& newName)
+void FriendListWidget::reloadTheme()
 {
-    groupLayout.removeSortedWidget(groupWidget);
-    groupLayout.addSortedWidget(groupWidget);
+    defaultAvatars.clear();
+    delegate->reloadTheme();
+    viewport()->update();
 }
 
-void FriendListWidget::renameCircleWidget(CircleWidget* circleWidget, const QString& newName)
+void FriendListWidget::mousePressEvent(QMouseEvent* event)
 {
-    circleLayout->removeSortedWidget(circleWidget);
-    circleWidget->setName(newName);
-    circleLayout->addSortedWidget(circleWidget);
+    dragStartPos = event->pos();
+    pressedIndex = indexAt(event->pos());
+    QTreeView::mousePressEvent(event);
 }
 
-void FriendListWidget::onFriendWidgetRenamed(FriendWidget* friendWidget)
+void FriendListWidget::mouseMoveEvent(QMouseEvent* event)
 {
-    const Friend* contact = friendWidget->getFriend();
-    auto status = contact->getStatus();
-    if (mode == SortingMode::Activity) {
-        auto* categoryWidget = getTimeCategoryWidget(contact);
-        categoryWidget->removeFriendWidget(friendWidget, status);
-        categoryWidget->addFriendWidget(friendWidget, status);
-    } else {
-        int id = Settings::getInstance().getFriendCircleID(contact->getPublicKey());
-        CircleWidget* circleWidget = CircleWidget::getFromID(id);
-        if (circleWidget != nullptr) {
-            circleWidget->removeFriendWidget(friendWidget, status);
-            circleWidget->addFriendWidget(friendWidget, status);
-            emit searchCircle(*circleWidget);
+    if (event->buttons() & Qt::LeftButton && pressedIndex.isValid()
+        && (event->pos() - dragStartPos).manhattanLength() > QApplication::startDragDistance()) {
+        const QModelIndex index = pressedIndex;
+        pressedIndex = QPersistentModelIndex();
+        if (model->getContact(index)) {
+            dragContact(index);
+            return;
+        }
+    }
+
+    QTreeView::mouseMoveEvent(event);
+}
+
+void FriendListWidget::mouseReleaseEvent(QMouseEvent* event)
+{
+    QTreeView::mouseReleaseEvent(event);
+
+    const QModelIndex index = indexAt(event->pos());
+    const bool clicked = index.isValid() && index == pressedIndex;
+    pressedIndex = QPersistentModelIndex();
+    if (!clicked) {
+        return;
+    }
+
+    Contact* contact = model->getContact(index);
+    if (event->button() == Qt::LeftButton) {
+        if (contact) {
+            emit chatroomActivated(contact);
         } else {
-            listLayout->removeFriendWidget(friendWidget, status);
-            listLayout->addFriendWidget(friendWidget, status);
+            setSectionExpanded(index, !isExpanded(index));
+        }
+    } else if (event->button() == Qt::MiddleButton) {
+        const Group* group = qobject_cast<const Group*>(contact);
+        if (group) {
+            emit removeGroupRequested(group->getPersistentId());
         }
     }
 }
 
-void FriendListWidget::onGroupchatPositionChanged(bool top)
+void FriendListWidget::contextMenuEvent(QContextMenuEvent* event)
 {
-    groupsOnTop = top;
+    const QModelIndex index = indexAt(event->pos());
+    if (!index.isValid()) {
+        emit customContextMenuRequested(viewport()->mapToParent(event->pos()));
+        return;
+    }
+
+    const QPoint pos = event->globalPos();
+    Contact* contact = model->getContact(index);
+    if (Friend* frnd = qobject_cast<Friend*>(contact)) {
+        showFriendMenu(frnd, pos);
+    } else if (Group* group = qobject_cast<Group*>(contact)) {
+        showGroupMenu(group, pos);
+    } else if (model->getItemType(index) == FriendListModel::ItemType::Circle) {
+        showCircleMenu(index, pos);
+    }
+}
 
-    if (mode != SortingMode::Name)
+void FriendListWidget::dragEnterEvent(QDragEnterEvent* event)
+{
+    if (!event->mimeData()->hasFormat("toxPk")) {
         return;
+    }
+
+    const ToxPk toxPk{event->mimeData()->data("toxPk")};
+    if (FriendList::findFriend(toxPk)) {
+        event->acceptProposedAction();
+        setDropIndex(dropTarget(event->pos()));
+    }
+}
 
-    listLayout->removeItem(groupLayout.getLayout());
+void FriendListWidget::dragMoveEvent(QDragMoveEvent* event)
+{
+    if (!event->mimeData()->hasFormat("toxPk")) {
+        return;
+    }
 
-    if (top)
-        listLayout->insertLayout(0, groupLayout.getLayout());
-    else
-        listLayout->insertLayout(1, groupLayout.getLayout());
+    event->acceptProposedAction();
+    setDropIndex(dropTarget(event->pos()));
+}
 
-    reDraw();
+void FriendListWidget::dragLeaveEvent(QDragLeaveEvent*)
+{
+    setDropIndex(QModelIndex());
 }
 
-void FriendListWidget::cycleContacts(GenericChatroomWidget* activeChatroomWidget, bool forward)
+void FriendListWidget::dropEvent(QDropEvent* event)
 {
-    if (!activeChatroomWidget) {
+    const QModelIndex target = dropTarget(event->pos());
+    setDropIndex(QModelIndex());
+
+    // Check, that the element is dropped from qTox
+    if (!event->source() || !event->mimeData()->hasFormat("toxPk")) {
         return;
     }
 
-    int index = -1;
-    FriendWidget* friendWidget = qobject_cast<FriendWidget*>(activeChatroomWidget);
+    // Check, that the user has a friend with the same ToxPk
+    const ToxPk toxPk{event->mimeData()->data("toxPk")};
+    const Friend* frnd = FriendList::findFriend(toxPk);
+    if (!frnd) {
+        return;
+    }
 
-    if (mode == SortingMode::Activity) {
-        if (!friendWidget) {
-            return;
+    if (Group* group = qobject_cast<Group*>(model->getContact(target))) {
+        const auto& chatroom = groupChatrooms.value(group);
+        if (chatroom && chatroom->friendExists(toxPk)) {
+            chatroom->inviteFriend(toxPk);
         }
+    } else if (target.isValid()) {
+        model->moveToCircle(frnd, model->getSectionId(target));
+    } else if (model->getMode() == SortingMode::Name) {
+        model->moveToCircle(frnd, -1);
+    }
+}
+
+void FriendListWidget::resizeEvent(QResizeEvent* event)
+{
+    QTreeView::resizeEvent(event);
 
-        const auto activityTime = getActiveTimeFriend(friendWidget->getFriend());
-        index = static_cast<int>(getTimeBucket(activityTime));
-        QWidget* widget = activityLayout->itemAt(index)->widget();
-        CategoryWidget* categoryWidget = qobject_cast<CategoryWidget*>(widget);
+    if (topEdge != nullptr) {
+        recalculateTopEdge();
+    }
+    if (bottomEdge != nullptr) {
+        recalculateBottomEdge();
+    }
+}
 
-        if (categoryWidget == nullptr || categoryWidget->cycleContacts(friendWidget, forward)) {
-            return;
+/**
+ * @brief Applies the expansion state kept by the model to the sections of the view.
+ */
+void FriendListWidget::syncExpansion()
+{
+    const int count = model->rowCount();
+    for (int row = 0; row < count; ++row) {
+        const QModelIndex index = model->index(row, 0);
+        if (!model->getContact(index)) {
+            setExpanded(index, model->isExpanded(index));
         }
+    }
 
-        index += forward ? 1 : -1;
+    updateVisualTracking();
+}
 
-        for (;;) {
-            // Bounds checking.
-            if (index < 0) {
-                index = LAST_TIME;
-                continue;
-            } else if (index > LAST_TIME) {
-                index = 0;
-                continue;
-            }
+/**
+ * @brief Expands new sections like the model says, the view inserts them collapsed.
+ */
+void FriendListWidget::onRowsInserted(const QModelIndex& parent, int first, int last)
+{
+    if (parent.isValid()) {
+        return;
+    }
 
-            auto* widget = activityLayout->itemAt(index)->widget();
-            categoryWidget = qobject_cast<CategoryWidget*>(widget);
+    for (int row = first; row <= last; ++row) {
+        const QModelIndex index = model->index(row, 0);
+        if (!model->getContact(index)) {
+            setExpanded(index, model->isExpanded(index));
+        }
+    }
+}
 
-            if (categoryWidget != nullptr) {
-                if (!categoryWidget->cycleContacts(forward)) {
-                    // Skip empty or finished categories.
-                    index += forward ? 1 : -1;
-                    continue;
-                }
-            }
+void FriendListWidget::findNextContact()
+{
+    scrollToTracked(Below);
+}
 
-            break;
-        }
+void FriendListWidget::findPreviousContact()
+{
+    scrollToTracked(Above);
+}
 
+void FriendListWidget::showFriendMenu(Friend* frnd, const QPoint& pos)
+{
+    const auto chatroom = friendChatrooms.value(frnd);
+    if (!chatroom) {
         return;
     }
 
-    QLayout* currentLayout = nullptr;
-    CircleWidget* circleWidget = nullptr;
+    const ToxPk friendPk = frnd->getPublicKey();
+    // No parent, the right to left direction of the list would propagate to the menu
+    FriendContextMenu menu{chatroom};
+    connect(&menu, &FriendContextMenu::newWindowRequested, this,
+            [=]() { emit newWindowRequested(frnd); });
+    connect(&menu, &FriendContextMenu::aliasEditRequested, this, [=]() { editName(frnd); });
+    connect(&menu, &FriendContextMenu::moveToNewCircleRequested, this,
+            [=]() { moveToNewCircle(friendPk); });
+    connect(&menu, &FriendContextMenu::moveToCircleRequested, this,
+            [=](int circleId) { moveToCircle(friendPk, circleId); });
+    connect(&menu, &FriendContextMenu::removeFriendRequested, this,
+            [=]() { emit removeFriendRequested(friendPk); }, Qt::QueuedConnection);
+    connect(&menu, &FriendContextMenu::detailsRequested, this, [=]() { showDetails(frnd); });
+    menu.exec(pos);
+}
 
-    if (friendWidget != nullptr) {
-        const ToxPk& pk = friendWidget->getFriend()->getPublicKey();
-        uint32_t circleId = Settings::getInstance().getFriendCircleID(pk);
-        circleWidget = CircleWidget::getFromID(circleId);
-        if (circleWidget != nullptr) {
-            if (circleWidget->cycleContacts(friendWidget, forward)) {
-                return;
-            }
+void FriendListWidget::showGroupMenu(Group* group, const QPoint& pos)
+{
+    const auto chatroom = groupChatrooms.value(group);
+    if (!chatroom) {
+        return;
+    }
 
-            index = circleLayout->indexOfSortedWidget(circleWidget);
-            currentLayout = circleLayout->getLayout();
-        } else {
-            currentLayout = listLayout->getLayoutOnline();
-            index = listLayout->indexOfFriendWidget(friendWidget, true);
-            if (index == -1) {
-                currentLayout = listLayout->getLayoutOffline();
-                index = listLayout->indexOfFriendWidget(friendWidget, false);
-            }
-        }
-    } else {
-        GroupWidget* groupWidget = qobject_cast<GroupWidget*>(activeChatroomWidget);
-        if (groupWidget != nullptr) {
-            currentLayout = groupLayout.getLayout();
-            index = groupLayout.indexOfSortedWidget(groupWidget);
-        } else {
-            return;
-        }
+    // The entries keep the GroupWidget context, which the translations have them under
+    QMenu menu;
+
+    QAction* openChatWindow = nullptr;
+    if (chatroom->possibleToOpenInNewWindow()) {
+        openChatWindow =
+            menu.addAction(QCoreApplication::translate("GroupWidget", "Open chat in new window"));
     }
 
-    index += forward ? 1 : -1;
+    QAction* removeChatWindow = nullptr;
+    if (chatroom->canBeRemovedFromWindow()) {
+        removeChatWindow = menu.addAction(
+            QCoreApplication::translate("GroupWidget", "Remove chat from this window"));
+    }
 
-    for (;;) {
-        // Bounds checking.
-        if (index < 0) {
-            currentLayout = nextLayout(currentLayout, forward);
-            index = currentLayout->count() - 1;
-            continue;
-        } else if (index >= currentLayout->count()) {
-            currentLayout = nextLayout(currentLayout, forward);
-            index = 0;
-            continue;
-        }
+    menu.addSeparator();
 
-        // Go to the actual next index.
-        if (currentLayout == listLayout->getLayoutOnline()
-            || currentLayout == listLayout->getLayoutOffline()
-            || currentLayout == groupLayout.getLayout()) {
-            GenericChatroomWidget* chatWidget =
-                qobject_cast<GenericChatroomWidget*>(currentLayout->itemAt(index)->widget());
+    QAction* setTitle = menu.addAction(QCoreApplication::translate("GroupWidget", "Set title..."));
+    QAction* quitGroup = menu.addAction(
+        QCoreApplication::translate("GroupWidget", "Quit group", "Menu to quit a groupchat"));
 
-            if (chatWidget != nullptr)
-                emit chatWidget->chatroomWidgetClicked(chatWidget);
+    QAction* selectedItem = menu.exec(pos);
+    if (!selectedItem) {
+        return;
+    }
 
-            return;
-        } else if (currentLayout == circleLayout->getLayout()) {
-            circleWidget = qobject_cast<CircleWidget*>(currentLayout->itemAt(index)->widget());
-            if (circleWidget != nullptr) {
-                if (!circleWidget->cycleContacts(forward)) {
-                    // Skip empty or finished circles.
-                    index += forward ? 1 : -1;
-                    continue;
-                }
-            }
-            return;
-        } else {
-            return;
-        }
+    if (selectedItem == quitGroup) {
+        emit removeGroupRequested(group->getPersistentId());
+    } else if (selectedItem == openChatWindow) {
+        emit newWindowRequested(group);
+    } else if (selectedItem == removeChatWindow) {
+        chatroom->removeGroupFromDialogs();
+    } else if (selectedItem == setTitle) {
+        editName(group);
     }
 }
 
-void FriendListWidget::dragEnterEvent(QDragEnterEvent* event)
+void FriendListWidget::showCircleMenu(const QModelIndex& index, const QPoint& pos)
 {
-    if (!event->mimeData()->hasFormat("toxPk")) {
+    const int circleId = model->getSectionId(index);
+
+    // The entries keep the CircleWidget context, which the translations have them under
+    QMenu menu;
+    QAction* renameAction = menu.addAction(
+        QCoreApplication::translate("CircleWidget", "Rename circle", "Menu for renaming a circle"));
+    QAction* removeAction = menu.addAction(
+        QCoreApplication::translate("CircleWidget", "Remove circle", "Menu for removing a circle"));
+    QAction* openAction = nullptr;
+
+    if (index.data(FriendListModel::TotalCountRole).toInt() > 0) {
+        openAction =
+            menu.addAction(QCoreApplication::translate("CircleWidget", "Open all in new window"));
+    }
+
+    QAction* selectedItem = menu.exec(pos);
+    if (!selectedItem) {
         return;
     }
-    ToxPk toxPk(event->mimeData()->data("toxPk"));
-    Friend* frnd = FriendList::findFriend(toxPk);
-    if (frnd)
-        event->acceptProposedAction();
+
+    if (selectedItem == renameAction) {
+        editCircle(circleId);
+    } else if (selectedItem == removeAction) {
+        model->removeCircle(circleId);
+    } else if (selectedItem == openAction) {
+        emit circleOpenRequested(model->getCircleFriends(circleId));
+    }
 }
 
-void FriendListWidget::dropEvent(QDropEvent* event)
+void FriendListWidget::showDetails(Friend* frnd)
 {
-    // Check, that the element is dropped from qTox
-    QObject* o = event->source();
-    FriendWidget* widget = qobject_cast<FriendWidget*>(o);
-    if (!widget)
-        return;
+    const ToxPk friendPk = frnd->getPublicKey();
+    const auto iabout = new AboutFriend(frnd, &Settings::getInstance());
+    std::unique_ptr<IAboutFriend> about = std::unique_ptr<IAboutFriend>(iabout);
+    const auto aboutUser = new AboutFriendForm(std::move(about), window());
+    connect(aboutUser, &AboutFriendForm::histroyRemoved, this,
+            [=]() { emit friendHistoryRemoved(friendPk); });
+    aboutUser->show();
+}
 
-    // Check, that the user has a friend with the same ToxPk
-    assert(event->mimeData()->hasFormat("toxPk"));
-    const ToxPk toxPk{event->mimeData()->data("toxPk")};
-    Friend* f = FriendList::findFriend(toxPk);
-    if (!f)
+/**
+ * @brief Expands or collapses a section and remembers it.
+ */
+void FriendListWidget::setSectionExpanded(const QModelIndex& index, bool expanded)
+{
+    if (!index.isValid()) {
         return;
+    }
 
-    // Save CircleWidget before changing the Id
-    int circleId = Settings::getInstance().getFriendCircleID(f->getPublicKey());
-    CircleWidget* circleWidget = CircleWidget::getFromID(circleId);
+    model->setExpanded(index, expanded);
+    setExpanded(index, expanded);
+    if (model->getItemType(index) == FriendListModel::ItemType::Circle) {
+        Settings::getInstance().savePersonal();
+    }
 
-    moveWidget(widget, f->getStatus(), true);
+    updateVisualTracking();
+}
 
-    if (circleWidget)
-        circleWidget->updateStatus();
+void FriendListWidget::expandSectionOf(const Contact* contact)
+{
+    const QModelIndex parent = model->indexOf(contact).parent();
+    if (parent.isValid() && !isExpanded(parent)) {
+        setSectionExpanded(parent, true);
+    }
 }
 
-void FriendListWidget::dayTimeout()
+void FriendListWidget::editCircle(int circleId)
 {
-    if (mode == SortingMode::Activity) {
-        setMode(SortingMode::Name);
-        setMode(SortingMode::Activity); // Refresh all.
+    model->applyPendingChanges();
+    const QModelIndex index = model->indexOfCircle(circleId);
+    if (!index.isValid()) {
+        return;
     }
 
-    dayTimer->start(timeUntilTomorrow());
+    scrollTo(index);
+    edit(index);
 }
 
-void FriendListWidget::moveWidget(FriendWidget* widget, Status::Status s, bool add)
+void FriendListWidget::dragContact(const QModelIndex& index)
 {
-    if (mode == SortingMode::Name) {
-        const Friend* f = widget->getFriend();
-        int circleId = Settings::getInstance().getFriendCircleID(f->getPublicKey());
-        CircleWidget* circleWidget = CircleWidget::getFromID(circleId);
+    Contact* contact = model->getContact(index);
+    QDrag* drag = new QDrag(this);
+    drag->setMimeData(model->mimeData({index}));
+    drag->setPixmap(getAvatar(contact, false));
+    drag->exec(Qt::CopyAction | Qt::MoveAction);
+}
 
-        if (circleWidget == nullptr || add) {
-            if (circleId != -1)
-                Settings::getInstance().setFriendCircleID(f->getPublicKey(), -1);
+/**
+ * @brief Finds the row a dragged friend would be dropped on.
+ * @return The group or circle under the cursor, the circle of the friend under the cursor, or an
+ * invalid index for the rest of the list.
+ */
+QModelIndex FriendListWidget::dropTarget(const QPoint& pos) const
+{
+    const QModelIndex index = indexAt(pos);
+    if (!index.isValid()) {
+        return QModelIndex();
+    }
 
-            listLayout->addFriendWidget(widget, s);
-            return;
+    switch (model->getItemType(index)) {
+    case FriendListModel::ItemType::Group:
+    case FriendListModel::ItemType::Circle:
+        return index;
+    case FriendListModel::ItemType::Friend: {
+        const QModelIndex parent = index.parent();
+        if (parent.isValid() && model->getItemType(parent) == FriendListModel::ItemType::Circle) {
+            return parent;
         }
-
-        circleWidget->addFriendWidget(widget, s);
-    } else {
-        const Friend* contact = widget->getFriend();
-        auto* categoryWidget = getTimeCategoryWidget(contact);
-        categoryWidget->addFriendWidget(widget, contact->getStatus());
-        categoryWidget->show();
+        return QModelIndex();
+    }
+    case FriendListModel::ItemType::Category:
+        break;
     }
+
+    return QModelIndex();
 }
 
-void FriendListWidget::updateActivityTime(const QDateTime& time)
+void FriendListWidget::setDropIndex(const QModelIndex& index)
 {
-    if (mode != SortingMode::Activity)
+    if (dropIndex == index) {
         return;
+    }
 
-    int timeIndex = static_cast<int>(getTimeBucket(time));
-    QWidget* widget = activityLayout->itemAt(timeIndex)->widget();
-    CategoryWidget* categoryWidget = static_cast<CategoryWidget*>(widget);
-    categoryWidget->updateStatus();
-
-    categoryWidget->setVisible(categoryWidget->hasChatrooms());
+    dropIndex = index;
+    viewport()->update();
 }
 
-// update widget after add/delete/hide/show
-void FriendListWidget::reDraw()
+QPixmap FriendListWidget::renderAvatar(const QPixmap& pixmap) const
 {
-    hide();
-    show();
-    resize(QSize()); // lifehack
+    const QSize size{AVATAR_SIZE, AVATAR_SIZE};
+    const QPixmap scaled = pixmap.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    const QPixmap mask =
+        QPixmap(AVATAR_MASK).scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+    QPixmap result{size};
+    result.fill(Qt::transparent);
+
+    // centering the pixmap
+    const QPoint offset((size.width() - scaled.width()) / 2, (size.height() - scaled.height()) / 2);
+
+    QPainter painter(&result);
+    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    painter.drawPixmap(offset, scaled);
+    painter.setCompositionMode(QPainter::CompositionMode_DestinationIn);
+    painter.drawPixmap(0, 0, mask);
+    painter.end();
+    return result;
 }
 
-CircleWidget* FriendListWidget::createCircleWidget(int id)
+const QPixmap& FriendListWidget::getDefaultAvatar(const QString& path, bool svg)
 {
-    if (id == -1)
-        id = Settings::getInstance().addCircle();
+    auto it = defaultAvatars.find(path);
+    if (it == defaultAvatars.end()) {
+        const QPixmap pixmap = svg ? Style::scaleSvgImage(path, AVATAR_SIZE, AVATAR_SIZE)
+                                   : QPixmap(path);
+        it = defaultAvatars.insert(path, renderAvatar(pixmap));
+    }
+
+    return it.value();
+}
 
-    // Stop, after it has been created. Code after this is for displaying.
-    if (mode == SortingMode::Activity)
-        return nullptr;
+FriendListWidget::Visibility FriendListWidget::contactVisibility(const Contact* contact)
+{
+    model->applyPendingChanges();
+    QModelIndex index = model->indexOf(contact);
+    if (!index.isValid()) {
+        return Visible;
+    }
 
-    assert(circleLayout != nullptr);
+    const QModelIndex parent = index.parent();
+    if (parent.isValid() && !isExpanded(parent)) {
+        index = parent;
+    }
 
-    CircleWidget* circleWidget = new CircleWidget(core, this, id);
-    emit connectCircleWidget(*circleWidget);
-    circleLayout->addSortedWidget(circleWidget);
-    connect(this, &FriendListWidget::onCompactChanged, circleWidget, &CircleWidget::onCompactChanged);
-    connect(circleWidget, &CircleWidget::renameRequested, this, &FriendListWidget::renameCircleWidget);
-    circleWidget->show(); // Avoid flickering.
+    const QRect rect = visualRect(index);
+    if (rect.top() < 0) {
+        return Above;
+    } else if (rect.bottom() > viewport()->height()) {
+        return Below;
+    }
 
-    return circleWidget;
+    return Visible;
 }
 
-QLayout* FriendListWidget::nextLayout(QLayout* layout, bool forward) const
+/**
+ * @brief Scrolls to the tracked contact closest to the visible part of the list.
+ * @param visibility Side of the list to look at.
+ */
+void FriendListWidget::scrollToTracked(Visibility visibility)
 {
-    if (layout == groupLayout.getLayout()) {
-        if (forward) {
-            if (groupsOnTop)
-                return listLayout->getLayoutOnline();
+    const Contact* next = nullptr;
+    int value = 0;
 
-            return listLayout->getLayoutOffline();
-        } else {
-            if (groupsOnTop)
-                return circleLayout->getLayout();
+    for (auto i = trackedContacts.constBegin(); i != trackedContacts.constEnd(); ++i) {
+        if (i.value() != visibility) {
+            continue;
+        }
 
-            return listLayout->getLayoutOnline();
+        const int y = visualRect(model->indexOf(i.key())).top();
+        if (!next || (visibility == Below ? y < value : y > value)) {
+            next = i.key();
+            value = y;
         }
-    } else if (layout == listLayout->getLayoutOnline()) {
-        if (forward) {
-            if (groupsOnTop)
-                return listLayout->getLayoutOffline();
+    }
 
-            return groupLayout.getLayout();
-        } else {
-            if (groupsOnTop)
-                return groupLayout.getLayout();
+    if (next != nullptr) {
+        expandSectionOf(next);
+        scrollTo(model->indexOf(next), QAbstractItemView::PositionAtCenter);
+    }
+}
 
-            return circleLayout->getLayout();
-        }
-    } else if (layout == listLayout->getLayoutOffline()) {
-        if (forward)
-            return circleLayout->getLayout();
-        else if (groupsOnTop)
-            return listLayout->getLayoutOnline();
-
-        return groupLayout.getLayout();
-    } else if (layout == circleLayout->getLayout()) {
-        if (forward) {
-            if (groupsOnTop)
-                return groupLayout.getLayout();
-
-            return listLayout->getLayoutOnline();
-        } else
-            return listLayout->getLayoutOffline();
-    }
-    return nullptr;
+void FriendListWidget::recalculateTopEdge()
+{
+    topEdge->move(viewport()->pos());
+    topEdge->resize(viewport()->width(), topEdge->height());
+}
+
+void FriendListWidget::recalculateBottomEdge()
+{
+    QPoint position = viewport()->pos();
+    position.setY(position.y() + viewport()->height() - bottomEdge->height());
+    bottomEdge->move(position);
+    bottomEdge->resize(viewport()->width(), bottomEdge->height());
+}
+
+void FriendListWidget::retranslateUi()
+{
+    model->setLocale(QLocale(Settings::getInstance().getTranslation()));
+    viewport()->update();
 }
@@ -17,84 +17,157 @@
     along with qTox.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+
 #pragma once
 
-#include "genericchatitemlayout.h"
-#include "src/core/core.h"
-#include "src/model/status.h"
-#include "src/persistence/settings.h"
-#include <QWidget>
-
-class QVBoxLayout;
-class QGridLayout;
-class QPixmap;
-class Widget;
-class FriendWidget;
-class GroupWidget;
-class CircleWidget;
-class FriendListLayout;
-class GenericChatroomWidget;
-class CategoryWidget;
+#include "src/core/groupid.h"
+#include "src/core/toxpk.h"
+#include "src/model/friendlistmodel.h"
+
+#include <QColor>
+#include <QHash>
+#include <QPersistentModelIndex>
+#include <QPixmap>
+#include <QSet>
+#include <QTreeView>
+
+#include <memory>
+
+class Contact;
 class Friend;
+class FriendChatroom;
+class FriendListDelegate;
+class Group;
+class GroupChatroom;
+class NotificationEdgeWidget;
 
-class FriendListWidget : public QWidget
+class FriendListWidget : public QTreeView
 {
     Q_OBJECT
+    Q_PROPERTY(QColor nameColor READ getNameColor WRITE setNameColor)
+    Q_PROPERTY(QColor sectionNameColor READ getSectionNameColor WRITE setSectionNameColor)
+    Q_PROPERTY(QColor sectionCountColor READ getSectionCountColor WRITE setSectionCountColor)
+    Q_PROPERTY(QColor sectionLineColor READ getSectionLineColor WRITE setSectionLineColor)
 public:
-    using SortingMode = Settings::FriendListSortingMode;
-    explicit FriendListWidget(const Core& _core, Widget* parent, bool groupsOnTop = true);
-    ~FriendListWidget();
+    using SortingMode = FriendListModel::SortingMode;
+    explicit FriendListWidget(QWidget* parent = nullptr);
+    ~FriendListWidget() override;
+
     void setMode(SortingMode mode);
     SortingMode getMode() const;
 
-    void addGroupWidget(GroupWidget* widget);
-    void addFriendWidget(FriendWidget* w, Status::Status s, int circleIndex);
-    void removeGroupWidget(GroupWidget* w);
-    void removeFriendWidget(FriendWidget* w);
-    void addCircleWidget(int id);
-    void addCircleWidget(FriendWidget* widget = nullptr);
-    void removeCircleWidget(CircleWidget* widget);
+    void addFriend(std::shared_ptr<FriendChatroom> chatroom);
+    void removeFriend(const Friend* frnd);
+    void addGroup(std::shared_ptr<GroupChatroom> chatroom);
+    void removeGroup(const Group* group);
+    void addCircle();
     void searchChatrooms(const QString& searchString, bool hideOnline = false,
                          bool hideOffline = false, bool hideGroups = false);
 
-    void cycleContacts(GenericChatroomWidget* activeChatroomWidget, bool forward);
+    void cycleContacts(const Contact* activeContact, bool forward);
+    void setActiveContact(const Contact* contact);
+    void updateContact(const Contact* contact);
+    void updateActivity(const Friend* frnd);
+    void editName(const Contact* contact);
 
-    void updateActivityTime(const QDateTime& date);
-    void reDraw();
+    void trackContact(const Contact* contact);
+    void updateTracking(const Contact* contact);
+
+    QPixmap getAvatar(const Contact* contact, bool active);
+    QModelIndex getDropIndex() const;
+
+    QColor getNameColor() const;
+    void setNameColor(const QColor& color);
+    QColor getSectionNameColor() const;
+    void setSectionNameColor(const QColor& color);
+    QColor getSectionCountColor() const;
+    void setSectionCountColor(const QColor& color);
+    QColor getSectionLineColor() const;
+    void setSectionLineColor(const QColor& color);
 
 signals:
-    void onCompactChanged(bool compact);
-    void connectCircleWidget(CircleWidget& circleWidget);
-    void searchCircle(CircleWidget& circleWidget);
+    void chatroomActivated(const Contact* contact);
+    void newWindowRequested(const Contact* contact);
+    void removeFriendRequested(const ToxPk& friendPk);
+    void removeGroupRequested(const GroupId& groupId);
+    void friendHistoryRemoved(const ToxPk& friendPk);
+    void circleOpenRequested(const QVector<const Friend*>& friends);
+    void avatarRequested(const ToxPk& friendPk);
 
 public slots:
-    void renameGroupWidget(GroupWidget* groupWidget, const QString& newName);
-    void renameCircleWidget(CircleWidget* circleWidget, const QString& newName);
-    void onFriendWidgetRenamed(FriendWidget* friendWidget);
+    void onCompactChanged(bool compact);
     void onGroupchatPositionChanged(bool top);
-    void moveWidget(FriendWidget* w, Status::Status s, bool add = false);
+    void onAvatarSet(const ToxPk& friendPk, const QPixmap& pic);
+    void onAvatarRemoved(const ToxPk& friendPk);
+    void moveToNewCircle(const ToxPk& friendPk);
+    void moveToCircle(const ToxPk& friendPk, int circleId);
+    void updateVisualTracking();
+    void reloadTheme();
 
 protected:
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
+    void contextMenuEvent(QContextMenuEvent* event) override;
     void dragEnterEvent(QDragEnterEvent* event) override;
+    void dragMoveEvent(QDragMoveEvent* event) override;
+    void dragLeaveEvent(QDragLeaveEvent* event) override;
     void dropEvent(QDropEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
 
 private slots:
-    void dayTimeout();
+    void syncExpansion();
+    void onRowsInserted(const QModelIndex& parent, int first, int last);
+    void findNextContact();
+    void findPreviousContact();
 
 private:
-    CircleWidget* createCircleWidget(int id = -1);
-    QLayout* nextLayout(QLayout* layout, bool forward) const;
-    void moveFriends(QLayout* layout);
-    CategoryWidget* getTimeCategoryWidget(const Friend* frd) const;
-    void sortByMode(SortingMode mode);
-
-    SortingMode mode;
-    bool groupsOnTop;
-    FriendListLayout* listLayout;
-    GenericChatItemLayout* circleLayout = nullptr;
-    GenericChatItemLayout groupLayout;
-    QVBoxLayout* activityLayout = nullptr;
-    QTimer* dayTimer;
-
-    const Core& core;
+    enum Visibility : uint8_t
+    {
+        Visible,
+        Above,
+        Below
+    };
+
+    void showFriendMenu(Friend* frnd, const QPoint& pos);
+    void showGroupMenu(Group* group, const QPoint& pos);
+    void showCircleMenu(const QModelIndex& index, const QPoint& pos);
+    void showDetails(Friend* frnd);
+    void setSectionExpanded(const QModelIndex& index, bool expanded);
+    void expandSectionOf(const Contact* contact);
+    void editCircle(int circleId);
+    void dragContact(const QModelIndex& index);
+    QModelIndex dropTarget(const QPoint& pos) const;
+    void setDropIndex(const QModelIndex& index);
+    QPixmap renderAvatar(const QPixmap& pixmap) const;
+    const QPixmap& getDefaultAvatar(const QString& path, bool svg);
+    Visibility contactVisibility(const Contact* contact);
+    void scrollToTracked(Visibility visibility);
+    void recalculateTopEdge();
+    void recalculateBottomEdge();
+    void retranslateUi();
+
+    FriendListModel* model;
+    FriendListDelegate* delegate;
+    QHash<const Contact*, std::shared_ptr<FriendChatroom>> friendChatrooms;
+    QHash<const Contact*, std::shared_ptr<GroupChatroom>> groupChatrooms;
+
+    QHash<ToxPk, QPixmap> avatars;
+    QSet<ToxPk> requestedAvatars;
+    QHash<QString, QPixmap> defaultAvatars;
+
+    QPoint dragStartPos;
+    QPersistentModelIndex pressedIndex;
+    QPersistentModelIndex dropIndex;
+
+    QHash<const Contact*, Visibility> trackedContacts;
+    NotificationEdgeWidget* topEdge = nullptr;
+    NotificationEdgeWidget* bottomEdge = nullptr;
+    size_t referencesAbove = 0;
+    size_t referencesBelow = 0;
+
+    QColor nameColor;
+    QColor sectionNameColor;
+    QColor sectionCountColor;
+    QColor sectionLineColor;
 };
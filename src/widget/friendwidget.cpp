@@ -19,8 +19,7 @@
 
 #include "friendwidget.h"
 
-#include "circlewidget.h"
-#include "friendlistwidget.h"
+#include "friendcontextmenu.h"
 #include "groupwidget.h"
 #include "maskablepixmapwidget.h"
 
@@ -43,9 +42,7 @@
 #include <QContextMenuEvent>
 #include <QDebug>
 #include <QDrag>
-#include <QFileDialog>
 #include <QInputDialog>
-#include <QMenu>
 #include <QMimeData>
 
 #include <cassert>
@@ -72,8 +69,6 @@ FriendWidget::FriendWidget(std::shared_ptr<FriendChatroom> chatroom, bool compac
     connect(nameLabel, &CroppingLabel::editFinished, frnd, &Friend::setAlias);
     // update on changes of the displayed name
     connect(frnd, &Friend::displayedNameChanged, nameLabel, &CroppingLabel::setText);
-    connect(frnd, &Friend::displayedNameChanged, this,
-            [this](const QString /* &newName */) { emit friendWidgetRenamed(this); });
     connect(chatroom.get(), &FriendChatroom::activeChanged, this, &FriendWidget::setActive);
     statusMessageLabel->setTextFormat(Qt::PlainText);
 }
@@ -104,75 +99,18 @@ void FriendWidget::onContextMenuCalled(QContextMenuEvent* event)
 
     installEventFilter(this); // Disable leave event.
 
-    QMenu menu;
-
-    if (chatroom->possibleToOpenInNewWindow()) {
-        const auto openChatWindow = menu.addAction(tr("Open chat in new window"));
-        connect(openChatWindow, &QAction::triggered, [=]() { emit newWindowOpened(this); });
-    }
-
-    if (chatroom->canBeRemovedFromWindow()) {
-        const auto removeChatWindow = menu.addAction(tr("Remove chat from this window"));
-        connect(removeChatWindow, &QAction::triggered, this, &FriendWidget::removeChatWindow);
-    }
-
-    menu.addSeparator();
-    QMenu* inviteMenu =
-        menu.addMenu(tr("Invite to group", "Menu to invite a friend to a groupchat"));
-    inviteMenu->setEnabled(chatroom->canBeInvited());
-    const auto newGroupAction = inviteMenu->addAction(tr("To new group"));
-    connect(newGroupAction, &QAction::triggered, chatroom.get(), &FriendChatroom::inviteToNewGroup);
-    inviteMenu->addSeparator();
-
-    for (const auto& group : chatroom->getGroups()) {
-        const auto groupAction = inviteMenu->addAction(tr("Invite to group '%1'").arg(group.name));
-        connect(groupAction, &QAction::triggered, [=]() { chatroom->inviteFriend(group.group); });
-    }
-
-    const auto circleId = chatroom->getCircleId();
-    auto circleMenu =
-        menu.addMenu(tr("Move to circle...", "Menu to move a friend into a different circle"));
-
-    const auto newCircleAction = circleMenu->addAction(tr("To new circle"));
-    connect(newCircleAction, &QAction::triggered, this, &FriendWidget::moveToNewCircle);
-
-    if (circleId != -1) {
-        const auto circleName = chatroom->getCircleName();
-        const auto removeCircleAction =
-            circleMenu->addAction(tr("Remove from circle '%1'").arg(circleName));
-        connect(removeCircleAction, &QAction::triggered, this, &FriendWidget::removeFromCircle);
-    }
-
-    circleMenu->addSeparator();
-
-    for (const auto& circle : chatroom->getOtherCircles()) {
-        QAction* action = new QAction(tr("Move to circle \"%1\"").arg(circle.name), circleMenu);
-        connect(action, &QAction::triggered, [=]() { moveToCircle(circle.circleId); });
-        circleMenu->addAction(action);
-    }
-
-    const auto setAlias = menu.addAction(tr("Set alias..."));
-    connect(setAlias, &QAction::triggered, nameLabel, &CroppingLabel::editBegin);
-
-    menu.addSeparator();
-    auto autoAccept =
-        menu.addAction(tr("Auto accept files from this friend", "context menu entry"));
-    autoAccept->setCheckable(true);
-    autoAccept->setChecked(!chatroom->autoAcceptEnabled());
-    connect(autoAccept, &QAction::triggered, this, &FriendWidget::changeAutoAccept);
-    menu.addSeparator();
-
-    if (chatroom->friendCanBeRemoved()) {
-        const auto friendPk = chatroom->getFriend()->getPublicKey();
-        const auto removeAction =
-            menu.addAction(tr("Remove friend", "Menu to remove the friend from the friend list"));
-        connect(removeAction, &QAction::triggered, this, [=]() { emit removeFriend(friendPk); },
-                Qt::QueuedConnection);
-    }
-
-    menu.addSeparator();
-    const auto aboutWindow = menu.addAction(tr("Show details"));
-    connect(aboutWindow, &QAction::triggered, this, &FriendWidget::showDetails);
+    const auto friendPk = chatroom->getFriend()->getPublicKey();
+    FriendContextMenu menu{chatroom};
+    connect(&menu, &FriendContextMenu::newWindowRequested, this,
+            [=]() { emit newWindowOpened(this); });
+    connect(&menu, &FriendContextMenu::aliasEditRequested, nameLabel, &CroppingLabel::editBegin);
+    connect(&menu, &FriendContextMenu::moveToNewCircleRequested, this,
+            [=]() { emit moveToNewCircleRequested(friendPk); });
+    connect(&menu, &FriendContextMenu::moveToCircleRequested, this,
+            [=](int circleId) { emit moveToCircleRequested(friendPk, circleId); });
+    connect(&menu, &FriendContextMenu::removeFriendRequested, this,
+            [=]() { emit removeFriend(friendPk); }, Qt::QueuedConnection);
+    connect(&menu, &FriendContextMenu::detailsRequested, this, &FriendWidget::showDetails);
 
     const auto pos = event->globalPos();
     menu.exec(pos);
@@ -184,104 +122,6 @@ void FriendWidget::onContextMenuCalled(QContextMenuEvent* event)
     }
 }
 
-void FriendWidget::removeChatWindow()
-{
-    chatroom->removeFriendFromDialogs();
-}
-
-namespace {
-
-std::tuple<CircleWidget*, FriendListWidget*> getCircleAndFriendList(const Friend* frnd, FriendWidget* fw)
-{
-    const auto pk = frnd->getPublicKey();
-    const auto circleId = Settings::getInstance().getFriendCircleID(pk);
-    auto circleWidget = CircleWidget::getFromID(circleId);
-    auto w = circleWidget ? static_cast<QWidget*>(circleWidget) : static_cast<QWidget*>(fw);
-    auto friendList = qobject_cast<FriendListWidget*>(w->parentWidget());
-    return std::make_tuple(circleWidget, friendList);
-}
-
-} // namespace
-
-void FriendWidget::moveToNewCircle()
-{
-    const auto frnd = chatroom->getFriend();
-    CircleWidget* circleWidget;
-    FriendListWidget* friendList;
-    std::tie(circleWidget, friendList) = getCircleAndFriendList(frnd, this);
-
-    if (circleWidget != nullptr) {
-        circleWidget->updateStatus();
-    }
-
-    if (friendList != nullptr) {
-        friendList->addCircleWidget(this);
-    } else {
-        const auto pk = frnd->getPublicKey();
-        auto& s = Settings::getInstance();
-        auto circleId = s.addCircle();
-        s.setFriendCircleID(pk, circleId);
-    }
-}
-
-void FriendWidget::removeFromCircle()
-{
-    const auto frnd = chatroom->getFriend();
-    CircleWidget* circleWidget;
-    FriendListWidget* friendList;
-    std::tie(circleWidget, friendList) = getCircleAndFriendList(frnd, this);
-
-    if (friendList != nullptr) {
-        friendList->moveWidget(this, frnd->getStatus(), true);
-    } else {
-        const auto pk = frnd->getPublicKey();
-        auto& s = Settings::getInstance();
-        s.setFriendCircleID(pk, -1);
-    }
-
-    if (circleWidget != nullptr) {
-        circleWidget->updateStatus();
-        emit searchCircle(*circleWidget);
-    }
-}
-
-void FriendWidget::moveToCircle(int newCircleId)
-{
-    const auto frnd = chatroom->getFriend();
-    const auto pk = frnd->getPublicKey();
-    const auto oldCircleId = Settings::getInstance().getFriendCircleID(pk);
-    auto& s = Settings::getInstance();
-    auto oldCircleWidget = CircleWidget::getFromID(oldCircleId);
-    auto newCircleWidget = CircleWidget::getFromID(newCircleId);
-
-    if (newCircleWidget) {
-        newCircleWidget->addFriendWidget(this, frnd->getStatus());
-        newCircleWidget->setExpanded(true);
-        emit searchCircle(*newCircleWidget);
-        s.savePersonal();
-    } else {
-        s.setFriendCircleID(pk, newCircleId);
-    }
-
-    if (oldCircleWidget) {
-        oldCircleWidget->updateStatus();
-        emit searchCircle(*oldCircleWidget);
-    }
-}
-
-void FriendWidget::changeAutoAccept(bool enable)
-{
-    if (enable) {
-        const auto oldDir = chatroom->getAutoAcceptDir();
-        const auto newDir =
-            QFileDialog::getExistingDirectory(Q_NULLPTR,
-                                              tr("Choose an auto accept directory", "popup title"),
-                                              oldDir);
-        chatroom->setAutoAcceptDir(newDir);
-    } else {
-        chatroom->disableAutoAccept();
-    }
-}
 void FriendWidget::showDetails()
 {
     const auto frnd = chatroom->getFriend();
@@ -319,13 +159,6 @@ void FriendWidget::updateStatusLight()
     statusPic.setPixmap(QPixmap(Status::getIconPath(frnd->getStatus(), event)));
 
     if (event) {
-        const Settings& s = Settings::getInstance();
-        const uint32_t circleId = s.getFriendCircleID(frnd->getPublicKey());
-        CircleWidget* circleWidget = CircleWidget::getFromID(circleId);
-        if (circleWidget) {
-            circleWidget->setExpanded(true);
-        }
-
         emit updateFriendActivity(*frnd);
     }
 
@@ -334,7 +167,14 @@ void FriendWidget::updateStatusLight()
 
 QString FriendWidget::getStatusString() const
 {
-    const auto frnd = chatroom->getFriend();
+    return getStatusString(chatroom->getFriend());
+}
+
+/**
+ * @brief Describes the status of a friend, for window titles.
+ */
+QString FriendWidget::getStatusString(const Friend* frnd)
+{
     const int status = static_cast<int>(frnd->getStatus());
     const bool event = frnd->getEventFlag();
 
@@ -360,18 +200,6 @@ const Contact* FriendWidget::getContact() const
     return getFriend();
 }
 
-void FriendWidget::search(const QString& searchString, bool hide)
-{
-    const auto frnd = chatroom->getFriend();
-    searchName(searchString, hide);
-    const Settings& s = Settings::getInstance();
-    const uint32_t circleId = s.getFriendCircleID(frnd->getPublicKey());
-    CircleWidget* circleWidget = CircleWidget::getFromID(circleId);
-    if (circleWidget) {
-        circleWidget->search(searchString);
-    }
-}
-
 void FriendWidget::resetEventFlags()
 {
     chatroom->resetEventFlags();
@@ -27,7 +27,6 @@
 class FriendChatroom;
 class QPixmap;
 class MaskablePixmapWidget;
-class CircleWidget;
 
 class FriendWidget : public GenericChatroomWidget
 {
@@ -44,7 +43,7 @@ public:
     const Friend* getFriend() const final;
     const Contact* getContact() const final;
 
-    void search(const QString& searchString, bool hide = false);
+    static QString getStatusString(const Friend* frnd);
 
 signals:
     void friendWidgetClicked(FriendWidget* widget);
@@ -52,8 +51,8 @@ signals:
     void copyFriendIdToClipboard(const ToxPk& friendPk);
     void contextMenuCalled(QContextMenuEvent* event);
     void friendHistoryRemoved();
-    void friendWidgetRenamed(FriendWidget* friendWidget);
-    void searchCircle(CircleWidget& circleWidget);
+    void moveToNewCircleRequested(const ToxPk& friendPk);
+    void moveToCircleRequested(const ToxPk& friendPk, int circleId);
     void updateFriendActivity(Friend& frnd);
 
 public slots:
@@ -68,11 +67,6 @@ protected:
     void setFriendAlias();
 
 private slots:
-    void removeChatWindow();
-    void moveToNewCircle();
-    void removeFromCircle();
-    void moveToCircle(int circleId);
-    void changeAutoAccept(bool enable);
     void showDetails();
 
 public:
@@ -31,6 +31,7 @@
 GenericChatItemLayout::GenericChatItemLayout()
     : layout(new QVBoxLayout())
 {
+    collator.setNumericMode(true);
 }
 
 GenericChatItemLayout::~GenericChatItemLayout()
@@ -107,6 +108,7 @@ QLayout* GenericChatItemLayout::getLayout() const
 int GenericChatItemLayout::indexOfClosestSortedWidget(GenericChatItemWidget* widget) const
 {
     // Binary search: Deferred test of equality.
+    const QString name = widget->getName();
     int min = 0, max = layout->count();
     while (min < max) {
         int mid = (max - min) / 2 + min;
@@ -116,10 +118,7 @@ int GenericChatItemLayout::indexOfClosestSortedWidget(GenericChatItemWidget* wid
 
         bool lessThan = false;
 
-        QCollator collator;
-        collator.setNumericMode(true);
-
-        int compareValue = collator.compare(atMid->getName(), widget->getName());
+        int compareValue = collator.compare(atMid->getName(), name);
 
         if (compareValue < 0)
             lessThan = true;
@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <QCollator>
 #include <Qt>
 
 class QLayout;
@@ -47,4 +48,5 @@ public:
 private:
     int indexOfClosestSortedWidget(GenericChatItemWidget* widget) const;
     QVBoxLayout* layout;
+    QCollator collator;
 };
@@ -177,7 +177,15 @@ void GroupWidget::updateStatusLight()
 
 QString GroupWidget::getStatusString() const
 {
-    if (chatroom->hasNewMessage()) {
+    return getStatusString(chatroom->getGroup());
+}
+
+/**
+ * @brief Describes the status of a group, for window titles.
+ */
+QString GroupWidget::getStatusString(const Group* group)
+{
+    if (group->getEventFlag()) {
         return tr("New Message");
     } else {
         return tr("Online");
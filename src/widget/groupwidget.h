@@ -42,6 +42,8 @@ public:
     void setName(const QString& name);
     void editName();
 
+    static QString getStatusString(const Group* group);
+
 signals:
     void groupWidgetClicked(GroupWidget* widget);
     void removeGroup(const GroupId& groupId);
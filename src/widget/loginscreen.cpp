@@ -106,6 +106,7 @@ void LoginScreen::onProfileLoaded()
 
 void LoginScreen::onProfileLoadFailed()
 {
+    ui->loginButton->setEnabled(true);
     QMessageBox::critical(this, tr("Couldn't load this profile"), tr("Wrong password."));
     ui->loginPassword->setFocus();
     ui->loginPassword->selectAll();
@@ -199,6 +200,11 @@ void LoginScreen::onLoginUsernameSelected(const QString& name)
 
 void LoginScreen::onLogin()
 {
+    // the profile is still being unlocked
+    if (!ui->loginButton->isEnabled()) {
+        return;
+    }
+
     QString name = ui->loginUsernames->currentText();
     QString pass = ui->loginPassword->text();
 
@@ -216,6 +222,7 @@ void LoginScreen::onLogin()
         return;
     }
 
+    ui->loginButton->setEnabled(false);
     emit loadProfile(name, pass);
 }
 
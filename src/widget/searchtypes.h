@@ -91,4 +91,40 @@ public:
 
         return filter;
     }
+
+    /**
+     * @brief getRegexpForPhrase generates the regular expression that finds the phrase with the given filter
+     * @param phrase for search
+     * @param filter for search
+     * @return compiled regular expression, JIT-compiled if supported since it's run on every message
+     */
+    static QRegularExpression getRegexpForPhrase(const QString& phrase, FilterSearch filter) {
+        constexpr auto regexFlags = QRegularExpression::UseUnicodePropertiesOption;
+        constexpr auto caseInsensitiveFlags = QRegularExpression::CaseInsensitiveOption;
+
+        QRegularExpression regexp;
+        switch (filter) {
+        case FilterSearch::Register:
+            regexp = QRegularExpression(QRegularExpression::escape(phrase), regexFlags);
+            break;
+        case FilterSearch::WordsOnly:
+            regexp = QRegularExpression(generateFilterWordsOnly(phrase), caseInsensitiveFlags);
+            break;
+        case FilterSearch::RegisterAndWordsOnly:
+            regexp = QRegularExpression(generateFilterWordsOnly(phrase), regexFlags);
+            break;
+        case FilterSearch::RegisterAndRegular:
+            regexp = QRegularExpression(phrase, regexFlags);
+            break;
+        case FilterSearch::Regular:
+            regexp = QRegularExpression(phrase, caseInsensitiveFlags);
+            break;
+        default:
+            regexp = QRegularExpression(QRegularExpression::escape(phrase), caseInsensitiveFlags);
+            break;
+        }
+
+        regexp.optimize();
+        return regexp;
+    }
 };
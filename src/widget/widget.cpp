@@ -39,7 +39,6 @@
 #endif
 
 #include "audio/audio.h"
-#include "circlewidget.h"
 #include "contentdialog.h"
 #include "contentlayout.h"
 #include "friendlistwidget.h"
@@ -142,7 +141,7 @@ Widget::Widget(Profile &_profile, IAudioControl& audio, QWidget* parent)
     , profile{_profile}
     , trayMenu{nullptr}
     , ui(new Ui::MainWindow)
-    , activeChatroomWidget{nullptr}
+    , activeContact{nullptr}
     , eventFlag(false)
     , eventIcon(false)
     , audio(audio)
@@ -252,13 +251,7 @@ void Widget::init()
 
     sharedMessageProcessorParams.reset(new MessageProcessor::SharedParams(core->getMaxMessageSize(), coreExt->getMaxExtendedMessageSize()));
 
-    contactListWidget = new FriendListWidget(*core, this, settings.getGroupchatPosition());
-    connect(contactListWidget, &FriendListWidget::searchCircle, this, &Widget::searchCircle);
-    connect(contactListWidget, &FriendListWidget::connectCircleWidget, this,
-            &Widget::connectCircleWidget);
-    ui->friendList->setWidget(contactListWidget);
     ui->friendList->setLayoutDirection(Qt::RightToLeft);
-    ui->friendList->setContextMenuPolicy(Qt::CustomContextMenu);
 
     ui->statusLabel->setEditable(true);
 
@@ -326,6 +319,20 @@ void Widget::init()
     connect(filterGroup, &QActionGroup::triggered, this, &Widget::searchContacts);
     connect(filterDisplayGroup, &QActionGroup::triggered, this, &Widget::changeDisplayMode);
     connect(ui->friendList, &QWidget::customContextMenuRequested, this, &Widget::friendListContextMenu);
+    connect(ui->friendList, &FriendListWidget::chatroomActivated, this, &Widget::onChatroomActivated);
+    connect(ui->friendList, &FriendListWidget::newWindowRequested, this, &Widget::openNewDialog);
+    connect(ui->friendList, &FriendListWidget::removeFriendRequested, this,
+            [this](const ToxPk& friendPk) { removeFriend(friendPk); });
+    connect(ui->friendList, &FriendListWidget::removeGroupRequested, this,
+            [this](const GroupId& groupId) { removeGroup(groupId); });
+    connect(ui->friendList, &FriendListWidget::friendHistoryRemoved, this,
+            [this](const ToxPk& friendPk) { chatForms[friendPk]->clearChatArea(); });
+    connect(ui->friendList, &FriendListWidget::circleOpenRequested, this, &Widget::openCircleDialog);
+    connect(ui->friendList, &FriendListWidget::avatarRequested, this, &Widget::loadFriendAvatar,
+            Qt::QueuedConnection);
+    connect(&profile, &Profile::friendAvatarSet, ui->friendList, &FriendListWidget::onAvatarSet);
+    connect(&profile, &Profile::friendAvatarRemoved, ui->friendList,
+            &FriendListWidget::onAvatarRemoved);
 
     connect(coreFile, &CoreFile::fileSendStarted, this, &Widget::dispatchFile);
     connect(coreFile, &CoreFile::fileReceiveRequested, this, &Widget::dispatchFile);
@@ -333,7 +340,7 @@ void Widget::init()
     connect(coreFile, &CoreFile::fileTransferCancelled, this, &Widget::dispatchFile);
     connect(coreFile, &CoreFile::fileTransferFinished, this, &Widget::dispatchFile);
     connect(coreFile, &CoreFile::fileTransferPaused, this, &Widget::dispatchFile);
-    connect(coreFile, &CoreFile::fileTransferInfo, this, &Widget::dispatchFile);
+    connect(coreFile, &CoreFile::fileTransferInfo, this, &Widget::dispatchFileProgress);
     connect(coreFile, &CoreFile::fileTransferRemotePausedUnpaused, this, &Widget::dispatchFileWithBool);
     connect(coreFile, &CoreFile::fileTransferBrokenUnbroken, this, &Widget::dispatchFileWithBool);
     connect(coreFile, &CoreFile::fileSendFailed, this, &Widget::dispatchFileSendFailed);
@@ -461,9 +468,9 @@ void Widget::init()
     // settings
     connect(&settings, &Settings::showSystemTrayChanged, this, &Widget::onSetShowSystemTray);
     connect(&settings, &Settings::separateWindowChanged, this, &Widget::onSeparateWindowClicked);
-    connect(&settings, &Settings::compactLayoutChanged, contactListWidget,
+    connect(&settings, &Settings::compactLayoutChanged, ui->friendList,
             &FriendListWidget::onCompactChanged);
-    connect(&settings, &Settings::groupchatPositionChanged, contactListWidget,
+    connect(&settings, &Settings::groupchatPositionChanged, ui->friendList,
             &FriendListWidget::onGroupchatPositionChanged);
 
     connect(&GUI::getInstance(), &GUI::themeReload, this, &Widget::reloadTheme);
@@ -680,6 +687,7 @@ void Widget::onCoreChanged(Core& core)
     connect(&core, &Core::usernameSet, this, &Widget::setUsername);
     connect(&core, &Core::statusMessageSet, this, &Widget::setStatusMessage);
     connect(&core, &Core::friendAdded, this, &Widget::addFriend);
+    connect(&core, &Core::friendsLoaded, this, &Widget::onFriendsLoaded);
     connect(&core, &Core::failedToAddFriend, this, &Widget::addFriendFailed);
     connect(&core, &Core::friendUsernameChanged, this, &Widget::onFriendUsernameChanged);
     connect(&core, &Core::friendStatusChanged, this, &Widget::onCoreFriendStatusChanged);
@@ -976,7 +984,7 @@ void Widget::showProfile() // onAvatarClicked, onUsernameClicked
     }
 }
 
-void Widget::hideMainForms(GenericChatroomWidget* chatroomWidget)
+void Widget::hideMainForms(const Contact* contact)
 {
     setActiveToolMenuButton(ActiveToolMenuButton::None);
 
@@ -984,11 +992,8 @@ void Widget::hideMainForms(GenericChatroomWidget* chatroomWidget)
         contentLayout->clear();
     }
 
-    if (activeChatroomWidget != nullptr) {
-        activeChatroomWidget->setAsInactiveChatroom();
-    }
-
-    activeChatroomWidget = chatroomWidget;
+    activeContact = contact;
+    ui->friendList->setActiveContact(contact);
 }
 
 void Widget::setUsername(const QString& username)
@@ -1121,6 +1126,17 @@ void Widget::dispatchFileWithBool(ToxFile file, bool)
     dispatchFile(file);
 }
 
+void Widget::dispatchFileProgress(ToxFileProgressInfo info)
+{
+    const auto& friendId = FriendList::id2Key(info.friendId);
+    Friend* f = FriendList::findFriend(friendId);
+    if (!f) {
+        return;
+    }
+
+    friendChatLogs[f->getPublicKey()]->onFileProgress(info);
+}
+
 void Widget::dispatchFileSendFailed(uint32_t friendId, const QString& fileName)
 {
     const auto& friendPk = FriendList::id2Key(friendId);
@@ -1140,6 +1156,23 @@ void Widget::onRejectCall(uint32_t friendId)
     av->cancelCall(friendId);
 }
 
+/**
+ * @brief Creates the contacts of all friends stored in the tox save at once.
+ * @param friends Friends as read by Core on startup.
+ */
+void Widget::onFriendsLoaded(const QVector<FriendSnapshot>& friends)
+{
+    for (const FriendSnapshot& snapshot : friends) {
+        addFriend(snapshot.friendId, snapshot.publicKey);
+        // Friend::setName clears legacy aliases equal to the old name (issue #5013)
+        onFriendUsernameChanged(snapshot.friendId, snapshot.username);
+
+        if (!snapshot.statusMessage.isEmpty()) {
+            onFriendStatusMessageChanged(snapshot.friendId, snapshot.statusMessage);
+        }
+    }
+}
+
 void Widget::addFriend(uint32_t friendId, const ToxPk& friendPk)
 {
     assert(core != nullptr);
@@ -1149,9 +1182,6 @@ void Widget::addFriend(uint32_t friendId, const ToxPk& friendPk)
     auto dialogManager = ContentDialogManager::getInstance();
     auto rawChatroom = new FriendChatroom(newfriend, dialogManager, *core);
     std::shared_ptr<FriendChatroom> chatroom(rawChatroom);
-    const auto compact = settings.getCompactLayout();
-    auto widget = new FriendWidget(chatroom, compact);
-    connectFriendWidget(*widget);
     auto history = profile.getHistory();
 
     auto messageProcessor = MessageProcessor(*sharedMessageProcessorParams);
@@ -1169,7 +1199,6 @@ void Widget::addFriend(uint32_t friendId, const ToxPk& friendPk)
     friendMessageDispatchers[friendPk] = friendMessageDispatcher;
     friendChatLogs[friendPk] = chatHistory;
     friendChatrooms[friendPk] = chatroom;
-    friendWidgets[friendPk] = widget;
     chatForms[friendPk] = friendForm;
 
     const auto activityTime = settings.getFriendActivity(friendPk);
@@ -1178,9 +1207,7 @@ void Widget::addFriend(uint32_t friendId, const ToxPk& friendPk)
         settings.setFriendActivity(friendPk, chatTime);
     }
 
-    contactListWidget->addFriendWidget(widget, Status::Status::Offline,
-                                       settings.getFriendCircleID(friendPk));
-
+    ui->friendList->addFriend(chatroom);
 
     auto notifyReceivedCallback = [this, friendPk](const ToxPk& author, const Message& message) {
         newFriendMessageAlert(friendPk, message.content);
@@ -1201,26 +1228,33 @@ void Widget::addFriend(uint32_t friendId, const ToxPk& friendPk)
     connect(friendForm, &ChatForm::endCallNotification, this, &Widget::onCallEnd);
     connect(friendForm, &ChatForm::rejectCall, this, &Widget::onRejectCall);
 
-    connect(widget, &FriendWidget::newWindowOpened, this, &Widget::openNewDialog);
-    connect(widget, &FriendWidget::chatroomWidgetClicked, this, &Widget::onChatroomWidgetClicked);
-    connect(widget, &FriendWidget::chatroomWidgetClicked, friendForm, &ChatForm::focusInput);
-    connect(widget, &FriendWidget::friendHistoryRemoved, friendForm, &ChatForm::clearChatArea);
-    connect(widget, &FriendWidget::copyFriendIdToClipboard, this, &Widget::copyFriendIdToClipboard);
-    connect(widget, &FriendWidget::contextMenuCalled, widget, &FriendWidget::onContextMenuCalled);
-    connect(widget, SIGNAL(removeFriend(const ToxPk&)), this, SLOT(removeFriend(const ToxPk&)));
+    // The avatar is loaded from the cache once the friend is actually displayed
+    pendingAvatars.insert(friendPk);
+    connect(friendForm, &ChatForm::avatarRequested, this, &Widget::loadFriendAvatar,
+            Qt::QueuedConnection);
+}
 
-    connect(&profile, &Profile::friendAvatarSet, widget, &FriendWidget::onAvatarSet);
-    connect(&profile, &Profile::friendAvatarRemoved, widget, &FriendWidget::onAvatarRemoved);
+/**
+ * @brief Loads a friend's avatar from the cache, if it hasn't been loaded yet.
+ * @param friendPk Public key of the friend.
+ */
+void Widget::loadFriendAvatar(const ToxPk& friendPk)
+{
+    if (!pendingAvatars.remove(friendPk)) {
+        return;
+    }
 
-    // Try to get the avatar from the cache
     QPixmap avatar = profile.loadAvatar(friendPk);
-    if (!avatar.isNull()) {
-        friendForm->onAvatarChanged(friendPk, avatar);
-        widget->onAvatarSet(friendPk, avatar);
+    if (avatar.isNull()) {
+        return;
     }
 
-    FilterCriteria filter = getFilterCriteria();
-    widget->search(ui->searchContactText->text(), filterOffline(filter));
+    auto form = chatForms.find(friendPk);
+    if (form != chatForms.end()) {
+        (*form)->onAvatarChanged(friendPk, avatar);
+    }
+
+    ui->friendList->onAvatarSet(friendPk, avatar);
 }
 
 void Widget::addFriendFailed(const ToxPk&, const QString& errorInfo)
@@ -1262,17 +1296,10 @@ void Widget::onCoreFriendStatusChanged(int friendId, Status::Status status)
 
 void Widget::onFriendStatusChanged(const ToxPk& friendPk, Status::Status status)
 {
-    FriendWidget* widget = friendWidgets[friendPk];
-
-    if (Status::isOnline(status)) {
-        contactListWidget->moveWidget(widget, Status::Status::Online);
-    } else {
-        contactListWidget->moveWidget(widget, Status::Status::Offline);
-    }
-
-    widget->updateStatusLight();
-    if (widget->isActive()) {
-        setWindowTitle(widget->getTitle());
+    Q_UNUSED(status)
+    const Friend* f = FriendList::findFriend(friendPk);
+    if (f && f == activeContact) {
+        setWindowTitle(getContactTitle(f));
     }
 
     ContentDialogManager::getInstance()->updateFriendStatus(friendPk);
@@ -1290,7 +1317,6 @@ void Widget::onFriendStatusMessageChanged(int friendId, const QString& message)
     str.replace('\n', ' ').remove('\r').remove(QChar('\0'));
     f->setStatusMessage(str);
 
-    friendWidgets[friendPk]->setStatusMsg(str);
     chatForms[friendPk]->setStatusMessage(str);
 }
 
@@ -1304,8 +1330,7 @@ void Widget::onFriendDisplayedNameChanged(const QString& displayed)
         }
     }
 
-    FriendWidget* friendWidget = friendWidgets[f->getPublicKey()];
-    if (friendWidget->isActive()) {
+    if (f == activeContact) {
         GUI::setWindowTitle(displayed);
     }
 }
@@ -1325,39 +1350,72 @@ void Widget::onFriendUsernameChanged(int friendId, const QString& username)
 
 void Widget::onFriendAliasChanged(const ToxPk& friendId, const QString& alias)
 {
-    Friend* f = qobject_cast<Friend*>(sender());
-
-    // TODO(sudden6): don't update the contact list here, make it update itself
-    FriendWidget* friendWidget = friendWidgets[friendId];
-    Status::Status status = f->getStatus();
-    contactListWidget->moveWidget(friendWidget, status);
-    FilterCriteria criteria = getFilterCriteria();
-    bool filter = status == Status::Status::Offline ? filterOffline(criteria) : filterOnline(criteria);
-    friendWidget->searchName(ui->searchContactText->text(), filter);
-
     settings.setFriendAlias(friendId, alias);
     settings.savePersonal();
 }
 
-void Widget::onChatroomWidgetClicked(GenericChatroomWidget* widget)
+void Widget::onChatroomActivated(const Contact* contact)
 {
-    openDialog(widget, /* newWindow = */ false);
+    openDialog(contact, /* newWindow = */ false);
+    focusChatInput();
 }
 
-void Widget::openNewDialog(GenericChatroomWidget* widget)
+void Widget::openNewDialog(const Contact* contact)
 {
-    openDialog(widget, /* newWindow = */ true);
+    openDialog(contact, /* newWindow = */ true);
 }
 
-void Widget::openDialog(GenericChatroomWidget* widget, bool newWindow)
+/**
+ * @brief Opens all friends of a circle in a new window.
+ * @param friends Members of the circle.
+ */
+void Widget::openCircleDialog(const QVector<const Friend*>& friends)
 {
-    widget->resetEventFlags();
-    widget->updateStatusLight();
+    ContentDialog* dialog = createContentDialog();
+    for (const Friend* frnd : friends) {
+        addFriendDialog(frnd, dialog);
+    }
+
+    dialog->show();
+    dialog->ensureSplitterVisible();
+}
+
+/**
+ * @brief Clears the new message flag of a contact and repaints it.
+ */
+void Widget::resetEventFlags(const Contact* contact)
+{
+    const Friend* frnd = qobject_cast<const Friend*>(contact);
+    if (frnd) {
+        friendChatrooms[frnd->getPublicKey()]->resetEventFlags();
+    } else {
+        const Group* group = qobject_cast<const Group*>(contact);
+        groupChatrooms[group->getPersistentId()]->resetEventFlags();
+    }
+
+    ui->friendList->updateContact(contact);
+}
+
+/**
+ * @brief Builds the window title shown while the chat of a contact is open.
+ */
+QString Widget::getContactTitle(const Contact* contact) const
+{
+    const Friend* frnd = qobject_cast<const Friend*>(contact);
+    const QString status = frnd ? FriendWidget::getStatusString(frnd)
+                                : GroupWidget::getStatusString(qobject_cast<const Group*>(contact));
+
+    return contact->getDisplayedName() + QStringLiteral(" (") + status + QStringLiteral(")");
+}
+
+void Widget::openDialog(const Contact* contact, bool newWindow)
+{
+    resetEventFlags(contact);
 
     GenericChatForm* form;
     GroupId id;
-    const Friend* frnd = widget->getFriend();
-    const Group* group = widget->getGroup();
+    const Friend* frnd = qobject_cast<const Friend*>(contact);
+    const Group* group = qobject_cast<const Group*>(contact);
     if (frnd) {
         form = chatForms[frnd->getPublicKey()];
     } else {
@@ -1389,21 +1447,19 @@ void Widget::openDialog(GenericChatroomWidget* widget, bool newWindow)
         if (frnd) {
             addFriendDialog(frnd, dialog);
         } else {
-            Group* group = widget->getGroup();
-            addGroupDialog(group, dialog);
+            addGroupDialog(groupChatrooms[group->getPersistentId()]->getGroup(), dialog);
         }
 
         dialog->raise();
         dialog->activateWindow();
     } else {
-        hideMainForms(widget);
+        hideMainForms(contact);
         if (frnd) {
             chatForms[frnd->getPublicKey()]->show(contentLayout);
         } else {
             groupChatForms[group->getPersistentId()]->show(contentLayout);
         }
-        widget->setAsActiveChatroom();
-        setWindowTitle(widget->getTitle());
+        setWindowTitle(getContactTitle(contact));
     }
 }
 
@@ -1457,8 +1513,7 @@ void Widget::addFriendDialog(const Friend* frnd, ContentDialog* dialog)
     const ToxPk& friendPk = frnd->getPublicKey();
     ContentDialog* contentDialog = ContentDialogManager::getInstance()->getFriendDialog(friendPk);
     bool isSeparate = settings.getSeparateWindow();
-    FriendWidget* widget = friendWidgets[friendPk];
-    bool isCurrent = activeChatroomWidget == widget;
+    bool isCurrent = activeContact == frnd;
     if (!contentDialog && !isSeparate && isCurrent) {
         onAddClicked();
     }
@@ -1468,7 +1523,7 @@ void Widget::addFriendDialog(const Friend* frnd, ContentDialog* dialog)
     FriendWidget* friendWidget =
         ContentDialogManager::getInstance()->addFriendToDialog(dialog, chatroom, form);
 
-    friendWidget->setStatusMsg(widget->getStatusMsg());
+    friendWidget->setStatusMsg(frnd->getStatusMessage());
 
 #if (QT_VERSION >= QT_VERSION_CHECK(5, 7, 0))
     auto widgetRemoveFriend = QOverload<const ToxPk&>::of(&Widget::removeFriend);
@@ -1480,24 +1535,17 @@ void Widget::addFriendDialog(const Friend* frnd, ContentDialog* dialog)
             [=]() { dialog->removeFriend(friendPk); });
     connect(friendWidget, &FriendWidget::copyFriendIdToClipboard, this,
             &Widget::copyFriendIdToClipboard);
-    connect(friendWidget, &FriendWidget::newWindowOpened, this, &Widget::openNewDialog);
-
-    // Signal transmission from the created `friendWidget` (which shown in
-    // ContentDialog) to the `widget` (which shown in main widget)
-    // FIXME: emit should be removed
-    connect(friendWidget, &FriendWidget::contextMenuCalled, widget,
-            [=](QContextMenuEvent* event) { emit widget->contextMenuCalled(event); });
-
-    connect(friendWidget, &FriendWidget::chatroomWidgetClicked, [=](GenericChatroomWidget* w) {
-        Q_UNUSED(w)
-        emit widget->chatroomWidgetClicked(widget);
-    });
-    connect(friendWidget, &FriendWidget::newWindowOpened, [=](GenericChatroomWidget* w) {
-        Q_UNUSED(w)
-        emit widget->newWindowOpened(widget);
+    connect(friendWidget, &FriendWidget::contextMenuCalled, friendWidget,
+            &FriendWidget::onContextMenuCalled);
+    connect(friendWidget, &FriendWidget::friendHistoryRemoved, form, &ChatForm::clearChatArea);
+    connect(friendWidget, &FriendWidget::chatroomWidgetClicked, this, [=]() {
+        openDialog(frnd, /* newWindow = */ false);
+        form->focusInput();
     });
-    // FIXME: emit should be removed
-    emit widget->chatroomWidgetClicked(widget);
+    connect(friendWidget, &FriendWidget::newWindowOpened, this, [=]() { openNewDialog(frnd); });
+
+    openDialog(frnd, /* newWindow = */ false);
+    form->focusInput();
 
     connect(&profile, &Profile::friendAvatarSet, friendWidget, &FriendWidget::onAvatarSet);
     connect(&profile, &Profile::friendAvatarRemoved, friendWidget, &FriendWidget::onAvatarRemoved);
@@ -1513,8 +1561,7 @@ void Widget::addGroupDialog(Group* group, ContentDialog* dialog)
     const GroupId& groupId = group->getPersistentId();
     ContentDialog* groupDialog = ContentDialogManager::getInstance()->getGroupDialog(groupId);
     bool separated = settings.getSeparateWindow();
-    GroupWidget* widget = groupWidgets[groupId];
-    bool isCurrentWindow = activeChatroomWidget == widget;
+    bool isCurrentWindow = activeContact == group;
     if (!groupDialog && !separated && isCurrentWindow) {
         onAddClicked();
     }
@@ -1534,23 +1581,12 @@ void Widget::addGroupDialog(Group* group, ContentDialog* dialog)
     connect(groupWidget, &GroupWidget::middleMouseClicked, dialog,
             [=]() { dialog->removeGroup(groupId); });
     connect(groupWidget, &GroupWidget::chatroomWidgetClicked, chatForm, &ChatForm::focusInput);
-    connect(groupWidget, &GroupWidget::newWindowOpened, this, &Widget::openNewDialog);
-
-    // Signal transmission from the created `groupWidget` (which shown in
-    // ContentDialog) to the `widget` (which shown in main widget)
-    // FIXME: emit should be removed
-    connect(groupWidget, &GroupWidget::chatroomWidgetClicked, [=](GenericChatroomWidget* w) {
-        Q_UNUSED(w)
-        emit widget->chatroomWidgetClicked(widget);
-    });
+    connect(groupWidget, &GroupWidget::chatroomWidgetClicked, this,
+            [=]() { openDialog(group, /* newWindow = */ false); });
+    connect(groupWidget, &GroupWidget::newWindowOpened, this, [=]() { openNewDialog(group); });
 
-    connect(groupWidget, &GroupWidget::newWindowOpened, [=](GenericChatroomWidget* w) {
-        Q_UNUSED(w)
-        emit widget->newWindowOpened(widget);
-    });
-
-    // FIXME: emit should be removed
-    emit widget->chatroomWidgetClicked(widget);
+    openDialog(group, /* newWindow = */ false);
+    chatForm->focusInput();
 }
 
 bool Widget::newFriendMessageAlert(const ToxPk& friendId, const QString& text, bool sound, QString filename, size_t filesize)
@@ -1579,16 +1615,15 @@ bool Widget::newFriendMessageAlert(const ToxPk& friendId, const QString& text, b
             hasActive = ContentDialogManager::getInstance()->isContactActive(friendId);
         } else {
             currentWindow = window();
-            FriendWidget* widget = friendWidgets[friendId];
-            hasActive = widget == activeChatroomWidget;
+            hasActive = f == activeContact;
         }
     }
 
     if (newMessageAlert(currentWindow, hasActive, sound)) {
-        FriendWidget* widget = friendWidgets[friendId];
         f->setEventFlag(true);
-        widget->updateStatusLight();
-        ui->friendList->trackWidget(widget);
+        ui->friendList->updateContact(f);
+        updateFriendActivity(*f);
+        ui->friendList->trackContact(f);
 #if DESKTOP_NOTIFICATIONS
         auto notificationData = filename.isEmpty() ? notificationGenerator->friendMessageNotification(f, text)
                                                    : notificationGenerator->fileTransferNotification(f, filename, filesize);
@@ -1597,7 +1632,7 @@ bool Widget::newFriendMessageAlert(const ToxPk& friendId, const QString& text, b
 
         if (contentDialog == nullptr) {
             if (hasActive) {
-                setWindowTitle(widget->getTitle());
+                setWindowTitle(getContactTitle(f));
             }
         } else {
             ContentDialogManager::getInstance()->updateFriendStatus(friendId);
@@ -1616,14 +1651,13 @@ bool Widget::newGroupMessageAlert(const GroupId& groupId, const ToxPk& authorPk,
     QWidget* currentWindow;
     ContentDialog* contentDialog = ContentDialogManager::getInstance()->getGroupDialog(groupId);
     Group* g = GroupList::findGroup(groupId);
-    GroupWidget* widget = groupWidgets[groupId];
 
     if (contentDialog != nullptr) {
         currentWindow = contentDialog->window();
         hasActive = ContentDialogManager::getInstance()->isContactActive(groupId);
     } else {
         currentWindow = window();
-        hasActive = widget == activeChatroomWidget;
+        hasActive = g == activeContact;
     }
 
     if (!newMessageAlert(currentWindow, hasActive, true, notify)) {
@@ -1631,7 +1665,7 @@ bool Widget::newGroupMessageAlert(const GroupId& groupId, const ToxPk& authorPk,
     }
 
     g->setEventFlag(true);
-    widget->updateStatusLight();
+    ui->friendList->updateContact(g);
 #if DESKTOP_NOTIFICATIONS
     auto notificationData = notificationGenerator->groupMessageNotification(g, authorPk, message);
     notifier.notifyMessage(notificationData);
@@ -1639,7 +1673,7 @@ bool Widget::newGroupMessageAlert(const GroupId& groupId, const ToxPk& authorPk,
 
     if (contentDialog == nullptr) {
         if (hasActive) {
-            setWindowTitle(widget->getTitle());
+            setWindowTitle(getContactTitle(g));
         }
     } else {
         ContentDialogManager::getInstance()->updateGroupStatus(groupId);
@@ -1727,12 +1761,9 @@ void Widget::onFileReceiveRequested(const ToxFile& file)
 void Widget::updateFriendActivity(const Friend& frnd)
 {
     const ToxPk& pk = frnd.getPublicKey();
-    const auto oldTime = settings.getFriendActivity(pk);
     const auto newTime = QDateTime::currentDateTime();
     settings.setFriendActivity(pk, newTime);
-    FriendWidget* widget = friendWidgets[frnd.getPublicKey()];
-    contactListWidget->moveWidget(widget, frnd.getStatus());
-    contactListWidget->updateActivityTime(oldTime); // update old category widget
+    ui->friendList->updateActivity(&frnd);
 }
 
 void Widget::removeFriend(Friend* f, bool fake)
@@ -1751,16 +1782,15 @@ void Widget::removeFriend(Friend* f, bool fake)
     }
 
     const ToxPk friendPk = f->getPublicKey();
-    auto widget = friendWidgets[friendPk];
-    widget->setAsInactiveChatroom();
-    if (widget == activeChatroomWidget) {
-        activeChatroomWidget = nullptr;
+    if (f == activeContact) {
+        activeContact = nullptr;
         onAddClicked();
     }
 
     friendAlertConnections.remove(friendPk);
+    pendingAvatars.remove(friendPk);
 
-    contactListWidget->removeFriendWidget(widget);
+    ui->friendList->removeFriend(f);
 
     ContentDialog* lastDialog = ContentDialogManager::getInstance()->getFriendDialog(friendPk);
     if (lastDialog != nullptr) {
@@ -1778,9 +1808,6 @@ void Widget::removeFriend(Friend* f, bool fake)
         }
     }
 
-    friendWidgets.remove(friendPk);
-    delete widget;
-
     auto chatForm = chatForms[friendPk];
     chatForms.remove(friendPk);
     delete chatForm;
@@ -1789,8 +1816,6 @@ void Widget::removeFriend(Friend* f, bool fake)
     if (contentLayout && contentLayout->mainHead->layout()->isEmpty()) {
         onAddClicked();
     }
-
-    contactListWidget->reDraw();
 }
 
 void Widget::removeFriend(const ToxPk& friendId)
@@ -1798,24 +1823,22 @@ void Widget::removeFriend(const ToxPk& friendId)
     removeFriend(FriendList::findFriend(friendId), false);
 }
 
-void Widget::onDialogShown(GenericChatroomWidget* widget)
+void Widget::onDialogShown(const Contact* contact)
 {
-    widget->resetEventFlags();
-    widget->updateStatusLight();
+    resetEventFlags(contact);
 
-    ui->friendList->updateTracking(widget);
+    ui->friendList->updateTracking(contact);
     resetIcon();
 }
 
 void Widget::onFriendDialogShown(const Friend* f)
 {
-    onDialogShown(friendWidgets[f->getPublicKey()]);
+    onDialogShown(f);
 }
 
 void Widget::onGroupDialogShown(Group* g)
 {
-    const GroupId& groupId = g->getPersistentId();
-    onDialogShown(groupWidgets[groupId]);
+    onDialogShown(g);
 }
 
 void Widget::toggleFullscreen()
@@ -2026,14 +2049,11 @@ void Widget::onGroupTitleChanged(uint32_t groupnumber, const QString& author, co
     Group* g = GroupList::findGroup(groupId);
     assert(g);
 
-    GroupWidget* widget = groupWidgets[groupId];
-    if (widget->isActive()) {
+    if (g == activeContact) {
         GUI::setWindowTitle(title);
     }
 
     g->setTitle(author, title);
-    FilterCriteria filter = getFilterCriteria();
-    widget->searchName(ui->searchContactText->text(), filterGroups(filter));
 }
 
 void Widget::titleChangedByUser(const QString& title)
@@ -2056,15 +2076,13 @@ void Widget::removeGroup(Group* g, bool fake)
 {
     const auto& groupId = g->getPersistentId();
     const auto groupnumber = g->getId();
-    auto groupWidgetIt = groupWidgets.find(groupId);
-    if (groupWidgetIt == groupWidgets.end()) {
-        qWarning() << "Tried to remove group" << groupnumber << "but GroupWidget doesn't exist";
+    if (!groupChatrooms.contains(groupId)) {
+        qWarning() << "Tried to remove group" << groupnumber << "but GroupChatroom doesn't exist";
         return;
     }
-    auto widget = groupWidgetIt.value();
-    widget->setAsInactiveChatroom();
-    if (static_cast<GenericChatroomWidget*>(widget) == activeChatroomWidget) {
-        activeChatroomWidget = nullptr;
+
+    if (g == activeContact) {
+        activeContact = nullptr;
         onAddClicked();
     }
 
@@ -2077,9 +2095,9 @@ void Widget::removeGroup(Group* g, bool fake)
     if (!fake) {
         core->removeGroup(groupnumber);
     }
-    contactListWidget->removeGroupWidget(widget); // deletes widget
+    ui->friendList->removeGroup(g);
 
-    groupWidgets.remove(groupId);
+    groupChatrooms.remove(groupId);
     auto groupChatFormIt = groupChatForms.find(groupId);
     if (groupChatFormIt == groupChatForms.end()) {
         qWarning() << "Tried to remove group" << groupnumber << "but GroupChatForm doesn't exist";
@@ -2092,8 +2110,6 @@ void Widget::removeGroup(Group* g, bool fake)
     }
 
     groupAlertConnections.remove(groupId);
-
-    contactListWidget->reDraw();
 }
 
 void Widget::removeGroup(const GroupId& groupId)
@@ -2128,8 +2144,6 @@ Group* Widget::createGroup(uint32_t groupnumber, const GroupId& groupId)
     auto rawChatroom = new GroupChatroom(newgroup, dialogManager, *core);
     std::shared_ptr<GroupChatroom> chatroom(rawChatroom);
 
-    const auto compact = settings.getCompactLayout();
-    auto widget = new GroupWidget(chatroom, compact);
     auto messageProcessor = MessageProcessor(*sharedMessageProcessorParams);
     auto messageDispatcher =
         std::make_shared<GroupMessageDispatcher>(*newgroup, std::move(messageProcessor), *core,
@@ -2163,30 +2177,14 @@ Group* Widget::createGroup(uint32_t groupnumber, const GroupId& groupId)
     form->setColorizedNames(settings.getEnableGroupChatsColor());
     groupMessageDispatchers[groupId] = messageDispatcher;
     groupChatLogs[groupId] = groupChatLog;
-    groupWidgets[groupId] = widget;
     groupChatrooms[groupId] = chatroom;
     groupChatForms[groupId] = QSharedPointer<GroupChatForm>(form);
 
-    contactListWidget->addGroupWidget(widget);
-    widget->updateStatusLight();
-    contactListWidget->activateWindow();
+    ui->friendList->addGroup(chatroom);
 
-    connect(widget, &GroupWidget::chatroomWidgetClicked, this, &Widget::onChatroomWidgetClicked);
-    connect(widget, &GroupWidget::newWindowOpened, this, &Widget::openNewDialog);
-#if (QT_VERSION >= QT_VERSION_CHECK(5, 7, 0))
-    auto widgetRemoveGroup = QOverload<const GroupId&>::of(&Widget::removeGroup);
-#else
-    auto widgetRemoveGroup = static_cast<void (Widget::*)(const GroupId&)>(&Widget::removeGroup);
-#endif
-    connect(widget, &GroupWidget::removeGroup, this, widgetRemoveGroup);
-    connect(widget, &GroupWidget::middleMouseClicked, this, [=]() { removeGroup(groupId); });
-    connect(widget, &GroupWidget::chatroomWidgetClicked, form, &ChatForm::focusInput);
     connect(newgroup, &Group::titleChangedByUser, this, &Widget::titleChangedByUser);
     connect(core, &Core::usernameSet, newgroup, &Group::setSelfName);
 
-    FilterCriteria filter = getFilterCriteria();
-    widget->searchName(ui->searchContactText->text(), filterGroups(filter));
-
     return newgroup;
 }
 
@@ -2199,7 +2197,7 @@ void Widget::onEmptyGroupCreated(uint32_t groupnumber, const GroupId& groupId, c
     if (title.isEmpty()) {
         // Only rename group if groups are visible.
         if (groupsVisible()) {
-            groupWidgets[groupId]->editName();
+            ui->friendList->editName(group);
         }
     } else {
         group->setTitle(QString(), title);
@@ -2232,10 +2230,9 @@ bool Widget::event(QEvent* e)
         ui->friendList->updateVisualTracking();
         break;
     case QEvent::WindowActivate:
-        if (activeChatroomWidget) {
-            activeChatroomWidget->resetEventFlags();
-            activeChatroomWidget->updateStatusLight();
-            setWindowTitle(activeChatroomWidget->getTitle());
+        if (activeContact) {
+            resetEventFlags(activeContact);
+            setWindowTitle(getContactTitle(activeContact));
         }
 
         if (eventFlag) {
@@ -2408,7 +2405,7 @@ void Widget::onSplitterMoved(int pos, int index)
 
 void Widget::cycleContacts(bool forward)
 {
-    contactListWidget->cycleContacts(activeChatroomWidget, forward);
+    ui->friendList->cycleContacts(activeContact, forward);
 }
 
 bool Widget::filterGroups(FilterCriteria index)
@@ -2467,7 +2464,7 @@ void Widget::reloadTheme()
     ui->statusHead->setStyleSheet(statusPanelStyle);
     ui->friendList->setStyleSheet(Style::getStylesheet("friendList/friendList.css"));
     ui->statusButton->setStyleSheet(Style::getStylesheet("statusButton/statusButton.css"));
-    contactListWidget->reDraw();
+    ui->friendList->reloadTheme();
 
     profilePicture->setStyleSheet(Style::getStylesheet("window/profile.css"));
 }
@@ -2514,12 +2511,10 @@ void Widget::searchContacts()
     QString searchString = ui->searchContactText->text();
     FilterCriteria filter = getFilterCriteria();
 
-    contactListWidget->searchChatrooms(searchString, filterOnline(filter), filterOffline(filter),
-                                       filterGroups(filter));
+    ui->friendList->searchChatrooms(searchString, filterOnline(filter), filterOffline(filter),
+                                    filterGroups(filter));
 
     updateFilterText();
-
-    contactListWidget->reDraw();
 }
 
 void Widget::changeDisplayMode()
@@ -2527,9 +2522,9 @@ void Widget::changeDisplayMode()
     filterDisplayGroup->setEnabled(false);
 
     if (filterDisplayGroup->checkedAction() == filterDisplayActivity) {
-        contactListWidget->setMode(FriendListWidget::SortingMode::Activity);
+        ui->friendList->setMode(FriendListWidget::SortingMode::Activity);
     } else if (filterDisplayGroup->checkedAction() == filterDisplayName) {
-        contactListWidget->setMode(FriendListWidget::SortingMode::Name);
+        ui->friendList->setMode(FriendListWidget::SortingMode::Name);
     }
 
     searchContacts();
@@ -2562,13 +2557,6 @@ Widget::FilterCriteria Widget::getFilterCriteria() const
     return FilterCriteria::All;
 }
 
-void Widget::searchCircle(CircleWidget& circleWidget)
-{
-    FilterCriteria filter = getFilterCriteria();
-    QString text = ui->searchContactText->text();
-    circleWidget.search(text, true, filterOnline(filter), filterOffline(filter));
-}
-
 bool Widget::groupsVisible() const
 {
     FilterCriteria filter = getFilterCriteria();
@@ -2583,7 +2571,7 @@ void Widget::friendListContextMenu(const QPoint& pos)
     QAction* chosenAction = menu.exec(ui->friendList->mapToGlobal(pos));
 
     if (chosenAction == addCircleAction) {
-        contactListWidget->addCircleWidget();
+        ui->friendList->addCircle();
     } else if (chosenAction == createGroupAction) {
         core->createGroup();
     }
@@ -2698,12 +2686,10 @@ void Widget::retranslateUi()
 
 void Widget::focusChatInput()
 {
-    if (activeChatroomWidget) {
-        if (const Friend* f = activeChatroomWidget->getFriend()) {
-            chatForms[f->getPublicKey()]->focusInput();
-        } else if (Group* g = activeChatroomWidget->getGroup()) {
-            groupChatForms[g->getPersistentId()]->focusInput();
-        }
+    if (const Friend* f = qobject_cast<const Friend*>(activeContact)) {
+        chatForms[f->getPublicKey()]->focusInput();
+    } else if (const Group* g = qobject_cast<const Group*>(activeContact)) {
+        groupChatForms[g->getPersistentId()]->focusInput();
     }
 }
 
@@ -2714,14 +2700,11 @@ void Widget::refreshPeerListsLocal(const QString& username)
     }
 }
 
-void Widget::connectCircleWidget(CircleWidget& circleWidget)
-{
-    connect(&circleWidget, &CircleWidget::searchCircle, this, &Widget::searchCircle);
-    connect(&circleWidget, &CircleWidget::newContentDialog, this, &Widget::registerContentDialog);
-}
-
 void Widget::connectFriendWidget(FriendWidget& friendWidget)
 {
-    connect(&friendWidget, &FriendWidget::searchCircle, this, &Widget::searchCircle);
     connect(&friendWidget, &FriendWidget::updateFriendActivity, this, &Widget::updateFriendActivity);
+    connect(&friendWidget, &FriendWidget::moveToNewCircleRequested, ui->friendList,
+            &FriendListWidget::moveToNewCircle);
+    connect(&friendWidget, &FriendWidget::moveToCircleRequested, ui->friendList,
+            &FriendListWidget::moveToCircle);
 }
@@ -24,6 +24,7 @@
 #include <QFileInfo>
 #include <QMainWindow>
 #include <QPointer>
+#include <QSet>
 #include <QSystemTrayIcon>
 
 #include "genericchatitemwidget.h"
@@ -52,16 +53,15 @@ class AddFriendForm;
 class AlSink;
 class Camera;
 class ChatForm;
-class CircleWidget;
 class ContentDialog;
 class ContentLayout;
+class Contact;
 class Core;
 class FilesForm;
 class Friend;
 class FriendChatroom;
 class FriendListWidget;
 class FriendWidget;
-class GenericChatroomWidget;
 class Group;
 class GroupChatForm;
 class GroupChatroom;
@@ -164,6 +164,8 @@ public slots:
     void setUsername(const QString& username);
     void setStatusMessage(const QString& statusMessage);
     void addFriend(uint32_t friendId, const ToxPk& friendPk);
+    void onFriendsLoaded(const QVector<FriendSnapshot>& friends);
+    void loadFriendAvatar(const ToxPk& friendPk);
     void addFriendFailed(const ToxPk& userId, const QString& errorInfo = QString());
     void onCoreFriendStatusChanged(int friendId, Status::Status status);
     void onFriendStatusChanged(const ToxPk& friendPk, Status::Status status);
@@ -215,8 +217,9 @@ private slots:
     void onGroupClicked();
     void onTransferClicked();
     void showProfile();
-    void openNewDialog(GenericChatroomWidget* widget);
-    void onChatroomWidgetClicked(GenericChatroomWidget* widget);
+    void openNewDialog(const Contact* contact);
+    void onChatroomActivated(const Contact* contact);
+    void openCircleDialog(const QVector<const Friend*>& friends);
     void onStatusMessageChanged(const QString& newStatusMessage);
     void removeFriend(const ToxPk& friendId);
     void copyFriendIdToClipboard(const ToxPk& friendId);
@@ -234,7 +237,7 @@ private slots:
     void friendRequestsUpdate();
     void groupInvitesUpdate();
     void groupInvitesClear();
-    void onDialogShown(GenericChatroomWidget* widget);
+    void onDialogShown(const Contact* contact);
     void outgoingNotification();
     void onCallEnd();
     void incomingNotification(uint32_t friendId);
@@ -242,10 +245,9 @@ private slots:
     void onStopNotification();
     void dispatchFile(ToxFile file);
     void dispatchFileWithBool(ToxFile file, bool);
+    void dispatchFileProgress(ToxFileProgressInfo info);
     void dispatchFileSendFailed(uint32_t friendId, const QString& fileName);
-    void connectCircleWidget(CircleWidget& circleWidget);
     void connectFriendWidget(FriendWidget& friendWidget);
-    void searchCircle(CircleWidget& circleWidget);
     void updateFriendActivity(const Friend& frnd);
     void registerContentDialog(ContentDialog& contentDialog) const;
 
@@ -260,7 +262,7 @@ private:
 
     bool newMessageAlert(QWidget* currentWindow, bool isActive, bool sound = true, bool notify = true);
     void setActiveToolMenuButton(ActiveToolMenuButton newActiveButton);
-    void hideMainForms(GenericChatroomWidget* chatroomWidget);
+    void hideMainForms(const Contact* contact);
     Group* createGroup(uint32_t groupnumber, const GroupId& groupId);
     void removeFriend(Friend* f, bool fake = false);
     void removeGroup(Group* g, bool fake = false);
@@ -276,7 +278,9 @@ private:
     static bool filterOffline(FilterCriteria index);
     void retranslateUi();
     void focusChatInput();
-    void openDialog(GenericChatroomWidget* widget, bool newWindow);
+    void openDialog(const Contact* contact, bool newWindow);
+    void resetEventFlags(const Contact* contact);
+    QString getContactTitle(const Contact* contact) const;
     void playNotificationSound(IAudioSink::Sound sound, bool loop = false);
     void cleanupNotificationSound();
     void acceptFileTransfer(const ToxFile &file, const QString &path);
@@ -319,8 +323,7 @@ private:
     std::unique_ptr<UpdateCheck> updateCheck; // ownership should be moved outside Widget once non-singleton
     FilesForm* filesForm;
     static Widget* instance;
-    GenericChatroomWidget* activeChatroomWidget;
-    FriendListWidget* contactListWidget;
+    const Contact* activeContact;
     MaskablePixmapWidget* profilePicture;
     bool notify(QObject* receiver, QEvent* event);
     bool autoAwayActive = false;
@@ -337,7 +340,6 @@ private:
     std::unique_ptr<IAudioSink> audioNotification;
     Settings& settings;
 
-    QMap<ToxPk, FriendWidget*> friendWidgets;
     // Shared pointer because qmap copies stuff all over the place
     QMap<ToxPk, std::shared_ptr<FriendMessageDispatcher>> friendMessageDispatchers;
     // Stop gap method of linking our friend messages back to a group id.
@@ -348,9 +350,9 @@ private:
     QMap<ToxPk, std::shared_ptr<ChatHistory>> friendChatLogs;
     QMap<ToxPk, std::shared_ptr<FriendChatroom>> friendChatrooms;
     QMap<ToxPk, ChatForm*> chatForms;
+    QSet<ToxPk> pendingAvatars;
     std::map<ToxPk, std::unique_ptr<QTimer>> negotiateTimers;
 
-    QMap<GroupId, GroupWidget*> groupWidgets;
     QMap<GroupId, std::shared_ptr<GroupMessageDispatcher>> groupMessageDispatchers;
 
     // Stop gap method of linking our group messages back to a group id.
@@ -88,6 +88,7 @@ Q_OBJECT
 private slots:
     void startup_without_proxy();
     void startup_with_invalid_proxy();
+    void load_many_friends();
 
 private:
     /* Test Variables */
@@ -100,6 +101,35 @@ private:
 
 namespace {
     const int timeout = 90000; //90 seconds timeout allowed for test
+    const int numSyntheticFriends = 2000;
+
+    /**
+     * @brief Creates a tox save with the given number of friends with made up public keys.
+     */
+    QByteArray makeSaveWithFriends(int numFriends)
+    {
+        Tox_Options* options = tox_options_new(nullptr);
+        tox_options_set_udp_enabled(options, false);
+        tox_options_set_local_discovery_enabled(options, false);
+        Tox* tox = tox_new(options, nullptr);
+        tox_options_free(options);
+        if (!tox) {
+            return {};
+        }
+
+        uint8_t friendPk[TOX_PUBLIC_KEY_SIZE] = {0x00};
+        for (int i = 0; i < numFriends; ++i) {
+            friendPk[0] = static_cast<uint8_t>(i & 0xff);
+            friendPk[1] = static_cast<uint8_t>((i >> 8) & 0xff);
+            friendPk[2] = 0x42;
+            tox_friend_add_norequest(tox, friendPk, nullptr);
+        }
+
+        QByteArray savedata(static_cast<int>(tox_get_savedata_size(tox)), 0x00);
+        tox_get_savedata(tox, reinterpret_cast<uint8_t*>(savedata.data()));
+        tox_kill(tox);
+        return savedata;
+    }
 }
 
 void TestCore::startup_without_proxy()
@@ -160,5 +190,37 @@ void TestCore::startup_with_invalid_proxy()
     }
 }
 
+/**
+ * @brief Checks that all friends of a big friend list are delivered in a single signal and
+ * reports how long it took from starting Core.
+ */
+void TestCore::load_many_friends()
+{
+    qRegisterMetaType<QVector<FriendSnapshot>>("QVector<FriendSnapshot>");
+
+    settings = new MockSettings();
+    settings->setProxyAddr("");
+    settings->setProxyPort(0);
+    settings->setProxyType(MockSettings::ProxyType::ptNone);
+
+    const QByteArray friendSave = makeSaveWithFriends(numSyntheticFriends);
+    QVERIFY(!friendSave.isEmpty());
+
+    MockNodeListGenerator nodesGenerator{};
+    test_core = Core::makeToxCore(friendSave, settings, nodesGenerator, err);
+    QVERIFY(test_core != nullptr);
+
+    QSignalSpy spyFriends(test_core.get(), &Core::friendsLoaded);
+    QElapsedTimer timer;
+    timer.start();
+    test_core->start();
+    QVERIFY(spyFriends.wait(timeout));
+    qDebug() << "Loaded" << numSyntheticFriends << "friends in" << timer.elapsed() << "ms";
+
+    QCOMPARE(spyFriends.count(), 1);
+    const auto friends = spyFriends.at(0).at(0).value<QVector<FriendSnapshot>>();
+    QCOMPARE(friends.size(), numSyntheticFriends);
+}
+
 QTEST_GUILESS_MAIN(TestCore)
 #include "core_test.moc"
@@ -0,0 +1,88 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "src/core/coreloopmetrics.h"
+
+#include <QtTest/QtTest>
+
+class TestCoreLoopMetrics : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testEmpty();
+    void testWindow();
+    void testCallbackScope();
+};
+
+void TestCoreLoopMetrics::testEmpty()
+{
+    CoreLoopMetrics metrics;
+    const auto snapshot = metrics.getSnapshot();
+    QCOMPARE(snapshot.iterationsPerSecond, 0.0);
+    QCOMPARE(snapshot.callbacks, 0ull);
+}
+
+/**
+ * @brief Values are only published once a window is complete, then start over.
+ */
+void TestCoreLoopMetrics::testWindow()
+{
+    CoreLoopMetrics metrics{1000};
+
+    // 100 iterations in one second, every 10ms, holding the lock for 2ms and for 12ms once
+    for (int i = 0; i < 100; ++i) {
+        metrics.addCallback(500);
+        QVERIFY(!metrics.addIteration(i * 10, i == 50 ? 12000000 : 2000000));
+    }
+    QCOMPARE(metrics.getSnapshot().iterationsPerSecond, 0.0);
+
+    QVERIFY(metrics.addIteration(1000, 2000000));
+    auto snapshot = metrics.getSnapshot();
+    QCOMPARE(snapshot.iterationsPerSecond, 101.0);
+    QCOMPARE(snapshot.averageLockHoldUs, 2099ll);
+    QCOMPARE(snapshot.maxLockHoldUs, 12000ll);
+    QCOMPARE(snapshot.callbacks, 100ull);
+    QCOMPARE(snapshot.averageCallbackNs, 500ll);
+
+    // an idle window
+    QVERIFY(metrics.addIteration(3000, 1000000));
+    snapshot = metrics.getSnapshot();
+    QCOMPARE(snapshot.iterationsPerSecond, 0.5);
+    QCOMPARE(snapshot.maxLockHoldUs, 1000ll);
+    QCOMPARE(snapshot.callbacks, 0ull);
+    QCOMPARE(snapshot.averageCallbackNs, 0ll);
+}
+
+void TestCoreLoopMetrics::testCallbackScope()
+{
+    CoreLoopMetrics metrics{1000};
+    {
+        CoreLoopMetrics::CallbackScope scope{metrics};
+        QThread::msleep(2);
+    }
+    metrics.addIteration(0, 0);
+    metrics.addIteration(1000, 0);
+
+    const auto snapshot = metrics.getSnapshot();
+    QCOMPARE(snapshot.callbacks, 1ull);
+    QVERIFY(snapshot.averageCallbackNs >= 2000000);
+}
+
+QTEST_GUILESS_MAIN(TestCoreLoopMetrics)
+#include "coreloopmetrics_test.moc"
@@ -0,0 +1,177 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "src/core/fileprogressaggregator.h"
+#include "src/core/toxfile.h"
+
+#include <QtTest/QtTest>
+
+namespace {
+// size of a toxcore file chunk
+const quint64 chunkSize = 1371;
+const quint64 megabyte = 1024 * 1024;
+// Core iterates every 10ms while a transfer is running
+const qint64 iterationMs = 10;
+
+ToxFile makeFile(uint32_t friendId, uint32_t fileNum, quint64 filesize)
+{
+    ToxFile file{fileNum, friendId, "file", "", ToxFile::RECEIVING};
+    file.bytesSent = 0;
+    file.filesize = filesize;
+    return file;
+}
+
+/**
+ * @brief Feeds a transfer through the aggregator like CoreFile does.
+ * @param bytesPerIteration Data received between two Core iterations.
+ * @return Number of progress updates that would be emitted to the GUI thread.
+ */
+int simulateTransfer(FileProgressAggregator& aggregator, ToxFile& file, quint64 bytesPerIteration)
+{
+    int events = 0;
+    qint64 now = 0;
+    while (file.bytesSent < file.filesize) {
+        const quint64 iterationEnd = qMin(file.bytesSent + bytesPerIteration, file.filesize);
+        while (file.bytesSent < iterationEnd) {
+            file.bytesSent = qMin(file.bytesSent + chunkSize, file.filesize);
+            aggregator.addChunk(file);
+        }
+        events += aggregator.takeDue(now).size();
+        now += iterationMs;
+    }
+    return events;
+}
+} // namespace
+
+class TestFileProgressAggregator : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testLatestProgressWins();
+    void testInterval();
+    void testRemoveFile();
+    void testMultipleTransfers();
+    void benchmarkEventsPerMegabyte();
+};
+
+/**
+ * @brief Only the most recent position of a transfer is published.
+ */
+void TestFileProgressAggregator::testLatestProgressWins()
+{
+    FileProgressAggregator aggregator;
+    ToxFile file = makeFile(1, 2, 10 * chunkSize);
+    for (int i = 0; i < 5; ++i) {
+        file.bytesSent += chunkSize;
+        aggregator.addChunk(file);
+    }
+
+    auto due = aggregator.takeDue(0);
+    QCOMPARE(due.size(), 1);
+    QCOMPARE(due[0].friendId, 1u);
+    QCOMPARE(due[0].fileNum, 2u);
+    QCOMPARE(due[0].direction, ToxFile::RECEIVING);
+    QCOMPARE(due[0].bytesSent, 5 * chunkSize);
+    QCOMPARE(due[0].filesize, 10 * chunkSize);
+}
+
+/**
+ * @brief Updates are held back until the interval since the last batch has elapsed.
+ */
+void TestFileProgressAggregator::testInterval()
+{
+    FileProgressAggregator aggregator{100};
+    ToxFile file = makeFile(0, 0, 10 * chunkSize);
+
+    file.bytesSent = chunkSize;
+    aggregator.addChunk(file);
+    QCOMPARE(aggregator.takeDue(0).size(), 1);
+
+    file.bytesSent = 2 * chunkSize;
+    aggregator.addChunk(file);
+    QVERIFY(aggregator.takeDue(50).isEmpty());
+    QVERIFY(aggregator.takeDue(99).isEmpty());
+
+    auto due = aggregator.takeDue(100);
+    QCOMPARE(due.size(), 1);
+    QCOMPARE(due[0].bytesSent, 2 * chunkSize);
+
+    // nothing changed since
+    QVERIFY(aggregator.takeDue(500).isEmpty());
+}
+
+/**
+ * @brief Progress of finished or cancelled transfers is never published.
+ */
+void TestFileProgressAggregator::testRemoveFile()
+{
+    FileProgressAggregator aggregator;
+    ToxFile file = makeFile(3, 4, 10 * chunkSize);
+    file.bytesSent = chunkSize;
+    aggregator.addChunk(file);
+    aggregator.removeFile(3, 4);
+    QVERIFY(aggregator.takeDue(0).isEmpty());
+}
+
+/**
+ * @brief Concurrent transfers are reported separately in the same batch.
+ */
+void TestFileProgressAggregator::testMultipleTransfers()
+{
+    FileProgressAggregator aggregator;
+    ToxFile first = makeFile(1, 0, 10 * chunkSize);
+    ToxFile second = makeFile(2, 0, 10 * chunkSize);
+    first.bytesSent = chunkSize;
+    second.bytesSent = 3 * chunkSize;
+    aggregator.addChunk(first);
+    aggregator.addChunk(second);
+    aggregator.addChunk(first);
+
+    auto due = aggregator.takeDue(0);
+    QCOMPARE(due.size(), 2);
+    for (const ToxFileProgressInfo& info : due) {
+        QCOMPARE(info.bytesSent, info.friendId == 1 ? chunkSize : 3 * chunkSize);
+    }
+}
+
+/**
+ * @brief Reports GUI-thread progress events per MB for a 64 MB transfer at 5 MB/s.
+ *
+ * Without aggregation every chunk is one event, i.e. ~765 events per MB.
+ */
+void TestFileProgressAggregator::benchmarkEventsPerMegabyte()
+{
+    const quint64 filesize = 64 * megabyte;
+    const quint64 bytesPerSecond = 5 * megabyte;
+    const quint64 bytesPerIteration = bytesPerSecond * iterationMs / 1000;
+
+    FileProgressAggregator aggregator;
+    ToxFile file = makeFile(0, 0, filesize);
+    const int events = simulateTransfer(aggregator, file, bytesPerIteration);
+
+    const qreal eventsPerMegabyte = static_cast<qreal>(events) * megabyte / filesize;
+    const qreal chunksPerMegabyte = static_cast<qreal>(megabyte) / chunkSize;
+    // 5 MB/s with one update per 100ms gives two updates per MB
+    QVERIFY(eventsPerMegabyte <= 2.1);
+    QVERIFY(eventsPerMegabyte * 100 < chunksPerMegabyte);
+    QTest::setBenchmarkResult(eventsPerMegabyte, QTest::Events);
+}
+
+QTEST_GUILESS_MAIN(TestFileProgressAggregator)
+#include "fileprogressaggregator_test.moc"
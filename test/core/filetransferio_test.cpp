@@ -0,0 +1,251 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "src/core/filetransferio.h"
+
+#include <QtTest/QtTest>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+#include <atomic>
+
+namespace {
+// size of a toxcore file chunk
+const int chunkSize = 1371;
+const uint64_t key = 42;
+
+QByteArray makeContent(int size)
+{
+    QByteArray content;
+    content.reserve(size);
+    for (int i = 0; i < size; ++i) {
+        content.append(static_cast<char>(i * 7));
+    }
+    return content;
+}
+} // namespace
+
+class TestFileTransferIo : public QObject
+{
+    Q_OBJECT
+private slots:
+    void init();
+    void testReceive();
+    void testReceiveFull();
+    void testSend();
+    void testSendSeek();
+    void testSendMissingFile();
+    void testUnknownTransfer();
+
+private:
+    std::unique_ptr<QTemporaryDir> dir;
+    // spans several blocks and a partial one
+    const QByteArray content = makeContent(3 * FileTransferIo::blockSize + 1234);
+};
+
+void TestFileTransferIo::init()
+{
+    dir.reset(new QTemporaryDir);
+    QVERIFY(dir->isValid());
+}
+
+/**
+ * @brief Received chunks end up on disk and hashed once the transfer is closed.
+ */
+void TestFileTransferIo::testReceive()
+{
+    const QString path = dir->filePath("received");
+    auto file = std::make_shared<QFile>(path);
+    QVERIFY(file->open(QIODevice::ReadWrite));
+    auto hash = std::make_shared<QCryptographicHash>(QCryptographicHash::Sha256);
+
+    FileTransferIo io;
+    io.start();
+    io.startReceive(key, file, hash);
+    for (int pos = 0; pos < content.size(); pos += chunkSize) {
+        const QByteArray chunk = content.mid(pos, chunkSize);
+        QCOMPARE(io.write(key, reinterpret_cast<const uint8_t*>(chunk.constData()),
+                          static_cast<size_t>(chunk.size())),
+                 FileTransferIo::WriteResult::Ok);
+    }
+
+    std::atomic<bool> closed{false};
+    io.close(key, [&closed]() { closed = true; });
+    io.stop();
+    QVERIFY(closed);
+
+    QFile result(path);
+    QVERIFY(result.open(QIODevice::ReadOnly));
+    QCOMPARE(result.readAll(), content);
+    QCOMPARE(hash->result(), QCryptographicHash::hash(content, QCryptographicHash::Sha256));
+}
+
+/**
+ * @brief A backlog too large for the disk asks for a pause, and reports when it's written.
+ */
+void TestFileTransferIo::testReceiveFull()
+{
+    const QString path = dir->filePath("received");
+    auto file = std::make_shared<QFile>(path);
+    QVERIFY(file->open(QIODevice::ReadWrite));
+    auto hash = std::make_shared<QCryptographicHash>(QCryptographicHash::Sha256);
+
+    std::atomic<bool> drained{false};
+    FileTransferIo io;
+    io.startReceive(key, file, hash, [&drained]() { drained = true; });
+
+    // the I/O thread isn't running yet, so nothing gets written
+    const QByteArray block = makeContent(FileTransferIo::blockSize);
+    const auto data = reinterpret_cast<const uint8_t*>(block.constData());
+    const int blocks = FileTransferIo::writeBehindSize / FileTransferIo::blockSize;
+    for (int i = 1; i < blocks; ++i) {
+        QCOMPARE(io.write(key, data, static_cast<size_t>(block.size())),
+                 FileTransferIo::WriteResult::Ok);
+    }
+    QCOMPARE(io.write(key, data, static_cast<size_t>(block.size())),
+             FileTransferIo::WriteResult::Full);
+    // chunks still in flight are accepted
+    QCOMPARE(io.write(key, data, static_cast<size_t>(block.size())),
+             FileTransferIo::WriteResult::Full);
+    QVERIFY(!drained);
+
+    io.start();
+    QTRY_VERIFY(drained);
+    io.close(key);
+    io.stop();
+    QCOMPARE(QFileInfo(path).size(), static_cast<qint64>(blocks + 1) * block.size());
+}
+
+/**
+ * @brief Sent chunks are served from the read-ahead buffer in order.
+ */
+void TestFileTransferIo::testSend()
+{
+    const QString path = dir->filePath("sent");
+    {
+        QFile source(path);
+        QVERIFY(source.open(QIODevice::WriteOnly));
+        source.write(content);
+    }
+
+    auto file = std::make_shared<QFile>(path);
+    QVERIFY(file->open(QIODevice::ReadOnly));
+    auto hash = std::make_shared<QCryptographicHash>(QCryptographicHash::Sha256);
+
+    FileTransferIo io;
+    io.start();
+    io.startSend(key, file, hash, static_cast<quint64>(content.size()));
+
+    QByteArray sent;
+    while (sent.size() < content.size()) {
+        const size_t length = static_cast<size_t>(qMin(chunkSize, content.size() - sent.size()));
+        QByteArray chunk;
+        const auto result = io.read(key, static_cast<quint64>(sent.size()), length, chunk);
+        QVERIFY(result != FileTransferIo::ReadResult::Error);
+        if (result == FileTransferIo::ReadResult::Pending) {
+            QThread::msleep(1);
+            continue;
+        }
+        sent.append(chunk);
+    }
+    io.close(key);
+    io.stop();
+
+    QCOMPARE(sent, content);
+    QCOMPARE(hash->result(), QCryptographicHash::hash(content, QCryptographicHash::Sha256));
+}
+
+/**
+ * @brief Requests outside of the read-ahead buffer, like on resume, read from there.
+ */
+void TestFileTransferIo::testSendSeek()
+{
+    const QString path = dir->filePath("sent");
+    {
+        QFile source(path);
+        QVERIFY(source.open(QIODevice::WriteOnly));
+        source.write(content);
+    }
+
+    auto file = std::make_shared<QFile>(path);
+    QVERIFY(file->open(QIODevice::ReadOnly));
+    auto hash = std::make_shared<QCryptographicHash>(QCryptographicHash::Sha256);
+
+    FileTransferIo io;
+    io.start();
+    io.startSend(key, file, hash, static_cast<quint64>(content.size()));
+
+    const auto readAt = [&io](quint64 position, QByteArray& chunk) {
+        auto result = FileTransferIo::ReadResult::Pending;
+        QTRY_VERIFY((result = io.read(key, position, chunkSize, chunk))
+                    != FileTransferIo::ReadResult::Pending);
+        QCOMPARE(result, FileTransferIo::ReadResult::Ok);
+    };
+
+    // forward, skipping data
+    const quint64 ahead = 2 * FileTransferIo::blockSize + 17;
+    QByteArray chunk;
+    readAt(ahead, chunk);
+    QCOMPARE(chunk, content.mid(static_cast<int>(ahead), chunkSize));
+
+    // back to a position that has already been dropped
+    readAt(5, chunk);
+    QCOMPARE(chunk, content.mid(5, chunkSize));
+
+    QCOMPARE(io.read(key, static_cast<quint64>(content.size()), chunkSize, chunk),
+             FileTransferIo::ReadResult::Error);
+    io.close(key);
+    io.stop();
+}
+
+/**
+ * @brief A file that can't be read fails the transfer instead of stalling it.
+ */
+void TestFileTransferIo::testSendMissingFile()
+{
+    auto file = std::make_shared<QFile>(dir->filePath("missing"));
+    auto hash = std::make_shared<QCryptographicHash>(QCryptographicHash::Sha256);
+
+    FileTransferIo io;
+    io.start();
+    io.startSend(key, file, hash, 100);
+
+    QByteArray chunk;
+    auto result = FileTransferIo::ReadResult::Pending;
+    QTRY_VERIFY((result = io.read(key, 0, 100, chunk)) != FileTransferIo::ReadResult::Pending);
+    QCOMPARE(result, FileTransferIo::ReadResult::Error);
+}
+
+void TestFileTransferIo::testUnknownTransfer()
+{
+    FileTransferIo io;
+    QByteArray chunk;
+    const uint8_t data[] = {1, 2, 3};
+    QCOMPARE(io.read(key, 0, 1, chunk), FileTransferIo::ReadResult::Error);
+    QCOMPARE(io.write(key, data, sizeof(data)), FileTransferIo::WriteResult::Error);
+
+    bool closed = false;
+    io.close(key, [&closed]() { closed = true; });
+    QVERIFY(closed);
+}
+
+QTEST_GUILESS_MAIN(TestFileTransferIo)
+#include "filetransferio_test.moc"
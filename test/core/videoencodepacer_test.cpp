@@ -0,0 +1,114 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "src/core/videoencodepacer.h"
+
+#include <QtTest/QtTest>
+
+namespace {
+// a 30 fps camera
+const qint64 frameIntervalMs = 33;
+
+/**
+ * @brief Offers frames for durationMs, returns how many were accepted
+ */
+int sendFrames(VideoEncodePacer& pacer, qint64 startMs, qint64 durationMs)
+{
+    int sent = 0;
+    for (qint64 now = startMs; now < startMs + durationMs; now += frameIntervalMs) {
+        if (pacer.beginFrame(now)) {
+            pacer.endFrame(true, 1000000);
+            ++sent;
+        }
+    }
+    return sent;
+}
+} // namespace
+
+class TestVideoEncodePacer : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testFullRate();
+    void testLowBitrate();
+    void testBitrateChange();
+    void testFailedFrame();
+};
+
+void TestVideoEncodePacer::testFullRate()
+{
+    VideoEncodePacer pacer{2500};
+    QCOMPARE(sendFrames(pacer, 0, 3300), 100);
+    QVERIFY(!pacer.getFrameSize({1920, 1080}).isValid());
+
+    const auto stats = pacer.getStats();
+    QCOMPARE(stats.droppedFrames, 0ull);
+    QCOMPARE(stats.averageEncodeUs, 1000ll);
+}
+
+/**
+ * @brief A low bitrate spreads fewer, smaller frames evenly.
+ */
+void TestVideoEncodePacer::testLowBitrate()
+{
+    VideoEncodePacer pacer{300};
+    const int sent = sendFrames(pacer, 0, 2 * VideoEncodePacer::windowMs);
+    QVERIFY(qAbs(sent - 200) <= 2);
+
+    const auto stats = pacer.getStats();
+    QVERIFY(qAbs(stats.framesPerSecond - 20.0) < 1.0);
+    QVERIFY(stats.droppedFrames >= 98);
+
+    QCOMPARE(pacer.getFrameSize({1280, 720}), QSize(640, 360));
+    QVERIFY(!pacer.getFrameSize({320, 240}).isValid());
+}
+
+void TestVideoEncodePacer::testBitrateChange()
+{
+    VideoEncodePacer pacer{2500};
+    uint32_t bitrate = 0;
+    QVERIFY(!pacer.takeBitrateChange(bitrate));
+
+    pacer.setBitrate(2500);
+    QVERIFY(!pacer.takeBitrateChange(bitrate));
+
+    pacer.setBitrate(800);
+    QVERIFY(pacer.takeBitrateChange(bitrate));
+    QCOMPARE(bitrate, 800u);
+    QVERIFY(!pacer.takeBitrateChange(bitrate));
+    QCOMPARE(pacer.getFrameSize({1920, 1080}), QSize(852, 480));
+}
+
+/**
+ * @brief Frames toxav didn't take count as dropped.
+ */
+void TestVideoEncodePacer::testFailedFrame()
+{
+    VideoEncodePacer pacer{2500};
+    QVERIFY(pacer.beginFrame(0));
+    pacer.endFrame(false, 0);
+
+    const auto stats = pacer.getStats();
+    QCOMPARE(stats.droppedFrames, 1ull);
+    QCOMPARE(stats.averageEncodeUs, 0ll);
+}
+
+QTEST_GUILESS_MAIN(TestVideoEncodePacer)
+#include "videoencodepacer_test.moc"
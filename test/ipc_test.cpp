@@ -0,0 +1,114 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "src/ipc.h"
+
+#include <QtTest/QtTest>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QProcess>
+
+#include <cstdio>
+
+namespace {
+const char* ownerEnv = "QTOX_IPC_TEST_OWNER";
+const int numRoundTrips = 20;
+
+/**
+ * @brief Runs the owning instance in the child process until it receives "quit".
+ */
+int runOwner()
+{
+    IPC ipc{0};
+    if (!ipc.isAttached() || !ipc.isCurrentOwner()) {
+        return 1;
+    }
+
+    ipc.registerEventHandler("echo", [](const QByteArray&) { return true; });
+    ipc.registerEventHandler("quit", [](const QByteArray&) {
+        QTimer::singleShot(0, qApp, &QCoreApplication::quit);
+        return true;
+    });
+
+    printf("ready\n");
+    fflush(stdout);
+    return qApp->exec();
+}
+} // namespace
+
+class TestIPC : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void testRoundTrip();
+};
+
+void TestIPC::initTestCase()
+{
+    // don't share the segment with a running qTox
+    qputenv("USER", "qtox-ipc-test-" + QByteArray::number(QCoreApplication::applicationPid()));
+}
+
+/**
+ * @brief Events posted to another process are accepted, reports their average latency.
+ */
+void TestIPC::testRoundTrip()
+{
+    QProcess owner;
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    env.insert(ownerEnv, "1");
+    owner.setProcessEnvironment(env);
+    owner.start(QCoreApplication::applicationFilePath(), QStringList{});
+    QVERIFY(owner.waitForStarted());
+    QTRY_VERIFY(owner.canReadLine() || owner.waitForReadyRead(100));
+    QCOMPARE(owner.readLine().trimmed(), QByteArray("ready"));
+
+    IPC ipc{0};
+    QVERIFY(ipc.isAttached());
+    QVERIFY(!ipc.isCurrentOwner());
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < numRoundTrips; ++i) {
+        const time_t event = ipc.postEvent("echo", QByteArray::number(i));
+        QVERIFY(event);
+        QVERIFY(ipc.waitUntilAccepted(event, 2));
+    }
+    const qint64 averageMs = timer.elapsed() / numRoundTrips;
+    qDebug() << "Average IPC round trip:" << averageMs << "ms";
+
+    QVERIFY(ipc.waitUntilAccepted(ipc.postEvent("quit"), 2));
+    QVERIFY(owner.waitForFinished());
+    QCOMPARE(owner.exitCode(), 0);
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    if (qEnvironmentVariableIsSet(ownerEnv)) {
+        return runOwner();
+    }
+
+    TestIPC test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "ipc_test.moc"
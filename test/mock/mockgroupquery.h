@@ -62,6 +62,16 @@ public:
         return QStringList({QString("me"), QString("other")});
     }
 
+    QVector<GroupPeer> getGroupPeers(int groupId) const override
+    {
+        QVector<GroupPeer> peers;
+        const QStringList names = getGroupPeerNames(groupId);
+        for (int i = 0; i < names.size(); ++i) {
+            peers.append({getGroupPeerPk(groupId, i), names[i]});
+        }
+        return peers;
+    }
+
     bool getGroupAvEnabled(int groupId) const override
     {
         return false;
@@ -0,0 +1,179 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "src/model/chatlogsearch.h"
+#include "src/model/sessionchatlog.h"
+
+#include "test/mock/mockcoreidhandler.h"
+
+#include <QSignalSpy>
+#include <QtTest/QtTest>
+
+namespace {
+const size_t numBenchMessages = 100000;
+
+std::unique_ptr<SessionChatLog> createChatLog(const QStringList& texts, const MockCoreIdHandler& idHandler)
+{
+    std::unique_ptr<SessionChatLog> chatLog{
+        new SessionChatLog(ChatLogIdx(static_cast<size_t>(texts.size())), idHandler)};
+    for (int i = 0; i < texts.size(); ++i) {
+        Message message;
+        message.content = texts[i];
+        message.isAction = false;
+        message.timestamp = QDateTime::currentDateTime();
+        chatLog->insertCompleteMessageAtIdx(ChatLogIdx(static_cast<size_t>(i)), ToxPk(), "friend",
+                                            ChatLogMessage{MessageState::complete, message});
+    }
+    return chatLog;
+}
+
+SearchPos makePos(size_t idx, size_t numMatches)
+{
+    return SearchPos{ChatLogIdx(idx), numMatches};
+}
+} // namespace
+
+class TestChatLogSearch : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testForward();
+    void testBackward();
+    void testFilter();
+    void testRestart();
+    void benchmarkSearch();
+
+private:
+    void waitForSearch(ChatLogSearch& search);
+
+    MockCoreIdHandler idHandler;
+};
+
+void TestChatLogSearch::waitForSearch(ChatLogSearch& search)
+{
+    QTRY_VERIFY(!search.isRunning());
+}
+
+void TestChatLogSearch::testForward()
+{
+    auto chatLog = createChatLog({"a test", "nothing", "test test"}, idHandler);
+    ChatLogSearch search;
+    search.start(*chatLog, "test", ParameterSearch(), SearchDirection::Down);
+    waitForSearch(search);
+    QCOMPARE(search.getNumResults(), size_t{3});
+
+    auto result = search.findNext(makePos(0, 0));
+    QVERIFY(result.found);
+    QVERIFY(result.pos == makePos(0, 1));
+    QCOMPARE(result.start, size_t{2});
+    QCOMPARE(result.len, size_t{4});
+
+    result = search.findNext(result.pos);
+    QVERIFY(result.pos == makePos(2, 1));
+    result = search.findNext(result.pos);
+    QVERIFY(result.pos == makePos(2, 2));
+    QCOMPARE(result.start, size_t{5});
+    QVERIFY(!search.findNext(result.pos).found);
+}
+
+/**
+ * @brief Searching from the newest message first gives the same results
+ */
+void TestChatLogSearch::testBackward()
+{
+    auto chatLog = createChatLog({"a test", "nothing", "test test"}, idHandler);
+    ChatLogSearch search;
+    search.start(*chatLog, "test", ParameterSearch(), SearchDirection::Up);
+    waitForSearch(search);
+    QCOMPARE(search.getNumResults(), size_t{3});
+
+    auto result = search.findPrevious(makePos(3, 0));
+    QVERIFY(result.pos == makePos(2, 2));
+    result = search.findPrevious(result.pos);
+    QVERIFY(result.pos == makePos(2, 1));
+    result = search.findPrevious(result.pos);
+    QVERIFY(result.pos == makePos(0, 1));
+    QVERIFY(!search.findPrevious(result.pos).found);
+
+    // The current message is included when starting from it
+    result = search.findPrevious(makePos(2, 0));
+    QVERIFY(result.pos == makePos(2, 2));
+}
+
+void TestChatLogSearch::testFilter()
+{
+    auto chatLog = createChatLog({"Test", "test", "testing"}, idHandler);
+    ChatLogSearch search;
+
+    ParameterSearch parameter;
+    parameter.filter = FilterSearch::RegisterAndWordsOnly;
+    search.start(*chatLog, "test", parameter, SearchDirection::Down);
+    waitForSearch(search);
+    QCOMPARE(search.getNumResults(), size_t{1});
+    QVERIFY(search.findNext(makePos(0, 0)).pos == makePos(1, 1));
+    QVERIFY(search.isSearching("test", parameter));
+    QVERIFY(!search.isSearching("test", ParameterSearch()));
+}
+
+/**
+ * @brief A new search replaces one that's still running
+ */
+void TestChatLogSearch::testRestart()
+{
+    QStringList texts;
+    for (size_t i = 0; i < numBenchMessages; ++i) {
+        texts << QStringLiteral("message %1").arg(i);
+    }
+    texts << "needle";
+    auto chatLog = createChatLog(texts, idHandler);
+
+    ChatLogSearch search;
+    QSignalSpy finished(&search, &ChatLogSearch::finished);
+    search.start(*chatLog, "message", ParameterSearch(), SearchDirection::Down);
+    search.start(*chatLog, "needle", ParameterSearch(), SearchDirection::Up);
+    waitForSearch(search);
+
+    QCOMPARE(search.getNumResults(), size_t{1});
+    QVERIFY(search.findPrevious(makePos(numBenchMessages + 1, 0)).pos
+            == makePos(numBenchMessages, 1));
+    QTRY_COMPARE(finished.count(), 1);
+}
+
+void TestChatLogSearch::benchmarkSearch()
+{
+    QStringList texts;
+    for (size_t i = 0; i < numBenchMessages; ++i) {
+        texts << QStringLiteral("the quick brown fox jumps over the lazy dog %1").arg(i);
+    }
+    auto chatLog = createChatLog(texts, idHandler);
+
+    ChatLogSearch search;
+    QBENCHMARK
+    {
+        search.start(*chatLog, "lazy cat", ParameterSearch(), SearchDirection::Up);
+        while (search.isRunning()) {
+            QThread::yieldCurrentThread();
+        }
+    }
+    QCOMPARE(search.getNumResults(), size_t{0});
+}
+
+QTEST_GUILESS_MAIN(TestChatLogSearch)
+#include "chatlogsearch_test.moc"
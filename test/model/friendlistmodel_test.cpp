@@ -0,0 +1,549 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "src/model/friendlistmodel.h"
+#include "src/model/friend.h"
+#include "src/model/group.h"
+#include "src/persistence/icirclesettings.h"
+#include "src/persistence/ifriendsettings.h"
+
+#include "test/mock/mockcoreidhandler.h"
+#include "test/mock/mockgroupquery.h"
+
+#include <QSignalSpy>
+#include <QtTest/QtTest>
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 11, 0))
+#include <QAbstractItemModelTester>
+#endif
+
+#include <memory>
+#include <vector>
+
+namespace {
+const int numBenchFriends = 5000;
+
+ToxPk makePk(int num)
+{
+    uint8_t id[TOX_PUBLIC_KEY_SIZE] = {0};
+    id[0] = static_cast<uint8_t>(num >> 8);
+    id[1] = static_cast<uint8_t>(num);
+    return ToxPk(id);
+}
+
+/**
+ * Mock friend and circle settings, kept in memory
+ */
+class MockSettings : public IFriendSettings, public ICircleSettings
+{
+public:
+    QString getContactNote(const ToxPk&) const override
+    {
+        return {};
+    }
+    void setContactNote(const ToxPk&, const QString&) override {}
+
+    QString getAutoAcceptDir(const ToxPk&) const override
+    {
+        return {};
+    }
+    void setAutoAcceptDir(const ToxPk&, const QString&) override {}
+
+    AutoAcceptCallFlags getAutoAcceptCall(const ToxPk&) const override
+    {
+        return {};
+    }
+    void setAutoAcceptCall(const ToxPk&, AutoAcceptCallFlags) override {}
+
+    bool getAutoGroupInvite(const ToxPk&) const override
+    {
+        return false;
+    }
+    void setAutoGroupInvite(const ToxPk&, bool) override {}
+
+    QString getFriendAlias(const ToxPk&) const override
+    {
+        return {};
+    }
+    void setFriendAlias(const ToxPk&, const QString&) override {}
+
+    int getFriendCircleID(const ToxPk& pk) const override
+    {
+        return friendCircles.value(pk, -1);
+    }
+    void setFriendCircleID(const ToxPk& pk, int circleId) override
+    {
+        friendCircles[pk] = circleId;
+    }
+
+    QDateTime getFriendActivity(const ToxPk& pk) const override
+    {
+        return activity.value(pk);
+    }
+    void setFriendActivity(const ToxPk& pk, const QDateTime& date) override
+    {
+        activity[pk] = date;
+    }
+
+    void saveFriendSettings(const ToxPk&) override {}
+    void removeFriendSettings(const ToxPk&) override {}
+
+    QMetaObject::Connection connectTo_autoAcceptCallChanged(QObject*,
+                                                            Slot_autoAcceptCallChanged) const override
+    {
+        return {};
+    }
+    QMetaObject::Connection connectTo_autoGroupInviteChanged(QObject*,
+                                                             Slot_autoGroupInviteChanged) const override
+    {
+        return {};
+    }
+    QMetaObject::Connection connectTo_autoAcceptDirChanged(QObject*,
+                                                           Slot_autoAcceptDirChanged) const override
+    {
+        return {};
+    }
+    QMetaObject::Connection connectTo_contactNoteChanged(QObject*,
+                                                         Slot_contactNoteChanged) const override
+    {
+        return {};
+    }
+
+    int getCircleCount() const override
+    {
+        return circles.size();
+    }
+    int addCircle(const QString& name = QString()) override
+    {
+        circles.append({name.isEmpty() ? QString("Circle #%1").arg(circles.size() + 1) : name, false});
+        return circles.size() - 1;
+    }
+    int removeCircle(int id) override
+    {
+        circles[id] = circles.last();
+        circles.pop_back();
+        return circles.size();
+    }
+    QString getCircleName(int id) const override
+    {
+        return circles[id].first;
+    }
+    void setCircleName(int id, const QString& name) override
+    {
+        circles[id].first = name;
+    }
+    bool getCircleExpanded(int id) const override
+    {
+        return circles[id].second;
+    }
+    void setCircleExpanded(int id, bool expanded) override
+    {
+        circles[id].second = expanded;
+    }
+
+    QHash<ToxPk, int> friendCircles;
+    QHash<ToxPk, QDateTime> activity;
+    QVector<QPair<QString, bool>> circles;
+};
+} // namespace
+
+class TestFriendListModel : public QObject
+{
+    Q_OBJECT
+private slots:
+    void init();
+    void cleanup();
+    void testNameOrder();
+    void testGroupsBelow();
+    void testCircles();
+    void testRemoveCircle();
+    void testFilter();
+    void testActivity();
+    void testActivityMove();
+    void testCycle();
+    void testPersistentIndex();
+    void testRowChanges();
+    void benchmarkFilter();
+    void benchmarkActivity();
+
+private:
+    Friend* addFriend(const QString& name, bool online);
+    Group* addGroup(const QString& title);
+    QStringList rows(const QModelIndex& parent = QModelIndex()) const;
+
+    std::unique_ptr<MockSettings> settings;
+    std::unique_ptr<FriendListModel> model;
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 11, 0))
+    std::unique_ptr<QAbstractItemModelTester> tester;
+#endif
+    std::unique_ptr<MockGroupQuery> groupQuery;
+    std::unique_ptr<MockCoreIdHandler> coreIdHandler;
+    std::vector<std::unique_ptr<Friend>> friends;
+    std::vector<std::unique_ptr<Group>> groups;
+};
+
+void TestFriendListModel::init()
+{
+    settings.reset(new MockSettings);
+    model.reset(new FriendListModel(*settings, *settings));
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 11, 0))
+    tester.reset(new QAbstractItemModelTester(model.get(),
+                                              QAbstractItemModelTester::FailureReportingMode::QtTest));
+#endif
+    groupQuery.reset(new MockGroupQuery);
+    coreIdHandler.reset(new MockCoreIdHandler);
+}
+
+void TestFriendListModel::cleanup()
+{
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 11, 0))
+    tester.reset();
+#endif
+    model.reset();
+    friends.clear();
+    groups.clear();
+}
+
+Friend* TestFriendListModel::addFriend(const QString& name, bool online)
+{
+    const int id = static_cast<int>(friends.size());
+    friends.emplace_back(new Friend(id, makePk(id), QString(), name));
+    Friend* frnd = friends.back().get();
+    if (online) {
+        frnd->setStatus(Status::Status::Online);
+        frnd->onNegotiationComplete();
+    }
+
+    model->addFriend(frnd);
+    return frnd;
+}
+
+Group* TestFriendListModel::addGroup(const QString& title)
+{
+    const int id = static_cast<int>(groups.size());
+    groups.emplace_back(
+        new Group(id, GroupId(), title, false, "me", *groupQuery, *coreIdHandler));
+    Group* group = groups.back().get();
+    model->addGroup(group);
+    return group;
+}
+
+QStringList TestFriendListModel::rows(const QModelIndex& parent) const
+{
+    model->applyPendingChanges();
+    QStringList names;
+    for (int row = 0; row < model->rowCount(parent); ++row) {
+        names.append(model->index(row, 0, parent).data().toString());
+    }
+    return names;
+}
+
+/**
+ * @brief Groups come first, then online and offline friends, each sorted by name.
+ */
+void TestFriendListModel::testNameOrder()
+{
+    addFriend("dave", false);
+    addFriend("bob", true);
+    addFriend("carol", false);
+    addFriend("alice", true);
+    addGroup("group");
+
+    QCOMPARE(rows(), QStringList({"group", "alice", "bob", "carol", "dave"}));
+}
+
+void TestFriendListModel::testGroupsBelow()
+{
+    addFriend("alice", true);
+    addFriend("bob", false);
+    addGroup("group");
+    model->setGroupsOnTop(false);
+
+    QCOMPARE(rows(), QStringList({"alice", "group", "bob"}));
+}
+
+/**
+ * @brief Friends in circles are children of their circle, and are counted in it.
+ */
+void TestFriendListModel::testCircles()
+{
+    Friend* alice = addFriend("alice", true);
+    Friend* bob = addFriend("bob", false);
+    addFriend("carol", true);
+    const int work = model->addCircle("work");
+    model->addCircle("empty");
+    model->moveToCircle(alice, work);
+    model->moveToCircle(bob, work);
+
+    QCOMPARE(rows(), QStringList({"carol", "empty", "work"}));
+    const QModelIndex workIndex = model->indexOfCircle(work);
+    QCOMPARE(rows(workIndex), QStringList({"alice", "bob"}));
+    QCOMPARE(workIndex.data(FriendListModel::OnlineCountRole).toInt(), 1);
+    QCOMPARE(workIndex.data(FriendListModel::TotalCountRole).toInt(), 2);
+    QVERIFY(model->isExpanded(workIndex));
+    QCOMPARE(model->indexOf(alice).parent(), workIndex);
+
+    model->moveToCircle(alice, -1);
+    QCOMPARE(rows(), QStringList({"alice", "carol", "empty", "work"}));
+}
+
+/**
+ * @brief Removing a circle takes its friends out, and keeps the others in theirs.
+ */
+void TestFriendListModel::testRemoveCircle()
+{
+    Friend* alice = addFriend("alice", true);
+    Friend* bob = addFriend("bob", true);
+    const int first = model->addCircle("first");
+    const int last = model->addCircle("last");
+    model->moveToCircle(alice, first);
+    model->moveToCircle(bob, last);
+
+    model->removeCircle(first);
+
+    QCOMPARE(settings->getFriendCircleID(alice->getPublicKey()), -1);
+    QCOMPARE(settings->getFriendCircleID(bob->getPublicKey()), first);
+    QCOMPARE(rows(), QStringList({"alice", "last"}));
+    QCOMPARE(rows(model->indexOfCircle(first)), QStringList({"bob"}));
+}
+
+void TestFriendListModel::testFilter()
+{
+    Friend* alice = addFriend("alice", true);
+    addFriend("bob", false);
+    addFriend("alfred", false);
+    addGroup("algebra");
+    const int circle = model->addCircle("circle");
+    model->addCircle("empty");
+    model->moveToCircle(alice, circle);
+
+    model->setFilter("AL", false, false, false);
+    QCOMPARE(rows(), QStringList({"algebra", "alfred", "circle"}));
+    QCOMPARE(rows(model->indexOfCircle(circle)), QStringList({"alice"}));
+
+    model->setFilter("", false, true, true);
+    QCOMPARE(rows(), QStringList({"circle", "empty"}));
+
+    model->setFilter("", true, true, false);
+    QCOMPARE(rows(), QStringList({"algebra"}));
+}
+
+/**
+ * @brief Sorting by activity puts friends in time categories, and hides empty ones.
+ */
+void TestFriendListModel::testActivity()
+{
+    Friend* alice = addFriend("alice", false);
+    addFriend("bob", true);
+    addGroup("group");
+    settings->setFriendActivity(alice->getPublicKey(), QDateTime::currentDateTime());
+
+    model->setMode(FriendListModel::SortingMode::Activity);
+    const QStringList top = rows();
+    QCOMPARE(top.size(), 3);
+    QCOMPARE(top[0], QString("group"));
+    QCOMPARE(rows(model->index(1, 0)), QStringList({"alice"}));
+    QCOMPARE(rows(model->index(2, 0)), QStringList({"bob"}));
+
+    model->updateActivity(alice);
+    QCOMPARE(rows(model->index(1, 0)), QStringList({"alice"}));
+}
+
+/**
+ * @brief New activity moves only the friend, and creates or removes its categories.
+ */
+void TestFriendListModel::testActivityMove()
+{
+    Friend* alice = addFriend("alice", false);
+    Friend* bob = addFriend("bob", true);
+    Friend* carol = addFriend("carol", true);
+    settings->setFriendActivity(alice->getPublicKey(), QDateTime::currentDateTime());
+    settings->setFriendActivity(bob->getPublicKey(), QDateTime::currentDateTime().addDays(-1));
+    model->setMode(FriendListModel::SortingMode::Activity);
+    QCOMPARE(rows().size(), 3);
+
+    QSignalSpy inserted(model.get(), &QAbstractItemModel::rowsInserted);
+    QSignalSpy removed(model.get(), &QAbstractItemModel::rowsRemoved);
+    QSignalSpy layout(model.get(), &QAbstractItemModel::layoutChanged);
+
+    // The friend goes before the offline ones, its old category disappears
+    settings->setFriendActivity(bob->getPublicKey(), QDateTime::currentDateTime());
+    model->updateActivity(bob);
+    QCOMPARE(rows().size(), 2);
+    QCOMPARE(rows(model->index(0, 0)), QStringList({"bob", "alice"}));
+    QCOMPARE(model->index(0, 0).data(FriendListModel::TotalCountRole).toInt(), 2);
+    QCOMPARE(model->index(0, 0).data(FriendListModel::OnlineCountRole).toInt(), 1);
+    QCOMPARE(model->indexOf(bob), model->index(0, 0, model->index(0, 0)));
+    QCOMPARE(removed.count(), 2);
+    QCOMPARE(inserted.count(), 1);
+
+    // A category appears for the friend
+    settings->setFriendActivity(alice->getPublicKey(), QDateTime::currentDateTime().addDays(-1));
+    model->updateActivity(alice);
+    QCOMPARE(rows().size(), 3);
+    QCOMPARE(rows(model->index(1, 0)), QStringList({"alice"}));
+    QCOMPARE(rows(model->index(2, 0)), QStringList({"carol"}));
+    QCOMPARE(model->indexOf(carol), model->index(0, 0, model->index(2, 0)));
+    QCOMPARE(removed.count(), 3);
+    QCOMPARE(inserted.count(), 2);
+    QCOMPARE(layout.count(), 0);
+}
+
+/**
+ * @brief Cycling goes through the contacts in display order, and wraps around.
+ */
+void TestFriendListModel::testCycle()
+{
+    Friend* alice = addFriend("alice", true);
+    Friend* bob = addFriend("bob", true);
+    Friend* carol = addFriend("carol", false);
+    Group* group = addGroup("group");
+    const int circle = model->addCircle("circle");
+    model->moveToCircle(bob, circle);
+    model->applyPendingChanges();
+
+    QCOMPARE(model->nextContact(group, true), alice);
+    QCOMPARE(model->nextContact(alice, true), carol);
+    QCOMPARE(model->nextContact(carol, true), bob);
+    QCOMPARE(model->nextContact(bob, true), group);
+    QCOMPARE(model->nextContact(group, false), bob);
+}
+
+/**
+ * @brief Persistent indexes follow their contact when the list is reordered.
+ */
+void TestFriendListModel::testPersistentIndex()
+{
+    Friend* alice = addFriend("alice", true);
+    addFriend("bob", true);
+    model->applyPendingChanges();
+
+    const QPersistentModelIndex index = model->indexOf(alice);
+    QCOMPARE(index.row(), 0);
+
+    alice->setAlias("zoe");
+    model->applyPendingChanges();
+    QCOMPARE(index.row(), 1);
+    QCOMPARE(model->getContact(index), alice);
+}
+
+/**
+ * @brief Rows that appear or disappear are inserted and removed, reorders are layout changes.
+ */
+void TestFriendListModel::testRowChanges()
+{
+    addFriend("alice", true);
+    Friend* bob = addFriend("bob", true);
+    const int circle = model->addCircle("circle");
+    model->applyPendingChanges();
+
+    QSignalSpy inserted(model.get(), &QAbstractItemModel::rowsInserted);
+    QSignalSpy removed(model.get(), &QAbstractItemModel::rowsRemoved);
+    QSignalSpy layout(model.get(), &QAbstractItemModel::layoutChanged);
+
+    model->setFilter("bob", false, false, false);
+    QCOMPARE(rows(), QStringList({"bob"}));
+    // alice and the empty circle are not adjacent
+    QCOMPARE(removed.count(), 2);
+    QCOMPARE(layout.count(), 0);
+
+    model->setFilter("", false, false, false);
+    QCOMPARE(rows(), QStringList({"alice", "bob", "circle"}));
+    QCOMPARE(inserted.count(), 2);
+    QCOMPARE(layout.count(), 0);
+
+    model->moveToCircle(bob, circle);
+    QCOMPARE(rows(), QStringList({"alice", "circle"}));
+    QCOMPARE(rows(model->indexOfCircle(circle)), QStringList({"bob"}));
+    QCOMPARE(removed.count(), 3);
+    QCOMPARE(inserted.count(), 3);
+    QCOMPARE(layout.count(), 0);
+
+    bob->setAlias("aaron");
+    addFriend("carol", false);
+    model->moveToCircle(bob, -1);
+    QCOMPARE(rows(), QStringList({"aaron", "alice", "carol", "circle"}));
+    QCOMPARE(layout.count(), 0);
+
+    bob->setAlias("zoe");
+    QCOMPARE(rows(), QStringList({"alice", "zoe", "carol", "circle"}));
+    QCOMPARE(layout.count(), 1);
+}
+
+/**
+ * @brief Measures filtering a list of 5000 friends, spread in circles.
+ */
+void TestFriendListModel::benchmarkFilter()
+{
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 11, 0))
+    // measure the model alone
+    tester.reset();
+#endif
+
+    for (int i = 0; i < 10; ++i) {
+        model->addCircle();
+    }
+
+    for (int i = 0; i < numBenchFriends; ++i) {
+        Friend* frnd = addFriend(QString("friend %1").arg(i), i % 3 == 0);
+        if (i % 2 == 0) {
+            settings->setFriendCircleID(frnd->getPublicKey(), i % 10);
+        }
+    }
+    model->applyPendingChanges();
+
+    int i = 0;
+    QBENCHMARK
+    {
+        model->setFilter(QString::number(i++ % 10), false, false, false);
+        model->applyPendingChanges();
+    }
+}
+
+/**
+ * @brief Measures a burst of messages from friends in a list of 5000, sorted by activity.
+ */
+void TestFriendListModel::benchmarkActivity()
+{
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 11, 0))
+    tester.reset();
+#endif
+
+    const QDateTime lastMonth = QDateTime::currentDateTime().addDays(-20);
+    for (int i = 0; i < numBenchFriends; ++i) {
+        Friend* frnd = addFriend(QString("friend %1").arg(i), i % 3 == 0);
+        settings->setFriendActivity(frnd->getPublicKey(), lastMonth);
+    }
+    model->setMode(FriendListModel::SortingMode::Activity);
+    model->applyPendingChanges();
+
+    int i = 0;
+    QBENCHMARK
+    {
+        // Every friend moves to today once, then its next messages change nothing
+        Friend* frnd = friends[i++ % numBenchFriends].get();
+        settings->setFriendActivity(frnd->getPublicKey(), QDateTime::currentDateTime());
+        for (int message = 0; message < 10; ++message) {
+            model->updateActivity(frnd);
+        }
+        model->applyPendingChanges();
+    }
+}
+
+QTEST_GUILESS_MAIN(TestFriendListModel)
+#include "friendlistmodel_test.moc"
@@ -35,25 +35,30 @@ class MockCoreExtPacket : public ICoreExtPacket
 {
 public:
 
-    MockCoreExtPacket(uint64_t& numSentMessages, uint64_t& currentReceiptId)
+    MockCoreExtPacket(uint64_t& numSentMessages, uint64_t& currentReceiptId, uint64_t& numSentPackets)
         : numSentMessages(numSentMessages)
         , currentReceiptId(currentReceiptId)
+        , numSentPackets(numSentPackets)
     {}
 
     uint64_t addExtendedMessage(QString message) override
     {
         this->message = message;
+        numAddedMessages++;
         return currentReceiptId++;
     }
 
     bool send() override
     {
-        numSentMessages++;
+        numSentMessages += numAddedMessages;
+        numSentPackets++;
         return true;
     }
 
     uint64_t& numSentMessages;
     uint64_t& currentReceiptId;
+    uint64_t& numSentPackets;
+    uint64_t numAddedMessages = 0;
     QDateTime senderTimestamp;
     QString message;
 };
@@ -63,37 +68,58 @@ class MockCoreExtPacketAllocator : public ICoreExtPacketAllocator
 public:
     std::unique_ptr<ICoreExtPacket> getPacket(uint32_t friendId) override
     {
-        return std::unique_ptr<MockCoreExtPacket>(new MockCoreExtPacket(numSentMessages, currentReceiptId));
+        return std::unique_ptr<MockCoreExtPacket>(new MockCoreExtPacket(numSentMessages, currentReceiptId, numSentPackets));
     }
 
-    uint64_t numSentMessages;
-    uint64_t currentReceiptId;
+    uint64_t numSentMessages = 0;
+    uint64_t currentReceiptId = 0;
+    uint64_t numSentPackets = 0;
 };
 
 class MockFriendMessageSender : public ICoreFriendMessageSender
 {
 public:
-    bool sendAction(uint32_t friendId, const QString& action, ReceiptNum& receipt) override
+    FriendSendResult sendAction(uint32_t friendId, const QString& action,
+                                ReceiptNum& receipt) override
     {
-        if (canSend) {
+        const FriendSendResult result = nextResult();
+        if (result == FriendSendResult::Sent) {
             numSentActions++;
             receipt = receiptNum;
             receiptNum.get() += 1;
         }
-        return canSend;
+        return result;
     }
 
-    bool sendMessage(uint32_t friendId, const QString& message, ReceiptNum& receipt) override
+    FriendSendResult sendMessage(uint32_t friendId, const QString& message,
+                                 ReceiptNum& receipt) override
     {
-        if (canSend) {
+        const FriendSendResult result = nextResult();
+        if (result == FriendSendResult::Sent) {
             numSentMessages++;
             receipt = receiptNum;
             receiptNum.get() += 1;
         }
-        return canSend;
+        return result;
+    }
+
+    FriendSendResult nextResult()
+    {
+        if (!canSend) {
+            return FriendSendResult::QueueFull;
+        }
+
+        if (numFailures > 0) {
+            --numFailures;
+            return FriendSendResult::Failed;
+        }
+
+        return FriendSendResult::Sent;
     }
 
     bool canSend = true;
+    // number of the next messages refused for good
+    size_t numFailures = 0;
     ReceiptNum receiptNum{0};
     size_t numSentActions = 0;
     size_t numSentMessages = 0;
@@ -116,6 +142,11 @@ private slots:
     void testOfflineExtensionMessages();
     void testSentMessageExtensionSetReduced();
     void testActionMessagesSplitWithExtensions();
+    void testSendQueueFull();
+    void testSendFailureKeepsDraining();
+    void testResendManyMessages();
+    void testExtendedMessageBatching();
+    void benchmarkExtendedMessageBacklog();
 
     void onMessageSent(DispatchedMessageId id, Message message)
     {
@@ -152,6 +183,10 @@ private:
     std::map<DispatchedMessageId, Message> outgoingMessages;
     std::set<DispatchedMessageId> brokenMessages;
     std::deque<Message> receivedMessages;
+
+    void queueExtendedMessages(size_t numMessages);
+    void ackExtendedMessages();
+    uint64_t numAckedExtendedMessages = 0;
 };
 
 TestFriendMessageDispatcher::TestFriendMessageDispatcher() {}
@@ -185,6 +220,35 @@ void TestFriendMessageDispatcher::init()
     outgoingMessages = std::map<DispatchedMessageId, Message>();
     receivedMessages = std::deque<Message>();
     brokenMessages = std::set<DispatchedMessageId>();
+    numAckedExtendedMessages = 0;
+}
+
+/**
+ * @brief Queues extended messages while the friend is offline, then brings it back online.
+ */
+void TestFriendMessageDispatcher::queueExtendedMessages(size_t numMessages)
+{
+    auto requiredExtensions = ExtensionSet();
+    requiredExtensions[ExtensionType::messages] = true;
+
+    f->setStatus(Status::Status::Offline);
+    for (size_t i = 0; i < numMessages; ++i) {
+        friendMessageDispatcher->sendExtendedMessage(QString::number(i), requiredExtensions);
+    }
+
+    f->setStatus(Status::Status::Online);
+    f->setExtendedMessageSupport(true);
+    f->onNegotiationComplete();
+}
+
+/**
+ * @brief Acts as the receiving friend, acknowledges all extended messages sent so far.
+ */
+void TestFriendMessageDispatcher::ackExtendedMessages()
+{
+    for (; numAckedExtendedMessages < coreExtPacketAllocator->currentReceiptId; ++numAckedExtendedMessages) {
+        friendMessageDispatcher->onExtReceiptReceived(numAckedExtendedMessages);
+    }
 }
 
 /**
@@ -391,5 +455,118 @@ void TestFriendMessageDispatcher::testActionMessagesSplitWithExtensions()
     QVERIFY(messageSender->numSentActions > 1);
 }
 
+/**
+ * @brief Tests that messages toxcore can't queue yet are retried while the friend stays online
+ */
+void TestFriendMessageDispatcher::testSendQueueFull()
+{
+    messageSender->canSend = false;
+
+    friendMessageDispatcher->sendMessage(false, "test");
+    friendMessageDispatcher->sendMessage(false, "test2");
+
+    QVERIFY(messageSender->numSentMessages == 0);
+    QVERIFY(friendMessageDispatcher->getOutboundQueueDepth() == 2);
+
+    messageSender->canSend = true;
+
+    QTRY_COMPARE(messageSender->numSentMessages, size_t(2));
+    QVERIFY(friendMessageDispatcher->getOutboundQueueDepth() == 0);
+    QVERIFY(outgoingMessages.size() == 2);
+}
+
+/**
+ * @brief Tests that a message toxcore refuses for good doesn't block the queue, and is kept
+ * for the next time the friend comes online
+ */
+void TestFriendMessageDispatcher::testSendFailureKeepsDraining()
+{
+    messageSender->canSend = false;
+
+    friendMessageDispatcher->sendMessage(false, "test");
+    friendMessageDispatcher->sendMessage(false, "test2");
+    QVERIFY(friendMessageDispatcher->getOutboundQueueDepth() == 2);
+
+    messageSender->numFailures = 1;
+    messageSender->canSend = true;
+
+    QTRY_COMPARE(messageSender->numSentMessages, size_t(1));
+    QVERIFY(friendMessageDispatcher->getOutboundQueueDepth() == 0);
+    QVERIFY(outgoingMessages.size() == 2);
+
+    friendMessageDispatcher->onReceiptReceived(ReceiptNum(0));
+    QVERIFY(outgoingMessages.size() == 1);
+
+    f->setStatus(Status::Status::Offline);
+    f->setStatus(Status::Status::Online);
+    f->onNegotiationComplete();
+
+    QVERIFY(messageSender->numSentMessages == 2);
+}
+
+/**
+ * @brief Tests that a large backlog is resent in batches once the friend comes online
+ */
+void TestFriendMessageDispatcher::testResendManyMessages()
+{
+    f->setStatus(Status::Status::Offline);
+
+    const size_t numMessages = 500;
+    for (size_t i = 0; i < numMessages; ++i) {
+        friendMessageDispatcher->sendMessage(false, QString::number(i));
+    }
+
+    f->setStatus(Status::Status::Online);
+    f->onNegotiationComplete();
+
+    // the backlog is queued as a whole, then a single drain of 32 messages is sent right away
+    QCOMPARE(messageSender->numSentMessages, size_t(32));
+    QVERIFY(friendMessageDispatcher->getOutboundQueueDepth() > 0);
+
+    QTRY_COMPARE(messageSender->numSentMessages, numMessages);
+    QVERIFY(friendMessageDispatcher->getOutboundQueueDepth() == 0);
+
+    for (auto i = ReceiptNum(0); i < messageSender->receiptNum; ++i.get()) {
+        friendMessageDispatcher->onReceiptReceived(i);
+    }
+    QVERIFY(outgoingMessages.empty());
+}
+
+/**
+ * @brief Tests that a backlog of extended messages shares toxext packets
+ */
+void TestFriendMessageDispatcher::testExtendedMessageBatching()
+{
+    const size_t numMessages = 100;
+    queueExtendedMessages(numMessages);
+
+    QTRY_COMPARE(coreExtPacketAllocator->numSentMessages, uint64_t(numMessages));
+    QVERIFY(friendMessageDispatcher->getOutboundQueueDepth() == 0);
+    QVERIFY(coreExtPacketAllocator->numSentPackets < numMessages / 10);
+    QVERIFY(messageSender->numSentMessages == 0);
+
+    ackExtendedMessages();
+    QVERIFY(outgoingMessages.empty());
+    QVERIFY(brokenMessages.empty());
+}
+
+/**
+ * @brief Measures flushing a backlog of extended messages to a friend that acknowledges them
+ */
+void TestFriendMessageDispatcher::benchmarkExtendedMessageBacklog()
+{
+    const size_t numMessages = 500;
+    QBENCHMARK
+    {
+        queueExtendedMessages(numMessages);
+        while (friendMessageDispatcher->getOutboundQueueDepth() > 0) {
+            QCoreApplication::processEvents();
+        }
+        ackExtendedMessages();
+    }
+
+    QVERIFY(outgoingMessages.empty());
+}
+
 QTEST_GUILESS_MAIN(TestFriendMessageDispatcher)
 #include "friendmessagedispatcher_test.moc"
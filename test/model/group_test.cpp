@@ -0,0 +1,180 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "src/model/group.h"
+
+#include "test/mock/mockcoreidhandler.h"
+#include "test/mock/mockgroupquery.h"
+
+#include <QSignalSpy>
+#include <QtTest/QtTest>
+
+namespace {
+const int numBenchPeers = 300;
+
+ToxPk makePk(int num)
+{
+    uint8_t id[TOX_PUBLIC_KEY_SIZE] = {0};
+    id[0] = static_cast<uint8_t>(num >> 8);
+    id[1] = static_cast<uint8_t>(num);
+    id[2] = 1; // never our own key
+    return ToxPk(id);
+}
+
+/**
+ * Mock group with a peer list that can be changed between queries
+ */
+class PeerListQuery : public MockGroupQuery
+{
+public:
+    QVector<GroupPeer> getGroupPeers(int) const override
+    {
+        return peers;
+    }
+
+    QVector<GroupPeer> peers;
+};
+} // namespace
+
+class TestGroup : public QObject
+{
+    Q_OBJECT
+private slots:
+    void init();
+    void testJoin();
+    void testLeave();
+    void testRename();
+    void testUnchanged();
+    void benchmarkJoinLargeGroup();
+
+private:
+    using PeerChanges = QVector<QPair<ToxPk, QString>>;
+    void record(void (Group::*signal)(const ToxPk&, const QString&), PeerChanges& changes);
+
+    std::unique_ptr<PeerListQuery> groupQuery;
+    std::unique_ptr<MockCoreIdHandler> coreIdHandler;
+    std::unique_ptr<Group> group;
+};
+
+void TestGroup::init()
+{
+    groupQuery.reset(new PeerListQuery);
+    groupQuery->peers = {{makePk(1), "alice"}, {makePk(2), "bob"}};
+    coreIdHandler.reset(new MockCoreIdHandler);
+    group.reset(new Group(0, GroupId(), "TestGroup", false, "me", *groupQuery, *coreIdHandler));
+    QCOMPARE(group->getPeersCount(), 2);
+}
+
+void TestGroup::record(void (Group::*signal)(const ToxPk&, const QString&), PeerChanges& changes)
+{
+    connect(group.get(), signal, [&changes](const ToxPk& pk, const QString& name) {
+        changes.append(qMakePair(pk, name));
+    });
+}
+
+void TestGroup::testJoin()
+{
+    PeerChanges joined;
+    PeerChanges left;
+    record(&Group::userJoined, joined);
+    record(&Group::userLeft, left);
+    QSignalSpy count(group.get(), &Group::numPeersChanged);
+
+    groupQuery->peers.append({makePk(3), "carol"});
+    group->regeneratePeerList();
+
+    QCOMPARE(joined.size(), 1);
+    QCOMPARE(joined[0].first, makePk(3));
+    QCOMPARE(joined[0].second, QString("carol"));
+    QCOMPARE(left.size(), 0);
+    QCOMPARE(count.count(), 1);
+    QCOMPARE(count[0][0].toInt(), 3);
+    QCOMPARE(group->resolveToxId(makePk(3)), QString("carol"));
+}
+
+void TestGroup::testLeave()
+{
+    PeerChanges joined;
+    PeerChanges left;
+    record(&Group::userJoined, joined);
+    record(&Group::userLeft, left);
+
+    groupQuery->peers.removeFirst();
+    group->regeneratePeerList();
+
+    QCOMPARE(joined.size(), 0);
+    QCOMPARE(left.size(), 1);
+    QCOMPARE(left[0].first, makePk(1));
+    QCOMPARE(left[0].second, QString("alice"));
+    QCOMPARE(group->getPeersCount(), 1);
+    QVERIFY(!group->getPeerList().contains(makePk(1)));
+}
+
+void TestGroup::testRename()
+{
+    QStringList renamed;
+    connect(group.get(), &Group::peerNameChanged,
+            [&renamed](const ToxPk&, const QString& oldName, const QString& newName) {
+                renamed << oldName << newName;
+            });
+    QSignalSpy count(group.get(), &Group::numPeersChanged);
+
+    groupQuery->peers[1].name = "robert";
+    group->regeneratePeerList();
+
+    QCOMPARE(renamed, QStringList({"bob", "robert"}));
+    QCOMPARE(count.count(), 0);
+}
+
+void TestGroup::testUnchanged()
+{
+    PeerChanges changes;
+    record(&Group::userJoined, changes);
+    record(&Group::userLeft, changes);
+    int renamed = 0;
+    connect(group.get(), &Group::peerNameChanged, [&renamed]() { ++renamed; });
+    QSignalSpy count(group.get(), &Group::numPeersChanged);
+
+    group->regeneratePeerList();
+
+    QCOMPARE(changes.size() + renamed + count.count(), 0);
+}
+
+/**
+ * @brief Measures a peer joining a large conference, which runs once per joining peer.
+ */
+void TestGroup::benchmarkJoinLargeGroup()
+{
+    groupQuery->peers.clear();
+    for (int i = 0; i < numBenchPeers; ++i) {
+        groupQuery->peers.append({makePk(i), QString("peer %1").arg(i)});
+    }
+    group->regeneratePeerList();
+
+    QBENCHMARK
+    {
+        groupQuery->peers.append({makePk(numBenchPeers), "late"});
+        group->regeneratePeerList();
+        groupQuery->peers.removeLast();
+        group->regeneratePeerList();
+    }
+}
+
+QTEST_GUILESS_MAIN(TestGroup)
+#include "group_test.moc"
@@ -61,10 +61,17 @@ public:
     void setBlackList(const QStringList& blist) override
     {
         blacklist = blist;
+        peerBlackList.publish(blist);
+    }
+
+    const PeerBlackList& getPeerBlackList() const override
+    {
+        return peerBlackList;
     }
 
 private:
     QStringList blacklist;
+    PeerBlackList peerBlackList;
 };
 
 class TestGroupMessageDispatcher : public QObject
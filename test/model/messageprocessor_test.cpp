@@ -17,6 +17,7 @@
     along with qTox.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include "src/core/toxstring.h"
 #include "src/model/message.h"
 
 #include <tox/tox.h>
@@ -45,6 +46,9 @@ private slots:
     void testSelfMention();
     void testOutgoingMessage();
     void testIncomingMessage();
+    void benchmarkMentionDetection();
+    void testIncomingMessageShared();
+    void benchmarkReceivePath();
 };
 
 
@@ -161,5 +165,80 @@ void TestMessageProcessor::testIncomingMessage()
     QVERIFY(message.timestamp.isValid());
 }
 
+/**
+ * @brief Measures mention detection on the messages of a busy conference, a few of which
+ * mention us.
+ */
+void TestMessageProcessor::benchmarkMentionDetection()
+{
+    MessageProcessor::SharedParams sharedParams(tox_max_message_length(), 10 * 1024 * 1024);
+    sharedParams.onUserNameSet("MyUserName");
+    sharedParams.setPublicKey("0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF");
+
+    auto messageProcessor = MessageProcessor(sharedParams);
+    messageProcessor.enableMentions();
+
+    QStringList messages;
+    for (int i = 0; i < 1000; ++i) {
+        QString message = QString("message %1, some chatter about whatever is going on").arg(i);
+        if (i % 20 == 0) {
+            message += " myusername";
+        }
+        messages << message;
+    }
+
+    int numMentions = 0;
+    QBENCHMARK
+    {
+        numMentions = 0;
+        for (const auto& message : messages) {
+            numMentions += messageHasSelfMention(
+                messageProcessor.processIncomingCoreMessage(false, message));
+        }
+    }
+    QCOMPARE(numMentions, 50);
+}
+
+/**
+ * @brief Tests that the text of a received message is decoded once and then shared, not copied
+ */
+void TestMessageProcessor::testIncomingMessageShared()
+{
+    MessageProcessor::SharedParams sharedParams(tox_max_message_length(), 10 * 1024 * 1024);
+    sharedParams.onUserNameSet("MyUserName");
+    auto messageProcessor = MessageProcessor(sharedParams);
+    messageProcessor.enableMentions();
+
+    const QByteArray raw = QByteArrayLiteral("hello myusername");
+    const QString decoded =
+        ToxString(reinterpret_cast<const uint8_t*>(raw.constData()), raw.size()).getQString();
+    const Message message = messageProcessor.processIncomingCoreMessage(false, decoded);
+
+    QVERIFY(messageHasSelfMention(message));
+    QVERIFY(message.content.constData() == decoded.constData());
+}
+
+/**
+ * @brief Measures a received message from the toxcore buffer up to the UTF-8 stored in history.
+ */
+void TestMessageProcessor::benchmarkReceivePath()
+{
+    MessageProcessor::SharedParams sharedParams(tox_max_message_length(), 10 * 1024 * 1024);
+    sharedParams.onUserNameSet("MyUserName");
+    auto messageProcessor = MessageProcessor(sharedParams);
+    messageProcessor.enableMentions();
+
+    const QByteArray raw = QString("Ünïcödé text from a busy conference ").repeated(30).toUtf8();
+    QByteArray stored;
+    QBENCHMARK
+    {
+        const QString decoded =
+            ToxString(reinterpret_cast<const uint8_t*>(raw.constData()), raw.size()).getQString();
+        const Message message = messageProcessor.processIncomingCoreMessage(false, decoded);
+        stored = message.content.toUtf8();
+    }
+    QCOMPARE(stored, raw);
+}
+
 QTEST_GUILESS_MAIN(TestMessageProcessor)
 #include "messageprocessor_test.moc"
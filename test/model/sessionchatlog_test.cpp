@@ -25,6 +25,8 @@
 
 namespace {
 static const QString TEST_USERNAME = "qTox Tester #1";
+// About a million messages
+const size_t numScrollItems = 4096 * SessionChatLog::chunkSize;
 
 Message createMessage(const QString& content)
 {
@@ -35,6 +37,11 @@ Message createMessage(const QString& content)
     return message;
 }
 
+ChatLogMessage createCompleteMessage(const QString& content)
+{
+    return ChatLogMessage{MessageState::complete, createMessage(content)};
+}
+
 class MockCoreIdHandler : public ICoreIdHandler
 {
 public:
@@ -68,8 +75,14 @@ private slots:
     void init();
 
     void testSanity();
+    void testEviction();
+    void testPinnedItems();
+    void testSearchStopsAtEvicted();
+    void benchmarkScrollThrough();
 
 private:
+    void insertRange(SessionChatLog& log, size_t start, size_t end);
+
     MockCoreIdHandler idHandler;
     std::unique_ptr<SessionChatLog> chatLog;
 };
@@ -133,5 +146,102 @@ void TestSessionChatLog::testSanity()
     QVERIFY(searchResult.start == 5);
 }
 
+void TestSessionChatLog::insertRange(SessionChatLog& log, size_t start, size_t end)
+{
+    const auto message = createCompleteMessage("test");
+    for (auto i = start; i < end; ++i) {
+        log.insertCompleteMessageAtIdx(ChatLogIdx(i), ToxPk(), "friend", message);
+    }
+}
+
+/**
+ * @brief Loading far more items than the limit keeps the most recently used chunks,
+ * evicted ones can be inserted again
+ */
+void TestSessionChatLog::testEviction()
+{
+    const size_t limit = 4 * SessionChatLog::chunkSize;
+    const size_t numItems = 20 * SessionChatLog::chunkSize;
+    chatLog.reset(new SessionChatLog(ChatLogIdx(numItems), idHandler));
+    chatLog->setCacheLimit(limit);
+
+    insertRange(*chatLog, 0, numItems);
+
+    QVERIFY(chatLog->getNumCachedItems() <= limit);
+    QVERIFY(!chatLog->contains(ChatLogIdx(0)));
+    QVERIFY(chatLog->contains(ChatLogIdx(numItems - 1)));
+    QVERIFY(chatLog->getCachedRangeEnd(ChatLogIdx(numItems - limit)) == ChatLogIdx(numItems));
+
+    insertRange(*chatLog, 0, SessionChatLog::chunkSize);
+    QVERIFY(chatLog->getNumCachedItems() <= limit);
+    QCOMPARE(chatLog->at(ChatLogIdx(0)).getContentAsMessage().message.content, QString("test"));
+    QVERIFY(chatLog->getFirstIdx() == ChatLogIdx(0));
+    QVERIFY(chatLog->getCachedRangeEnd(ChatLogIdx(0)) == ChatLogIdx(SessionChatLog::chunkSize));
+}
+
+/**
+ * @brief Chunks with pending messages aren't evicted until the message completes
+ */
+void TestSessionChatLog::testPinnedItems()
+{
+    const size_t limit = 2 * SessionChatLog::chunkSize;
+    const size_t numItems = 10 * SessionChatLog::chunkSize;
+    chatLog.reset(new SessionChatLog(ChatLogIdx(numItems), idHandler));
+    chatLog->setCacheLimit(limit);
+
+    const auto pending = ChatLogMessage{MessageState::pending, createMessage("pending")};
+    chatLog->insertIncompleteMessageAtIdx(ChatLogIdx(0), ToxPk(), "friend", pending,
+                                          DispatchedMessageId(0));
+    insertRange(*chatLog, 1, numItems / 2);
+    QVERIFY(chatLog->contains(ChatLogIdx(0)));
+
+    chatLog->onMessageComplete(DispatchedMessageId(0));
+    QCOMPARE(chatLog->at(ChatLogIdx(0)).getContentAsMessage().state, MessageState::complete);
+
+    insertRange(*chatLog, numItems / 2, numItems);
+    QVERIFY(!chatLog->contains(ChatLogIdx(0)));
+    QVERIFY(chatLog->getNumCachedItems() <= limit);
+}
+
+/**
+ * @brief Searches only cover the uninterrupted range of cached items
+ */
+void TestSessionChatLog::testSearchStopsAtEvicted()
+{
+    const size_t numItems = 3 * SessionChatLog::chunkSize;
+    chatLog.reset(new SessionChatLog(ChatLogIdx(numItems), idHandler));
+    chatLog->insertCompleteMessageAtIdx(ChatLogIdx(0), ToxPk(), "friend",
+                                        createCompleteMessage("needle"));
+    insertRange(*chatLog, 2 * SessionChatLog::chunkSize, numItems);
+
+    auto result = chatLog->searchBackward(SearchPos{ChatLogIdx(numItems - 1), 0}, "needle",
+                                          ParameterSearch());
+    QVERIFY(!result.found);
+
+    result = chatLog->searchForward(SearchPos{ChatLogIdx(0), 0}, "needle", ParameterSearch());
+    QVERIFY(result.found);
+    QVERIFY(result.pos.logIdx == ChatLogIdx(0));
+    QVERIFY(chatLog->getCachedRangeEnd(ChatLogIdx(0)) == ChatLogIdx(1));
+}
+
+/**
+ * @brief Scrolls through a large history the way ChatHistory loads it, one chunk at a time
+ */
+void TestSessionChatLog::benchmarkScrollThrough()
+{
+    const size_t limit = 16 * SessionChatLog::chunkSize;
+    QBENCHMARK_ONCE
+    {
+        chatLog.reset(new SessionChatLog(ChatLogIdx(numScrollItems), idHandler));
+        chatLog->setCacheLimit(limit);
+        for (size_t start = numScrollItems; start > 0; start -= SessionChatLog::chunkSize) {
+            insertRange(*chatLog, start - SessionChatLog::chunkSize, start);
+            chatLog->at(ChatLogIdx(start - 1));
+        }
+    }
+
+    QVERIFY(chatLog->getNumCachedItems() <= limit);
+}
+
 QTEST_GUILESS_MAIN(TestSessionChatLog)
 #include "sessionchatlog_test.moc"
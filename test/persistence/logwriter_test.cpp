@@ -0,0 +1,120 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "src/persistence/logwriter.h"
+
+#include <QtTest/QtTest>
+#include <QFile>
+#include <QTemporaryDir>
+
+namespace {
+QByteArray readFile(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+    return file.readAll();
+}
+} // namespace
+
+class TestLogWriter : public QObject
+{
+    Q_OBJECT
+private slots:
+    void init();
+    void testKeepUntilFile();
+    void testRotate();
+    void testDropped();
+
+private:
+    std::unique_ptr<QTemporaryDir> dir;
+};
+
+void TestLogWriter::init()
+{
+    dir.reset(new QTemporaryDir);
+    QVERIFY(dir->isValid());
+}
+
+/**
+ * @brief Messages logged before the file is known end up in it, in order.
+ */
+void TestLogWriter::testKeepUntilFile()
+{
+    const QString path = dir->filePath("test.log");
+    LogWriter writer{nullptr, true};
+    writer.start();
+    writer.log("first\n");
+    writer.log("second\n");
+    writer.setFile(path);
+    writer.log("third\n");
+    writer.stop();
+
+    QCOMPARE(readFile(path), QByteArray("first\nsecond\nthird\n"));
+    QCOMPARE(writer.getNumDropped(), 0ull);
+}
+
+/**
+ * @brief The file is moved aside once it grows beyond its maximum size.
+ */
+void TestLogWriter::testRotate()
+{
+    const QString path = dir->filePath("test.log");
+    LogWriter writer{nullptr, true};
+    writer.start();
+    writer.setFile(path, 10);
+    QByteArray expected;
+    for (int i = 0; i < 5; ++i) {
+        const QByteArray line = QByteArray("line ") + QByteArray::number(i) + '\n';
+        writer.log(line);
+        expected += line;
+        QThread::msleep(10);
+    }
+    writer.stop();
+
+    const QByteArray rotated = readFile(path + ".1");
+    QVERIFY(!rotated.isEmpty());
+    QVERIFY(expected.endsWith(rotated + readFile(path)));
+}
+
+/**
+ * @brief Messages beyond the queue limit are counted and the count is logged.
+ */
+void TestLogWriter::testDropped()
+{
+    const QString path = dir->filePath("test.log");
+    LogWriter writer{nullptr, true, 10};
+    writer.log("12345\n");
+    writer.log("12345\n");
+    writer.log("12345\n");
+    QCOMPARE(writer.getNumDropped(), 2ull);
+
+    writer.setFile(path);
+    writer.start();
+    writer.stop();
+
+    const QByteArray content = readFile(path);
+    QVERIFY(content.contains("Dropped 2 log messages"));
+    QVERIFY(content.endsWith("12345\n"));
+}
+
+QTEST_GUILESS_MAIN(TestLogWriter)
+#include "logwriter_test.moc"
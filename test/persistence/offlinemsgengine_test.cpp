@@ -35,8 +35,42 @@ private slots:
     void testTypeCoordination();
     void testCallback();
     void testExtendedMessageCoordination();
+    void testReceiptEviction();
+    void testManyResentMessages();
+    void benchmarkResendManyMessages();
 };
 
+namespace {
+// messages queued while a friend was offline for a long time
+const uint32_t numResentMessages = 10000;
+
+/**
+ * @brief Resends all messages and receives their receipts, the first half of them before
+ * the message is added, the rest in reverse order afterwards.
+ * @return Number of completed messages.
+ */
+size_t resendAndReceive(OfflineMsgEngine& offlineMsgEngine)
+{
+    size_t numCallbacks = 0;
+    auto callback = [&numCallbacks] (bool) { numCallbacks++; };
+
+    const uint32_t half = numResentMessages / 2;
+    for (uint32_t i = 0; i < half; ++i) {
+        offlineMsgEngine.onReceiptReceived(ReceiptNum(i));
+    }
+
+    for (uint32_t i = 0; i < numResentMessages; ++i) {
+        offlineMsgEngine.addSentCoreMessage(ReceiptNum(i), Message(), callback);
+    }
+
+    for (uint32_t i = numResentMessages; i > half; --i) {
+        offlineMsgEngine.onReceiptReceived(ReceiptNum(i - 1));
+    }
+
+    return numCallbacks;
+}
+} // namespace
+
 void completionFn(bool) {}
 
 void TestOfflineMsgEngine::testReceiptBeforeMessage()
@@ -183,5 +217,44 @@ void TestOfflineMsgEngine::testExtendedMessageCoordination()
     QVERIFY(numCallbacks == 3);
 }
 
+/**
+ * @brief Receipts that never get a message are dropped once they are too old.
+ */
+void TestOfflineMsgEngine::testReceiptEviction()
+{
+    OfflineMsgEngine offlineMsgEngine{std::chrono::milliseconds(10)};
+
+    size_t numCallbacks = 0;
+    auto callback = [&numCallbacks] (bool) { numCallbacks++; };
+
+    offlineMsgEngine.onReceiptReceived(ReceiptNum(1));
+    QTest::qWait(20);
+    offlineMsgEngine.onReceiptReceived(ReceiptNum(2));
+
+    offlineMsgEngine.addSentCoreMessage(ReceiptNum(1), Message(), callback);
+    QVERIFY(numCallbacks == 0);
+
+    offlineMsgEngine.addSentCoreMessage(ReceiptNum(2), Message(), callback);
+    QVERIFY(numCallbacks == 1);
+
+    QVERIFY(offlineMsgEngine.removeAllMessages().size() == 1);
+}
+
+void TestOfflineMsgEngine::testManyResentMessages()
+{
+    OfflineMsgEngine offlineMsgEngine;
+    QCOMPARE(resendAndReceive(offlineMsgEngine), static_cast<size_t>(numResentMessages));
+    QVERIFY(offlineMsgEngine.removeAllMessages().empty());
+}
+
+void TestOfflineMsgEngine::benchmarkResendManyMessages()
+{
+    OfflineMsgEngine offlineMsgEngine;
+    QBENCHMARK
+    {
+        resendAndReceive(offlineMsgEngine);
+    }
+}
+
 QTEST_GUILESS_MAIN(TestOfflineMsgEngine)
 #include "offlinemsgengine_test.moc"
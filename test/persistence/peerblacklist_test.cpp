@@ -0,0 +1,154 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "src/persistence/peerblacklist.h"
+
+#include <tox/tox.h>
+
+#include <QMutex>
+#include <QtTest/QtTest>
+
+namespace {
+// peers sending audio to a large conference call, one frame every 20ms each
+const int numPeers = 50;
+
+ToxPk makePk(int num)
+{
+    uint8_t id[TOX_PUBLIC_KEY_SIZE] = {0};
+    id[0] = static_cast<uint8_t>(num);
+    return ToxPk(id);
+}
+
+/**
+ * @brief Black list with every fifth peer blocked and some entries that aren't peers.
+ */
+QStringList makeBlackList()
+{
+    QStringList blackList{"", "not a key"};
+    for (int i = 0; i < numPeers; i += 5) {
+        blackList << makePk(i).toString();
+    }
+    return blackList;
+}
+} // namespace
+
+class TestPeerBlackList : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testPublish();
+    void testInvalidEntries();
+    void testReaderRefresh();
+    void benchmarkStringListAudioFrames();
+    void benchmarkReaderAudioFrames();
+};
+
+void TestPeerBlackList::testPublish()
+{
+    PeerBlackList blackList;
+    QVERIFY(blackList.getPeers()->isEmpty());
+
+    blackList.publish(makeBlackList());
+    const auto peers = blackList.getPeers();
+    QCOMPARE(peers->size(), numPeers / 5);
+    QVERIFY(peers->contains(makePk(5)));
+    QVERIFY(!peers->contains(makePk(6)));
+}
+
+/**
+ * @brief Only entries that compared equal to ToxPk::toString before are blocked.
+ */
+void TestPeerBlackList::testInvalidEntries()
+{
+    PeerBlackList blackList;
+    const QString pk = makePk(1).toString();
+    blackList.publish({pk.toLower(), pk.left(10), pk + "00"});
+    QVERIFY(blackList.getPeers()->isEmpty());
+}
+
+/**
+ * @brief A reader notices a new black list, older snapshots stay unchanged.
+ */
+void TestPeerBlackList::testReaderRefresh()
+{
+    PeerBlackList blackList;
+    PeerBlackList::Reader reader{blackList};
+    QVERIFY(!reader.contains(makePk(1)));
+
+    const auto before = blackList.getPeers();
+    blackList.publish({makePk(1).toString()});
+    QVERIFY(reader.contains(makePk(1)));
+    QVERIFY(before->isEmpty());
+
+    blackList.publish({});
+    QVERIFY(!reader.contains(makePk(1)));
+}
+
+/**
+ * @brief Measures one audio frame from every peer the way the black list used to be checked.
+ */
+void TestPeerBlackList::benchmarkStringListAudioFrames()
+{
+    QMutex bigLock;
+    const QStringList blackList = makeBlackList();
+    QVector<ToxPk> peers;
+    for (int i = 0; i < numPeers; ++i) {
+        peers.append(makePk(i));
+    }
+
+    int blocked = 0;
+    QBENCHMARK
+    {
+        blocked = 0;
+        for (const ToxPk& peerPk : peers) {
+            bigLock.lock();
+            const QStringList copy = blackList;
+            bigLock.unlock();
+            blocked += copy.contains(peerPk.toString());
+        }
+    }
+    QCOMPARE(blocked, numPeers / 5);
+}
+
+/**
+ * @brief Measures one audio frame from every peer checked against the published black list.
+ */
+void TestPeerBlackList::benchmarkReaderAudioFrames()
+{
+    PeerBlackList blackList;
+    blackList.publish(makeBlackList());
+    PeerBlackList::Reader reader{blackList};
+    QVector<ToxPk> peers;
+    for (int i = 0; i < numPeers; ++i) {
+        peers.append(makePk(i));
+    }
+
+    int blocked = 0;
+    QBENCHMARK
+    {
+        blocked = 0;
+        for (const ToxPk& peerPk : peers) {
+            blocked += reader.contains(peerPk);
+        }
+    }
+    QCOMPARE(blocked, numPeers / 5);
+}
+
+QTEST_GUILESS_MAIN(TestPeerBlackList)
+#include "peerblacklist_test.moc"
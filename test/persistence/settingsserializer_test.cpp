@@ -0,0 +1,247 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "src/persistence/serialize.h"
+#include "src/persistence/settingsserializer.h"
+
+#include <QtTest/QtTest>
+#include <QFile>
+#include <QSettings>
+#include <QTemporaryDir>
+
+namespace {
+const int numBenchFriends = 2000;
+
+void appendString(QByteArray& data, const QString& str)
+{
+    const QByteArray utf8 = str.toUtf8();
+    data.append(vintToData(utf8.size()));
+    data.append(utf8);
+}
+
+void appendVInt(QByteArray& data, int num)
+{
+    const QByteArray vint = vintToData(num);
+    data.append(vintToData(vint.size()));
+    data.append(vint);
+}
+
+void writeFriends(SettingsSerializer& ps, int numFriends)
+{
+    ps.beginGroup("Friends");
+    ps.beginWriteArray("Friend", numFriends);
+    for (int i = 0; i < numFriends; ++i) {
+        ps.setArrayIndex(i);
+        ps.setValue("addr", QString::number(i).repeated(8));
+        ps.setValue("alias", QString("friend %1").arg(i));
+        ps.setValue("circle", i % 10);
+    }
+    ps.endArray();
+    ps.endGroup();
+}
+} // namespace
+
+class TestSettingsSerializer : public QObject
+{
+    Q_OBJECT
+private slots:
+    void init();
+    void testRoundTrip();
+    void testUntouchedGroupsPreserved();
+    void testLegacyImport();
+    void testIniImport();
+    void benchmarkLoad();
+
+private:
+    std::unique_ptr<QTemporaryDir> dir;
+    QString path;
+};
+
+void TestSettingsSerializer::init()
+{
+    dir.reset(new QTemporaryDir);
+    QVERIFY(dir->isValid());
+    path = dir->filePath("profile.ini");
+}
+
+/**
+ * @brief Saves values in groups and arrays and checks they are read back.
+ */
+void TestSettingsSerializer::testRoundTrip()
+{
+    {
+        SettingsSerializer ps(path);
+        ps.setValue("rootKey", "root");
+        ps.beginGroup("Privacy");
+        ps.setValue("typingNotification", true);
+        ps.endGroup();
+        writeFriends(ps, 3);
+        ps.save();
+    }
+
+    QVERIFY(SettingsSerializer::isSerializedFormat(path));
+
+    SettingsSerializer ps(path);
+    ps.load();
+    QCOMPARE(ps.value("rootKey").toString(), QString("root"));
+    ps.beginGroup("Privacy");
+    QCOMPARE(ps.value("typingNotification").toBool(), true);
+    QCOMPARE(ps.value("missing", 42).toInt(), 42);
+    ps.endGroup();
+
+    ps.beginGroup("Friends");
+    QCOMPARE(ps.beginReadArray("Friend"), 3);
+    for (int i = 0; i < 3; ++i) {
+        ps.setArrayIndex(i);
+        QCOMPARE(ps.value("alias").toString(), QString("friend %1").arg(i));
+        QCOMPARE(ps.value("circle").toInt(), i % 10);
+    }
+    ps.endArray();
+    ps.endGroup();
+}
+
+/**
+ * @brief Checks that groups which are never entered survive a load/save cycle.
+ */
+void TestSettingsSerializer::testUntouchedGroupsPreserved()
+{
+    {
+        SettingsSerializer ps(path);
+        writeFriends(ps, 2);
+        ps.beginGroup("GUI");
+        ps.setValue("compactLayout", false);
+        ps.endGroup();
+        ps.save();
+    }
+
+    {
+        SettingsSerializer ps(path);
+        ps.load();
+        ps.beginGroup("GUI");
+        ps.setValue("compactLayout", true);
+        ps.endGroup();
+        ps.save();
+    }
+
+    SettingsSerializer ps(path);
+    ps.load();
+    ps.beginGroup("GUI");
+    QCOMPARE(ps.value("compactLayout").toBool(), true);
+    ps.endGroup();
+    ps.beginGroup("Friends");
+    QCOMPARE(ps.beginReadArray("Friend"), 2);
+    ps.setArrayIndex(1);
+    QCOMPARE(ps.value("alias").toString(), QString("friend 1"));
+    ps.endArray();
+    ps.endGroup();
+}
+
+/**
+ * @brief Reads a file in the unindexed "QTOX" RecordTag stream format.
+ */
+void TestSettingsSerializer::testLegacyImport()
+{
+    QByteArray data("QTOX");
+    data.append('\x00'); // Value
+    appendString(data, "rootKey");
+    appendString(data, "root");
+    data.append('\x01'); // GroupStart
+    appendString(data, "Friends");
+    data.append('\x02'); // ArrayStart
+    appendString(data, "Friend");
+    appendVInt(data, 1);
+    data.append('\x03'); // ArrayValue
+    appendVInt(data, 0);
+    appendString(data, "alias");
+    appendString(data, "legacy");
+    data.append('\x04'); // ArrayEnd
+
+    QFile f(path);
+    QVERIFY(f.open(QIODevice::WriteOnly));
+    f.write(data);
+    f.close();
+
+    SettingsSerializer ps(path);
+    ps.load();
+    QCOMPARE(ps.value("rootKey").toString(), QString("root"));
+    ps.beginGroup("Friends");
+    QCOMPARE(ps.beginReadArray("Friend"), 1);
+    ps.setArrayIndex(0);
+    QCOMPARE(ps.value("alias").toString(), QString("legacy"));
+    ps.endArray();
+    ps.endGroup();
+}
+
+/**
+ * @brief Reads a plain .ini file, converting arrays.
+ */
+void TestSettingsSerializer::testIniImport()
+{
+    {
+        QSettings s(path, QSettings::IniFormat);
+        s.beginGroup("Friends");
+        s.beginWriteArray("Friend", 2);
+        s.setArrayIndex(0);
+        s.setValue("alias", "first");
+        s.setArrayIndex(1);
+        s.setValue("alias", "second");
+        s.endArray();
+        s.endGroup();
+    }
+
+    SettingsSerializer ps(path);
+    ps.load();
+    ps.beginGroup("Friends");
+    QCOMPARE(ps.beginReadArray("Friend"), 2);
+    ps.setArrayIndex(1);
+    QCOMPARE(ps.value("alias").toString(), QString("second"));
+    ps.endArray();
+    ps.endGroup();
+}
+
+/**
+ * @brief Measures loading and reading a profile with many friends.
+ */
+void TestSettingsSerializer::benchmarkLoad()
+{
+    {
+        SettingsSerializer ps(path);
+        writeFriends(ps, numBenchFriends);
+        ps.save();
+    }
+
+    QBENCHMARK
+    {
+        SettingsSerializer ps(path);
+        ps.load();
+        ps.beginGroup("Friends");
+        int size = ps.beginReadArray("Friend");
+        for (int i = 0; i < size; ++i) {
+            ps.setArrayIndex(i);
+            ps.value("addr");
+            ps.value("alias");
+            ps.value("circle");
+        }
+        ps.endArray();
+        ps.endGroup();
+    }
+}
+
+QTEST_GUILESS_MAIN(TestSettingsSerializer)
+#include "settingsserializer_test.moc"
@@ -40,6 +40,9 @@ private slots:
     void testSmilifySingleCharEmoji();
     void testSmilifyMultiCharEmoji();
     void testSmilifyAsciiEmoticon();
+    void testSmilifyAsciiEmoticonBoundaries();
+    void testSmilifyMixed();
+    void benchmarkSmilifyEmojiHeavy();
 private:
     std::unique_ptr<QGuiApplication> app;
 };
@@ -112,6 +115,59 @@ void TestSmileyPack::testSmilifyAsciiEmoticon()
     QVERIFY(result == "  " + getAsRichText(":-)") + "  ");
 }
 
+/**
+ * @brief Test that neighbouring ascii emoticons are only smilified when separated by white space
+ */
+void TestSmileyPack::testSmilifyAsciiEmoticonBoundaries()
+{
+    auto& smileyPack = SmileyPack::getInstance();
+
+    auto result = smileyPack.smileyfied(":) :smile:\n:-D");
+    QVERIFY(result == getAsRichText(":)") + " " + getAsRichText(":smile:") + "\n"
+                          + getAsRichText(":-D"));
+
+    constexpr auto adjacentMsg = ":):)";
+    result = smileyPack.smileyfied(adjacentMsg);
+    QVERIFY(result == adjacentMsg);
+
+    constexpr auto punctuationMsg = "Fine :-).";
+    result = smileyPack.smileyfied(punctuationMsg);
+    QVERIFY(result == punctuationMsg);
+}
+
+/**
+ * @brief Test that emojis and ascii emoticons in one message are all smilified
+ */
+void TestSmileyPack::testSmilifyMixed()
+{
+    auto& smileyPack = SmileyPack::getInstance();
+
+    constexpr auto plainMsg = "No smileys in here";
+    auto result = smileyPack.smileyfied(plainMsg);
+    QVERIFY(result == plainMsg);
+
+    result = smileyPack.smileyfied("😊🇬🇧 :-) 😊");
+    QVERIFY(result == getAsRichText("😊") + getAsRichText("🇬🇧") + " " + getAsRichText(":-)")
+                          + " " + getAsRichText("😊"));
+}
+
+/**
+ * @brief Measures smilifying a long message that mostly consists of emojis
+ */
+void TestSmileyPack::benchmarkSmilifyEmojiHeavy()
+{
+    auto& smileyPack = SmileyPack::getInstance();
+
+    QString msg;
+    for (int i = 0; i < 100; ++i) {
+        msg += QStringLiteral("😊🇬🇧 :-) word 🇫🇷");
+    }
+
+    QBENCHMARK
+    {
+        smileyPack.smileyfied(msg);
+    }
+}
 
 QTEST_GUILESS_MAIN(TestSmileyPack)
 #include "smileypack_test.moc"
@@ -0,0 +1,214 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "src/persistence/thumbnailcache.h"
+
+#include <QDir>
+#include <QTemporaryDir>
+#include <QtTest/QtTest>
+
+namespace {
+const int iconSize = 60;
+} // namespace
+
+class TestThumbnailCache : public QObject
+{
+    Q_OBJECT
+private slots:
+    void init();
+    void testCanPreview();
+    void testIcon();
+    void testSmallIcon();
+    void testChangedFile();
+    void testPreview();
+    void testUndecodable();
+    void testMemoryOnly();
+    void testDiskLimit();
+    void testDestroyedReceiver();
+
+private:
+    QString makeImage(const QString& name, QSize size);
+    QImage waitForIcon(const QString& filePath);
+    int countStoredIcons() const;
+
+    std::unique_ptr<QTemporaryDir> dir;
+    std::unique_ptr<ThumbnailCache> cache;
+};
+
+void TestThumbnailCache::init()
+{
+    dir.reset(new QTemporaryDir);
+    QVERIFY(dir->isValid());
+    cache.reset(new ThumbnailCache{dir->filePath("cache")});
+}
+
+QString TestThumbnailCache::makeImage(const QString& name, QSize size)
+{
+    QImage image{size, QImage::Format_RGB32};
+    image.fill(Qt::red);
+    const QString path = dir->filePath(name);
+    image.save(path);
+    return path;
+}
+
+QImage TestThumbnailCache::waitForIcon(const QString& filePath)
+{
+    QImage result;
+    bool ready = false;
+    cache->requestIcon(filePath, iconSize, this, [&](const QImage& icon) {
+        result = icon;
+        ready = true;
+    });
+
+    for (int i = 0; i < 500 && !ready; ++i) {
+        QTest::qWait(10);
+    }
+    return result;
+}
+
+int TestThumbnailCache::countStoredIcons() const
+{
+    return QDir{dir->filePath("cache")}.entryList(QDir::Files).size();
+}
+
+void TestThumbnailCache::testCanPreview()
+{
+    QVERIFY(ThumbnailCache::canPreview("/tmp/image.jpg"));
+    QVERIFY(ThumbnailCache::canPreview("/tmp/image.PNG"));
+    QVERIFY(!ThumbnailCache::canPreview("/tmp/archive.zip"));
+}
+
+/**
+ * @brief Large images are cropped into a square and the icon is stored.
+ */
+void TestThumbnailCache::testIcon()
+{
+    const QString path = makeImage("large.png", {1600, 900});
+    const QImage icon = waitForIcon(path);
+    QCOMPARE(icon.size(), QSize(iconSize, iconSize));
+    QCOMPARE(countStoredIcons(), 1);
+
+    // served from memory
+    QCOMPARE(waitForIcon(path).size(), QSize(iconSize, iconSize));
+    QCOMPARE(countStoredIcons(), 1);
+
+    // served from disk
+    cache.reset(new ThumbnailCache{dir->filePath("cache")});
+    QCOMPARE(waitForIcon(path).size(), QSize(iconSize, iconSize));
+    QCOMPARE(countStoredIcons(), 1);
+}
+
+void TestThumbnailCache::testSmallIcon()
+{
+    const QString path = makeImage("small.png", {20, 200});
+    QCOMPARE(waitForIcon(path).size(), QSize(20, iconSize));
+}
+
+/**
+ * @brief A file that changed on disk doesn't get the icon of its previous content.
+ */
+void TestThumbnailCache::testChangedFile()
+{
+    const QString path = makeImage("changed.png", {200, 200});
+    QVERIFY(!waitForIcon(path).isNull());
+
+    makeImage("changed.png", {300, 200});
+    QVERIFY(!waitForIcon(path).isNull());
+    QCOMPARE(countStoredIcons(), 2);
+}
+
+void TestThumbnailCache::testPreview()
+{
+    const QString path = makeImage("preview.png", {1600, 900});
+    QByteArray png;
+    cache->requestPreview(path, {400, 400}, this, [&png](const QByteArray& result) { png = result; });
+    QTRY_VERIFY(!png.isEmpty());
+
+    const QImage preview = QImage::fromData(png, "PNG");
+    QCOMPARE(preview.size(), QSize(400, 225));
+}
+
+void TestThumbnailCache::testUndecodable()
+{
+    const QString path = dir->filePath("broken.jpg");
+    QFile file{path};
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("not an image");
+    file.close();
+
+    bool called = false;
+    cache->requestIcon(path, iconSize, this, [&called](const QImage&) { called = true; });
+    QTest::qWait(500);
+    QVERIFY(!called);
+}
+
+/**
+ * @brief Without a directory, like for encrypted profiles, nothing is written to disk.
+ */
+void TestThumbnailCache::testMemoryOnly()
+{
+    cache.reset(new ThumbnailCache);
+    const QString path = makeImage("memory.png", {200, 200});
+    QVERIFY(!waitForIcon(path).isNull());
+    QVERIFY(!waitForIcon(path).isNull());
+    QCOMPARE(countStoredIcons(), 0);
+}
+
+/**
+ * @brief The oldest icons are removed once the stored ones get too large.
+ */
+void TestThumbnailCache::testDiskLimit()
+{
+    const QString first = makeImage("first.png", {200, 200});
+    QVERIFY(!waitForIcon(first).isNull());
+    const qint64 iconBytes = QDir{dir->filePath("cache")}.entryInfoList(QDir::Files)[0].size();
+
+    cache.reset(new ThumbnailCache{dir->filePath("cache"), iconBytes * 3});
+    for (int i = 0; i < 3; ++i) {
+        // a different size for every file, so each gets its own icon
+        QVERIFY(!waitForIcon(makeImage(QString("%1.png").arg(i), {200 + i, 200})).isNull());
+        QTest::qWait(10);
+    }
+
+    // the fourth icon went over the limit, the two oldest were removed
+    QCOMPARE(countStoredIcons(), 2);
+    cache.reset(new ThumbnailCache{dir->filePath("cache")});
+    QVERIFY(!waitForIcon(first).isNull());
+    QCOMPARE(countStoredIcons(), 3);
+}
+
+/**
+ * @brief Results for receivers that are gone are dropped.
+ */
+void TestThumbnailCache::testDestroyedReceiver()
+{
+    const QString path = makeImage("destroyed.png", {200, 200});
+    bool called = false;
+    std::unique_ptr<QObject> receiver{new QObject};
+    cache->requestIcon(path, iconSize, receiver.get(), [&called](const QImage&) { called = true; });
+    receiver.reset();
+
+    // the icon is still stored, for the next request
+    QTRY_COMPARE(countStoredIcons(), 1);
+    QTest::qWait(50);
+    QVERIFY(!called);
+}
+
+QTEST_GUILESS_MAIN(TestThumbnailCache)
+#include "thumbnailcache_test.moc"
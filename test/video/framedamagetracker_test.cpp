@@ -0,0 +1,159 @@
+/*
+    Copyright © 2019 by The qTox Project Contributors
+
+    This file is part of qTox, a Qt-based graphical interface for Tox.
+
+    qTox is libre software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    qTox is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with qTox.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "src/video/framedamagetracker.h"
+
+#include <QtTest/QtTest>
+
+#include <vector>
+
+namespace {
+// 4 bytes per pixel like the frames of x11grab
+const int bytesPerPixel = 4;
+// rows are padded like the frames of ffmpeg
+const int padding = 32;
+
+struct Frame
+{
+    Frame(int width, int height)
+        : rowBytes{width * bytesPerPixel}
+        , linesize{rowBytes + padding}
+        , height{height}
+        , data(static_cast<size_t>(linesize) * height)
+    {
+    }
+
+    uint8_t* row(int y)
+    {
+        return data.data() + static_cast<size_t>(y) * linesize;
+    }
+
+    int rowBytes;
+    int linesize;
+    int height;
+    std::vector<uint8_t> data;
+};
+} // namespace
+
+class TestFrameDamageTracker : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testFirstFrame();
+    void testUnchanged();
+    void testDamage();
+    void testResize();
+    void benchmarkUpdate_data();
+    void benchmarkUpdate();
+};
+
+void TestFrameDamageTracker::testFirstFrame()
+{
+    Frame frame{64, 48};
+    FrameDamageTracker tracker;
+    QVERIFY(tracker.update(frame.data.data(), frame.linesize, frame.rowBytes, frame.height));
+}
+
+/**
+ * @brief Only the picture counts, changes in the padding are no damage.
+ */
+void TestFrameDamageTracker::testUnchanged()
+{
+    Frame frame{64, 48};
+    FrameDamageTracker tracker;
+    tracker.update(frame.data.data(), frame.linesize, frame.rowBytes, frame.height);
+
+    frame.row(10)[frame.rowBytes] = 1;
+    QVERIFY(!tracker.update(frame.data.data(), frame.linesize, frame.rowBytes, frame.height));
+
+    tracker.reset();
+    QVERIFY(tracker.update(frame.data.data(), frame.linesize, frame.rowBytes, frame.height));
+}
+
+void TestFrameDamageTracker::testDamage()
+{
+    Frame frame{64, 48};
+    FrameDamageTracker tracker;
+    tracker.update(frame.data.data(), frame.linesize, frame.rowBytes, frame.height);
+
+    frame.row(5)[0] = 1;
+    QVERIFY(tracker.update(frame.data.data(), frame.linesize, frame.rowBytes, frame.height));
+
+    // the last byte of the picture in a row counts too
+    frame.row(20)[frame.rowBytes - 1] = 1;
+    QVERIFY(tracker.update(frame.data.data(), frame.linesize, frame.rowBytes, frame.height));
+
+    // the changed rows were remembered
+    QVERIFY(!tracker.update(frame.data.data(), frame.linesize, frame.rowBytes, frame.height));
+}
+
+void TestFrameDamageTracker::testResize()
+{
+    Frame small{64, 48};
+    Frame large{128, 96};
+    FrameDamageTracker tracker;
+    tracker.update(small.data.data(), small.linesize, small.rowBytes, small.height);
+    QVERIFY(tracker.update(large.data.data(), large.linesize, large.rowBytes, large.height));
+}
+
+void TestFrameDamageTracker::benchmarkUpdate_data()
+{
+    QTest::addColumn<int>("width");
+    QTest::addColumn<int>("height");
+    QTest::addColumn<bool>("animated");
+
+    QTest::newRow("static 1080p") << 1920 << 1080 << false;
+    QTest::newRow("animated 1080p") << 1920 << 1080 << true;
+    QTest::newRow("static 4K") << 3840 << 2160 << false;
+    QTest::newRow("animated 4K") << 3840 << 2160 << true;
+}
+
+/**
+ * @brief Measures the cost per captured screen frame. The animated desktop changes a moving
+ * band of a quarter of the screen, like a playing video.
+ */
+void TestFrameDamageTracker::benchmarkUpdate()
+{
+    QFETCH(int, width);
+    QFETCH(int, height);
+    QFETCH(bool, animated);
+
+    Frame frame{width, height};
+    FrameDamageTracker tracker;
+    tracker.update(frame.data.data(), frame.linesize, frame.rowBytes, frame.height);
+
+    const int band = height / 4;
+    uint8_t value = 0;
+    int top = 0;
+    QBENCHMARK
+    {
+        if (animated) {
+            ++value;
+            top = (top + 8) % (height - band);
+            for (int y = top; y < top + band; ++y) {
+                memset(frame.row(y) + frame.rowBytes / 4, value, frame.rowBytes / 2);
+            }
+        }
+        tracker.update(frame.data.data(), frame.linesize, frame.rowBytes, frame.height);
+    }
+}
+
+QTEST_GUILESS_MAIN(TestFrameDamageTracker)
+#include "framedamagetracker_test.moc"